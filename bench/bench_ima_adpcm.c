@@ -0,0 +1,802 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+
+/* 計測対象のモジュール */
+#include "../ima_adpcm.c"
+
+/* 計測に使うブロック数 */
+#define BENCH_NUM_BLOCKS      4096
+
+/* 円周率 */
+#define BENCH_PI              3.14159265358979323846
+
+/* 計測の繰り返し回数 */
+#define BENCH_NUM_ITERATIONS  8
+
+/* 1サンプルデコード処理の名前 */
+#if defined(IMAADPCM_USE_TRANSITION_TABLE)
+#define BENCH_DECODE_KERNEL_NAME "transition table"
+#else
+#define BENCH_DECODE_KERNEL_NAME "arithmetic"
+#endif
+
+/* 乱数でデータブロックを作成 */
+static void Bench_MakeRandomBlocks(
+    uint8_t *data, uint32_t block_size, uint32_t num_channels, uint32_t num_blocks)
+{
+  uint32_t i, blk, ch;
+
+  srand(0);
+  for (i = 0; i < block_size * num_blocks; i++) {
+    data[i] = (uint8_t)(rand() & 0xFF);
+  }
+
+  /* ブロックヘッダは有効な値にする */
+  for (blk = 0; blk < num_blocks; blk++) {
+    for (ch = 0; ch < num_channels; ch++) {
+      data[blk * block_size + 4 * ch + 2] = (uint8_t)(rand() % 89);
+      data[blk * block_size + 4 * ch + 3] = 0;
+    }
+  }
+}
+
+/* 合成信号をヘッダ含めてエンコード */
+/* encodedにはIMAADPCMWAVENCODER_HEADER_SIZE + block_size * num_blocksのサイズが必要 */
+static void Bench_EncodeSignal(
+    uint8_t *encoded, uint32_t block_size, uint32_t num_channels, uint32_t num_blocks)
+{
+  uint32_t smpl, ch, num_samples, output_size;
+  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS];
+  struct IMAADPCMWAVEncoder *encoder;
+  struct IMAADPCMWAVEncodeParameter enc_param;
+  const uint32_t num_samples_per_block = (block_size - 4 * num_channels) * 2 / num_channels + 1;
+  const uint32_t encoded_size = IMAADPCMWAVENCODER_HEADER_SIZE + block_size * num_blocks;
+
+  num_samples = num_samples_per_block * num_blocks;
+  srand(0);
+  for (ch = 0; ch < num_channels; ch++) {
+    input[ch] = (int16_t *)malloc(sizeof(int16_t) * num_samples);
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      const double t = (double)smpl / 44100.0;
+      const double val = 8000.0 * sin(2.0 * BENCH_PI * 440.0 * t)
+        + 4000.0 * sin(2.0 * BENCH_PI * 1234.5 * (ch + 1) * t)
+        + 500.0 * ((double)rand() / RAND_MAX - 0.5);
+      input[ch][smpl] = (int16_t)val;
+    }
+  }
+
+  encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  enc_param.num_channels = (uint16_t)num_channels;
+  enc_param.sampling_rate = 44100;
+  enc_param.bits_per_sample = 4;
+  enc_param.block_size = (uint16_t)block_size;
+  if ((IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_EncodeWhole(encoder,
+          (const int16_t *const *)input, num_samples, encoded, encoded_size, &output_size) != IMAADPCM_APIRESULT_OK)) {
+    fprintf(stderr, "Failed to encode signal. \n");
+    exit(1);
+  }
+
+  IMAADPCMWAVEncoder_Destroy(encoder);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(input[ch]);
+  }
+}
+
+/* 合成信号をエンコードしてデータブロックを作成 */
+/* 乱数ブロックはほぼ常にクリップするため、実際の音声に近いデータとして使う */
+static void Bench_MakeSignalBlocks(
+    uint8_t *data, uint32_t block_size, uint32_t num_channels, uint32_t num_blocks)
+{
+  uint8_t *encoded;
+
+  encoded = (uint8_t *)malloc(IMAADPCMWAVENCODER_HEADER_SIZE + block_size * num_blocks);
+  Bench_EncodeSignal(encoded, block_size, num_channels, num_blocks);
+  memcpy(data, &encoded[IMAADPCMWAVENCODER_HEADER_SIZE], block_size * num_blocks);
+  free(encoded);
+}
+
+/* ブロック単位のスカラデコード処理時間の計測 */
+static void Bench_DecodeBlock(uint16_t num_channels, uint16_t block_size, uint8_t use_signal)
+{
+  uint8_t *data;
+  uint32_t ch, blk, itr, num_decode_samples, checksum;
+  int16_t *output[IMAADPCM_MAX_NUM_CHANNELS];
+  struct IMAADPCMWAVDecoder *decoder;
+  clock_t start, end;
+  double elapsed_sec, total_samples;
+
+  data = (uint8_t *)malloc((size_t)block_size * BENCH_NUM_BLOCKS);
+  if (use_signal) {
+    Bench_MakeSignalBlocks(data, block_size, num_channels, BENCH_NUM_BLOCKS);
+  } else {
+    Bench_MakeRandomBlocks(data, block_size, num_channels, BENCH_NUM_BLOCKS);
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    output[ch] = (int16_t *)malloc(sizeof(int16_t) * block_size * 2);
+  }
+
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+  decoder->header.num_channels = num_channels;
+
+  checksum = 0;
+  total_samples = 0.0;
+  start = clock();
+  for (itr = 0; itr < BENCH_NUM_ITERATIONS; itr++) {
+    for (blk = 0; blk < BENCH_NUM_BLOCKS; blk++) {
+      if (IMAADPCMWAVDecoder_DecodeBlock(decoder,
+            &data[blk * block_size], block_size,
+            output, num_channels, (uint32_t)block_size * 2, &num_decode_samples) != IMAADPCM_APIRESULT_OK) {
+        fprintf(stderr, "Failed to decode block. \n");
+        exit(1);
+      }
+      checksum += (uint16_t)output[0][num_decode_samples - 1];
+      total_samples += (double)num_decode_samples * num_channels;
+    }
+  }
+  end = clock();
+  elapsed_sec = (double)(end - start) / CLOCKS_PER_SEC;
+
+  printf("%-16s %-6s ch:%d block:%5d %8.3f [ns/sample] (checksum:%08X) \n",
+      BENCH_DECODE_KERNEL_NAME, use_signal ? "signal" : "random", num_channels, block_size,
+      (elapsed_sec * 1.0e9) / total_samples, checksum);
+
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(output[ch]);
+  }
+  free(data);
+}
+
+/* カーネルを指定したファイル全体のデコード処理時間の計測 */
+static void Bench_DecodeWhole(uint16_t num_channels, uint16_t block_size, IMAADPCMKernel kernel)
+{
+  static const char *kernel_names[] = { "auto", "scalar", "sse41", "avx2" };
+  uint8_t *data;
+  uint32_t ch, itr, data_size, checksum;
+  int16_t *output[IMAADPCM_MAX_NUM_CHANNELS];
+  struct IMAADPCMWAVDecoder *decoder;
+  struct IMAADPCMWAVHeaderInfo header;
+  clock_t start, end;
+  double elapsed_sec;
+
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+  if (IMAADPCMWAVDecoder_SetKernel(decoder, kernel) != IMAADPCM_APIRESULT_OK) {
+    /* 実行中のCPUで使えないカーネルは計測しない */
+    IMAADPCMWAVDecoder_Destroy(decoder);
+    return;
+  }
+
+  data_size = IMAADPCMWAVENCODER_HEADER_SIZE + (uint32_t)block_size * BENCH_NUM_BLOCKS;
+  data = (uint8_t *)malloc(data_size);
+  Bench_EncodeSignal(data, block_size, num_channels, BENCH_NUM_BLOCKS);
+  if (IMAADPCMWAVDecoder_DecodeHeader(data, data_size, &header) != IMAADPCM_APIRESULT_OK) {
+    fprintf(stderr, "Failed to decode header. \n");
+    exit(1);
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    output[ch] = (int16_t *)malloc(sizeof(int16_t) * header.num_samples);
+  }
+
+  checksum = 0;
+  start = clock();
+  for (itr = 0; itr < BENCH_NUM_ITERATIONS; itr++) {
+    if (IMAADPCMWAVDecoder_DecodeWhole(decoder,
+          data, data_size, output, num_channels, header.num_samples) != IMAADPCM_APIRESULT_OK) {
+      fprintf(stderr, "Failed to decode. \n");
+      exit(1);
+    }
+    checksum += (uint16_t)output[0][header.num_samples - 1];
+  }
+  end = clock();
+  elapsed_sec = (double)(end - start) / CLOCKS_PER_SEC;
+
+  printf("%-16s %-6s ch:%d block:%5d %8.3f [ns/sample] (checksum:%08X) \n",
+      "whole", kernel_names[IMAADPCMWAVDecoder_GetKernel(decoder)], num_channels, block_size,
+      (elapsed_sec * 1.0e9) / ((double)header.num_samples * num_channels * BENCH_NUM_ITERATIONS), checksum);
+
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(output[ch]);
+  }
+  free(data);
+}
+
+/* ファイル全体のブロック独立エンコード（1タスク）の計測 */
+static void Bench_EncodeWhole(uint16_t num_channels, uint16_t block_size, IMAADPCMKernel kernel)
+{
+  static const char *kernel_names[] = { "auto", "scalar", "sse41", "avx2" };
+  uint8_t *data;
+  uint32_t ch, smpl, itr, data_size, num_samples, output_size, checksum;
+  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS];
+  struct IMAADPCMWAVEncoder *encoder;
+  struct IMAADPCMWAVEncodeParameter enc_param;
+  clock_t start, end;
+  double elapsed_sec;
+
+  encoder = IMAADPCMWAVEncoder_CreateParallel(1, NULL, 0);
+  if (IMAADPCMWAVEncoder_SetKernel(encoder, kernel) != IMAADPCM_APIRESULT_OK) {
+    /* 実行中のCPUで使えないカーネルは計測しない */
+    IMAADPCMWAVEncoder_Destroy(encoder);
+    return;
+  }
+  enc_param.num_channels = num_channels;
+  enc_param.sampling_rate = 44100;
+  enc_param.bits_per_sample = IMAADPCM_BITS_PER_SAMPLE;
+  enc_param.block_size = block_size;
+  if (IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK) {
+    fprintf(stderr, "Failed to set encode parameter. \n");
+    exit(1);
+  }
+
+  /* 正弦波に雑音を加えた信号 */
+  num_samples = ((block_size - 4U * num_channels) * 2U / num_channels + 1U) * BENCH_NUM_BLOCKS;
+  srand(0);
+  for (ch = 0; ch < num_channels; ch++) {
+    input[ch] = (int16_t *)malloc(sizeof(int16_t) * num_samples);
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      input[ch][smpl] = (int16_t)(8000.0 * sin(2.0 * BENCH_PI * 440.0 * smpl / 44100.0) + (rand() % 512) - 256);
+    }
+  }
+  data_size = IMAADPCMWAVENCODER_HEADER_SIZE + (uint32_t)block_size * BENCH_NUM_BLOCKS;
+  data = (uint8_t *)malloc(data_size);
+
+  checksum = 0;
+  start = clock();
+  for (itr = 0; itr < BENCH_NUM_ITERATIONS; itr++) {
+    if (IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+          (const int16_t *const *)input, num_samples, data, data_size, &output_size, 1, NULL, NULL) != IMAADPCM_APIRESULT_OK) {
+      fprintf(stderr, "Failed to encode. \n");
+      exit(1);
+    }
+    checksum += data[output_size - 1];
+  }
+  end = clock();
+  elapsed_sec = (double)(end - start) / CLOCKS_PER_SEC;
+
+  printf("%-16s %-6s ch:%d block:%5d %8.3f [ns/sample] (checksum:%08X) \n",
+      "encode", kernel_names[IMAADPCMWAVEncoder_GetKernel(encoder)], num_channels, block_size,
+      (elapsed_sec * 1.0e9) / ((double)num_samples * num_channels * BENCH_NUM_ITERATIONS), checksum);
+
+  IMAADPCMWAVEncoder_Destroy(encoder);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(input[ch]);
+  }
+  free(data);
+}
+
+/* デコーダバンクによる多数ストリームの同時デコードの計測 */
+/* use_bankが0の場合は比較用に、1つのハンドルでストリーム毎にティック分ずつ範囲デコードする */
+static void Bench_DecoderBank(uint32_t num_streams, uint8_t use_bank, IMAADPCMKernel kernel)
+{
+  static const char *kernel_names[] = { "auto", "scalar", "sse41", "avx2" };
+  uint8_t *data;
+  uint32_t i, itr, frame, data_size, checksum, num_decode_samples;
+  int16_t *output;
+  struct IMAADPCMDecoderBank *bank;
+  struct IMAADPCMWAVDecoder *decoder;
+  struct IMAADPCMWAVHeaderInfo header;
+  clock_t start, end;
+  double elapsed_sec;
+  const uint32_t block_size = 256;
+  const uint32_t num_blocks = 64;
+  const uint32_t num_tick_frames = 256;
+
+  bank = IMAADPCMDecoderBank_Create(num_streams, NULL, 0);
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+  if (IMAADPCMDecoderBank_SetKernel(bank, kernel) != IMAADPCM_APIRESULT_OK) {
+    /* 実行中のCPUで使えないカーネルは計測しない */
+    IMAADPCMDecoderBank_Destroy(bank);
+    IMAADPCMWAVDecoder_Destroy(decoder);
+    return;
+  }
+
+  /* 短いモノラルのストリームを共有する */
+  data_size = IMAADPCMWAVENCODER_HEADER_SIZE + block_size * num_blocks;
+  data = (uint8_t *)malloc(data_size);
+  Bench_EncodeSignal(data, block_size, 1, num_blocks);
+  if (IMAADPCMWAVDecoder_DecodeHeader(data, data_size, &header) != IMAADPCM_APIRESULT_OK) {
+    fprintf(stderr, "Failed to decode header. \n");
+    exit(1);
+  }
+  output = (int16_t *)malloc(sizeof(int16_t) * num_streams * IMAADPCM_MAX_NUM_CHANNELS * num_tick_frames);
+
+  checksum = 0;
+  start = clock();
+  for (itr = 0; itr < BENCH_NUM_ITERATIONS; itr++) {
+    if (use_bank) {
+      /* 全ストリームを追加し、終端までティック単位でデコード */
+      for (i = 0; i < num_streams; i++) {
+        uint32_t id;
+        if (IMAADPCMDecoderBank_AddStream(bank, data, data_size, &id) != IMAADPCM_APIRESULT_OK) {
+          fprintf(stderr, "Failed to add stream. \n");
+          exit(1);
+        }
+      }
+      for (frame = 0; frame < header.num_samples; frame += num_tick_frames) {
+        if (IMAADPCMDecoderBank_Decode(bank,
+              output, num_streams * IMAADPCM_MAX_NUM_CHANNELS * num_tick_frames, num_tick_frames) != IMAADPCM_APIRESULT_OK) {
+          fprintf(stderr, "Failed to decode. \n");
+          exit(1);
+        }
+        checksum += (uint16_t)output[(num_streams - 1) * IMAADPCM_MAX_NUM_CHANNELS];
+      }
+      for (i = 0; i < num_streams; i++) {
+        IMAADPCMDecoderBank_RemoveStream(bank, i);
+      }
+    } else {
+      /* ストリーム毎にティック分を範囲デコード */
+      for (frame = 0; frame < header.num_samples; frame += num_tick_frames) {
+        for (i = 0; i < num_streams; i++) {
+          int16_t *buffer[1];
+          buffer[0] = &output[i * num_tick_frames];
+          if (IMAADPCMWAVDecoder_DecodeRange(decoder, data, data_size,
+                frame, num_tick_frames, buffer, 1, num_tick_frames, &num_decode_samples) != IMAADPCM_APIRESULT_OK) {
+            fprintf(stderr, "Failed to decode. \n");
+            exit(1);
+          }
+        }
+        checksum += (uint16_t)output[(num_streams - 1) * num_tick_frames];
+      }
+    }
+  }
+  end = clock();
+  elapsed_sec = (double)(end - start) / CLOCKS_PER_SEC;
+
+  printf("%-16s %-6s streams:%5d %8.3f [ns/sample] (checksum:%08X) \n",
+      use_bank ? "bank" : "handles", use_bank ? kernel_names[bank->kernel] : "-", num_streams,
+      (elapsed_sec * 1.0e9) / ((double)header.num_samples * num_streams * BENCH_NUM_ITERATIONS), checksum);
+
+  IMAADPCMDecoderBank_Destroy(bank);
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  free(output);
+  free(data);
+}
+
+/* デコード結果のミックスの計測 */
+/* use_fusedが0の場合は比較用に、範囲デコードで16bitバッファに受けてから別のループでバスに加算する */
+static void Bench_DecodeMix(uint16_t num_channels, uint32_t num_streams, uint8_t use_fused)
+{
+  uint8_t *data;
+  uint32_t i, ch, smpl, itr, frame, data_size, checksum, num_decode_samples;
+  int16_t *pcm[IMAADPCM_MAX_NUM_CHANNELS];
+  int32_t *bus[IMAADPCM_MAX_NUM_CHANNELS];
+  struct IMAADPCMWAVDecoder *decoder;
+  struct IMAADPCMWAVHeaderInfo header;
+  clock_t start, end;
+  double elapsed_sec;
+  const uint32_t block_size = 1024;
+  const uint32_t num_blocks = 64;
+  const uint32_t num_tick_frames = 256;
+
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+
+  data_size = IMAADPCMWAVENCODER_HEADER_SIZE + block_size * num_blocks;
+  data = (uint8_t *)malloc(data_size);
+  Bench_EncodeSignal(data, block_size, num_channels, num_blocks);
+  if (IMAADPCMWAVDecoder_DecodeHeader(data, data_size, &header) != IMAADPCM_APIRESULT_OK) {
+    fprintf(stderr, "Failed to decode header. \n");
+    exit(1);
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    pcm[ch] = (int16_t *)malloc(sizeof(int16_t) * num_tick_frames);
+    bus[ch] = (int32_t *)malloc(sizeof(int32_t) * num_tick_frames);
+  }
+
+  checksum = 0;
+  start = clock();
+  for (itr = 0; itr < BENCH_NUM_ITERATIONS; itr++) {
+    for (frame = 0; frame < header.num_samples; frame += num_tick_frames) {
+      for (ch = 0; ch < num_channels; ch++) {
+        memset(bus[ch], 0, sizeof(int32_t) * num_tick_frames);
+      }
+      /* ストリーム毎に再生位置をずらしてティック分をミックス */
+      for (i = 0; i < num_streams; i++) {
+        const uint32_t position = (frame + i * 997) % header.num_samples;
+        const int32_t gain = (int32_t)(IMAADPCM_MIX_GAIN_ONE / num_streams);
+        if (use_fused) {
+          if (IMAADPCMWAVDecoder_DecodeRangeMix(decoder, data, data_size,
+                position, num_tick_frames, gain, bus, num_channels, num_tick_frames, &num_decode_samples) != IMAADPCM_APIRESULT_OK) {
+            fprintf(stderr, "Failed to decode. \n");
+            exit(1);
+          }
+        } else {
+          if (IMAADPCMWAVDecoder_DecodeRange(decoder, data, data_size,
+                position, num_tick_frames, pcm, num_channels, num_tick_frames, &num_decode_samples) != IMAADPCM_APIRESULT_OK) {
+            fprintf(stderr, "Failed to decode. \n");
+            exit(1);
+          }
+          for (ch = 0; ch < num_channels; ch++) {
+            for (smpl = 0; smpl < num_decode_samples; smpl++) {
+              bus[ch][smpl] += (pcm[ch][smpl] * gain + (1 << 14)) >> 15;
+            }
+          }
+        }
+      }
+      checksum += (uint32_t)bus[0][0];
+    }
+  }
+  end = clock();
+  elapsed_sec = (double)(end - start) / CLOCKS_PER_SEC;
+
+  printf("%-16s ch:%d streams:%5d %8.3f [ns/sample] (checksum:%08X) \n",
+      use_fused ? "mix fused" : "mix 2-pass", num_channels, num_streams,
+      (elapsed_sec * 1.0e9) / ((double)header.num_samples * num_channels * num_streams * BENCH_NUM_ITERATIONS), checksum);
+
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(pcm[ch]);
+    free(bus[ch]);
+  }
+  free(data);
+}
+
+/* リサンプリングデコード（44.1kHzから48kHz）の計測 */
+/* use_fusedが0の場合は比較用に、一括デコードで全長のバッファに受けてから別のループで変換する */
+static void Bench_DecodeResample(uint16_t num_channels, IMAADPCMResampleMode mode, uint8_t use_fused)
+{
+  uint8_t *data;
+  uint32_t ch, smpl, tap, itr, data_size, checksum, num_output_samples, num_decode_samples, progress;
+  int16_t *whole[IMAADPCM_MAX_NUM_CHANNELS], *output[IMAADPCM_MAX_NUM_CHANNELS];
+  struct IMAADPCMWAVDecoder *decoder;
+  struct IMAADPCMWAVHeaderInfo header;
+  clock_t start, end;
+  double elapsed_sec;
+  const uint32_t block_size = 1024;
+  const uint32_t num_blocks = 256;
+  const uint32_t num_chunk_samples = 1024;
+  const uint32_t output_sampling_rate = 48000;
+
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+
+  data_size = IMAADPCMWAVENCODER_HEADER_SIZE + block_size * num_blocks;
+  data = (uint8_t *)malloc(data_size);
+  Bench_EncodeSignal(data, block_size, num_channels, num_blocks);
+  if (IMAADPCMWAVDecoder_DecodeHeader(data, data_size, &header) != IMAADPCM_APIRESULT_OK) {
+    fprintf(stderr, "Failed to decode header. \n");
+    exit(1);
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    /* 変換で窓が前後にはみ出す分を0で埋めておく */
+    whole[ch] = (int16_t *)calloc(header.num_samples + 2 * IMAADPCM_RESAMPLE_NUM_TAPS, sizeof(int16_t));
+    output[ch] = (int16_t *)malloc(sizeof(int16_t) * num_chunk_samples);
+  }
+
+  checksum = 0;
+  num_output_samples = 0;
+  start = clock();
+  for (itr = 0; itr < BENCH_NUM_ITERATIONS; itr++) {
+    if (IMAADPCMWAVDecoder_BeginResample(decoder, data, data_size,
+          output_sampling_rate, mode, &num_output_samples) != IMAADPCM_APIRESULT_OK) {
+      fprintf(stderr, "Failed to begin resample. \n");
+      exit(1);
+    }
+    if (use_fused) {
+      for (progress = 0; progress < num_output_samples; progress += num_decode_samples) {
+        if (IMAADPCMWAVDecoder_DecodeResample(decoder,
+              output, num_channels, num_chunk_samples, &num_decode_samples) != IMAADPCM_APIRESULT_OK) {
+          fprintf(stderr, "Failed to decode. \n");
+          exit(1);
+        }
+        checksum += (uint16_t)output[0][0];
+      }
+    } else {
+      /* 変換はデコーダと同じ位置の進め方・係数で行う */
+      const uint32_t num_taps = (mode == IMAADPCM_RESAMPLE_LINEAR) ? 2 : IMAADPCM_RESAMPLE_NUM_TAPS;
+      uint32_t position = 0, position_frac = 0;
+      const uint32_t step_int = decoder->resample.step_int, step_frac = decoder->resample.step_frac;
+      int16_t *whole_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+      for (ch = 0; ch < num_channels; ch++) {
+        whole_ptr[ch] = &whole[ch][IMAADPCM_RESAMPLE_NUM_TAPS];
+      }
+      if (IMAADPCMWAVDecoder_DecodeWhole(decoder,
+            data, data_size, whole_ptr, num_channels, header.num_samples) != IMAADPCM_APIRESULT_OK) {
+        fprintf(stderr, "Failed to decode. \n");
+        exit(1);
+      }
+      for (progress = 0; progress < num_output_samples; progress += num_chunk_samples) {
+        for (smpl = 0; (smpl < num_chunk_samples) && ((progress + smpl) < num_output_samples); smpl++) {
+          for (ch = 0; ch < num_channels; ch++) {
+            int32_t acc;
+            const int16_t *x = &whole[ch][IMAADPCM_RESAMPLE_NUM_TAPS + position - (num_taps / 2 - 1)];
+            if (mode == IMAADPCM_RESAMPLE_LINEAR) {
+              acc = x[0] + (((x[1] - x[0]) * (int32_t)(position_frac >> 17) + (1 << 14)) >> 15);
+            } else {
+              const int16_t *row = &decoder->resample.coef[(position_frac >> (32 - IMAADPCM_RESAMPLE_PHASE_BITS)) * IMAADPCM_RESAMPLE_NUM_TAPS];
+              acc = 0;
+              for (tap = 0; tap < num_taps; tap++) {
+                acc += row[tap] * x[tap];
+              }
+              acc = IMAADPCM_INNER_VAL((acc + (1 << 14)) >> 15, -32768, 32767);
+            }
+            output[ch][smpl] = (int16_t)acc;
+          }
+          position_frac += step_frac;
+          position += step_int + ((position_frac < step_frac) ? 1 : 0);
+        }
+        checksum += (uint16_t)output[0][0];
+      }
+    }
+  }
+  end = clock();
+  elapsed_sec = (double)(end - start) / CLOCKS_PER_SEC;
+
+  printf("%-16s %-9s ch:%d %8.3f [ns/sample] (checksum:%08X) \n",
+      use_fused ? "resample fused" : "resample 2-pass", (mode == IMAADPCM_RESAMPLE_LINEAR) ? "linear" : "polyphase",
+      num_channels, (elapsed_sec * 1.0e9) / ((double)num_output_samples * num_channels * BENCH_NUM_ITERATIONS), checksum);
+
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(whole[ch]);
+    free(output[ch]);
+  }
+  free(data);
+}
+
+/* レイアウト指定デコードの計測 */
+/* use_layout: 0 ならint16でファイル全体をデコードしてから変換, 1 ならデコードしながら変換 */
+static void Bench_DecodeLayout(uint16_t num_channels, IMAADPCMSampleFormat format, uint8_t interleaved, uint8_t use_layout)
+{
+  static const char *format_names[] = { "int16", "int32", "float32" };
+  static const size_t format_sizes[] = { sizeof(int16_t), sizeof(int32_t), sizeof(float) };
+  uint8_t *data;
+  uint32_t ch, smpl, itr, data_size, checksum, stride;
+  int16_t *whole[IMAADPCM_MAX_NUM_CHANNELS];
+  void *output[IMAADPCM_MAX_NUM_CHANNELS];
+  struct IMAADPCMWAVDecoder *decoder;
+  struct IMAADPCMWAVHeaderInfo header;
+  struct IMAADPCMOutputLayout layout;
+  clock_t start, end;
+  double elapsed_sec;
+  const uint16_t block_size = 1024;
+
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+
+  data_size = IMAADPCMWAVENCODER_HEADER_SIZE + (uint32_t)block_size * BENCH_NUM_BLOCKS;
+  data = (uint8_t *)malloc(data_size);
+  Bench_EncodeSignal(data, block_size, num_channels, BENCH_NUM_BLOCKS);
+  if (IMAADPCMWAVDecoder_DecodeHeader(data, data_size, &header) != IMAADPCM_APIRESULT_OK) {
+    fprintf(stderr, "Failed to decode header. \n");
+    exit(1);
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    whole[ch] = (int16_t *)malloc(sizeof(int16_t) * header.num_samples);
+    output[ch] = malloc(format_sizes[format] * header.num_samples * num_channels);
+  }
+  layout.sample_format = format;
+  layout.interleaved = interleaved;
+  stride = interleaved ? num_channels : 1;
+
+  checksum = 0;
+  start = clock();
+  for (itr = 0; itr < BENCH_NUM_ITERATIONS; itr++) {
+    if (use_layout) {
+      if (IMAADPCMWAVDecoder_DecodeWholeToLayout(decoder,
+            data, data_size, &layout, output, num_channels, header.num_samples) != IMAADPCM_APIRESULT_OK) {
+        fprintf(stderr, "Failed to decode. \n");
+        exit(1);
+      }
+    } else {
+      if (IMAADPCMWAVDecoder_DecodeWhole(decoder,
+            data, data_size, whole, num_channels, header.num_samples) != IMAADPCM_APIRESULT_OK) {
+        fprintf(stderr, "Failed to decode. \n");
+        exit(1);
+      }
+      for (ch = 0; ch < num_channels; ch++) {
+        void *dst = interleaved ? output[0] : output[ch];
+        const uint32_t offset = interleaved ? ch : 0;
+        for (smpl = 0; smpl < header.num_samples; smpl++) {
+          switch (format) {
+            case IMAADPCM_SAMPLE_FORMAT_INT16:
+              ((int16_t *)dst)[smpl * stride + offset] = whole[ch][smpl];
+              break;
+            case IMAADPCM_SAMPLE_FORMAT_INT32:
+              ((int32_t *)dst)[smpl * stride + offset] = (int32_t)whole[ch][smpl] * 65536;
+              break;
+            default:
+              ((float *)dst)[smpl * stride + offset] = (float)whole[ch][smpl] * (1.0f / 32768.0f);
+              break;
+          }
+        }
+      }
+    }
+    checksum += ((const uint8_t *)output[0])[format_sizes[format] * header.num_samples - 1];
+  }
+  end = clock();
+  elapsed_sec = (double)(end - start) / CLOCKS_PER_SEC;
+
+  printf("%-16s %-7s %-7s ch:%d %8.3f [ns/sample] (checksum:%08X) \n",
+      use_layout ? "layout direct" : "layout 2-pass", format_names[format], interleaved ? "interlv" : "planar",
+      num_channels, (elapsed_sec * 1.0e9) / ((double)header.num_samples * num_channels * BENCH_NUM_ITERATIONS), checksum);
+
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(whole[ch]);
+    free(output[ch]);
+  }
+  free(data);
+}
+
+/* レイアウト指定エンコードの計測 */
+/* use_layout: 0 ならint16のバッファを確保・変換してからエンコード, 1 ならエンコードしながら変換 */
+static void Bench_EncodeLayout(uint16_t num_channels, IMAADPCMSampleFormat format, uint8_t interleaved, uint8_t use_layout)
+{
+  static const char *format_names[] = { "int16", "int32", "float32" };
+  static const size_t format_sizes[] = { sizeof(int16_t), sizeof(int32_t), sizeof(float) };
+  uint8_t *data;
+  uint32_t ch, smpl, itr, data_size, num_samples, output_size, checksum, stride;
+  int16_t *converted[IMAADPCM_MAX_NUM_CHANNELS];
+  void *input[IMAADPCM_MAX_NUM_CHANNELS];
+  struct IMAADPCMWAVEncoder *encoder;
+  struct IMAADPCMWAVEncodeParameter enc_param;
+  struct IMAADPCMInputLayout layout;
+  clock_t start, end;
+  double elapsed_sec;
+  const uint16_t block_size = 1024;
+
+  encoder = IMAADPCMWAVEncoder_CreateParallel(1, NULL, 0);
+  enc_param.num_channels = num_channels;
+  enc_param.sampling_rate = 44100;
+  enc_param.bits_per_sample = IMAADPCM_BITS_PER_SAMPLE;
+  enc_param.block_size = block_size;
+  if (IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK) {
+    fprintf(stderr, "Failed to set encode parameter. \n");
+    exit(1);
+  }
+
+  /* 正弦波に雑音を加えた信号 */
+  num_samples = ((block_size - 4U * num_channels) * 2U / num_channels + 1U) * BENCH_NUM_BLOCKS;
+  stride = interleaved ? num_channels : 1;
+  srand(0);
+  for (ch = 0; ch < num_channels; ch++) {
+    input[ch] = malloc(format_sizes[format] * num_samples * num_channels);
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    void *dst = interleaved ? input[0] : input[ch];
+    const uint32_t offset = interleaved ? ch : 0;
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      const int16_t val = (int16_t)(8000.0 * sin(2.0 * BENCH_PI * 440.0 * smpl / 44100.0) + (rand() % 512) - 256);
+      switch (format) {
+        case IMAADPCM_SAMPLE_FORMAT_INT16:
+          ((int16_t *)dst)[smpl * stride + offset] = val;
+          break;
+        case IMAADPCM_SAMPLE_FORMAT_INT32:
+          ((int32_t *)dst)[smpl * stride + offset] = (int32_t)val * 65536;
+          break;
+        default:
+          ((float *)dst)[smpl * stride + offset] = (float)val / 32768.0f;
+          break;
+      }
+    }
+  }
+  data_size = IMAADPCMWAVENCODER_HEADER_SIZE + (uint32_t)block_size * BENCH_NUM_BLOCKS;
+  data = (uint8_t *)malloc(data_size);
+  layout.sample_format = format;
+  layout.interleaved = interleaved;
+
+  checksum = 0;
+  start = clock();
+  for (itr = 0; itr < BENCH_NUM_ITERATIONS; itr++) {
+    if (use_layout) {
+      if (IMAADPCMWAVEncoder_EncodeWholeParallelFromLayout(encoder, &layout,
+            (const void *const *)input, num_channels, num_samples,
+            data, data_size, &output_size, 1, NULL, NULL) != IMAADPCM_APIRESULT_OK) {
+        fprintf(stderr, "Failed to encode. \n");
+        exit(1);
+      }
+    } else {
+      /* 変換先の確保から計測する */
+      for (ch = 0; ch < num_channels; ch++) {
+        const void *src = interleaved ? input[0] : input[ch];
+        const uint32_t offset = interleaved ? ch : 0;
+        converted[ch] = (int16_t *)malloc(sizeof(int16_t) * num_samples);
+        for (smpl = 0; smpl < num_samples; smpl++) {
+          switch (format) {
+            case IMAADPCM_SAMPLE_FORMAT_INT16:
+              converted[ch][smpl] = ((const int16_t *)src)[smpl * stride + offset];
+              break;
+            case IMAADPCM_SAMPLE_FORMAT_INT32:
+              converted[ch][smpl] = (int16_t)(((const int32_t *)src)[smpl * stride + offset] >> 16);
+              break;
+            default:
+              {
+                const float val = ((const float *)src)[smpl * stride + offset] * 32768.0f;
+                converted[ch][smpl] = (int16_t)IMAADPCM_INNER_VAL(floor(val + 0.5f), -32768.0f, 32767.0f);
+              }
+              break;
+          }
+        }
+      }
+      if (IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+            (const int16_t *const *)converted, num_samples, data, data_size, &output_size, 1, NULL, NULL) != IMAADPCM_APIRESULT_OK) {
+        fprintf(stderr, "Failed to encode. \n");
+        exit(1);
+      }
+      for (ch = 0; ch < num_channels; ch++) {
+        free(converted[ch]);
+      }
+    }
+    checksum += data[output_size - 1];
+  }
+  end = clock();
+  elapsed_sec = (double)(end - start) / CLOCKS_PER_SEC;
+
+  printf("%-16s %-7s %-7s ch:%d %8.3f [ns/sample] (checksum:%08X) \n",
+      use_layout ? "encode layout" : "encode convert", format_names[format], interleaved ? "interlv" : "planar",
+      num_channels, (elapsed_sec * 1.0e9) / ((double)num_samples * num_channels * BENCH_NUM_ITERATIONS), checksum);
+
+  IMAADPCMWAVEncoder_Destroy(encoder);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(input[ch]);
+  }
+  free(data);
+}
+
+int main(void)
+{
+  uint8_t use_signal;
+
+  for (use_signal = 0; use_signal <= 1; use_signal++) {
+    Bench_DecodeBlock(1,  256, use_signal);
+    Bench_DecodeBlock(1, 1024, use_signal);
+    Bench_DecodeBlock(2,  256, use_signal);
+    Bench_DecodeBlock(2, 1024, use_signal);
+  }
+
+  Bench_DecodeWhole(1, 1024, IMAADPCM_KERNEL_AUTO);
+  Bench_DecodeWhole(1, 1024, IMAADPCM_KERNEL_SCALAR);
+  Bench_DecodeWhole(1, 1024, IMAADPCM_KERNEL_SSE41);
+  Bench_DecodeWhole(1, 1024, IMAADPCM_KERNEL_AVX2);
+  Bench_DecodeWhole(2, 1024, IMAADPCM_KERNEL_AUTO);
+  Bench_DecodeWhole(2, 1024, IMAADPCM_KERNEL_SCALAR);
+  Bench_DecodeWhole(2, 1024, IMAADPCM_KERNEL_SSE41);
+  Bench_DecodeWhole(2, 1024, IMAADPCM_KERNEL_AVX2);
+
+  Bench_EncodeWhole(1, 1024, IMAADPCM_KERNEL_AUTO);
+  Bench_EncodeWhole(1, 1024, IMAADPCM_KERNEL_SCALAR);
+  Bench_EncodeWhole(1, 1024, IMAADPCM_KERNEL_SSE41);
+  Bench_EncodeWhole(1, 1024, IMAADPCM_KERNEL_AVX2);
+  Bench_EncodeWhole(2, 1024, IMAADPCM_KERNEL_AUTO);
+  Bench_EncodeWhole(2, 1024, IMAADPCM_KERNEL_SCALAR);
+  Bench_EncodeWhole(2, 1024, IMAADPCM_KERNEL_SSE41);
+  Bench_EncodeWhole(2, 1024, IMAADPCM_KERNEL_AVX2);
+
+  Bench_DecoderBank(1024, 0, IMAADPCM_KERNEL_AUTO);
+  Bench_DecoderBank(1024, 1, IMAADPCM_KERNEL_AUTO);
+  Bench_DecoderBank(1024, 1, IMAADPCM_KERNEL_SCALAR);
+  Bench_DecoderBank(1024, 1, IMAADPCM_KERNEL_SSE41);
+  Bench_DecoderBank(1024, 1, IMAADPCM_KERNEL_AVX2);
+
+  Bench_DecodeMix(1, 64, 0);
+  Bench_DecodeMix(1, 64, 1);
+  Bench_DecodeMix(2, 64, 0);
+  Bench_DecodeMix(2, 64, 1);
+
+  Bench_DecodeResample(1, IMAADPCM_RESAMPLE_LINEAR, 0);
+  Bench_DecodeResample(1, IMAADPCM_RESAMPLE_LINEAR, 1);
+  Bench_DecodeResample(1, IMAADPCM_RESAMPLE_POLYPHASE, 0);
+  Bench_DecodeResample(1, IMAADPCM_RESAMPLE_POLYPHASE, 1);
+  Bench_DecodeResample(2, IMAADPCM_RESAMPLE_LINEAR, 0);
+  Bench_DecodeResample(2, IMAADPCM_RESAMPLE_LINEAR, 1);
+  Bench_DecodeResample(2, IMAADPCM_RESAMPLE_POLYPHASE, 0);
+  Bench_DecodeResample(2, IMAADPCM_RESAMPLE_POLYPHASE, 1);
+
+  Bench_DecodeLayout(2, IMAADPCM_SAMPLE_FORMAT_INT16, 1, 0);
+  Bench_DecodeLayout(2, IMAADPCM_SAMPLE_FORMAT_INT16, 1, 1);
+  Bench_DecodeLayout(2, IMAADPCM_SAMPLE_FORMAT_INT32, 0, 0);
+  Bench_DecodeLayout(2, IMAADPCM_SAMPLE_FORMAT_INT32, 0, 1);
+  Bench_DecodeLayout(2, IMAADPCM_SAMPLE_FORMAT_FLOAT32, 1, 0);
+  Bench_DecodeLayout(2, IMAADPCM_SAMPLE_FORMAT_FLOAT32, 1, 1);
+
+  Bench_EncodeLayout(2, IMAADPCM_SAMPLE_FORMAT_INT16, 1, 0);
+  Bench_EncodeLayout(2, IMAADPCM_SAMPLE_FORMAT_INT16, 1, 1);
+  Bench_EncodeLayout(2, IMAADPCM_SAMPLE_FORMAT_INT32, 0, 0);
+  Bench_EncodeLayout(2, IMAADPCM_SAMPLE_FORMAT_INT32, 0, 1);
+  Bench_EncodeLayout(2, IMAADPCM_SAMPLE_FORMAT_FLOAT32, 1, 0);
+  Bench_EncodeLayout(2, IMAADPCM_SAMPLE_FORMAT_FLOAT32, 1, 1);
+
+  return 0;
+}
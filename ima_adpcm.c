@@ -5,6 +5,14 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+
+/* x86系SIMD命令の使用可否 */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IMAADPCM_USE_X86_SIMD
+#include <immintrin.h>
+#include <cpuid.h>
+#endif
 
 /* アラインメント */
 #define IMAADPCM_ALIGNMENT              16
@@ -12,6 +20,21 @@
 /* エンコード時に書き出すヘッダサイズ（データブロック直前までのファイルサイズ） */
 #define IMAADPCMWAVENCODER_HEADER_SIZE  60
 
+/* ds64チャンクのサイズ（チャンクID・サイズ + RIFFサイズ・dataサイズ・サンプル数・テーブル長） */
+#define IMAADPCM_DS64_CHUNK_SIZE        36
+
+/* RF64形式でエンコード時に書き出すヘッダサイズ（ds64チャンク、またはその予約領域のJUNKチャンクを含む） */
+#define IMAADPCMWAVENCODER_RF64_HEADER_SIZE (IMAADPCMWAVENCODER_HEADER_SIZE + IMAADPCM_DS64_CHUNK_SIZE)
+
+/* WAVE_FORMAT_EXTENSIBLE形式のfmtチャンクで増えるサイズ（cbSize 2 -> 22） */
+#define IMAADPCM_EXTENSIBLE_FMT_EXTRA_SIZE 20
+
+/* エンコード時に書き出すヘッダサイズの最大値 */
+#define IMAADPCMWAVENCODER_MAX_HEADER_SIZE (IMAADPCMWAVENCODER_RF64_HEADER_SIZE + IMAADPCM_EXTENSIBLE_FMT_EXTRA_SIZE)
+
+/* WAVE_FORMAT_EXTENSIBLE形式のfmtチャンクを使うか（3チャンネル以上、またはチャンネル配置の指定あり） */
+#define IMAADPCM_USE_EXTENSIBLE_FORMAT(num_channels) ((num_channels) > 2)
+
 /* nの倍数への切り上げ */
 #define IMAADPCM_ROUND_UP(val, n) ((((val) + ((n) - 1)) / (n)) * (n))
 
@@ -29,6 +52,47 @@
 #define IMAADPCM_CALCULATE_DATASIZE_BYTE(num_samples, bits_per_sample) \
   (IMAADPCM_ROUND_UP((num_samples) * (bits_per_sample), 8) / 8)
 
+/* ブロックサイズの最大値（ヘッダ上は16bit） */
+#define IMAADPCM_MAX_BLOCK_SIZE         65535
+
+/* シークインデックスのヘッダサイズ（チャンクID・サイズ + シーク点間隔・チャンネル数・ブロックサイズ・シーク点数） */
+#define IMAADPCM_SEEKINDEX_HEADER_SIZE  20
+
+/* リサンプリングの多相フィルタのタップ数 */
+#define IMAADPCM_RESAMPLE_NUM_TAPS      16
+
+/* リサンプリングの多相フィルタの位相数（2の冪） 入力位置の小数部（32bit）の上位ビットで位相を選ぶ */
+#define IMAADPCM_RESAMPLE_PHASE_BITS    8
+#define IMAADPCM_RESAMPLE_NUM_PHASES    (1 << IMAADPCM_RESAMPLE_PHASE_BITS)
+
+/* リサンプリングの入力履歴の長さ（フィルタ長 + まとめてデコードするサンプル数） */
+#define IMAADPCM_RESAMPLE_HISTORY_LENGTH (IMAADPCM_RESAMPLE_NUM_TAPS + 64)
+
+/* リサンプリングの多相フィルタの遮断周波数（入出力の低い方のナイキスト周波数に対する比） */
+#define IMAADPCM_RESAMPLE_CUTOFF        0.9
+
+/* 円周率 */
+#define IMAADPCM_PI                     3.14159265358979323846
+
+/* 浮動小数点バスへのミックスの係数（16bitサンプルとQ15ゲインの積を[-1,1]に正規化） */
+#define IMAADPCM_MIX_FLOAT_SCALE        (1.0f / (32768.0f * 32768.0f))
+
+/* 複数ブロック同時デコードでまとめて処理するブロック数（SIMDレーン数） */
+#define IMAADPCM_NUM_SIMD_LANES         8
+
+/* レイアウト指定デコード・エンコードでint16のまま一旦処理するタイルのサンプル数（全チャンネル合計） */
+/* チャンネル数で等分して使う 1024byteまでのブロックならチャンネル数によらず同時処理の全レーン分が収まる */
+/* 呼び出しスレッドではタイルをスタックに置くため、最大チャンネル数を増やしても大きくならないようにする */
+/* 並列処理のタスクが使うタイルはハンドルのワーク領域に置く（実行スレッドのスタックは小さいことがある） */
+#define IMAADPCM_LAYOUT_TILE_NUM_SAMPLES (IMAADPCM_NUM_SIMD_LANES * 2048)
+
+/* CPU機能フラグ */
+#define IMAADPCM_CPU_FEATURE_SSE41      (1 << 0)  /* SSE4.1 */
+#define IMAADPCM_CPU_FEATURE_AVX2       (1 << 1)  /* AVX2   */
+
+/* カーネルを強制指定する環境変数名 */
+#define IMAADPCM_KERNEL_ENVIRONMENT_VARIABLE "IMAADPCM_KERNEL"
+
 /* FourCCの一致確認 */
 #define IMAADPCM_CHECK_FOURCC(u32lebuf, c1, c2, c3, c4) \
   ((u32lebuf) == ((c1 << 0) | (c2 << 8) | (c3 << 16) | (c4 << 24)))
@@ -49,11 +113,83 @@ struct IMAADPCMCoreDecoder {
   int8_t  stepsize_index;         /* ステップサイズテーブルの参照インデックス     */
 };
 
+/* 複数ブロック同時デコード関数型 */
+typedef void (*IMAADPCMDecodeBlocksFunction)(
+    const uint8_t *data, uint32_t block_size, uint32_t num_channels,
+    uint32_t num_samples_per_block, int16_t **buffer);
+
+/* ブロックデコード関数型 */
+typedef IMAADPCMError (*IMAADPCMDecodeBlockFunction)(
+    struct IMAADPCMCoreDecoder *core_decoder, uint32_t num_channels,
+    const uint8_t *read_pos, uint32_t data_size,
+    int16_t **buffer, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
+/* デコード関数テーブル */
+struct IMAADPCMDecodeFunctions {
+  IMAADPCMDecodeBlockFunction   decode_block[IMAADPCM_MAX_NUM_CHANNELS];  /* ブロックデコード（チャンネル数-1で参照）                 */
+  IMAADPCMDecodeBlocksFunction  decode_blocks[IMAADPCM_MAX_NUM_CHANNELS]; /* 複数ブロック同時デコード（チャンネル数-1で参照, 無ければNULL） */
+};
+
+/* ストリーミングデコードの処理段階 */
+typedef enum IMAADPCMDecodeStreamStageTag {
+  IMAADPCM_DECODESTREAM_STAGE_RIFF = 0,       /* RIFFヘッダ読み込み中                 */
+  IMAADPCM_DECODESTREAM_STAGE_CHUNK_HEADER,   /* チャンクID・サイズ読み込み中         */
+  IMAADPCM_DECODESTREAM_STAGE_CHUNK_BODY,     /* fmt, factチャンク本体読み込み中      */
+  IMAADPCM_DECODESTREAM_STAGE_SKIP_CHUNK,     /* その他のチャンクの読み飛ばし中       */
+  IMAADPCM_DECODESTREAM_STAGE_BLOCK           /* データブロック読み込み中             */
+} IMAADPCMDecodeStreamStage;
+
+/* ストリーミングデコードの状態 */
+struct IMAADPCMDecodeStream {
+  uint8_t                   started;                                        /* 開始済みか                             */
+  IMAADPCMDecodeStreamStage stage;                                          /* 処理段階                               */
+  uint64_t                  read_offset;                                    /* ファイル先頭から読み込んだサイズ       */
+  uint32_t                  chunk_size;                                     /* 読み込み・読み飛ばし中のチャンクサイズ */
+  uint32_t                  progress;                                       /* デコード済みサンプル数                 */
+  uint32_t                  header_image_size;                              /* ヘッダ像のサイズ                       */
+  uint8_t                   header_image[IMAADPCMWAVENCODER_MAX_HEADER_SIZE]; /* 読み飛ばすチャンクを除いたヘッダ像    */
+  uint32_t                  buffered_size;                                  /* 一時バッファ内のデータサイズ           */
+  uint8_t                   *buffer;                                        /* チャンク・ブロックの一時バッファ（IMAADPCM_MAX_BLOCK_SIZE, ストリーミング用のハンドルのみ） */
+};
+
+/* リサンプリングデコードの状態 */
+/* 入力は先頭に(タップ数/2 - 1)個、末尾以降に無限個の0を詰めた列として扱い、出力位置に対応する入力位置からタップ数分を窓として参照する */
+struct IMAADPCMResampleStream {
+  uint8_t                       started;                                /* 開始済みか                                     */
+  IMAADPCMResampleMode          mode;                                   /* リサンプリング方式                             */
+  const uint8_t                 *data;                                  /* ファイル先頭                                   */
+  struct IMAADPCMWAVHeaderInfo  header;                                 /* 入力のヘッダ情報                               */
+  uint32_t                      num_samples_per_block;                  /* ブロックあたりサンプル数                       */
+  struct IMAADPCMCoreDecoder    core_decoder[IMAADPCM_MAX_NUM_CHANNELS]; /* ブロック途中のデコーダの状態                */
+  uint32_t                      num_taps;                               /* 窓のサンプル数                                 */
+  uint32_t                      read_progress;                          /* 0を詰めた入力列の読み込み済みサンプル数       */
+  uint64_t                      block_offset;                           /* デコード中のブロックのファイル先頭からの位置   */
+  uint32_t                      block_progress;                         /* デコード中のブロック内の次のサンプル位置       */
+  uint32_t                      num_output_samples;                     /* 総出力サンプル数                               */
+  uint32_t                      output_progress;                        /* 出力済みサンプル数                             */
+  uint32_t                      position;                               /* 次の出力の窓の先頭位置（0を詰めた入力列上）   */
+  uint32_t                      position_frac;                          /* 次の出力の入力位置の小数部（32bit固定小数）   */
+  uint32_t                      step_int;                               /* 出力1サンプルあたりの入力位置の進み（整数部） */
+  uint32_t                      step_frac;                              /* 出力1サンプルあたりの入力位置の進み（小数部） */
+  uint32_t                      history_start;                          /* 履歴先頭の位置（0を詰めた入力列上）           */
+  uint32_t                      history_length;                         /* 履歴内のサンプル数                             */
+  int16_t                       history[IMAADPCM_MAX_NUM_CHANNELS][IMAADPCM_RESAMPLE_HISTORY_LENGTH]; /* 入力の履歴 */
+  int16_t                       *coef;                                  /* 多相フィルタ係数（位相毎にタップ数分, Q15）   */
+};
+
 /* デコーダ */
 struct IMAADPCMWAVDecoder {
-  struct IMAADPCMWAVHeaderInfo  header;
-  struct IMAADPCMCoreDecoder    core_decoder[IMAADPCM_MAX_NUM_CHANNELS];
-  void                          *work;
+  struct IMAADPCMWAVHeaderInfo    header;
+  struct IMAADPCMCoreDecoder      core_decoder[IMAADPCM_MAX_NUM_CHANNELS];
+  IMAADPCMKernel                  kernel;
+  struct IMAADPCMDecodeFunctions  functions;
+  struct IMAADPCMDecodeStream     stream;
+  struct IMAADPCMResampleStream   resample;
+  uint32_t                        max_num_tasks;  /* 並列デコードの最大タスク数（0なら呼び出しスレッドで逐次デコード） */
+  struct IMAADPCMWAVDecoder       *task_decoder;  /* タスク毎のデコーダの状態（max_num_tasks個）                   */
+  int16_t                         *task_tile;     /* タスク毎のタイル（IMAADPCM_LAYOUT_TILE_NUM_SAMPLES * max_num_tasks） */
+  void                            *work;
 };
 
 /* コア処理エンコーダ */
@@ -62,11 +198,100 @@ struct IMAADPCMCoreEncoder {
   int8_t  stepsize_index;         /* ステップサイズテーブルの参照インデックス     */
 };
 
+/* ブロックエンコード関数型 */
+typedef IMAADPCMError (*IMAADPCMEncodeBlockFunction)(
+    struct IMAADPCMCoreEncoder *core_encoder, uint32_t num_channels,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size);
+
+/* 複数ブロック同時エンコード関数型 */
+/* start_indexはチャンネル毎に各レーン先頭のステップサイズインデックスを並べたもの */
+typedef void (*IMAADPCMEncodeBlocksFunction)(
+    const int16_t *const *input, const int8_t *start_index, uint32_t num_channels,
+    uint32_t num_samples_per_block, uint32_t block_size, uint8_t *data);
+
+/* エンコード関数テーブル */
+struct IMAADPCMEncodeFunctions {
+  IMAADPCMEncodeBlockFunction   encode_block[IMAADPCM_MAX_NUM_CHANNELS];  /* ブロックエンコード（チャンネル数-1で参照）                 */
+  IMAADPCMEncodeBlocksFunction  encode_blocks[IMAADPCM_MAX_NUM_CHANNELS]; /* 複数ブロック同時エンコード（チャンネル数-1で参照, 無ければNULL） */
+};
+
+/* ストリーミングエンコードの状態 */
+struct IMAADPCMEncodeStream {
+  uint8_t                     started;                                /* 開始済みか                                     */
+  uint8_t                     reserve_ds64;                           /* ヘッダにds64チャンクの領域を予約したか         */
+  uint32_t                    num_samples;                            /* 供給された総サンプル数                         */
+  uint32_t                    num_samples_per_block;                  /* ブロックあたりサンプル数                       */
+  uint32_t                    block_progress;                         /* ブロック内で次に処理するサンプル位置           */
+  struct IMAADPCMCoreEncoder  core_encoder[IMAADPCM_MAX_NUM_CHANNELS];
+  uint32_t                    codes[IMAADPCM_MAX_NUM_CHANNELS];       /* 書き出し単位に満たないニブル列                 */
+  int16_t                     last_sample[IMAADPCM_MAX_NUM_CHANNELS]; /* 直前のサンプル（末尾の埋め合わせに使う）       */
+};
+
 /* エンコーダ */
 struct IMAADPCMWAVEncoder {
   struct IMAADPCMWAVEncodeParameter encode_paramemter;
   uint8_t                           set_parameter;
+  uint32_t                          channel_mask;
   struct IMAADPCMCoreEncoder        core_encoder[IMAADPCM_MAX_NUM_CHANNELS];
+  IMAADPCMKernel                    kernel;
+  struct IMAADPCMEncodeFunctions    functions;
+  struct IMAADPCMEncodeStream       stream;
+  uint32_t                          max_num_tasks;  /* 並列エンコードの最大タスク数（0なら呼び出しスレッドでエンコード） */
+  struct IMAADPCMWAVEncoder         *task_encoder;  /* タスク毎のエンコーダの状態（max_num_tasks個）                     */
+  int16_t                           *task_tile;     /* タスク毎のタイル（IMAADPCM_LAYOUT_TILE_NUM_SAMPLES * max_num_tasks） */
+  void                              *work;
+};
+
+/* デコーダバンクで1度に処理するステップ（サンプル）数 */
+#define IMAADPCM_DECODERBANK_NUM_STEPS  32
+
+/* デコーダバンクで1レーングループ（IMAADPCM_NUM_SIMD_LANESレーン）に割り当てるストリーム数 */
+#define IMAADPCM_DECODERBANK_NUM_STREAMS_PER_GROUP (IMAADPCM_NUM_SIMD_LANES / IMAADPCM_DECODERBANK_MAX_NUM_CHANNELS)
+
+/* デコーダバンクのリセットを表すニブル値（これ以上の値はニブルではなくリセット） */
+#define IMAADPCM_DECODERBANK_RESET_NIBBLE 0x10
+
+/* デコーダバンクの1レーングループ分の入力列 */
+struct IMAADPCMDecoderBankSteps {
+  uint8_t nibble[IMAADPCM_DECODERBANK_NUM_STEPS][IMAADPCM_NUM_SIMD_LANES];       /* ニブル（リセットの場合はIMAADPCM_DECODERBANK_RESET_NIBBLE） */
+  int32_t reset_sample[IMAADPCM_DECODERBANK_NUM_STEPS][IMAADPCM_NUM_SIMD_LANES]; /* リセット後のサンプル値（リセットするレーンのみ有効）         */
+  int32_t reset_index[IMAADPCM_DECODERBANK_NUM_STEPS][IMAADPCM_NUM_SIMD_LANES];  /* リセット後のステップサイズインデックス（同上）               */
+};
+
+/* デコーダバンクのレーングループ処理関数型 */
+/* predict, indexはIMAADPCM_NUM_SIMD_LANESレーン分の状態 各ステップの全レーンのサンプルをoutputにoutput_stride間隔で書き出す */
+typedef void (*IMAADPCMDecoderBankStepFunction)(
+    const struct IMAADPCMDecoderBankSteps *steps, uint32_t num_steps,
+    int32_t *predict, int32_t *index, int16_t *output, uint32_t output_stride);
+
+/* デコーダバンクのストリーム状態 */
+struct IMAADPCMDecoderBankStream {
+  const uint8_t *data;                  /* ファイル先頭                                         */
+  uint32_t      data_size;              /* ファイルサイズ                                       */
+  uint32_t      block_offset;           /* デコード中のブロックのファイル先頭からのオフセット   */
+  uint32_t      block_progress;         /* ブロック内で次にデコードするサンプル位置             */
+  uint32_t      num_remain_samples;     /* 残りサンプル数                                       */
+  uint32_t      num_samples_per_block;  /* ブロックあたりサンプル数                             */
+  uint16_t      num_channels;           /* チャンネル数                                         */
+  uint16_t      block_size;             /* ブロックサイズ                                       */
+  uint8_t       active;                 /* 使用中か                                             */
+  uint8_t       broken;                 /* 不正なブロックヘッダで停止したか                     */
+};
+
+/* デコーダバンク */
+/* レーン（ストリームID * IMAADPCM_DECODERBANK_MAX_NUM_CHANNELS + チャンネル）毎のデコーダの状態を配列で持つ */
+struct IMAADPCMDecoderBank {
+  uint32_t                          max_num_streams;
+  uint32_t                          num_groups;     /* レーングループ数                   */
+  struct IMAADPCMDecoderBankStream  *streams;
+  int32_t                           *predict;       /* レーン毎のサンプル値               */
+  int32_t                           *index;         /* レーン毎のステップサイズインデックス */
+  uint32_t                          *codes;         /* レーン毎の読み込み中のワード       */
+  uint32_t                          *free_ids;      /* 空きストリームIDのスタック         */
+  uint32_t                          num_free_ids;
+  IMAADPCMKernel                    kernel;
+  IMAADPCMDecoderBankStepFunction   decode_steps;
   void                              *work;
 };
 
@@ -76,18 +301,93 @@ static int16_t IMAADPCMCoreDecoder_DecodeSample(
 
 /* モノラルブロックのデコード */
 static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockMono(
-    struct IMAADPCMCoreDecoder *core_decoder,
+    struct IMAADPCMCoreDecoder *core_decoder, uint32_t num_channels,
     const uint8_t *read_pos, uint32_t data_size, 
     int16_t **buffer, uint32_t buffer_num_samples,
     uint32_t *num_decode_samples);
 
 /* ステレオブロックのデコード */
 static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockStereo(
-    struct IMAADPCMCoreDecoder *core_decoder,
+    struct IMAADPCMCoreDecoder *core_decoder, uint32_t num_channels,
     const uint8_t *read_pos, uint32_t data_size, 
     int16_t **buffer, uint32_t buffer_num_samples, 
     uint32_t *num_decode_samples);
 
+/* 多チャンネルブロックのデコード準備 */
+static IMAADPCMError IMAADPCMWAVDecoder_PrepareMultichannelBlock(
+    struct IMAADPCMCoreDecoder *core_decoder, uint32_t num_channels,
+    const uint8_t *read_pos, uint32_t data_size,
+    int16_t **buffer, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
+/* 多チャンネル（3チャンネル以上）ブロックのデコード */
+static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockMultichannel(
+    struct IMAADPCMCoreDecoder *core_decoder, uint32_t num_channels,
+    const uint8_t *read_pos, uint32_t data_size,
+    int16_t **buffer, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
+/* 実行中のCPUで使用可能な機能フラグを取得 */
+static uint32_t IMAADPCM_GetCPUFeatures(void);
+
+/* 実行中のCPUでカーネルが使用可能か 使用可能ならば1を返す */
+static uint8_t IMAADPCM_IsKernelAvailable(IMAADPCMKernel kernel);
+
+/* ハンドル作成時に使うカーネルの取得 */
+static IMAADPCMKernel IMAADPCM_GetDefaultKernel(void);
+
+/* デコード関数テーブルの設定 */
+static void IMAADPCMWAVDecoder_BindKernel(
+    struct IMAADPCMWAVDecoder *decoder, IMAADPCMKernel kernel);
+
+/* エンコード関数テーブルの設定 */
+static void IMAADPCMWAVEncoder_BindKernel(
+    struct IMAADPCMWAVEncoder *encoder, IMAADPCMKernel kernel);
+
+/* ブロック内の一部のサンプルをデコード */
+static IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeBlockPartial(
+    struct IMAADPCMWAVDecoder *decoder, const uint8_t *block_data,
+    uint32_t begin_sample, uint32_t skip_samples, uint32_t num_samples, int16_t **buffer);
+
+/* ブロックあたりサンプル数の計算 */
+static uint32_t IMAADPCMWAVDecoder_CalculateNumSamplesPerBlock(const struct IMAADPCMWAVHeaderInfo *header);
+
+/* 指定サンプル数のブロックをエンコードした時の出力サイズ[byte]を計算 */
+static uint32_t IMAADPCMWAVEncoder_CalculateBlockOutputSize(uint32_t num_channels, uint32_t num_samples);
+
+/* ヘッダ情報の総サンプル数をエンコードした時のdataチャンクのサイズ[byte]を計算 */
+static uint64_t IMAADPCMWAVEncoder_CalculateDataChunkSize(const struct IMAADPCMWAVHeaderInfo *header);
+
+/* dataチャンクのサイズからエンコード時のヘッダサイズ[byte]を計算 */
+static uint32_t IMAADPCMWAVEncoder_CalculateHeaderSize(
+    const struct IMAADPCMWAVHeaderInfo *header, uint64_t data_chunk_size, uint8_t reserve_ds64);
+
+#if defined(IMAADPCM_USE_X86_SIMD)
+/* 複数ブロックの同時デコード（SSE4.1） */
+static void IMAADPCMWAVDecoder_DecodeBlocksSSE41(
+    const uint8_t *data, uint32_t block_size, uint32_t num_channels,
+    uint32_t num_samples_per_block, int16_t **buffer);
+
+/* 複数ブロックの同時デコード（AVX2） */
+static void IMAADPCMWAVDecoder_DecodeBlocksAVX2(
+    const uint8_t *data, uint32_t block_size, uint32_t num_channels,
+    uint32_t num_samples_per_block, int16_t **buffer);
+
+/* 多チャンネルブロックのデコード（SSE4.1） */
+static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockMultichannelSSE41(
+    struct IMAADPCMCoreDecoder *core_decoder, uint32_t num_channels,
+    const uint8_t *read_pos, uint32_t data_size,
+    int16_t **buffer, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
+/* 多チャンネルブロックのデコード（AVX2） */
+static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockMultichannelAVX2(
+    struct IMAADPCMCoreDecoder *core_decoder, uint32_t num_channels,
+    const uint8_t *read_pos, uint32_t data_size,
+    int16_t **buffer, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+#endif
+
 /* 単一データブロックエンコード */
 /* デコードとは違いstaticに縛る: エンコーダが内部的に状態を持ち、連続でEncodeBlockを呼ぶ必要があるから */
 static IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeBlock(
@@ -97,15 +397,75 @@ static IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeBlock(
 
 /* モノラルブロックのエンコード */
 static IMAADPCMError IMAADPCMWAVEncoder_EncodeBlockMono(
-    struct IMAADPCMCoreEncoder *core_encoder,
+    struct IMAADPCMCoreEncoder *core_encoder, uint32_t num_channels,
     const int16_t *const *input, uint32_t num_samples,
     uint8_t *data, uint32_t data_size, uint32_t *output_size);
 
 /* ステレオブロックのエンコード */
 static IMAADPCMError IMAADPCMWAVEncoder_EncodeBlockStereo(
-    struct IMAADPCMCoreEncoder *core_encoder,
+    struct IMAADPCMCoreEncoder *core_encoder, uint32_t num_channels,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size);
+
+/* 多チャンネルブロックのエンコード準備 */
+static IMAADPCMError IMAADPCMWAVEncoder_PrepareMultichannelBlock(
+    struct IMAADPCMCoreEncoder *core_encoder, uint32_t num_channels,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size);
+
+/* 多チャンネル（3チャンネル以上）ブロックのエンコード */
+static IMAADPCMError IMAADPCMWAVEncoder_EncodeBlockMultichannel(
+    struct IMAADPCMCoreEncoder *core_encoder, uint32_t num_channels,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size);
+
+/* ストリーミングエンコードで1サンプル（全チャンネル分）を処理し、確定したデータを書き出す */
+static uint32_t IMAADPCMWAVEncoder_EncodeStreamSample(
+    struct IMAADPCMWAVEncoder *encoder, const int16_t *const *input, uint32_t smpl, uint8_t *data);
+
+#if defined(IMAADPCM_USE_X86_SIMD)
+/* 複数ブロックの同時エンコード（SSE4.1） */
+static void IMAADPCMWAVEncoder_EncodeBlocksSSE41(
+    const int16_t *const *input, const int8_t *start_index, uint32_t num_channels,
+    uint32_t num_samples_per_block, uint32_t block_size, uint8_t *data);
+
+/* 複数ブロックの同時エンコード（AVX2） */
+static void IMAADPCMWAVEncoder_EncodeBlocksAVX2(
+    const int16_t *const *input, const int8_t *start_index, uint32_t num_channels,
+    uint32_t num_samples_per_block, uint32_t block_size, uint8_t *data);
+
+/* 多チャンネルブロックのエンコード（SSE4.1） */
+static IMAADPCMError IMAADPCMWAVEncoder_EncodeBlockMultichannelSSE41(
+    struct IMAADPCMCoreEncoder *core_encoder, uint32_t num_channels,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size);
+
+/* 多チャンネルブロックのエンコード（AVX2） */
+static IMAADPCMError IMAADPCMWAVEncoder_EncodeBlockMultichannelAVX2(
+    struct IMAADPCMCoreEncoder *core_encoder, uint32_t num_channels,
     const int16_t *const *input, uint32_t num_samples,
     uint8_t *data, uint32_t data_size, uint32_t *output_size);
+#endif
+
+/* デコーダバンクのレーングループ処理（スカラ） */
+static void IMAADPCMDecoderBank_DecodeStepsScalar(
+    const struct IMAADPCMDecoderBankSteps *steps, uint32_t num_steps,
+    int32_t *predict, int32_t *index, int16_t *output, uint32_t output_stride);
+
+#if defined(IMAADPCM_USE_X86_SIMD)
+/* デコーダバンクのレーングループ処理（SSE4.1） */
+static void IMAADPCMDecoderBank_DecodeStepsSSE41(
+    const struct IMAADPCMDecoderBankSteps *steps, uint32_t num_steps,
+    int32_t *predict, int32_t *index, int16_t *output, uint32_t output_stride);
+
+/* デコーダバンクのレーングループ処理（AVX2） */
+static void IMAADPCMDecoderBank_DecodeStepsAVX2(
+    const struct IMAADPCMDecoderBankSteps *steps, uint32_t num_steps,
+    int32_t *predict, int32_t *index, int16_t *output, uint32_t output_stride);
+#endif
+
+/* ブロック先頭のステップサイズインデックス推定に使う直前のサンプル数 */
+#define IMAADPCM_INDEX_ESTIMATION_NUM_SAMPLES 32
 
 /* インデックス変動テーブル */
 static const int8_t IMAADPCM_index_table[16] = {
@@ -114,7 +474,8 @@ static const int8_t IMAADPCM_index_table[16] = {
 };
 
 /* ステップサイズ量子化テーブル */
-static const uint16_t IMAADPCM_stepsize_table[89] = {
+/* 末尾の0は番兵: SIMDの32bitギャザで末尾要素を読んだ時に配列外を読まないため */
+static const uint16_t IMAADPCM_stepsize_table[89 + 1] = {
       7,     8,     9,    10,    11,    12,    13,    14, 
      16,    17,    19,    21,    23,    25,    28,    31, 
      34,    37,    41,    45,    50,    55,    60,    66,
@@ -126,17 +487,290 @@ static const uint16_t IMAADPCM_stepsize_table[89] = {
    3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,
    7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
   15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
-  32767
+  32767, 0
 };
 
-/* ワークサイズ計算 */
-int32_t IMAADPCMWAVDecoder_CalculateWorkSize(void)
+/* WAVE_FORMAT_EXTENSIBLE形式のサブフォーマットGUID（IMA-ADPCM: 00000011-0000-0010-8000-00AA00389B71） */
+static const uint8_t IMAADPCM_extensible_subformat_guid[16] = {
+  0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+  0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+};
+
+/* ニブルに対応するインデックス変動量（IMAADPCM_index_tableの定数式版） */
+#define IMAADPCM_INDEX_DELTA(nibble) \
+  ((((nibble) & 7) < 4) ? -1 : ((((nibble) & 7) << 1) - 6))
+
+/* 遷移テーブルの要素: 上位ビットに符号付き差分、下位8bitに次のステップサイズインデックスを詰める */
+#define IMAADPCM_TRANSITION_ENTRY(index, stepsize, nibble)                              \
+  ((((nibble) & 8) ? -1 : 1) * (((stepsize) * ((((nibble) & 7) << 1) + 1)) >> 3) * 256  \
+   + IMAADPCM_INNER_VAL((index) + IMAADPCM_INDEX_DELTA(nibble), 0, 88))
+
+/* 遷移テーブルの1行（あるステップサイズインデックスでの全ニブルに対する遷移） */
+#define IMAADPCM_TRANSITION_ROW(index, stepsize) {                                      \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize,  0),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize,  1),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize,  2),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize,  3),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize,  4),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize,  5),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize,  6),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize,  7),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize,  8),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize,  9),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize, 10),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize, 11),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize, 12),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize, 13),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize, 14),                                       \
+  IMAADPCM_TRANSITION_ENTRY(index, stepsize, 15)                                        \
+}
+
+/* 状態遷移テーブル [ステップサイズインデックス][ニブル] */
+/* 1回の参照で量子化差分と次のインデックスが得られる */
+static const int32_t IMAADPCM_transition_table[89][16] = {
+  IMAADPCM_TRANSITION_ROW( 0,     7),
+  IMAADPCM_TRANSITION_ROW( 1,     8),
+  IMAADPCM_TRANSITION_ROW( 2,     9),
+  IMAADPCM_TRANSITION_ROW( 3,    10),
+  IMAADPCM_TRANSITION_ROW( 4,    11),
+  IMAADPCM_TRANSITION_ROW( 5,    12),
+  IMAADPCM_TRANSITION_ROW( 6,    13),
+  IMAADPCM_TRANSITION_ROW( 7,    14),
+  IMAADPCM_TRANSITION_ROW( 8,    16),
+  IMAADPCM_TRANSITION_ROW( 9,    17),
+  IMAADPCM_TRANSITION_ROW(10,    19),
+  IMAADPCM_TRANSITION_ROW(11,    21),
+  IMAADPCM_TRANSITION_ROW(12,    23),
+  IMAADPCM_TRANSITION_ROW(13,    25),
+  IMAADPCM_TRANSITION_ROW(14,    28),
+  IMAADPCM_TRANSITION_ROW(15,    31),
+  IMAADPCM_TRANSITION_ROW(16,    34),
+  IMAADPCM_TRANSITION_ROW(17,    37),
+  IMAADPCM_TRANSITION_ROW(18,    41),
+  IMAADPCM_TRANSITION_ROW(19,    45),
+  IMAADPCM_TRANSITION_ROW(20,    50),
+  IMAADPCM_TRANSITION_ROW(21,    55),
+  IMAADPCM_TRANSITION_ROW(22,    60),
+  IMAADPCM_TRANSITION_ROW(23,    66),
+  IMAADPCM_TRANSITION_ROW(24,    73),
+  IMAADPCM_TRANSITION_ROW(25,    80),
+  IMAADPCM_TRANSITION_ROW(26,    88),
+  IMAADPCM_TRANSITION_ROW(27,    97),
+  IMAADPCM_TRANSITION_ROW(28,   107),
+  IMAADPCM_TRANSITION_ROW(29,   118),
+  IMAADPCM_TRANSITION_ROW(30,   130),
+  IMAADPCM_TRANSITION_ROW(31,   143),
+  IMAADPCM_TRANSITION_ROW(32,   157),
+  IMAADPCM_TRANSITION_ROW(33,   173),
+  IMAADPCM_TRANSITION_ROW(34,   190),
+  IMAADPCM_TRANSITION_ROW(35,   209),
+  IMAADPCM_TRANSITION_ROW(36,   230),
+  IMAADPCM_TRANSITION_ROW(37,   253),
+  IMAADPCM_TRANSITION_ROW(38,   279),
+  IMAADPCM_TRANSITION_ROW(39,   307),
+  IMAADPCM_TRANSITION_ROW(40,   337),
+  IMAADPCM_TRANSITION_ROW(41,   371),
+  IMAADPCM_TRANSITION_ROW(42,   408),
+  IMAADPCM_TRANSITION_ROW(43,   449),
+  IMAADPCM_TRANSITION_ROW(44,   494),
+  IMAADPCM_TRANSITION_ROW(45,   544),
+  IMAADPCM_TRANSITION_ROW(46,   598),
+  IMAADPCM_TRANSITION_ROW(47,   658),
+  IMAADPCM_TRANSITION_ROW(48,   724),
+  IMAADPCM_TRANSITION_ROW(49,   796),
+  IMAADPCM_TRANSITION_ROW(50,   876),
+  IMAADPCM_TRANSITION_ROW(51,   963),
+  IMAADPCM_TRANSITION_ROW(52,  1060),
+  IMAADPCM_TRANSITION_ROW(53,  1166),
+  IMAADPCM_TRANSITION_ROW(54,  1282),
+  IMAADPCM_TRANSITION_ROW(55,  1411),
+  IMAADPCM_TRANSITION_ROW(56,  1552),
+  IMAADPCM_TRANSITION_ROW(57,  1707),
+  IMAADPCM_TRANSITION_ROW(58,  1878),
+  IMAADPCM_TRANSITION_ROW(59,  2066),
+  IMAADPCM_TRANSITION_ROW(60,  2272),
+  IMAADPCM_TRANSITION_ROW(61,  2499),
+  IMAADPCM_TRANSITION_ROW(62,  2749),
+  IMAADPCM_TRANSITION_ROW(63,  3024),
+  IMAADPCM_TRANSITION_ROW(64,  3327),
+  IMAADPCM_TRANSITION_ROW(65,  3660),
+  IMAADPCM_TRANSITION_ROW(66,  4026),
+  IMAADPCM_TRANSITION_ROW(67,  4428),
+  IMAADPCM_TRANSITION_ROW(68,  4871),
+  IMAADPCM_TRANSITION_ROW(69,  5358),
+  IMAADPCM_TRANSITION_ROW(70,  5894),
+  IMAADPCM_TRANSITION_ROW(71,  6484),
+  IMAADPCM_TRANSITION_ROW(72,  7132),
+  IMAADPCM_TRANSITION_ROW(73,  7845),
+  IMAADPCM_TRANSITION_ROW(74,  8630),
+  IMAADPCM_TRANSITION_ROW(75,  9493),
+  IMAADPCM_TRANSITION_ROW(76, 10442),
+  IMAADPCM_TRANSITION_ROW(77, 11487),
+  IMAADPCM_TRANSITION_ROW(78, 12635),
+  IMAADPCM_TRANSITION_ROW(79, 13899),
+  IMAADPCM_TRANSITION_ROW(80, 15289),
+  IMAADPCM_TRANSITION_ROW(81, 16818),
+  IMAADPCM_TRANSITION_ROW(82, 18500),
+  IMAADPCM_TRANSITION_ROW(83, 20350),
+  IMAADPCM_TRANSITION_ROW(84, 22385),
+  IMAADPCM_TRANSITION_ROW(85, 24623),
+  IMAADPCM_TRANSITION_ROW(86, 27086),
+  IMAADPCM_TRANSITION_ROW(87, 29794),
+  IMAADPCM_TRANSITION_ROW(88, 32767)
+};
+
+/* バイト単位の状態遷移テーブルの16要素（上位ニブルhiを固定し、下位ニブル0から15まで並べたもの） */
+/* idec, i2, i4, i6, i8は下位ニブルで遷移した先のインデックス（-1, +2, +4, +6, +8を0から88に丸めたもの） */
+/* sdec, s2, s4, s6, s8はそれぞれのインデックスのステップサイズ */
+#define IMAADPCM_BYTE_TRANSITION_GROUP(hi, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8) \
+  IMAADPCM_TRANSITION_ENTRY(idec, sdec, hi),                                          \
+  IMAADPCM_TRANSITION_ENTRY(idec, sdec, hi),                                          \
+  IMAADPCM_TRANSITION_ENTRY(idec, sdec, hi),                                          \
+  IMAADPCM_TRANSITION_ENTRY(idec, sdec, hi),                                          \
+  IMAADPCM_TRANSITION_ENTRY(i2, s2, hi),                                              \
+  IMAADPCM_TRANSITION_ENTRY(i4, s4, hi),                                              \
+  IMAADPCM_TRANSITION_ENTRY(i6, s6, hi),                                              \
+  IMAADPCM_TRANSITION_ENTRY(i8, s8, hi),                                              \
+  IMAADPCM_TRANSITION_ENTRY(idec, sdec, hi),                                          \
+  IMAADPCM_TRANSITION_ENTRY(idec, sdec, hi),                                          \
+  IMAADPCM_TRANSITION_ENTRY(idec, sdec, hi),                                          \
+  IMAADPCM_TRANSITION_ENTRY(idec, sdec, hi),                                          \
+  IMAADPCM_TRANSITION_ENTRY(i2, s2, hi),                                              \
+  IMAADPCM_TRANSITION_ENTRY(i4, s4, hi),                                              \
+  IMAADPCM_TRANSITION_ENTRY(i6, s6, hi),                                              \
+  IMAADPCM_TRANSITION_ENTRY(i8, s8, hi)
+
+/* バイト単位の状態遷移テーブルの1行（あるステップサイズインデックスでの全バイトに対する遷移） */
+#define IMAADPCM_BYTE_TRANSITION_ROW(idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8) {    \
+  IMAADPCM_BYTE_TRANSITION_GROUP( 0, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP( 1, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP( 2, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP( 3, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP( 4, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP( 5, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP( 6, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP( 7, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP( 8, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP( 9, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP(10, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP(11, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP(12, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP(13, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP(14, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8),     \
+  IMAADPCM_BYTE_TRANSITION_GROUP(15, idec, sdec, i2, s2, i4, s4, i6, s6, i8, s8)      \
+}
+
+/* バイト単位の状態遷移テーブル [ステップサイズインデックス][バイト] */
+/* 要素の形式は状態遷移テーブルと同じで、上位ニブルの差分と2サンプル後のインデックスを持つ */
+/* 下位ニブルの差分は状態遷移テーブル[インデックス][下位ニブル]から（このテーブルと並列に）得る */
+static const int32_t IMAADPCM_byte_transition_table[89][256] = {
+  IMAADPCM_BYTE_TRANSITION_ROW( 0,     7,  2,     9,  4,    11,  6,    13,  8,    16),
+  IMAADPCM_BYTE_TRANSITION_ROW( 0,     7,  3,    10,  5,    12,  7,    14,  9,    17),
+  IMAADPCM_BYTE_TRANSITION_ROW( 1,     8,  4,    11,  6,    13,  8,    16, 10,    19),
+  IMAADPCM_BYTE_TRANSITION_ROW( 2,     9,  5,    12,  7,    14,  9,    17, 11,    21),
+  IMAADPCM_BYTE_TRANSITION_ROW( 3,    10,  6,    13,  8,    16, 10,    19, 12,    23),
+  IMAADPCM_BYTE_TRANSITION_ROW( 4,    11,  7,    14,  9,    17, 11,    21, 13,    25),
+  IMAADPCM_BYTE_TRANSITION_ROW( 5,    12,  8,    16, 10,    19, 12,    23, 14,    28),
+  IMAADPCM_BYTE_TRANSITION_ROW( 6,    13,  9,    17, 11,    21, 13,    25, 15,    31),
+  IMAADPCM_BYTE_TRANSITION_ROW( 7,    14, 10,    19, 12,    23, 14,    28, 16,    34),
+  IMAADPCM_BYTE_TRANSITION_ROW( 8,    16, 11,    21, 13,    25, 15,    31, 17,    37),
+  IMAADPCM_BYTE_TRANSITION_ROW( 9,    17, 12,    23, 14,    28, 16,    34, 18,    41),
+  IMAADPCM_BYTE_TRANSITION_ROW(10,    19, 13,    25, 15,    31, 17,    37, 19,    45),
+  IMAADPCM_BYTE_TRANSITION_ROW(11,    21, 14,    28, 16,    34, 18,    41, 20,    50),
+  IMAADPCM_BYTE_TRANSITION_ROW(12,    23, 15,    31, 17,    37, 19,    45, 21,    55),
+  IMAADPCM_BYTE_TRANSITION_ROW(13,    25, 16,    34, 18,    41, 20,    50, 22,    60),
+  IMAADPCM_BYTE_TRANSITION_ROW(14,    28, 17,    37, 19,    45, 21,    55, 23,    66),
+  IMAADPCM_BYTE_TRANSITION_ROW(15,    31, 18,    41, 20,    50, 22,    60, 24,    73),
+  IMAADPCM_BYTE_TRANSITION_ROW(16,    34, 19,    45, 21,    55, 23,    66, 25,    80),
+  IMAADPCM_BYTE_TRANSITION_ROW(17,    37, 20,    50, 22,    60, 24,    73, 26,    88),
+  IMAADPCM_BYTE_TRANSITION_ROW(18,    41, 21,    55, 23,    66, 25,    80, 27,    97),
+  IMAADPCM_BYTE_TRANSITION_ROW(19,    45, 22,    60, 24,    73, 26,    88, 28,   107),
+  IMAADPCM_BYTE_TRANSITION_ROW(20,    50, 23,    66, 25,    80, 27,    97, 29,   118),
+  IMAADPCM_BYTE_TRANSITION_ROW(21,    55, 24,    73, 26,    88, 28,   107, 30,   130),
+  IMAADPCM_BYTE_TRANSITION_ROW(22,    60, 25,    80, 27,    97, 29,   118, 31,   143),
+  IMAADPCM_BYTE_TRANSITION_ROW(23,    66, 26,    88, 28,   107, 30,   130, 32,   157),
+  IMAADPCM_BYTE_TRANSITION_ROW(24,    73, 27,    97, 29,   118, 31,   143, 33,   173),
+  IMAADPCM_BYTE_TRANSITION_ROW(25,    80, 28,   107, 30,   130, 32,   157, 34,   190),
+  IMAADPCM_BYTE_TRANSITION_ROW(26,    88, 29,   118, 31,   143, 33,   173, 35,   209),
+  IMAADPCM_BYTE_TRANSITION_ROW(27,    97, 30,   130, 32,   157, 34,   190, 36,   230),
+  IMAADPCM_BYTE_TRANSITION_ROW(28,   107, 31,   143, 33,   173, 35,   209, 37,   253),
+  IMAADPCM_BYTE_TRANSITION_ROW(29,   118, 32,   157, 34,   190, 36,   230, 38,   279),
+  IMAADPCM_BYTE_TRANSITION_ROW(30,   130, 33,   173, 35,   209, 37,   253, 39,   307),
+  IMAADPCM_BYTE_TRANSITION_ROW(31,   143, 34,   190, 36,   230, 38,   279, 40,   337),
+  IMAADPCM_BYTE_TRANSITION_ROW(32,   157, 35,   209, 37,   253, 39,   307, 41,   371),
+  IMAADPCM_BYTE_TRANSITION_ROW(33,   173, 36,   230, 38,   279, 40,   337, 42,   408),
+  IMAADPCM_BYTE_TRANSITION_ROW(34,   190, 37,   253, 39,   307, 41,   371, 43,   449),
+  IMAADPCM_BYTE_TRANSITION_ROW(35,   209, 38,   279, 40,   337, 42,   408, 44,   494),
+  IMAADPCM_BYTE_TRANSITION_ROW(36,   230, 39,   307, 41,   371, 43,   449, 45,   544),
+  IMAADPCM_BYTE_TRANSITION_ROW(37,   253, 40,   337, 42,   408, 44,   494, 46,   598),
+  IMAADPCM_BYTE_TRANSITION_ROW(38,   279, 41,   371, 43,   449, 45,   544, 47,   658),
+  IMAADPCM_BYTE_TRANSITION_ROW(39,   307, 42,   408, 44,   494, 46,   598, 48,   724),
+  IMAADPCM_BYTE_TRANSITION_ROW(40,   337, 43,   449, 45,   544, 47,   658, 49,   796),
+  IMAADPCM_BYTE_TRANSITION_ROW(41,   371, 44,   494, 46,   598, 48,   724, 50,   876),
+  IMAADPCM_BYTE_TRANSITION_ROW(42,   408, 45,   544, 47,   658, 49,   796, 51,   963),
+  IMAADPCM_BYTE_TRANSITION_ROW(43,   449, 46,   598, 48,   724, 50,   876, 52,  1060),
+  IMAADPCM_BYTE_TRANSITION_ROW(44,   494, 47,   658, 49,   796, 51,   963, 53,  1166),
+  IMAADPCM_BYTE_TRANSITION_ROW(45,   544, 48,   724, 50,   876, 52,  1060, 54,  1282),
+  IMAADPCM_BYTE_TRANSITION_ROW(46,   598, 49,   796, 51,   963, 53,  1166, 55,  1411),
+  IMAADPCM_BYTE_TRANSITION_ROW(47,   658, 50,   876, 52,  1060, 54,  1282, 56,  1552),
+  IMAADPCM_BYTE_TRANSITION_ROW(48,   724, 51,   963, 53,  1166, 55,  1411, 57,  1707),
+  IMAADPCM_BYTE_TRANSITION_ROW(49,   796, 52,  1060, 54,  1282, 56,  1552, 58,  1878),
+  IMAADPCM_BYTE_TRANSITION_ROW(50,   876, 53,  1166, 55,  1411, 57,  1707, 59,  2066),
+  IMAADPCM_BYTE_TRANSITION_ROW(51,   963, 54,  1282, 56,  1552, 58,  1878, 60,  2272),
+  IMAADPCM_BYTE_TRANSITION_ROW(52,  1060, 55,  1411, 57,  1707, 59,  2066, 61,  2499),
+  IMAADPCM_BYTE_TRANSITION_ROW(53,  1166, 56,  1552, 58,  1878, 60,  2272, 62,  2749),
+  IMAADPCM_BYTE_TRANSITION_ROW(54,  1282, 57,  1707, 59,  2066, 61,  2499, 63,  3024),
+  IMAADPCM_BYTE_TRANSITION_ROW(55,  1411, 58,  1878, 60,  2272, 62,  2749, 64,  3327),
+  IMAADPCM_BYTE_TRANSITION_ROW(56,  1552, 59,  2066, 61,  2499, 63,  3024, 65,  3660),
+  IMAADPCM_BYTE_TRANSITION_ROW(57,  1707, 60,  2272, 62,  2749, 64,  3327, 66,  4026),
+  IMAADPCM_BYTE_TRANSITION_ROW(58,  1878, 61,  2499, 63,  3024, 65,  3660, 67,  4428),
+  IMAADPCM_BYTE_TRANSITION_ROW(59,  2066, 62,  2749, 64,  3327, 66,  4026, 68,  4871),
+  IMAADPCM_BYTE_TRANSITION_ROW(60,  2272, 63,  3024, 65,  3660, 67,  4428, 69,  5358),
+  IMAADPCM_BYTE_TRANSITION_ROW(61,  2499, 64,  3327, 66,  4026, 68,  4871, 70,  5894),
+  IMAADPCM_BYTE_TRANSITION_ROW(62,  2749, 65,  3660, 67,  4428, 69,  5358, 71,  6484),
+  IMAADPCM_BYTE_TRANSITION_ROW(63,  3024, 66,  4026, 68,  4871, 70,  5894, 72,  7132),
+  IMAADPCM_BYTE_TRANSITION_ROW(64,  3327, 67,  4428, 69,  5358, 71,  6484, 73,  7845),
+  IMAADPCM_BYTE_TRANSITION_ROW(65,  3660, 68,  4871, 70,  5894, 72,  7132, 74,  8630),
+  IMAADPCM_BYTE_TRANSITION_ROW(66,  4026, 69,  5358, 71,  6484, 73,  7845, 75,  9493),
+  IMAADPCM_BYTE_TRANSITION_ROW(67,  4428, 70,  5894, 72,  7132, 74,  8630, 76, 10442),
+  IMAADPCM_BYTE_TRANSITION_ROW(68,  4871, 71,  6484, 73,  7845, 75,  9493, 77, 11487),
+  IMAADPCM_BYTE_TRANSITION_ROW(69,  5358, 72,  7132, 74,  8630, 76, 10442, 78, 12635),
+  IMAADPCM_BYTE_TRANSITION_ROW(70,  5894, 73,  7845, 75,  9493, 77, 11487, 79, 13899),
+  IMAADPCM_BYTE_TRANSITION_ROW(71,  6484, 74,  8630, 76, 10442, 78, 12635, 80, 15289),
+  IMAADPCM_BYTE_TRANSITION_ROW(72,  7132, 75,  9493, 77, 11487, 79, 13899, 81, 16818),
+  IMAADPCM_BYTE_TRANSITION_ROW(73,  7845, 76, 10442, 78, 12635, 80, 15289, 82, 18500),
+  IMAADPCM_BYTE_TRANSITION_ROW(74,  8630, 77, 11487, 79, 13899, 81, 16818, 83, 20350),
+  IMAADPCM_BYTE_TRANSITION_ROW(75,  9493, 78, 12635, 80, 15289, 82, 18500, 84, 22385),
+  IMAADPCM_BYTE_TRANSITION_ROW(76, 10442, 79, 13899, 81, 16818, 83, 20350, 85, 24623),
+  IMAADPCM_BYTE_TRANSITION_ROW(77, 11487, 80, 15289, 82, 18500, 84, 22385, 86, 27086),
+  IMAADPCM_BYTE_TRANSITION_ROW(78, 12635, 81, 16818, 83, 20350, 85, 24623, 87, 29794),
+  IMAADPCM_BYTE_TRANSITION_ROW(79, 13899, 82, 18500, 84, 22385, 86, 27086, 88, 32767),
+  IMAADPCM_BYTE_TRANSITION_ROW(80, 15289, 83, 20350, 85, 24623, 87, 29794, 88, 32767),
+  IMAADPCM_BYTE_TRANSITION_ROW(81, 16818, 84, 22385, 86, 27086, 88, 32767, 88, 32767),
+  IMAADPCM_BYTE_TRANSITION_ROW(82, 18500, 85, 24623, 87, 29794, 88, 32767, 88, 32767),
+  IMAADPCM_BYTE_TRANSITION_ROW(83, 20350, 86, 27086, 88, 32767, 88, 32767, 88, 32767),
+  IMAADPCM_BYTE_TRANSITION_ROW(84, 22385, 87, 29794, 88, 32767, 88, 32767, 88, 32767),
+  IMAADPCM_BYTE_TRANSITION_ROW(85, 24623, 88, 32767, 88, 32767, 88, 32767, 88, 32767),
+  IMAADPCM_BYTE_TRANSITION_ROW(86, 27086, 88, 32767, 88, 32767, 88, 32767, 88, 32767),
+  IMAADPCM_BYTE_TRANSITION_ROW(87, 29794, 88, 32767, 88, 32767, 88, 32767, 88, 32767)
+};
+
+/* ワークサイズ計算（streamingが非0ならストリーミングデコードの一時バッファを、max_num_tasksタスク分の並列デコードの領域を含める） */
+static int32_t IMAADPCMWAVDecoder_CalculateWorkSizeInternal(uint8_t streaming, uint32_t max_num_tasks)
 {
-  return IMAADPCM_ALIGNMENT + sizeof(struct IMAADPCMWAVDecoder);
+  assert(max_num_tasks <= IMAADPCM_MAX_NUM_TASKS);
+
+  /* ハンドル + リサンプリングのフィルタ係数 (+ ストリーミングデコードの一時バッファ) (+ タスク毎の状態とタイル) */
+  return (int32_t)(IMAADPCM_ALIGNMENT + sizeof(struct IMAADPCMWAVDecoder)
+    + sizeof(int16_t) * IMAADPCM_RESAMPLE_NUM_PHASES * IMAADPCM_RESAMPLE_NUM_TAPS
+    + (streaming ? IMAADPCM_ROUND_UP(IMAADPCM_MAX_BLOCK_SIZE, IMAADPCM_ALIGNMENT) : 0)
+    + max_num_tasks * (IMAADPCM_ROUND_UP(sizeof(struct IMAADPCMWAVDecoder), IMAADPCM_ALIGNMENT)
+        + sizeof(int16_t) * IMAADPCM_LAYOUT_TILE_NUM_SAMPLES));
 }
 
-/* デコードハンドル作成 */
-struct IMAADPCMWAVDecoder *IMAADPCMWAVDecoder_Create(void *work, int32_t work_size)
+/* デコードハンドル作成（streamingが非0ならストリーミングデコードの一時バッファを、max_num_tasksタスク分の並列デコードの領域を割り当てる） */
+static struct IMAADPCMWAVDecoder *IMAADPCMWAVDecoder_CreateInternal(
+    void *work, int32_t work_size, uint8_t streaming, uint32_t max_num_tasks)
 {
   struct IMAADPCMWAVDecoder *decoder;
   uint8_t *work_ptr;
@@ -144,13 +778,13 @@ struct IMAADPCMWAVDecoder *IMAADPCMWAVDecoder_Create(void *work, int32_t work_si
 
   /* 領域自前確保の場合 */
   if ((work == NULL) && (work_size == 0)) {
-    work_size = IMAADPCMWAVDecoder_CalculateWorkSize();
+    work_size = IMAADPCMWAVDecoder_CalculateWorkSizeInternal(streaming, max_num_tasks);
     work = malloc((uint32_t)work_size);
     alloced_by_malloc = 1;
   }
 
   /* 引数チェック */
-  if ((work == NULL) || (work_size < IMAADPCMWAVDecoder_CalculateWorkSize())) {
+  if ((work == NULL) || (work_size < IMAADPCMWAVDecoder_CalculateWorkSizeInternal(streaming, max_num_tasks))) {
     return NULL;
   }
 
@@ -162,6 +796,31 @@ struct IMAADPCMWAVDecoder *IMAADPCMWAVDecoder_Create(void *work, int32_t work_si
 
   /* ハンドルの中身を0初期化 */
   memset(decoder, 0, sizeof(struct IMAADPCMWAVDecoder));
+  work_ptr += sizeof(struct IMAADPCMWAVDecoder);
+
+  /* リサンプリングのフィルタ係数 */
+  decoder->resample.coef = (int16_t *)work_ptr;
+  work_ptr += sizeof(int16_t) * IMAADPCM_RESAMPLE_NUM_PHASES * IMAADPCM_RESAMPLE_NUM_TAPS;
+
+  /* ストリーミングデコードの一時バッファ */
+  if (streaming) {
+    decoder->stream.buffer = work_ptr;
+    work_ptr += IMAADPCM_ROUND_UP(IMAADPCM_MAX_BLOCK_SIZE, IMAADPCM_ALIGNMENT);
+  }
+
+  /* 並列デコードのタスク毎の状態とタイル */
+  decoder->max_num_tasks = max_num_tasks;
+  if (max_num_tasks > 0) {
+    work_ptr = (uint8_t *)IMAADPCM_ROUND_UP((uintptr_t)work_ptr, IMAADPCM_ALIGNMENT);
+    decoder->task_decoder = (struct IMAADPCMWAVDecoder *)work_ptr;
+    work_ptr += max_num_tasks * IMAADPCM_ROUND_UP(sizeof(struct IMAADPCMWAVDecoder), IMAADPCM_ALIGNMENT);
+    decoder->task_tile = (int16_t *)work_ptr;
+    work_ptr += max_num_tasks * sizeof(int16_t) * IMAADPCM_LAYOUT_TILE_NUM_SAMPLES;
+  }
+  assert((work_ptr - (uint8_t *)work) <= work_size);
+
+  /* 実行中のCPUに合わせたカーネルを設定 */
+  IMAADPCMWAVDecoder_BindKernel(decoder, IMAADPCM_GetDefaultKernel());
 
   /* 自前確保の場合はメモリを記憶しておく */
   decoder->work = alloced_by_malloc ? work : NULL;
@@ -169,6 +828,52 @@ struct IMAADPCMWAVDecoder *IMAADPCMWAVDecoder_Create(void *work, int32_t work_si
   return decoder;
 }
 
+/* ワークサイズ計算 */
+int32_t IMAADPCMWAVDecoder_CalculateWorkSize(void)
+{
+  return IMAADPCMWAVDecoder_CalculateWorkSizeInternal(0, 0);
+}
+
+/* デコードハンドル作成 */
+struct IMAADPCMWAVDecoder *IMAADPCMWAVDecoder_Create(void *work, int32_t work_size)
+{
+  return IMAADPCMWAVDecoder_CreateInternal(work, work_size, 0, 0);
+}
+
+/* ストリーミングデコード用のワークサイズ計算 */
+int32_t IMAADPCMWAVDecoder_CalculateStreamWorkSize(void)
+{
+  return IMAADPCMWAVDecoder_CalculateWorkSizeInternal(1, 0);
+}
+
+/* ストリーミングデコード用のデコードハンドル作成 */
+struct IMAADPCMWAVDecoder *IMAADPCMWAVDecoder_CreateStream(void *work, int32_t work_size)
+{
+  return IMAADPCMWAVDecoder_CreateInternal(work, work_size, 1, 0);
+}
+
+/* 並列デコード用のワークサイズ計算 */
+int32_t IMAADPCMWAVDecoder_CalculateParallelWorkSize(uint32_t max_num_tasks)
+{
+  /* 引数チェック */
+  if ((max_num_tasks == 0) || (max_num_tasks > IMAADPCM_MAX_NUM_TASKS)) {
+    return -1;
+  }
+
+  return IMAADPCMWAVDecoder_CalculateWorkSizeInternal(0, max_num_tasks);
+}
+
+/* 並列デコード用のデコードハンドル作成 */
+struct IMAADPCMWAVDecoder *IMAADPCMWAVDecoder_CreateParallel(uint32_t max_num_tasks, void *work, int32_t work_size)
+{
+  /* 引数チェック */
+  if ((max_num_tasks == 0) || (max_num_tasks > IMAADPCM_MAX_NUM_TASKS)) {
+    return NULL;
+  }
+
+  return IMAADPCMWAVDecoder_CreateInternal(work, work_size, 0, max_num_tasks);
+}
+
 /* デコードハンドル破棄 */
 void IMAADPCMWAVDecoder_Destroy(struct IMAADPCMWAVDecoder *decoder)
 {
@@ -187,7 +892,8 @@ IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeHeader(
   const uint8_t *data_pos;
   uint32_t u32buf;
   uint16_t u16buf;
-  uint32_t find_fact_chunk;
+  uint32_t find_fact_chunk, find_ds64_chunk, is_rf64, is_extensible;
+  uint64_t data_chunk_size, ds64_data_size, ds64_num_samples;
   struct IMAADPCMWAVHeaderInfo tmp_header_info;
 
   /* 引数チェック */
@@ -198,9 +904,13 @@ IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeHeader(
   /* 読み出し用ポインタ設定 */
   data_pos = data;
 
-  /* RIFFチャンクID */
+  /* RIFFチャンクID: 4GBを超えるファイルはRF64（BW64）で、サイズをds64チャンクに持つ */
   ByteArray_GetUint32LE(data_pos, &u32buf);
-  if (!IMAADPCM_CHECK_FOURCC(u32buf, 'R', 'I', 'F', 'F')) {
+  if (IMAADPCM_CHECK_FOURCC(u32buf, 'R', 'F', '6', '4') || IMAADPCM_CHECK_FOURCC(u32buf, 'B', 'W', '6', '4')) {
+    is_rf64 = 1;
+  } else if (IMAADPCM_CHECK_FOURCC(u32buf, 'R', 'I', 'F', 'F')) {
+    is_rf64 = 0;
+  } else {
     fprintf(stderr, "Invalid RIFF chunk id. \n");
     return IMAADPCM_APIRESULT_INVALID_FORMAT;
   }
@@ -214,8 +924,50 @@ IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeHeader(
     return IMAADPCM_APIRESULT_INVALID_FORMAT;
   }
 
+  /* fmtチャンクより前にあるds64チャンク（RF64のサイズ）とJUNKチャンク（ds64の予約領域）を読む */
+  find_ds64_chunk = 0;
+  ds64_data_size = ds64_num_samples = 0;
+  while (1) {
+    if (data_size < ((uint32_t)(data_pos - data) + 8)) {
+      return IMAADPCM_APIRESULT_INSUFFICIENT_DATA;
+    }
+    ByteArray_GetUint32LE(data_pos, &u32buf);
+    if (IMAADPCM_CHECK_FOURCC(u32buf, 'd', 's', '6', '4')) {
+      uint32_t lo, hi;
+      /* ds64チャンクサイズ: RIFFサイズ・dataサイズ・サンプル数・テーブル長の28byteは必須 */
+      ByteArray_GetUint32LE(data_pos, &u32buf);
+      if ((u32buf < (IMAADPCM_DS64_CHUNK_SIZE - 8))
+          || (data_size < ((uint32_t)(data_pos - data) + u32buf))) {
+        fprintf(stderr, "Unsupported ds64 chunk size: %d \n", u32buf);
+        return IMAADPCM_APIRESULT_INVALID_FORMAT;
+      }
+      /* RIFFサイズ（読み飛ばし） */
+      data_pos += 8;
+      /* dataチャンクサイズ */
+      ByteArray_GetUint32LE(data_pos, &lo);
+      ByteArray_GetUint32LE(data_pos, &hi);
+      ds64_data_size = ((uint64_t)hi << 32) | lo;
+      /* サンプル数 */
+      ByteArray_GetUint32LE(data_pos, &lo);
+      ByteArray_GetUint32LE(data_pos, &hi);
+      ds64_num_samples = ((uint64_t)hi << 32) | lo;
+      /* テーブル長以降（他のチャンクのサイズ）は読み飛ばし */
+      data_pos += u32buf - 24;
+      find_ds64_chunk = 1;
+    } else if (IMAADPCM_CHECK_FOURCC(u32buf, 'J', 'U', 'N', 'K')) {
+      ByteArray_GetUint32LE(data_pos, &u32buf);
+      data_pos += u32buf;
+    } else {
+      break;
+    }
+  }
+  /* RF64はds64チャンクが必須 */
+  if (is_rf64 && !find_ds64_chunk) {
+    fprintf(stderr, "ds64 chunk not found. \n");
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
   /* FMTチャンクID */
-  ByteArray_GetUint32LE(data_pos, &u32buf);
   if (!IMAADPCM_CHECK_FOURCC(u32buf, 'f', 'm', 't', ' ')) {
     fprintf(stderr, "Invalid fmt  chunk id. \n");
     return IMAADPCM_APIRESULT_INVALID_FORMAT;
@@ -226,12 +978,13 @@ IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeHeader(
     fprintf(stderr, "Data size too small. fmt chunk size:%d data size:%d \n", u32buf, data_size);
     return IMAADPCM_APIRESULT_INSUFFICIENT_DATA;
   }
-  /* WAVEフォーマットタイプ: IMA-ADPCM以外は受け付けない */
+  /* WAVEフォーマットタイプ: IMA-ADPCM(17)とWAVE_FORMAT_EXTENSIBLE(0xFFFE)以外は受け付けない */
   ByteArray_GetUint16LE(data_pos, &u16buf);
-  if (u16buf != 17) {
+  if ((u16buf != 17) && (u16buf != 0xFFFE)) {
     fprintf(stderr, "Unsupported format: %d \n", u16buf);
     return IMAADPCM_APIRESULT_INVALID_FORMAT;
   }
+  is_extensible = (u16buf == 0xFFFE) ? 1 : 0;
   /* チャンネル数 */
   ByteArray_GetUint16LE(data_pos, &u16buf);
   if (u16buf > IMAADPCM_MAX_NUM_CHANNELS) {
@@ -251,15 +1004,31 @@ IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeHeader(
   /* サンプルあたりビット数 */
   ByteArray_GetUint16LE(data_pos, &u16buf);
   tmp_header_info.bits_per_sample = u16buf;
-  /* fmtチャンクのエキストラサイズ: 2以外は想定していない */
+  /* fmtチャンクのエキストラサイズ: 2（WAVE_FORMAT_EXTENSIBLE形式では22）以外は想定していない */
   ByteArray_GetUint16LE(data_pos, &u16buf);
-  if (u16buf != 2) {
+  if (u16buf != (is_extensible ? (2 + IMAADPCM_EXTENSIBLE_FMT_EXTRA_SIZE) : 2)) {
     fprintf(stderr, "Unsupported fmt chunk extra size: %d \n", u16buf);
     return IMAADPCM_APIRESULT_INVALID_FORMAT;
   }
-  /* ブロックあたりサンプル数 */
+  /* ブロックあたりサンプル数（WAVE_FORMAT_EXTENSIBLE形式ではwSamplesPerBlock） */
   ByteArray_GetUint16LE(data_pos, &u16buf);
   tmp_header_info.num_samples_per_block = u16buf;
+  /* チャンネル配置とサブフォーマット: WAVE_FORMAT_EXTENSIBLE形式のみ */
+  tmp_header_info.channel_mask = 0;
+  if (is_extensible) {
+    uint32_t i;
+    ByteArray_GetUint32LE(data_pos, &u32buf);
+    tmp_header_info.channel_mask = u32buf;
+    /* サブフォーマットはIMA-ADPCMのみ */
+    for (i = 0; i < sizeof(IMAADPCM_extensible_subformat_guid); i++) {
+      uint8_t u8buf;
+      ByteArray_GetUint8(data_pos, &u8buf);
+      if (u8buf != IMAADPCM_extensible_subformat_guid[i]) {
+        fprintf(stderr, "Unsupported sub format. \n");
+        return IMAADPCM_APIRESULT_INVALID_FORMAT;
+      }
+    }
+  }
 
   /* dataチャンクまで読み飛ばし */
   find_fact_chunk = 0;
@@ -282,8 +1051,15 @@ IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeHeader(
         fprintf(stderr, "Unsupported fact chunk size: %d \n", u16buf);
         return IMAADPCM_APIRESULT_INVALID_FORMAT;
       }
-      /* サンプル数 */
+      /* サンプル数: RF64で-1の場合はds64チャンクのサンプル数 */
       ByteArray_GetUint32LE(data_pos, &u32buf);
+      if (is_rf64 && (u32buf == 0xFFFFFFFFUL)) {
+        if (ds64_num_samples > UINT32_MAX) {
+          fprintf(stderr, "Unsupported number of samples. \n");
+          return IMAADPCM_APIRESULT_INVALID_FORMAT;
+        }
+        u32buf = (uint32_t)ds64_num_samples;
+      }
       tmp_header_info.num_samples = u32buf;
       /* factチャンクを見つけたことをマーク */
       assert(find_fact_chunk == 0);
@@ -297,15 +1073,20 @@ IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeHeader(
     }
   }
 
-  /* データチャンクサイズ（読み飛ばし） */
+  /* データチャンクサイズ: RF64で-1の場合はds64チャンクのサイズ */
   ByteArray_GetUint32LE(data_pos, &u32buf);
+  data_chunk_size = (is_rf64 && (u32buf == 0xFFFFFFFFUL)) ? ds64_data_size : u32buf;
 
   /* factチャンクがない場合は、サンプル数をブロックサイズから計算 */
   if (find_fact_chunk == 0) {
-    uint32_t data_chunk_size = u32buf;
     /* 末尾のブロック分も含めるため+1 */
-    uint32_t num_blocks = data_chunk_size / tmp_header_info.block_size + 1;
-    tmp_header_info.num_samples = tmp_header_info.num_samples_per_block * num_blocks;
+    const uint64_t num_samples
+      = (uint64_t)tmp_header_info.num_samples_per_block * (data_chunk_size / tmp_header_info.block_size + 1);
+    if (num_samples > UINT32_MAX) {
+      fprintf(stderr, "Unsupported number of samples. \n");
+      return IMAADPCM_APIRESULT_INVALID_FORMAT;
+    }
+    tmp_header_info.num_samples = (uint32_t)num_samples;
   }
 
   /* データ領域先頭までのオフセット */
@@ -316,10 +1097,38 @@ IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeHeader(
   return IMAADPCM_APIRESULT_OK;
 }
 
+/* 64bitのサイズのデータからヘッダデコード（ヘッダは先頭の32bitで表せる範囲にある） */
+static IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeHeader64(
+    const uint8_t *data, uint64_t data_size, struct IMAADPCMWAVHeaderInfo *header_info)
+{
+  return IMAADPCMWAVDecoder_DecodeHeader(data,
+      (uint32_t)IMAADPCM_MIN_VAL(data_size, UINT32_MAX), header_info);
+}
+
 /* 1サンプルデコード */
 static int16_t IMAADPCMCoreDecoder_DecodeSample(
     struct IMAADPCMCoreDecoder *decoder, uint8_t nibble)
 {
+#if defined(IMAADPCM_USE_TRANSITION_TABLE)
+  int32_t predict, transition;
+
+  assert(decoder != NULL);
+  assert((decoder->stepsize_index >= 0) && (decoder->stepsize_index <= 88));
+
+  /* 状態遷移テーブルから差分と次のインデックスを一度に取得 */
+  /* ステップサイズ参照・乗算・インデックスのクリップを1回のテーブル参照で置き換える */
+  transition = IMAADPCM_transition_table[decoder->stepsize_index][nibble];
+
+  /* 差分を加えて16bit幅にクリップ */
+  predict = decoder->sample_val + (transition >> 8);
+  predict = IMAADPCM_INNER_VAL(predict, -32768, 32767);
+
+  /* 計算結果の反映 */
+  decoder->sample_val = (int16_t)predict;
+  decoder->stepsize_index = (int8_t)(transition & 0xFF);
+
+  return decoder->sample_val;
+#else
   int8_t  idx;
   int32_t predict, qdiff, delta, stepsize;
 
@@ -358,22 +1167,26 @@ static int16_t IMAADPCMCoreDecoder_DecodeSample(
   decoder->stepsize_index = idx;
 
   return decoder->sample_val;
+#endif
 }
 
 /* モノラルブロックのデコード */
 static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockMono(
-    struct IMAADPCMCoreDecoder *core_decoder,
+    struct IMAADPCMCoreDecoder *core_decoder, uint32_t num_channels,
     const uint8_t *read_pos, uint32_t data_size, 
     int16_t **buffer, uint32_t buffer_num_samples,
     uint32_t *num_decode_samples)
 {
   uint8_t u8buf;
   uint8_t nibble[2];
+  int32_t predict, idx;
   uint32_t smp, smpl, tmp_num_decode_samples;
+#ifndef NDEBUG
   const uint8_t *read_head = read_pos;
+#endif
 
   /* 引数チェック */
-  if ((core_decoder == NULL) || (read_pos == NULL)
+  if ((core_decoder == NULL) || (num_channels != 1) || (read_pos == NULL)
       || (buffer == NULL) || (buffer[0] == NULL)) {
     return IMAADPCM_ERROR_INVALID_ARGUMENT;
   }
@@ -391,26 +1204,53 @@ static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockMono(
   if (u8buf != 0) {
     return IMAADPCM_ERROR_INVALID_FORMAT;
   }
+  /* ステップサイズインデックスの範囲チェック */
+  if ((core_decoder->stepsize_index < 0) || (core_decoder->stepsize_index > 88)) {
+    return IMAADPCM_ERROR_INVALID_FORMAT;
+  }
 
   /* 先頭サンプルはヘッダに入っている */
   buffer[0][0] = core_decoder->sample_val;
 
   /* ブロックデータデコード */
-  for (smpl = 1; smpl < tmp_num_decode_samples - 2; smpl += 2) {
+  /* 1バイト（2サンプル）ずつテーブルを引き、インデックスの依存連鎖を1バイトあたり1回の参照にする */
+  predict = core_decoder->sample_val;
+  idx = core_decoder->stepsize_index;
+  for (smpl = 1; (smpl + 2) < tmp_num_decode_samples; smpl += 2) {
+    int32_t first, second, sample1, sample2;
     assert((uint32_t)(read_pos - read_head) < data_size);
     ByteArray_GetUint8(read_pos, &u8buf);
-    nibble[0] = (u8buf >> 0) & 0xF;
-    nibble[1] = (u8buf >> 4) & 0xF;
-    buffer[0][smpl + 0] = IMAADPCMCoreDecoder_DecodeSample(core_decoder, nibble[0]);
-    buffer[0][smpl + 1] = IMAADPCMCoreDecoder_DecodeSample(core_decoder, nibble[1]);
+    /* 2つの参照は互いに独立 */
+    first = IMAADPCM_transition_table[idx][u8buf & 0xF];
+    second = IMAADPCM_byte_transition_table[idx][u8buf];
+    sample1 = predict + (first >> 8);
+    sample2 = sample1 + (second >> 8);
+    /* 16bit幅のクリップが起こりうる場合のみ1ニブルずつ厳密にデコード */
+    if (((uint32_t)(sample1 + 32768) | (uint32_t)(sample2 + 32768)) > 0xFFFF) {
+      core_decoder->sample_val = (int16_t)predict;
+      core_decoder->stepsize_index = (int8_t)idx;
+      buffer[0][smpl + 0] = IMAADPCMCoreDecoder_DecodeSample(core_decoder, (uint8_t)((u8buf >> 0) & 0xF));
+      buffer[0][smpl + 1] = IMAADPCMCoreDecoder_DecodeSample(core_decoder, (uint8_t)((u8buf >> 4) & 0xF));
+      predict = core_decoder->sample_val;
+      idx = core_decoder->stepsize_index;
+    } else {
+      buffer[0][smpl + 0] = (int16_t)sample1;
+      buffer[0][smpl + 1] = (int16_t)sample2;
+      predict = sample2;
+      idx = second & 0xFF;
+    }
   }
+  core_decoder->sample_val = (int16_t)predict;
+  core_decoder->stepsize_index = (int8_t)idx;
 
-  /* 末尾サンプル対処 */
-  ByteArray_GetUint8(read_pos, &u8buf);
-  nibble[0] = (u8buf >> 0) & 0xF;
-  nibble[1] = (u8buf >> 4) & 0xF;
-  for (smp = 0; (smp < 2) && ((smpl + smp) < tmp_num_decode_samples); smp++) {
-    buffer[0][smpl + smp] = IMAADPCMCoreDecoder_DecodeSample(core_decoder, nibble[smp]);
+  /* 末尾サンプル対処（ヘッダのサンプルのみの場合は読まない） */
+  if (smpl < tmp_num_decode_samples) {
+    ByteArray_GetUint8(read_pos, &u8buf);
+    nibble[0] = (u8buf >> 0) & 0xF;
+    nibble[1] = (u8buf >> 4) & 0xF;
+    for (smp = 0; (smp < 2) && ((smpl + smp) < tmp_num_decode_samples); smp++) {
+      buffer[0][smpl + smp] = IMAADPCMCoreDecoder_DecodeSample(core_decoder, nibble[smp]);
+    }
   }
 
   /* デコードしたサンプル数をセット */
@@ -420,7 +1260,7 @@ static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockMono(
 
 /* ステレオブロックのデコード */
 static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockStereo(
-    struct IMAADPCMCoreDecoder *core_decoder,
+    struct IMAADPCMCoreDecoder *core_decoder, uint32_t num_channels,
     const uint8_t *read_pos, uint32_t data_size, 
     int16_t **buffer, uint32_t buffer_num_samples, 
     uint32_t *num_decode_samples)
@@ -428,10 +1268,12 @@ static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockStereo(
   uint32_t u32buf;
   uint8_t nibble[8];
   uint32_t ch, smpl, tmp_num_decode_samples;
+#ifndef NDEBUG
   const uint8_t *read_head = read_pos;
+#endif
 
   /* 引数チェック */
-  if ((core_decoder == NULL) || (read_pos == NULL)
+  if ((core_decoder == NULL) || (num_channels != 2) || (read_pos == NULL)
       || (buffer == NULL) || (buffer[0] == NULL) || (buffer[1] == NULL)) {
     return IMAADPCM_ERROR_INVALID_ARGUMENT;
   }
@@ -451,6 +1293,9 @@ static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockStereo(
     if (reserved != 0) {
       return IMAADPCM_ERROR_INVALID_FORMAT;
     }
+    if ((core_decoder[ch].stepsize_index < 0) || (core_decoder[ch].stepsize_index > 88)) {
+      return IMAADPCM_ERROR_INVALID_FORMAT;
+    }
   }
 
   /* 最初のサンプルの取得 */
@@ -494,628 +1339,5504 @@ static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockStereo(
   return IMAADPCM_ERROR_OK;
 }
 
-/* 単一データブロックデコード */
-static IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeBlock(
-    struct IMAADPCMWAVDecoder *decoder,
-    const uint8_t *data, uint32_t data_size, 
-    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples, 
+/* 多チャンネルブロックのデコード準備 */
+/* 引数とブロックヘッダを確認してデコーダの状態をセットし、先頭サンプルを書き出す */
+/* デコード可能なサンプル数（全チャンネルのワードが揃っている分）をnum_decode_samplesに返す */
+static IMAADPCMError IMAADPCMWAVDecoder_PrepareMultichannelBlock(
+    struct IMAADPCMCoreDecoder *core_decoder, uint32_t num_channels,
+    const uint8_t *read_pos, uint32_t data_size,
+    int16_t **buffer, uint32_t buffer_num_samples,
     uint32_t *num_decode_samples)
 {
-  IMAADPCMError err;
-  const struct IMAADPCMWAVHeaderInfo *header;
+  uint8_t reserved;
+  uint32_t ch, tmp_num_decode_samples;
 
   /* 引数チェック */
-  if ((decoder == NULL) || (data == NULL)
-      || (buffer == NULL) || (num_decode_samples == NULL)) {
-    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  if ((core_decoder == NULL) || (read_pos == NULL) || (buffer == NULL)
+      || (num_channels <= 2) || (num_channels > IMAADPCM_MAX_NUM_CHANNELS)) {
+    return IMAADPCM_ERROR_INVALID_ARGUMENT;
   }
-
-  header = &(decoder->header);
-
-  /* バッファサイズチェック */
-  if (buffer_num_channels < header->num_channels) {
-    return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+  for (ch = 0; ch < num_channels; ch++) {
+    if (buffer[ch] == NULL) {
+      return IMAADPCM_ERROR_INVALID_ARGUMENT;
+    }
   }
 
-  /* ブロックデコード */
-  switch (header->num_channels) {
-    case 1:
-      err = IMAADPCMWAVDecoder_DecodeBlockMono(decoder->core_decoder, 
-          data, data_size, buffer, buffer_num_samples, num_decode_samples);
-      break;
-    case 2:
-      err = IMAADPCMWAVDecoder_DecodeBlockStereo(decoder->core_decoder, 
-          data, data_size, buffer, buffer_num_samples, num_decode_samples);
-      break;
-    default:
-      return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  /* ブロックヘッダが揃っていない */
+  if (data_size < (4 * num_channels)) {
+    return IMAADPCM_ERROR_INSUFFICIENT_DATA;
   }
 
-  /* デコード時のエラーハンドル */
-  if (err != IMAADPCM_ERROR_OK) {
-    switch (err) {
-      case IMAADPCM_ERROR_INVALID_ARGUMENT:
-        return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
-      case IMAADPCM_ERROR_INVALID_FORMAT:
-        return IMAADPCM_APIRESULT_INVALID_FORMAT;
-      case IMAADPCM_ERROR_INSUFFICIENT_BUFFER:
-        return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
-      default:
-        return IMAADPCM_APIRESULT_NG;
+  /* デコード可能なサンプル数を計算 チャンネル毎の4バイトのワードに8サンプル, +1はヘッダ分 */
+  tmp_num_decode_samples = ((data_size - 4 * num_channels) / (4 * num_channels)) * 8;
+  tmp_num_decode_samples += 1;
+  /* バッファサイズで切り捨て */
+  tmp_num_decode_samples = IMAADPCM_MIN_VAL(tmp_num_decode_samples, buffer_num_samples);
+
+  /* ブロックヘッダデコード */
+  for (ch = 0; ch < num_channels; ch++) {
+    ByteArray_GetUint16LE(read_pos, (uint16_t *)&(core_decoder[ch].sample_val));
+    ByteArray_GetUint8(read_pos, (uint8_t *)&(core_decoder[ch].stepsize_index));
+    ByteArray_GetUint8(read_pos, &reserved);
+    if (reserved != 0) {
+      return IMAADPCM_ERROR_INVALID_FORMAT;
+    }
+    if ((core_decoder[ch].stepsize_index < 0) || (core_decoder[ch].stepsize_index > 88)) {
+      return IMAADPCM_ERROR_INVALID_FORMAT;
     }
   }
 
-  return IMAADPCM_APIRESULT_OK;
+  /* 最初のサンプルの取得 */
+  for (ch = 0; ch < num_channels; ch++) {
+    buffer[ch][0] = core_decoder[ch].sample_val;
+  }
+
+  (*num_decode_samples) = tmp_num_decode_samples;
+  return IMAADPCM_ERROR_OK;
 }
 
-/* ヘッダ含めファイル全体をデコード */
-IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWhole(
-    struct IMAADPCMWAVDecoder *decoder, const uint8_t *data, uint32_t data_size,
-    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples)
+/* 多チャンネル（3チャンネル以上）ブロックのデコード */
+/* 1チャンネルを1レーンとし、各レーンが自チャンネルのワード（8サンプル）を1ステップ1ニブルずつ処理する */
+/* レーン毎の依存連鎖は独立なので、チャンネルを内側のループにして連鎖を重ねて実行させる */
+static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockMultichannel(
+    struct IMAADPCMCoreDecoder *core_decoder, uint32_t num_channels,
+    const uint8_t *read_pos, uint32_t data_size,
+    int16_t **buffer, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
 {
-  IMAADPCMApiResult ret;
-  uint32_t progress, ch, read_offset, read_block_size, num_decode_samples;
-  const uint8_t *read_pos;
-  int16_t *buffer_ptr[IMAADPCM_MAX_NUM_CHANNELS];
-  const struct IMAADPCMWAVHeaderInfo *header;
-
-  /* 引数チェック */
-  if ((decoder == NULL) || (data == NULL) || (buffer == NULL)) {
-    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  IMAADPCMError err;
+  uint32_t ch, smp, smpl, num_word_samples, tmp_num_decode_samples;
+  uint32_t codes[IMAADPCM_MAX_NUM_CHANNELS];
+  int32_t predict[IMAADPCM_MAX_NUM_CHANNELS], idx[IMAADPCM_MAX_NUM_CHANNELS];
+  int16_t decoded[8][IMAADPCM_MAX_NUM_CHANNELS];
+  const uint8_t *word_pos;
+
+  /* 引数・ブロックヘッダの確認とデコード可能なサンプル数の計算 */
+  if ((err = IMAADPCMWAVDecoder_PrepareMultichannelBlock(core_decoder, num_channels,
+          read_pos, data_size, buffer, buffer_num_samples, &tmp_num_decode_samples)) != IMAADPCM_ERROR_OK) {
+    return err;
   }
 
-  /* ヘッダデコード */
-  if ((ret = IMAADPCMWAVDecoder_DecodeHeader(data, data_size, &(decoder->header)))
-      != IMAADPCM_APIRESULT_OK) {
-    return ret;
+  for (ch = 0; ch < num_channels; ch++) {
+    predict[ch] = core_decoder[ch].sample_val;
+    idx[ch] = core_decoder[ch].stepsize_index;
   }
-  header = &(decoder->header);
 
-  /* バッファサイズチェック */
+  /* ブロックデータデコード: 全チャンネルのワードを並べて1ステップずつ処理 */
+  word_pos = read_pos + 4 * num_channels;
+  for (smpl = 1; smpl < tmp_num_decode_samples; smpl += 8) {
+    for (ch = 0; ch < num_channels; ch++) {
+      codes[ch] = ByteArray_ReadUint32LE(&word_pos[4 * ch]);
+    }
+    word_pos += 4 * num_channels;
+
+    for (smp = 0; smp < 8; smp++) {
+      for (ch = 0; ch < num_channels; ch++) {
+        const int32_t transition = IMAADPCM_transition_table[idx[ch]][codes[ch] & 0xF];
+        predict[ch] = IMAADPCM_INNER_VAL(predict[ch] + (transition >> 8), -32768, 32767);
+        idx[ch] = transition & 0xFF;
+        codes[ch] >>= 4;
+        decoded[smp][ch] = (int16_t)predict[ch];
+      }
+    }
+
+    /* サンプル数が 1 + (8の倍数) でない場合があるため、一旦バッファに受ける */
+    num_word_samples = IMAADPCM_MIN_VAL(8, tmp_num_decode_samples - smpl);
+    for (ch = 0; ch < num_channels; ch++) {
+      for (smp = 0; smp < num_word_samples; smp++) {
+        buffer[ch][smpl + smp] = decoded[smp][ch];
+      }
+    }
+  }
+
+  /* デコーダの状態を反映 */
+  for (ch = 0; ch < num_channels; ch++) {
+    core_decoder[ch].sample_val = (int16_t)predict[ch];
+    core_decoder[ch].stepsize_index = (int8_t)idx[ch];
+  }
+
+  /* デコードしたサンプル数をセット */
+  (*num_decode_samples) = tmp_num_decode_samples;
+  return IMAADPCM_ERROR_OK;
+}
+
+/* 実行中のCPUで使用可能な機能フラグを取得 */
+static uint32_t IMAADPCM_GetCPUFeatures(void)
+{
+  uint32_t features = 0;
+#if defined(IMAADPCM_USE_X86_SIMD)
+  unsigned int eax, ebx, ecx, edx;
+
+  /* 基本機能の取得 */
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) {
+    return 0;
+  }
+
+  /* SSE4.1 */
+  if (ecx & bit_SSE4_1) {
+    features |= IMAADPCM_CPU_FEATURE_SSE41;
+  }
+
+  /* AVX2: OSがYMMレジスタを退避するか（XCR0）も確認 */
+  if ((ecx & bit_OSXSAVE) && (ecx & bit_AVX)) {
+    uint32_t xcr0_lo, xcr0_hi;
+    __asm__ __volatile__ ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    (void)xcr0_hi;
+    if (((xcr0_lo & 0x6) == 0x6) && (__get_cpuid_max(0, NULL) >= 7)) {
+      __cpuid_count(7, 0, eax, ebx, ecx, edx);
+      if (ebx & bit_AVX2) {
+        features |= IMAADPCM_CPU_FEATURE_AVX2;
+      }
+    }
+  }
+#endif
+
+  return features;
+}
+
+/* 実行中のCPUでカーネルが使用可能か 使用可能ならば1を返す */
+static uint8_t IMAADPCM_IsKernelAvailable(IMAADPCMKernel kernel)
+{
+  switch (kernel) {
+    case IMAADPCM_KERNEL_AUTO:
+    case IMAADPCM_KERNEL_SCALAR:
+      return 1;
+    case IMAADPCM_KERNEL_SSE41:
+      return (IMAADPCM_GetCPUFeatures() & IMAADPCM_CPU_FEATURE_SSE41) ? 1 : 0;
+    case IMAADPCM_KERNEL_AVX2:
+      return (IMAADPCM_GetCPUFeatures() & IMAADPCM_CPU_FEATURE_AVX2) ? 1 : 0;
+    default:
+      break;
+  }
+
+  return 0;
+}
+
+/* ハンドル作成時に使うカーネルの取得 */
+static IMAADPCMKernel IMAADPCM_GetDefaultKernel(void)
+{
+  IMAADPCMKernel kernel = IMAADPCM_KERNEL_AUTO;
+  const char *env = getenv(IMAADPCM_KERNEL_ENVIRONMENT_VARIABLE);
+
+  /* 環境変数による指定 */
+  if (env != NULL) {
+    if (strcmp(env, "scalar") == 0) {
+      kernel = IMAADPCM_KERNEL_SCALAR;
+    } else if (strcmp(env, "sse41") == 0) {
+      kernel = IMAADPCM_KERNEL_SSE41;
+    } else if (strcmp(env, "avx2") == 0) {
+      kernel = IMAADPCM_KERNEL_AVX2;
+    }
+  }
+
+  /* 使用できないカーネルの指定は無視する */
+  if (!IMAADPCM_IsKernelAvailable(kernel)) {
+    kernel = IMAADPCM_KERNEL_AUTO;
+  }
+
+  return kernel;
+}
+
+/* デコード関数テーブルの設定 */
+static void IMAADPCMWAVDecoder_BindKernel(
+    struct IMAADPCMWAVDecoder *decoder, IMAADPCMKernel kernel)
+{
+  uint32_t ch;
+  struct IMAADPCMDecodeFunctions *functions;
+  IMAADPCMDecodeBlockFunction decode_block_multichannel;
+
+  assert(decoder != NULL);
+  assert(IMAADPCM_IsKernelAvailable(kernel));
+
+  functions = &(decoder->functions);
+
+  /* モノラル・ステレオのブロック単位のデコードは全カーネル共通 */
+  functions->decode_block[0] = IMAADPCMWAVDecoder_DecodeBlockMono;
+  functions->decode_block[1] = IMAADPCMWAVDecoder_DecodeBlockStereo;
+  /* 3チャンネル以上はチャンネルをレーンに割り当てたブロックデコード */
+  decode_block_multichannel = IMAADPCMWAVDecoder_DecodeBlockMultichannel;
+
+  /* 複数ブロック同時デコード */
+  functions->decode_blocks[0] = NULL;
+  functions->decode_blocks[1] = NULL;
+  switch (kernel) {
+    case IMAADPCM_KERNEL_AUTO:
+      /* 最速のものを選ぶ */
+      /* モノラルはバイト単位のデコードが、SSE4.1の同時デコードより1ブロックずつのデコードが速い */
+      /* 3チャンネル以上はチャンネル数によらずSSE4.1が安定して速い（AVX2は4チャンネル以下で遅い） */
+#if defined(IMAADPCM_USE_X86_SIMD)
+      if (IMAADPCM_GetCPUFeatures() & IMAADPCM_CPU_FEATURE_AVX2) {
+        functions->decode_blocks[1] = IMAADPCMWAVDecoder_DecodeBlocksAVX2;
+      }
+      if (IMAADPCM_GetCPUFeatures() & IMAADPCM_CPU_FEATURE_SSE41) {
+        decode_block_multichannel = IMAADPCMWAVDecoder_DecodeBlockMultichannelSSE41;
+      }
+#endif
+      break;
+#if defined(IMAADPCM_USE_X86_SIMD)
+    case IMAADPCM_KERNEL_SSE41:
+      functions->decode_blocks[0] = IMAADPCMWAVDecoder_DecodeBlocksSSE41;
+      functions->decode_blocks[1] = IMAADPCMWAVDecoder_DecodeBlocksSSE41;
+      decode_block_multichannel = IMAADPCMWAVDecoder_DecodeBlockMultichannelSSE41;
+      break;
+    case IMAADPCM_KERNEL_AVX2:
+      functions->decode_blocks[0] = IMAADPCMWAVDecoder_DecodeBlocksAVX2;
+      functions->decode_blocks[1] = IMAADPCMWAVDecoder_DecodeBlocksAVX2;
+      decode_block_multichannel = IMAADPCMWAVDecoder_DecodeBlockMultichannelAVX2;
+      break;
+#endif
+    default:
+      break;
+  }
+
+  /* 3チャンネル以上はブロック内でチャンネル方向に並列化するため複数ブロック同時デコードは使わない */
+  for (ch = 2; ch < IMAADPCM_MAX_NUM_CHANNELS; ch++) {
+    functions->decode_block[ch] = decode_block_multichannel;
+    functions->decode_blocks[ch] = NULL;
+  }
+
+  decoder->kernel = kernel;
+}
+
+/* エンコード関数テーブルの設定 */
+static void IMAADPCMWAVEncoder_BindKernel(
+    struct IMAADPCMWAVEncoder *encoder, IMAADPCMKernel kernel)
+{
+  uint32_t ch;
+  struct IMAADPCMEncodeFunctions *functions;
+  IMAADPCMEncodeBlockFunction encode_block_multichannel;
+
+  assert(encoder != NULL);
+  assert(IMAADPCM_IsKernelAvailable(kernel));
+
+  functions = &(encoder->functions);
+
+  /* モノラル・ステレオのブロック単位のエンコードは全カーネル共通 */
+  functions->encode_block[0] = IMAADPCMWAVEncoder_EncodeBlockMono;
+  functions->encode_block[1] = IMAADPCMWAVEncoder_EncodeBlockStereo;
+  /* 3チャンネル以上はチャンネルをレーンに割り当てたブロックエンコード */
+  encode_block_multichannel = IMAADPCMWAVEncoder_EncodeBlockMultichannel;
+
+  /* 複数ブロック同時エンコード（ブロック毎に独立な並列エンコードで使用） */
+  functions->encode_blocks[0] = NULL;
+  functions->encode_blocks[1] = NULL;
+  switch (kernel) {
+    case IMAADPCM_KERNEL_AUTO:
+      /* 最速のものを選ぶ */
+      /* エンコードはAVX2のギャザー2回よりSSE4.1のスカラ参照の方が速い */
+#if defined(IMAADPCM_USE_X86_SIMD)
+      if (IMAADPCM_GetCPUFeatures() & IMAADPCM_CPU_FEATURE_SSE41) {
+        functions->encode_blocks[0] = IMAADPCMWAVEncoder_EncodeBlocksSSE41;
+        functions->encode_blocks[1] = IMAADPCMWAVEncoder_EncodeBlocksSSE41;
+        encode_block_multichannel = IMAADPCMWAVEncoder_EncodeBlockMultichannelSSE41;
+      }
+#endif
+      break;
+#if defined(IMAADPCM_USE_X86_SIMD)
+    case IMAADPCM_KERNEL_SSE41:
+      functions->encode_blocks[0] = IMAADPCMWAVEncoder_EncodeBlocksSSE41;
+      functions->encode_blocks[1] = IMAADPCMWAVEncoder_EncodeBlocksSSE41;
+      encode_block_multichannel = IMAADPCMWAVEncoder_EncodeBlockMultichannelSSE41;
+      break;
+    case IMAADPCM_KERNEL_AVX2:
+      functions->encode_blocks[0] = IMAADPCMWAVEncoder_EncodeBlocksAVX2;
+      functions->encode_blocks[1] = IMAADPCMWAVEncoder_EncodeBlocksAVX2;
+      encode_block_multichannel = IMAADPCMWAVEncoder_EncodeBlockMultichannelAVX2;
+      break;
+#endif
+    default:
+      break;
+  }
+
+  /* 3チャンネル以上はブロック内でチャンネル方向に並列化するため複数ブロック同時エンコードは使わない */
+  for (ch = 2; ch < IMAADPCM_MAX_NUM_CHANNELS; ch++) {
+    functions->encode_block[ch] = encode_block_multichannel;
+    functions->encode_blocks[ch] = NULL;
+  }
+
+  encoder->kernel = kernel;
+}
+
+/* デコードに使用するカーネルの設定 */
+IMAADPCMApiResult IMAADPCMWAVDecoder_SetKernel(
+    struct IMAADPCMWAVDecoder *decoder, IMAADPCMKernel kernel)
+{
+  /* 引数チェック */
+  if (decoder == NULL) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 実行中のCPUで使えないカーネルは設定できない */
+  if (!IMAADPCM_IsKernelAvailable(kernel)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  IMAADPCMWAVDecoder_BindKernel(decoder, kernel);
+
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* デコードに使用しているカーネルの取得 */
+IMAADPCMKernel IMAADPCMWAVDecoder_GetKernel(const struct IMAADPCMWAVDecoder *decoder)
+{
+  assert(decoder != NULL);
+  return decoder->kernel;
+}
+
+/* エンコードに使用するカーネルの設定 */
+IMAADPCMApiResult IMAADPCMWAVEncoder_SetKernel(
+    struct IMAADPCMWAVEncoder *encoder, IMAADPCMKernel kernel)
+{
+  /* 引数チェック */
+  if (encoder == NULL) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 実行中のCPUで使えないカーネルは設定できない */
+  if (!IMAADPCM_IsKernelAvailable(kernel)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  IMAADPCMWAVEncoder_BindKernel(encoder, kernel);
+
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* エンコードに使用しているカーネルの取得 */
+IMAADPCMKernel IMAADPCMWAVEncoder_GetKernel(const struct IMAADPCMWAVEncoder *encoder)
+{
+  assert(encoder != NULL);
+  return encoder->kernel;
+}
+
+/* 複数ブロック同時デコードの対象ブロックヘッダが全て正常か確認 正常ならば1を返す */
+static uint8_t IMAADPCMWAVDecoder_CheckBlockHeaders(
+    const uint8_t *data, uint32_t block_size, uint32_t num_channels, uint32_t num_blocks)
+{
+  uint32_t blk, ch;
+
+  for (blk = 0; blk < num_blocks; blk++) {
+    for (ch = 0; ch < num_channels; ch++) {
+      const uint8_t *block_header = &data[blk * block_size + 4 * ch];
+      /* ステップサイズインデックスの範囲と、reservedが0であるかを確認 */
+      if ((block_header[2] > 88) || (block_header[3] != 0)) {
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+#if defined(IMAADPCM_USE_X86_SIMD)
+/* 複数ブロックの同時デコード（SSE4.1） */
+/* 1レーンが1ブロックを担当し、IMAADPCM_NUM_SIMD_LANES個の完全なブロックを同時にデコードする */
+/* 4レーンのSSEレジスタを2本使用 */
+__attribute__((target("sse4.1")))
+static void IMAADPCMWAVDecoder_DecodeBlocksSSE41(
+    const uint8_t *data, uint32_t block_size, uint32_t num_channels,
+    uint32_t num_samples_per_block, int16_t **buffer)
+{
+  uint32_t ch, lane, word, smp, half;
+  int32_t buf[IMAADPCM_NUM_SIMD_LANES];
+  int32_t decoded[8][IMAADPCM_NUM_SIMD_LANES];
+  __m128i predict[2], index[2], codes[2];
+  const uint32_t num_words = (block_size - 4 * num_channels) / (4 * num_channels);
+  const __m128i nibble_mask = _mm_set1_epi32(0xF);
+  const __m128i index_mask = _mm_set1_epi32(0xFF);
+  const __m128i min_sample = _mm_set1_epi32(-32768);
+  const __m128i max_sample = _mm_set1_epi32(32767);
+
+  assert((data != NULL) && (buffer != NULL));
+  assert(((block_size - 4 * num_channels) % (4 * num_channels)) == 0);
+  assert(num_samples_per_block == (num_words * 8 + 1));
+
+  for (ch = 0; ch < num_channels; ch++) {
+    /* ブロックヘッダデコード */
+    for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+      const uint8_t *block_header = &data[lane * block_size + 4 * ch];
+      buf[lane] = (int16_t)ByteArray_ReadUint16LE(block_header);
+      buffer[ch][lane * num_samples_per_block] = (int16_t)buf[lane];
+    }
+    predict[0] = _mm_loadu_si128((const __m128i *)&buf[0]);
+    predict[1] = _mm_loadu_si128((const __m128i *)&buf[4]);
+    for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+      buf[lane] = data[lane * block_size + 4 * ch + 2];
+    }
+    index[0] = _mm_loadu_si128((const __m128i *)&buf[0]);
+    index[1] = _mm_loadu_si128((const __m128i *)&buf[4]);
+
+    /* ブロックデータデコード: 1ワード(8サンプル)ずつ全レーン同時に処理 */
+    for (word = 0; word < num_words; word++) {
+      const uint32_t word_offset = 4 * num_channels + (word * num_channels + ch) * 4;
+      for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+        buf[lane] = (int32_t)ByteArray_ReadUint32LE(&data[lane * block_size + word_offset]);
+      }
+      codes[0] = _mm_loadu_si128((const __m128i *)&buf[0]);
+      codes[1] = _mm_loadu_si128((const __m128i *)&buf[4]);
+
+      for (smp = 0; smp < 8; smp++) {
+        for (half = 0; half < 2; half++) {
+          int32_t idx[4], nib[4];
+          __m128i nibble, transition;
+          /* ニブル取り出し */
+          nibble = _mm_and_si128(codes[half], nibble_mask);
+          codes[half] = _mm_srli_epi32(codes[half], 4);
+          /* 状態遷移テーブルから差分と次のインデックスを取得 */
+          _mm_storeu_si128((__m128i *)idx, index[half]);
+          _mm_storeu_si128((__m128i *)nib, nibble);
+          transition = _mm_setr_epi32(
+              IMAADPCM_transition_table[idx[0]][nib[0]], IMAADPCM_transition_table[idx[1]][nib[1]],
+              IMAADPCM_transition_table[idx[2]][nib[2]], IMAADPCM_transition_table[idx[3]][nib[3]]);
+          index[half] = _mm_and_si128(transition, index_mask);
+          /* 差分を加えて16bit幅にクリップ */
+          predict[half] = _mm_add_epi32(predict[half], _mm_srai_epi32(transition, 8));
+          predict[half] = _mm_min_epi32(_mm_max_epi32(predict[half], min_sample), max_sample);
+          _mm_storeu_si128((__m128i *)&decoded[smp][4 * half], predict[half]);
+        }
+      }
+
+      /* 各ブロックの出力位置に書き出し */
+      for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+        int16_t *dst = &buffer[ch][lane * num_samples_per_block + 1 + 8 * word];
+        for (smp = 0; smp < 8; smp++) {
+          dst[smp] = (int16_t)decoded[smp][lane];
+        }
+      }
+    }
+  }
+}
+
+/* 複数ブロックの同時デコード（AVX2） */
+/* 1レーンが1ブロックを担当し、IMAADPCM_NUM_SIMD_LANES個の完全なブロックを同時にデコードする */
+__attribute__((target("avx2")))
+static void IMAADPCMWAVDecoder_DecodeBlocksAVX2(
+    const uint8_t *data, uint32_t block_size, uint32_t num_channels,
+    uint32_t num_samples_per_block, int16_t **buffer)
+{
+  uint32_t ch, lane, word, smp;
+  int32_t buf[IMAADPCM_NUM_SIMD_LANES];
+  int32_t decoded[8][IMAADPCM_NUM_SIMD_LANES];
+  __m256i predict, index, codes, block_offset;
+  const uint32_t num_words = (block_size - 4 * num_channels) / (4 * num_channels);
+  const __m256i nibble_mask = _mm256_set1_epi32(0xF);
+  const __m256i index_mask = _mm256_set1_epi32(0xFF);
+  const __m256i min_sample = _mm256_set1_epi32(-32768);
+  const __m256i max_sample = _mm256_set1_epi32(32767);
+
+  assert((data != NULL) && (buffer != NULL));
+  assert(((block_size - 4 * num_channels) % (4 * num_channels)) == 0);
+  assert(num_samples_per_block == (num_words * 8 + 1));
+
+  /* 各レーンが担当するブロックの先頭オフセット */
+  block_offset = _mm256_mullo_epi32(
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int32_t)block_size));
+
+  for (ch = 0; ch < num_channels; ch++) {
+    /* ブロックヘッダデコード */
+    for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+      const uint8_t *block_header = &data[lane * block_size + 4 * ch];
+      buf[lane] = (int16_t)ByteArray_ReadUint16LE(block_header);
+      buffer[ch][lane * num_samples_per_block] = (int16_t)buf[lane];
+    }
+    predict = _mm256_loadu_si256((const __m256i *)buf);
+    for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+      buf[lane] = data[lane * block_size + 4 * ch + 2];
+    }
+    index = _mm256_loadu_si256((const __m256i *)buf);
+
+    /* ブロックデータデコード: 1ワード(8サンプル)ずつ全レーン同時に処理 */
+    for (word = 0; word < num_words; word++) {
+      const uint32_t word_offset = 4 * num_channels + (word * num_channels + ch) * 4;
+      /* 各ブロックから同じ位置のワードを集める（リトルエンディアン前提） */
+      codes = _mm256_i32gather_epi32((const int *)data,
+          _mm256_add_epi32(block_offset, _mm256_set1_epi32((int32_t)word_offset)), 1);
+
+      for (smp = 0; smp < 8; smp++) {
+        __m256i nibble, transition;
+        /* ニブル取り出し */
+        nibble = _mm256_and_si256(codes, nibble_mask);
+        codes = _mm256_srli_epi32(codes, 4);
+        /* 状態遷移テーブルから差分と次のインデックスを取得 */
+        transition = _mm256_i32gather_epi32((const int *)IMAADPCM_transition_table,
+            _mm256_add_epi32(_mm256_slli_epi32(index, 4), nibble), 4);
+        index = _mm256_and_si256(transition, index_mask);
+        /* 差分を加えて16bit幅にクリップ */
+        predict = _mm256_add_epi32(predict, _mm256_srai_epi32(transition, 8));
+        predict = _mm256_min_epi32(_mm256_max_epi32(predict, min_sample), max_sample);
+        _mm256_storeu_si256((__m256i *)decoded[smp], predict);
+      }
+
+      /* 各ブロックの出力位置に書き出し */
+      for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+        int16_t *dst = &buffer[ch][lane * num_samples_per_block + 1 + 8 * word];
+        for (smp = 0; smp < 8; smp++) {
+          dst[smp] = (int16_t)decoded[smp][lane];
+        }
+      }
+    }
+  }
+}
+
+/* 多チャンネルブロックのデコード（SSE4.1） */
+/* 1チャンネルを1レーンとし、各レーンが自チャンネルのワード（8サンプル）を1ステップ1ニブルずつ処理する */
+/* 4レーンのSSEレジスタを（4チャンネル以下なら1本、それ以上は2本）使用 */
+__attribute__((target("sse4.1")))
+static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockMultichannelSSE41(
+    struct IMAADPCMCoreDecoder *core_decoder, uint32_t num_channels,
+    const uint8_t *read_pos, uint32_t data_size,
+    int16_t **buffer, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
+{
+  IMAADPCMError err;
+  uint32_t ch, smp, smpl, half, num_word_samples, tmp_num_decode_samples;
+  int32_t buf[IMAADPCM_NUM_SIMD_LANES] = { 0, };
+  int32_t decoded[8][IMAADPCM_NUM_SIMD_LANES];
+  __m128i predict[2], index[2], codes[2];
+  const uint8_t *word_pos;
+  const uint32_t num_halves = (num_channels + 3) / 4;
+  const __m128i nibble_mask = _mm_set1_epi32(0xF);
+  const __m128i index_mask = _mm_set1_epi32(0xFF);
+  const __m128i min_sample = _mm_set1_epi32(-32768);
+  const __m128i max_sample = _mm_set1_epi32(32767);
+
+  /* 引数・ブロックヘッダの確認とデコード可能なサンプル数の計算 */
+  if ((err = IMAADPCMWAVDecoder_PrepareMultichannelBlock(core_decoder, num_channels,
+          read_pos, data_size, buffer, buffer_num_samples, &tmp_num_decode_samples)) != IMAADPCM_ERROR_OK) {
+    return err;
+  }
+
+  /* 使わないレーンは状態(0, 0)から始めて結果を捨てる */
+  for (ch = 0; ch < num_channels; ch++) {
+    buf[ch] = core_decoder[ch].sample_val;
+  }
+  predict[0] = _mm_loadu_si128((const __m128i *)&buf[0]);
+  predict[1] = _mm_loadu_si128((const __m128i *)&buf[4]);
+  for (ch = 0; ch < num_channels; ch++) {
+    buf[ch] = core_decoder[ch].stepsize_index;
+  }
+  index[0] = _mm_loadu_si128((const __m128i *)&buf[0]);
+  index[1] = _mm_loadu_si128((const __m128i *)&buf[4]);
+
+  /* ブロックデータデコード: 全チャンネルのワードを並べて1ステップずつ処理 */
+  word_pos = read_pos + 4 * num_channels;
+  for (smpl = 1; smpl < tmp_num_decode_samples; smpl += 8) {
+    for (ch = 0; ch < num_channels; ch++) {
+      buf[ch] = (int32_t)ByteArray_ReadUint32LE(&word_pos[4 * ch]);
+    }
+    codes[0] = _mm_loadu_si128((const __m128i *)&buf[0]);
+    codes[1] = _mm_loadu_si128((const __m128i *)&buf[4]);
+    word_pos += 4 * num_channels;
+
+    for (smp = 0; smp < 8; smp++) {
+      for (half = 0; half < num_halves; half++) {
+        int32_t idx[4], nib[4];
+        __m128i nibble, transition;
+        /* ニブル取り出し */
+        nibble = _mm_and_si128(codes[half], nibble_mask);
+        codes[half] = _mm_srli_epi32(codes[half], 4);
+        /* 状態遷移テーブルから差分と次のインデックスを取得 */
+        _mm_storeu_si128((__m128i *)idx, index[half]);
+        _mm_storeu_si128((__m128i *)nib, nibble);
+        transition = _mm_setr_epi32(
+            IMAADPCM_transition_table[idx[0]][nib[0]], IMAADPCM_transition_table[idx[1]][nib[1]],
+            IMAADPCM_transition_table[idx[2]][nib[2]], IMAADPCM_transition_table[idx[3]][nib[3]]);
+        index[half] = _mm_and_si128(transition, index_mask);
+        /* 差分を加えて16bit幅にクリップ */
+        predict[half] = _mm_add_epi32(predict[half], _mm_srai_epi32(transition, 8));
+        predict[half] = _mm_min_epi32(_mm_max_epi32(predict[half], min_sample), max_sample);
+        _mm_storeu_si128((__m128i *)&decoded[smp][4 * half], predict[half]);
+      }
+    }
+
+    /* サンプル数が 1 + (8の倍数) でない場合があるため、一旦バッファに受ける */
+    num_word_samples = IMAADPCM_MIN_VAL(8, tmp_num_decode_samples - smpl);
+    for (ch = 0; ch < num_channels; ch++) {
+      for (smp = 0; smp < num_word_samples; smp++) {
+        buffer[ch][smpl + smp] = (int16_t)decoded[smp][ch];
+      }
+    }
+  }
+
+  /* デコーダの状態を反映 */
+  _mm_storeu_si128((__m128i *)&buf[0], predict[0]);
+  _mm_storeu_si128((__m128i *)&buf[4], predict[1]);
+  for (ch = 0; ch < num_channels; ch++) {
+    core_decoder[ch].sample_val = (int16_t)buf[ch];
+  }
+  _mm_storeu_si128((__m128i *)&buf[0], index[0]);
+  _mm_storeu_si128((__m128i *)&buf[4], index[1]);
+  for (ch = 0; ch < num_channels; ch++) {
+    core_decoder[ch].stepsize_index = (int8_t)buf[ch];
+  }
+
+  /* デコードしたサンプル数をセット */
+  (*num_decode_samples) = tmp_num_decode_samples;
+  return IMAADPCM_ERROR_OK;
+}
+
+/* 多チャンネルブロックのデコード（AVX2） */
+/* 1チャンネルを1レーンとし、各レーンが自チャンネルのワード（8サンプル）を1ステップ1ニブルずつ処理する */
+/* 全チャンネルのワードはブロック内で連続して並ぶため、1回のロードで全レーンのワードが揃う */
+__attribute__((target("avx2")))
+static IMAADPCMError IMAADPCMWAVDecoder_DecodeBlockMultichannelAVX2(
+    struct IMAADPCMCoreDecoder *core_decoder, uint32_t num_channels,
+    const uint8_t *read_pos, uint32_t data_size,
+    int16_t **buffer, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
+{
+  IMAADPCMError err;
+  uint32_t ch, smp, smpl, num_word_samples, tmp_num_decode_samples;
+  int32_t buf[IMAADPCM_NUM_SIMD_LANES] = { 0, };
+  int32_t decoded[8][IMAADPCM_NUM_SIMD_LANES];
+  __m256i predict, index, codes, lane_mask;
+  const uint8_t *word_pos;
+  const __m256i nibble_mask = _mm256_set1_epi32(0xF);
+  const __m256i index_mask = _mm256_set1_epi32(0xFF);
+  const __m256i min_sample = _mm256_set1_epi32(-32768);
+  const __m256i max_sample = _mm256_set1_epi32(32767);
+
+  /* 引数・ブロックヘッダの確認とデコード可能なサンプル数の計算 */
+  if ((err = IMAADPCMWAVDecoder_PrepareMultichannelBlock(core_decoder, num_channels,
+          read_pos, data_size, buffer, buffer_num_samples, &tmp_num_decode_samples)) != IMAADPCM_ERROR_OK) {
+    return err;
+  }
+
+  /* 使わないレーンは状態(0, 0)から始めて結果を捨てる */
+  for (ch = 0; ch < num_channels; ch++) {
+    buf[ch] = core_decoder[ch].sample_val;
+  }
+  predict = _mm256_loadu_si256((const __m256i *)buf);
+  for (ch = 0; ch < num_channels; ch++) {
+    buf[ch] = core_decoder[ch].stepsize_index;
+  }
+  index = _mm256_loadu_si256((const __m256i *)buf);
+
+  /* チャンネルが割り当てられたレーンのマスク */
+  lane_mask = _mm256_cmpgt_epi32(
+      _mm256_set1_epi32((int32_t)num_channels), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+  /* ブロックデータデコード: 全チャンネルのワードを並べて1ステップずつ処理 */
+  word_pos = read_pos + 4 * num_channels;
+  for (smpl = 1; smpl < tmp_num_decode_samples; smpl += 8) {
+    /* 全チャンネルのワードを一度に読み込む（リトルエンディアン前提, 使わないレーンは読まない） */
+    codes = _mm256_maskload_epi32((const int *)word_pos, lane_mask);
+    word_pos += 4 * num_channels;
+
+    for (smp = 0; smp < 8; smp++) {
+      __m256i nibble, transition;
+      /* ニブル取り出し */
+      nibble = _mm256_and_si256(codes, nibble_mask);
+      codes = _mm256_srli_epi32(codes, 4);
+      /* 状態遷移テーブルから差分と次のインデックスを取得 */
+      transition = _mm256_i32gather_epi32((const int *)IMAADPCM_transition_table,
+          _mm256_add_epi32(_mm256_slli_epi32(index, 4), nibble), 4);
+      index = _mm256_and_si256(transition, index_mask);
+      /* 差分を加えて16bit幅にクリップ */
+      predict = _mm256_add_epi32(predict, _mm256_srai_epi32(transition, 8));
+      predict = _mm256_min_epi32(_mm256_max_epi32(predict, min_sample), max_sample);
+      _mm256_storeu_si256((__m256i *)decoded[smp], predict);
+    }
+
+    /* サンプル数が 1 + (8の倍数) でない場合があるため、一旦バッファに受ける */
+    num_word_samples = IMAADPCM_MIN_VAL(8, tmp_num_decode_samples - smpl);
+    for (ch = 0; ch < num_channels; ch++) {
+      for (smp = 0; smp < num_word_samples; smp++) {
+        buffer[ch][smpl + smp] = (int16_t)decoded[smp][ch];
+      }
+    }
+  }
+
+  /* デコーダの状態を反映 */
+  _mm256_storeu_si256((__m256i *)buf, predict);
+  for (ch = 0; ch < num_channels; ch++) {
+    core_decoder[ch].sample_val = (int16_t)buf[ch];
+  }
+  _mm256_storeu_si256((__m256i *)buf, index);
+  for (ch = 0; ch < num_channels; ch++) {
+    core_decoder[ch].stepsize_index = (int8_t)buf[ch];
+  }
+
+  /* デコードしたサンプル数をセット */
+  (*num_decode_samples) = tmp_num_decode_samples;
+  return IMAADPCM_ERROR_OK;
+}
+#endif /* IMAADPCM_USE_X86_SIMD */
+
+/* 内部エラー型をAPI結果型に変換 */
+static IMAADPCMApiResult IMAADPCM_ConvertErrorToApiResult(IMAADPCMError err)
+{
+  switch (err) {
+    case IMAADPCM_ERROR_OK:
+      return IMAADPCM_APIRESULT_OK;
+    case IMAADPCM_ERROR_INVALID_ARGUMENT:
+      return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+    case IMAADPCM_ERROR_INVALID_FORMAT:
+      return IMAADPCM_APIRESULT_INVALID_FORMAT;
+    case IMAADPCM_ERROR_INSUFFICIENT_BUFFER:
+      return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+    default:
+      break;
+  }
+
+  return IMAADPCM_APIRESULT_NG;
+}
+
+/* 単一データブロックデコード */
+static IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeBlock(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size, 
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples, 
+    uint32_t *num_decode_samples)
+{
+  IMAADPCMError err;
+  const struct IMAADPCMWAVHeaderInfo *header;
+
+  /* 引数チェック */
+  if ((decoder == NULL) || (data == NULL)
+      || (buffer == NULL) || (num_decode_samples == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  header = &(decoder->header);
+
+  /* バッファサイズチェック */
+  if (buffer_num_channels < header->num_channels) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+  }
+
+  /* 対応していないチャンネル数 */
+  if ((header->num_channels == 0) || (header->num_channels > IMAADPCM_MAX_NUM_CHANNELS)) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* ブロックデコード */
+  err = decoder->functions.decode_block[header->num_channels - 1](decoder->core_decoder,
+      header->num_channels, data, data_size, buffer, buffer_num_samples, num_decode_samples);
+
+  return IMAADPCM_ConvertErrorToApiResult(err);
+}
+
+/* ブロック列のデコード */
+/* ファイル先頭からread_offsetの位置にあるブロックから順に、出力位置progressからデコードする */
+/* 出力位置がend_progressに達するか、ファイル先頭からdata_endまでのデータを読み切ったら終了 */
+/* decode_progressがNULLでなければ終了時の出力位置を返す */
+static IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeBlockSequence(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_end, uint64_t read_offset,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t progress, uint32_t end_progress, uint32_t *decode_progress)
+{
+  IMAADPCMApiResult ret;
+  uint32_t ch, read_block_size, num_decode_samples, simd_num_samples_per_block;
+  const uint8_t *read_pos;
+  int16_t *buffer_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+  const struct IMAADPCMWAVHeaderInfo *header;
+  IMAADPCMDecodeBlocksFunction decode_blocks;
+
+  assert((decoder != NULL) && (data != NULL) && (buffer != NULL));
+
+  header = &(decoder->header);
+  assert((header->num_channels > 0) && (header->num_channels <= IMAADPCM_MAX_NUM_CHANNELS));
+
+  /* 複数ブロック同時デコード関数はハンドル作成時（カーネル設定時）に選択済み */
+  decode_blocks = decoder->functions.decode_blocks[header->num_channels - 1];
+
+  /* 同時デコードはブロックのデータ部がワード（チャンネルあたり4byte）単位で割り切れる時のみ */
+  simd_num_samples_per_block = 0;
+  if ((decode_blocks != NULL)
+      && (header->block_size > (4 * header->num_channels))
+      && (((header->block_size - 4 * header->num_channels) % (4 * header->num_channels)) == 0)) {
+    simd_num_samples_per_block
+      = (uint32_t)((header->block_size - 4 * header->num_channels) * 2) / header->num_channels + 1;
+  }
+
+  read_pos = data + read_offset;
+  while ((progress < end_progress) && (read_offset < data_end)) {
+    /* 全レーンを完全なブロックで埋められるならば同時デコード */
+    if ((simd_num_samples_per_block > 0)
+        && ((data_end - read_offset) >= (IMAADPCM_NUM_SIMD_LANES * header->block_size))
+        && ((progress + (IMAADPCM_NUM_SIMD_LANES - 1) * simd_num_samples_per_block) < end_progress)
+        && ((buffer_num_samples - progress) >= (IMAADPCM_NUM_SIMD_LANES * simd_num_samples_per_block))
+        && IMAADPCMWAVDecoder_CheckBlockHeaders(read_pos,
+          header->block_size, header->num_channels, IMAADPCM_NUM_SIMD_LANES)) {
+      for (ch = 0; ch < header->num_channels; ch++) {
+        buffer_ptr[ch] = &buffer[ch][progress];
+      }
+      decode_blocks(read_pos, header->block_size, header->num_channels,
+          simd_num_samples_per_block, buffer_ptr);
+      read_pos    += IMAADPCM_NUM_SIMD_LANES * header->block_size;
+      read_offset += IMAADPCM_NUM_SIMD_LANES * header->block_size;
+      progress    += IMAADPCM_NUM_SIMD_LANES * simd_num_samples_per_block;
+      continue;
+    }
+
+    /* 読み出しサイズの確定 */
+    read_block_size = (uint32_t)IMAADPCM_MIN_VAL(data_end - read_offset, header->block_size);
+    /* サンプル書き出し位置のセット */
+    for (ch = 0; ch < header->num_channels; ch++) {
+      buffer_ptr[ch] = &buffer[ch][progress];
+    }
+
+    /* ブロックデコード */
+    if ((ret = IMAADPCMWAVDecoder_DecodeBlock(decoder,
+          read_pos, read_block_size,
+          buffer_ptr, buffer_num_channels, buffer_num_samples - progress, 
+          &num_decode_samples)) != IMAADPCM_APIRESULT_OK) {
+      return ret;
+    }
+
+    /* 進捗更新 */
+    read_pos    += read_block_size;
+    read_offset += read_block_size;
+    progress    += num_decode_samples;
+  }
+
+  /* デコードを終えた位置 */
+  if (decode_progress != NULL) {
+    (*decode_progress) = progress;
+  }
+
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ヘッダ含めファイル全体をデコード */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWhole(
+    struct IMAADPCMWAVDecoder *decoder, const uint8_t *data, uint32_t data_size,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples)
+{
+  return IMAADPCMWAVDecoder_DecodeWhole64(decoder,
+      data, data_size, buffer, buffer_num_channels, buffer_num_samples);
+}
+
+/* ヘッダ含めファイル全体をデコード（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWhole64(
+    struct IMAADPCMWAVDecoder *decoder, const uint8_t *data, uint64_t data_size,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples)
+{
+  IMAADPCMApiResult ret;
+  const struct IMAADPCMWAVHeaderInfo *header;
+
+  /* 引数チェック */
+  if ((decoder == NULL) || (data == NULL) || (buffer == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ヘッダデコード */
+  if ((ret = IMAADPCMWAVDecoder_DecodeHeader64(data, data_size, &(decoder->header))) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+  header = &(decoder->header);
+
+  /* バッファサイズチェック */
+  if ((buffer_num_channels < header->num_channels)
+      || (buffer_num_samples < header->num_samples)) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+  }
+
+  /* 全ブロックを先頭から順にデコード */
+  return IMAADPCMWAVDecoder_DecodeBlockSequence(decoder,
+      data, data_size, header->header_size,
+      buffer, buffer_num_channels, buffer_num_samples, 0, header->num_samples, NULL);
+}
+
+/* チャンネル毎のint16サンプルを出力レイアウトに従って書き出し */
+/* 出力のprogressサンプル目からnum_samples個を書き出す */
+static void IMAADPCMWAVDecoder_StoreToLayout(
+    const struct IMAADPCMOutputLayout *layout,
+    int16_t **input, uint32_t num_channels, uint32_t num_samples,
+    void **buffer, uint32_t buffer_num_channels, uint32_t progress)
+{
+  uint32_t ch, smpl;
+
+  assert((layout != NULL) && (input != NULL) && (buffer != NULL));
+
+  /* インターリーブ時のストライドはbuffer_num_channels */
+  switch (layout->sample_format) {
+  case IMAADPCM_SAMPLE_FORMAT_INT16:
+    if (layout->interleaved) {
+      int16_t *dst = (int16_t *)buffer[0] + (size_t)progress * buffer_num_channels;
+      for (ch = 0; ch < num_channels; ch++) {
+        const int16_t *src = input[ch];
+        for (smpl = 0; smpl < num_samples; smpl++) {
+          dst[(size_t)smpl * buffer_num_channels + ch] = src[smpl];
+        }
+      }
+    } else {
+      for (ch = 0; ch < num_channels; ch++) {
+        memcpy((int16_t *)buffer[ch] + progress, input[ch], sizeof(int16_t) * num_samples);
+      }
+    }
+    break;
+  case IMAADPCM_SAMPLE_FORMAT_INT32:
+    for (ch = 0; ch < num_channels; ch++) {
+      const int16_t *src = input[ch];
+      int32_t *dst;
+      uint32_t stride;
+      if (layout->interleaved) {
+        dst = (int32_t *)buffer[0] + (size_t)progress * buffer_num_channels + ch;
+        stride = buffer_num_channels;
+      } else {
+        dst = (int32_t *)buffer[ch] + progress;
+        stride = 1;
+      }
+      /* 上位16bitに左詰め */
+      for (smpl = 0; smpl < num_samples; smpl++) {
+        dst[(size_t)smpl * stride] = (int32_t)src[smpl] * 65536;
+      }
+    }
+    break;
+  case IMAADPCM_SAMPLE_FORMAT_FLOAT32:
+    for (ch = 0; ch < num_channels; ch++) {
+      const int16_t *src = input[ch];
+      float *dst;
+      uint32_t stride;
+      if (layout->interleaved) {
+        dst = (float *)buffer[0] + (size_t)progress * buffer_num_channels + ch;
+        stride = buffer_num_channels;
+      } else {
+        dst = (float *)buffer[ch] + progress;
+        stride = 1;
+      }
+      /* [-1,1)に正規化 */
+      for (smpl = 0; smpl < num_samples; smpl++) {
+        dst[(size_t)smpl * stride] = (float)src[smpl] * (1.0f / 32768.0f);
+      }
+    }
+    break;
+  default:
+    assert(0);
+  }
+}
+
+/* タイルをチャンネル毎に等分してtile_ptrに割り当て、チャンネルあたりのサンプル数を返す */
+static uint32_t IMAADPCM_SplitLayoutTile(int16_t *tile, uint32_t num_channels, int16_t **tile_ptr)
+{
+  uint32_t ch;
+  const uint32_t num_tile_samples = IMAADPCM_LAYOUT_TILE_NUM_SAMPLES / num_channels;
+
+  assert((tile != NULL) && (tile_ptr != NULL));
+  assert((num_channels > 0) && (num_channels <= IMAADPCM_MAX_NUM_CHANNELS));
+
+  for (ch = 0; ch < num_channels; ch++) {
+    tile_ptr[ch] = &tile[ch * num_tile_samples];
+  }
+
+  return num_tile_samples;
+}
+
+/* ブロック列を出力レイアウトに従ってデコード */
+/* 範囲はIMAADPCMWAVDecoder_DecodeBlockSequenceと同じ キャッシュに収まるタイルにint16でデコードしてから変換して書き出す */
+/* 出力バッファはend_progressを超えて書き出さない タイルにはIMAADPCM_LAYOUT_TILE_NUM_SAMPLES個の領域が必要 */
+static IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeBlockSequenceToLayout(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_end, uint64_t read_offset,
+    const struct IMAADPCMOutputLayout *layout,
+    void **buffer, uint32_t buffer_num_channels,
+    uint32_t progress, uint32_t end_progress, int16_t *tile)
+{
+  IMAADPCMApiResult ret;
+  uint32_t num_samples_per_block, num_tile_blocks, tile_num_samples;
+  uint32_t tile_end_progress, tile_progress;
+  uint64_t tile_data_end;
+  uint32_t read_block_size, num_block_samples, smpl, num_tile_samples;
+  int16_t *tile_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+  const struct IMAADPCMWAVHeaderInfo *header;
+
+  assert((decoder != NULL) && (data != NULL) && (layout != NULL) && (buffer != NULL) && (tile != NULL));
+
+  header = &(decoder->header);
+  assert((header->num_channels > 0) && (header->num_channels <= IMAADPCM_MAX_NUM_CHANNELS));
+
+  /* デコードできないブロック構成 */
+  if ((num_samples_per_block = IMAADPCMWAVDecoder_CalculateNumSamplesPerBlock(header)) == 0) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* タイルをチャンネル毎に分割 */
+  tile_num_samples = IMAADPCM_SplitLayoutTile(tile, header->num_channels, tile_ptr);
+
+  /* タイルに収まるブロック数 */
+  num_tile_blocks = tile_num_samples / num_samples_per_block;
+
+  while ((progress < end_progress) && (read_offset < data_end)) {
+    if (num_tile_blocks > 0) {
+      /* タイルに収まるだけのブロックをまとめてデコード */
+      tile_data_end = read_offset + IMAADPCM_MIN_VAL(data_end - read_offset, num_tile_blocks * header->block_size);
+      tile_end_progress = IMAADPCM_MIN_VAL(end_progress - progress, num_tile_blocks * num_samples_per_block);
+      if ((ret = IMAADPCMWAVDecoder_DecodeBlockSequence(decoder,
+              data, tile_data_end, read_offset,
+              tile_ptr, header->num_channels, tile_end_progress,
+              0, tile_end_progress, &tile_progress)) != IMAADPCM_APIRESULT_OK) {
+        return ret;
+      }
+      IMAADPCMWAVDecoder_StoreToLayout(layout,
+          tile_ptr, header->num_channels, tile_progress, buffer, buffer_num_channels, progress);
+      read_offset = tile_data_end;
+      progress += tile_progress;
+    } else {
+      /* タイルに収まらない大きなブロックは、ブロック内をタイル単位に分けてデコード */
+      read_block_size = (uint32_t)IMAADPCM_MIN_VAL(data_end - read_offset, header->block_size);
+      if (read_block_size < (4 * (uint32_t)header->num_channels)) {
+        return IMAADPCM_APIRESULT_INSUFFICIENT_DATA;
+      }
+      /* 途中で切れたブロックのサンプル数はブロックデコードと同じ計算 */
+      num_block_samples = ((read_block_size - 4 * (uint32_t)header->num_channels) * 2) / header->num_channels + 1;
+      num_block_samples = IMAADPCM_MIN_VAL(num_block_samples, num_samples_per_block);
+      num_block_samples = IMAADPCM_MIN_VAL(num_block_samples, end_progress - progress);
+      for (smpl = 0; smpl < num_block_samples; smpl += num_tile_samples) {
+        num_tile_samples = IMAADPCM_MIN_VAL(num_block_samples - smpl, tile_num_samples);
+        if ((ret = IMAADPCMWAVDecoder_DecodeBlockPartial(decoder, data + read_offset,
+                (smpl == 0) ? 0 : (smpl - 1), smpl, num_tile_samples, tile_ptr)) != IMAADPCM_APIRESULT_OK) {
+          return ret;
+        }
+        IMAADPCMWAVDecoder_StoreToLayout(layout,
+            tile_ptr, header->num_channels, num_tile_samples, buffer, buffer_num_channels, progress + smpl);
+      }
+      read_offset += read_block_size;
+      progress += num_block_samples;
+    }
+  }
+
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* 並列デコードのタスクコンテキスト */
+struct IMAADPCMDecodeTaskContext {
+  const struct IMAADPCMWAVDecoder       *decoder;
+  const uint8_t                         *data;
+  const struct IMAADPCMOutputLayout     *layout;                /* NULLならbufferに直接デコード */
+  int16_t                               **buffer;
+  void                                  **layout_buffer;        /* レイアウト指定時の出力先     */
+  uint32_t                              buffer_num_channels;
+  uint32_t                              buffer_num_samples;
+  uint32_t                              num_samples_per_block;  /* 完全なブロックのサンプル数   */
+  uint32_t                              num_blocks;             /* 並列にデコードするブロック数 */
+  uint32_t                              num_blocks_per_task;    /* タスクあたりのブロック数     */
+  IMAADPCMApiResult                     result[IMAADPCM_MAX_NUM_TASKS]; /* タスク毎の結果 */
+};
+
+/* 並列デコードのタスク */
+static void IMAADPCMWAVDecoder_DecodeTask(void *task_context, uint32_t task_index)
+{
+  uint32_t begin, end;
+  struct IMAADPCMWAVDecoder *task_decoder;
+  struct IMAADPCMDecodeTaskContext *context = (struct IMAADPCMDecodeTaskContext *)task_context;
+  const struct IMAADPCMWAVHeaderInfo *header = &(context->decoder->header);
+
+  assert(task_index < context->decoder->max_num_tasks);
+
+  /* 入出力位置はブロック番号から確定するため、デコーダの状態だけを各タスクで独立に持てばよい */
+  /* ワーク領域のタスク毎の領域にハンドルを複製して使う（複製はDestroyしないので自前確保の領域は解放されない） */
+  task_decoder = &(context->decoder->task_decoder[task_index]);
+  (*task_decoder) = *(context->decoder);
+
+  /* 担当するブロック範囲 */
+  begin = IMAADPCM_MIN_VAL(task_index * context->num_blocks_per_task, context->num_blocks);
+  end = IMAADPCM_MIN_VAL(begin + context->num_blocks_per_task, context->num_blocks);
+
+  if (context->layout != NULL) {
+    context->result[task_index] = IMAADPCMWAVDecoder_DecodeBlockSequenceToLayout(task_decoder,
+        context->data, header->header_size + (uint64_t)end * header->block_size,
+        header->header_size + (uint64_t)begin * header->block_size,
+        context->layout, context->layout_buffer, context->buffer_num_channels,
+        begin * context->num_samples_per_block, end * context->num_samples_per_block,
+        &(context->decoder->task_tile[(size_t)task_index * IMAADPCM_LAYOUT_TILE_NUM_SAMPLES]));
+  } else {
+    context->result[task_index] = IMAADPCMWAVDecoder_DecodeBlockSequence(task_decoder,
+        context->data, header->header_size + (uint64_t)end * header->block_size,
+        header->header_size + (uint64_t)begin * header->block_size,
+        context->buffer, context->buffer_num_channels, context->buffer_num_samples,
+        begin * context->num_samples_per_block, end * context->num_samples_per_block, NULL);
+  }
+}
+
+/* ヘッダ含めファイル全体を並列にデコード */
+/* layoutがNULLならbufferに、そうでなければlayout_bufferにレイアウトに従って書き出す */
+static IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWholeParallelCore(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    const struct IMAADPCMOutputLayout *layout, int16_t **buffer, void **layout_buffer,
+    uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context)
+{
+  IMAADPCMApiResult ret;
+  uint32_t task, num_blocks, num_samples_per_block;
+  const struct IMAADPCMWAVHeaderInfo *header;
+  struct IMAADPCMDecodeTaskContext context;
+
+  /* 引数チェック */
+  if ((decoder == NULL) || (data == NULL) || (num_tasks == 0)
+      || ((layout == NULL) && (buffer == NULL))
+      || ((layout != NULL) && (layout_buffer == NULL))) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 対応していない出力形式 */
+  if ((layout != NULL)
+      && (layout->sample_format != IMAADPCM_SAMPLE_FORMAT_INT16)
+      && (layout->sample_format != IMAADPCM_SAMPLE_FORMAT_INT32)
+      && (layout->sample_format != IMAADPCM_SAMPLE_FORMAT_FLOAT32)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ヘッダデコード */
+  if ((ret = IMAADPCMWAVDecoder_DecodeHeader64(data, data_size, &(decoder->header))) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+  header = &(decoder->header);
+
+  /* バッファサイズチェック */
   if ((buffer_num_channels < header->num_channels)
       || (buffer_num_samples < header->num_samples)) {
     return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
   }
 
-  progress = 0;
-  read_offset = header->header_size;
-  read_pos = data + header->header_size;
-  while ((progress < header->num_samples) && (read_offset < data_size)) {
-    /* 読み出しサイズの確定 */
-    read_block_size = IMAADPCM_MIN_VAL(data_size - read_offset, header->block_size);
-    /* サンプル書き出し位置のセット */
-    for (ch = 0; ch < header->num_channels; ch++) {
-      buffer_ptr[ch] = &buffer[ch][progress];
-    }
+  /* 並列にデコードするブロック数の計算 */
+  /* 手前のブロックが全て完全でバッファにも収まる、つまり入出力位置がブロック番号から確定するブロックが対象 */
+  num_blocks = 0;
+  num_samples_per_block = 0;
+  if ((header->block_size > (4 * header->num_channels)) && (data_size > header->header_size)) {
+    num_samples_per_block
+      = (uint32_t)((header->block_size - 4 * header->num_channels) * 2) / header->num_channels + 1;
+    num_blocks = (uint32_t)IMAADPCM_MIN_VAL((data_size - header->header_size) / header->block_size,
+        buffer_num_samples / num_samples_per_block);
+    num_blocks = IMAADPCM_MIN_VAL(num_blocks,
+        (header->num_samples + num_samples_per_block - 1) / num_samples_per_block);
+  }
+
+  /* タスク数の確定 タスク毎の領域が無いハンドルでは全て逐次デコード */
+  num_tasks = IMAADPCM_MIN_VAL(num_tasks, decoder->max_num_tasks);
+  num_tasks = IMAADPCM_MIN_VAL(num_tasks, num_blocks);
+  if (num_tasks == 0) {
+    num_blocks = 0;
+  }
+
+  /* ブロック列を分割して並列にデコード */
+  if (num_tasks > 0) {
+    context.decoder = decoder;
+    context.data = data;
+    context.layout = layout;
+    context.buffer = buffer;
+    context.layout_buffer = layout_buffer;
+    context.buffer_num_channels = buffer_num_channels;
+    context.buffer_num_samples = buffer_num_samples;
+    context.num_samples_per_block = num_samples_per_block;
+    context.num_blocks = num_blocks;
+    context.num_blocks_per_task = (num_blocks + num_tasks - 1) / num_tasks;
+
+    if (executor != NULL) {
+      executor(executor_context, IMAADPCMWAVDecoder_DecodeTask, &context, num_tasks);
+    } else {
+      for (task = 0; task < num_tasks; task++) {
+        IMAADPCMWAVDecoder_DecodeTask(&context, task);
+      }
+    }
+
+    /* 先頭側のタスクのエラーを優先して返す（逐次デコードと同じ結果になる） */
+    for (task = 0; task < num_tasks; task++) {
+      if (context.result[task] != IMAADPCM_APIRESULT_OK) {
+        return context.result[task];
+      }
+    }
+  }
+
+  /* 残りのブロックは呼び出しスレッドで逐次デコード */
+  if (layout != NULL) {
+    int16_t tile[IMAADPCM_LAYOUT_TILE_NUM_SAMPLES];
+    return IMAADPCMWAVDecoder_DecodeBlockSequenceToLayout(decoder,
+        data, data_size, header->header_size + (uint64_t)num_blocks * header->block_size,
+        layout, layout_buffer, buffer_num_channels,
+        num_blocks * num_samples_per_block, header->num_samples, tile);
+  }
+  return IMAADPCMWAVDecoder_DecodeBlockSequence(decoder,
+      data, data_size, header->header_size + (uint64_t)num_blocks * header->block_size,
+      buffer, buffer_num_channels, buffer_num_samples,
+      num_blocks * num_samples_per_block, header->num_samples, NULL);
+}
+
+/* ヘッダ含めファイル全体を並列にデコード */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWholeParallel(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context)
+{
+  return IMAADPCMWAVDecoder_DecodeWholeParallel64(decoder, data, data_size,
+      buffer, buffer_num_channels, buffer_num_samples,
+      num_tasks, executor, executor_context);
+}
+
+/* ヘッダ含めファイル全体を並列にデコード（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWholeParallel64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context)
+{
+  return IMAADPCMWAVDecoder_DecodeWholeParallelCore(decoder, data, data_size,
+      NULL, buffer, NULL, buffer_num_channels, buffer_num_samples,
+      num_tasks, executor, executor_context);
+}
+
+/* ヘッダ含めファイル全体を出力レイアウトに従って並列にデコード */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWholeParallelToLayout(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    const struct IMAADPCMOutputLayout *layout,
+    void **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context)
+{
+  return IMAADPCMWAVDecoder_DecodeWholeParallelToLayout64(decoder, data, data_size,
+      layout, buffer, buffer_num_channels, buffer_num_samples,
+      num_tasks, executor, executor_context);
+}
+
+/* ヘッダ含めファイル全体を出力レイアウトに従って並列にデコード（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWholeParallelToLayout64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    const struct IMAADPCMOutputLayout *layout,
+    void **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context)
+{
+  /* 引数チェック */
+  if (layout == NULL) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  return IMAADPCMWAVDecoder_DecodeWholeParallelCore(decoder, data, data_size,
+      layout, NULL, buffer, buffer_num_channels, buffer_num_samples,
+      num_tasks, executor, executor_context);
+}
+
+/* ヘッダ情報からデコード結果の1チャンネルあたりサンプル数と、出力レイアウトで必要なバッファサイズ[byte]（全チャンネル合計）を計算（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVDecoder_CalculateOutputSize64(
+    const struct IMAADPCMWAVHeaderInfo *header_info, const struct IMAADPCMOutputLayout *layout,
+    uint32_t *num_samples, uint64_t *buffer_size)
+{
+  uint32_t sample_size;
+
+  /* 引数チェック */
+  if ((header_info == NULL) || (layout == NULL) || (num_samples == NULL) || (buffer_size == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 対応していないブロック構成 */
+  if (IMAADPCMWAVDecoder_CalculateNumSamplesPerBlock(header_info) == 0) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* サンプルあたりのバイト数 */
+  switch (layout->sample_format) {
+    case IMAADPCM_SAMPLE_FORMAT_INT16:
+      sample_size = sizeof(int16_t);
+      break;
+    case IMAADPCM_SAMPLE_FORMAT_INT32:
+      sample_size = sizeof(int32_t);
+      break;
+    case IMAADPCM_SAMPLE_FORMAT_FLOAT32:
+      sample_size = sizeof(float);
+      break;
+    default:
+      return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* デコード関数はヘッダのサンプル数だけ出力する */
+  (*num_samples) = header_info->num_samples;
+  (*buffer_size) = (uint64_t)header_info->num_samples * header_info->num_channels * sample_size;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ヘッダ情報からデコード結果の1チャンネルあたりサンプル数と、出力レイアウトで必要なバッファサイズ[byte]（全チャンネル合計）を計算 */
+IMAADPCMApiResult IMAADPCMWAVDecoder_CalculateOutputSize(
+    const struct IMAADPCMWAVHeaderInfo *header_info, const struct IMAADPCMOutputLayout *layout,
+    uint32_t *num_samples, uint32_t *buffer_size)
+{
+  IMAADPCMApiResult ret;
+  uint32_t tmp_num_samples;
+  uint64_t tmp_buffer_size;
+
+  /* 引数チェック */
+  if ((num_samples == NULL) || (buffer_size == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  if ((ret = IMAADPCMWAVDecoder_CalculateOutputSize64(header_info, layout,
+          &tmp_num_samples, &tmp_buffer_size)) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* 32bitで表せないサイズは64bit版のAPIを使う */
+  if (tmp_buffer_size > UINT32_MAX) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  (*num_samples) = tmp_num_samples;
+  (*buffer_size) = (uint32_t)tmp_buffer_size;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ヘッダ含めファイル全体を出力レイアウトに従ってデコード */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWholeToLayout(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    const struct IMAADPCMOutputLayout *layout,
+    void **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples)
+{
+  return IMAADPCMWAVDecoder_DecodeWholeToLayout64(decoder, data, data_size,
+      layout, buffer, buffer_num_channels, buffer_num_samples);
+}
+
+/* ヘッダ含めファイル全体を出力レイアウトに従ってデコード（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWholeToLayout64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    const struct IMAADPCMOutputLayout *layout,
+    void **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples)
+{
+  /* 1タスクで呼び出しスレッドから実行すれば先頭から順にデコードする */
+  return IMAADPCMWAVDecoder_DecodeWholeParallelToLayout64(decoder, data, data_size,
+      layout, buffer, buffer_num_channels, buffer_num_samples, 1, NULL, NULL);
+}
+
+/* ヘッダエンコード */
+/* reserve_ds64が1の場合は、dataチャンクが4GB以下でもds64チャンクの領域をJUNKチャンクとして予約する */
+/* （後で総サンプル数が確定してからRF64のヘッダに書き換えられるように） */
+static IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeHeaderCore(
+    const struct IMAADPCMWAVHeaderInfo *header_info, uint8_t reserve_ds64, uint8_t *data, uint32_t data_size)
+{
+  uint8_t *data_pos;
+  uint32_t header_size, is_rf64, is_extensible;
+  uint64_t data_chunk_size;
+
+  /* 引数チェック */
+  if ((header_info == NULL) || (data == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ヘッダの簡易チェック: ブロックサイズはサンプルデータを全て入れられるはず */
+  if (IMAADPCM_CALCULATE_DATASIZE_BYTE(header_info->num_samples_per_block, header_info->bits_per_sample) > header_info->block_size) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+  
+  /* チャンネル数 */
+  if ((header_info->num_channels == 0) || (header_info->num_channels > IMAADPCM_MAX_NUM_CHANNELS)) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* データサイズ計算（エンコード関数が実際に書き出すサイズ） */
+  assert(header_info->num_samples_per_block != 0);
+  data_chunk_size = IMAADPCMWAVEncoder_CalculateDataChunkSize(header_info);
+
+  /* ヘッダサイズと入力データサイズの比較 */
+  is_extensible = IMAADPCM_USE_EXTENSIBLE_FORMAT(header_info->num_channels) ? 1 : 0;
+  header_size = IMAADPCMWAVEncoder_CalculateHeaderSize(header_info, data_chunk_size, reserve_ds64);
+  if (data_size < header_size) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_DATA;
+  }
+
+  /* RIFFチャンクのサイズが32bitに収まらなければRF64 */
+  is_rf64 = ((header_size - 8 + data_chunk_size) > UINT32_MAX) ? 1 : 0;
+
+  /* 書き出し用ポインタ設定 */
+  data_pos = data;
+
+  /* RIFFチャンクID */
+  ByteArray_PutUint8(data_pos, 'R');
+  ByteArray_PutUint8(data_pos, is_rf64 ? 'F' : 'I');
+  ByteArray_PutUint8(data_pos, is_rf64 ? '6' : 'F');
+  ByteArray_PutUint8(data_pos, is_rf64 ? '4' : 'F');
+  /* RIFFチャンクサイズ: RF64では-1としてds64チャンクに書く */
+  ByteArray_PutUint32LE(data_pos, is_rf64 ? 0xFFFFFFFFUL : (uint32_t)(header_size - 8 + data_chunk_size));
+  /* WAVEチャンクID */
+  ByteArray_PutUint8(data_pos, 'W');
+  ByteArray_PutUint8(data_pos, 'A');
+  ByteArray_PutUint8(data_pos, 'V');
+  ByteArray_PutUint8(data_pos, 'E');
+
+  /* ds64チャンク（4GB以下ならその予約領域のJUNKチャンク） */
+  if (header_size == (IMAADPCMWAVENCODER_RF64_HEADER_SIZE + (is_extensible ? IMAADPCM_EXTENSIBLE_FMT_EXTRA_SIZE : 0))) {
+    const uint64_t riff_size = is_rf64 ? (header_size - 8 + data_chunk_size) : 0;
+    const uint64_t ds64_data_size = is_rf64 ? data_chunk_size : 0;
+    const uint64_t ds64_num_samples = is_rf64 ? header_info->num_samples : 0;
+    ByteArray_PutUint8(data_pos, is_rf64 ? 'd' : 'J');
+    ByteArray_PutUint8(data_pos, is_rf64 ? 's' : 'U');
+    ByteArray_PutUint8(data_pos, is_rf64 ? '6' : 'N');
+    ByteArray_PutUint8(data_pos, is_rf64 ? '4' : 'K');
+    ByteArray_PutUint32LE(data_pos, IMAADPCM_DS64_CHUNK_SIZE - 8);
+    /* RIFFサイズ・dataサイズ・サンプル数（64bit）とテーブル長（テーブルは書き出さない） */
+    ByteArray_PutUint32LE(data_pos, (uint32_t)(riff_size & 0xFFFFFFFFUL));
+    ByteArray_PutUint32LE(data_pos, (uint32_t)(riff_size >> 32));
+    ByteArray_PutUint32LE(data_pos, (uint32_t)(ds64_data_size & 0xFFFFFFFFUL));
+    ByteArray_PutUint32LE(data_pos, (uint32_t)(ds64_data_size >> 32));
+    ByteArray_PutUint32LE(data_pos, (uint32_t)(ds64_num_samples & 0xFFFFFFFFUL));
+    ByteArray_PutUint32LE(data_pos, (uint32_t)(ds64_num_samples >> 32));
+    ByteArray_PutUint32LE(data_pos, 0);
+  }
+
+  /* FMTチャンクID */
+  ByteArray_PutUint8(data_pos, 'f');
+  ByteArray_PutUint8(data_pos, 'm');
+  ByteArray_PutUint8(data_pos, 't');
+  ByteArray_PutUint8(data_pos, ' ');
+  /* FMTチャンクサイズ: 20（WAVE_FORMAT_EXTENSIBLE形式では40） */
+  ByteArray_PutUint32LE(data_pos, is_extensible ? (20 + IMAADPCM_EXTENSIBLE_FMT_EXTRA_SIZE) : 20);
+  /* WAVEフォーマットタイプ: IMA-ADPCM(17)（WAVE_FORMAT_EXTENSIBLE形式では0xFFFE） */
+  ByteArray_PutUint16LE(data_pos, is_extensible ? 0xFFFE : 17);
+  /* チャンネル数 */
+  ByteArray_PutUint16LE(data_pos, header_info->num_channels);
+  /* サンプリングレート */
+  ByteArray_PutUint32LE(data_pos, header_info->sampling_rate);
+  /* データ速度[byte/sec] */
+  ByteArray_PutUint32LE(data_pos, header_info->bytes_per_sec);
+  /* ブロックサイズ */
+  ByteArray_PutUint16LE(data_pos, header_info->block_size);
+  /* サンプルあたりビット数: 4で決め打ち */
+  if (header_info->bits_per_sample != IMAADPCM_BITS_PER_SAMPLE) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+  ByteArray_PutUint16LE(data_pos, header_info->bits_per_sample);
+  /* fmtチャンクのエキストラサイズ: 2（WAVE_FORMAT_EXTENSIBLE形式では22） */
+  ByteArray_PutUint16LE(data_pos, is_extensible ? (2 + IMAADPCM_EXTENSIBLE_FMT_EXTRA_SIZE) : 2);
+  /* ブロックあたりサンプル数（WAVE_FORMAT_EXTENSIBLE形式ではwSamplesPerBlockとして同じ位置） */
+  ByteArray_PutUint16LE(data_pos, header_info->num_samples_per_block);
+  if (is_extensible) {
+    uint32_t i;
+    /* チャンネル配置 */
+    ByteArray_PutUint32LE(data_pos, header_info->channel_mask);
+    /* サブフォーマットGUID: IMA-ADPCM */
+    for (i = 0; i < sizeof(IMAADPCM_extensible_subformat_guid); i++) {
+      ByteArray_PutUint8(data_pos, IMAADPCM_extensible_subformat_guid[i]);
+    }
+  }
+
+  /* FACTチャンクID */
+  ByteArray_PutUint8(data_pos, 'f');
+  ByteArray_PutUint8(data_pos, 'a');
+  ByteArray_PutUint8(data_pos, 'c');
+  ByteArray_PutUint8(data_pos, 't');
+  /* FACTチャンクのエキストラサイズ: 4で決め打ち */
+  ByteArray_PutUint32LE(data_pos, 4);
+  /* サンプル数 */
+  ByteArray_PutUint32LE(data_pos, header_info->num_samples);
+
+  /* その他のチャンクは書き出さず、すぐにdataチャンクへ */
+
+  /* dataチャンクID */
+  ByteArray_PutUint8(data_pos, 'd');
+  ByteArray_PutUint8(data_pos, 'a');
+  ByteArray_PutUint8(data_pos, 't');
+  ByteArray_PutUint8(data_pos, 'a');
+  /* データチャンクサイズ: RF64では-1としてds64チャンクに書く */
+  ByteArray_PutUint32LE(data_pos, is_rf64 ? 0xFFFFFFFFUL : (uint32_t)data_chunk_size);
+  assert((uint32_t)(data_pos - data) == header_size);
+
+  /* 成功終了 */
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ヘッダエンコード */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeHeader(
+    const struct IMAADPCMWAVHeaderInfo *header_info, uint8_t *data, uint32_t data_size)
+{
+  return IMAADPCMWAVEncoder_EncodeHeaderCore(header_info, 0, data, data_size);
+}
+
+/* エンコーダワークサイズ計算（max_num_tasksタスク分の並列エンコードの領域を含める） */
+static int32_t IMAADPCMWAVEncoder_CalculateWorkSizeInternal(uint32_t max_num_tasks)
+{
+  assert(max_num_tasks <= IMAADPCM_MAX_NUM_TASKS);
+
+  /* ハンドル (+ タスク毎の状態とタイル) */
+  return (int32_t)(IMAADPCM_ALIGNMENT + sizeof(struct IMAADPCMWAVEncoder)
+    + max_num_tasks * (IMAADPCM_ROUND_UP(sizeof(struct IMAADPCMWAVEncoder), IMAADPCM_ALIGNMENT)
+        + sizeof(int16_t) * IMAADPCM_LAYOUT_TILE_NUM_SAMPLES));
+}
+
+/* エンコーダハンドル作成（max_num_tasksタスク分の並列エンコードの領域を割り当てる） */
+static struct IMAADPCMWAVEncoder *IMAADPCMWAVEncoder_CreateInternal(
+    void *work, int32_t work_size, uint32_t max_num_tasks)
+{
+  struct IMAADPCMWAVEncoder *encoder;
+  uint8_t *work_ptr;
+  uint32_t alloced_by_malloc = 0;
+
+  /* 領域自前確保の場合 */
+  if ((work == NULL) && (work_size == 0)) {
+    work_size = IMAADPCMWAVEncoder_CalculateWorkSizeInternal(max_num_tasks);
+    work = malloc((uint32_t)work_size);
+    alloced_by_malloc = 1;
+  }
+
+  /* 引数チェック */
+  if ((work == NULL) || (work_size < IMAADPCMWAVEncoder_CalculateWorkSizeInternal(max_num_tasks))) {
+    return NULL;
+  }
+
+  work_ptr = (uint8_t *)work;
+
+  /* アラインメントを揃えてから構造体を配置 */
+  work_ptr = (uint8_t *)IMAADPCM_ROUND_UP((uintptr_t)work_ptr, IMAADPCM_ALIGNMENT);
+  encoder = (struct IMAADPCMWAVEncoder *)work_ptr;
+
+  /* ハンドルの中身を0初期化 */
+  memset(encoder, 0, sizeof(struct IMAADPCMWAVEncoder));
+  work_ptr += sizeof(struct IMAADPCMWAVEncoder);
+
+  /* パラメータは未セット状態に */
+  encoder->set_parameter = 0;
+
+  /* 並列エンコードのタスク毎の状態とタイル */
+  encoder->max_num_tasks = max_num_tasks;
+  if (max_num_tasks > 0) {
+    work_ptr = (uint8_t *)IMAADPCM_ROUND_UP((uintptr_t)work_ptr, IMAADPCM_ALIGNMENT);
+    encoder->task_encoder = (struct IMAADPCMWAVEncoder *)work_ptr;
+    work_ptr += max_num_tasks * IMAADPCM_ROUND_UP(sizeof(struct IMAADPCMWAVEncoder), IMAADPCM_ALIGNMENT);
+    encoder->task_tile = (int16_t *)work_ptr;
+    work_ptr += max_num_tasks * sizeof(int16_t) * IMAADPCM_LAYOUT_TILE_NUM_SAMPLES;
+  }
+  assert((work_ptr - (uint8_t *)work) <= work_size);
+
+  /* 実行中のCPUに合わせたカーネルを設定 */
+  IMAADPCMWAVEncoder_BindKernel(encoder, IMAADPCM_GetDefaultKernel());
+
+  /* 自前確保の場合はメモリを記憶しておく */
+  encoder->work = alloced_by_malloc ? work : NULL;
+
+  return encoder;
+}
+
+/* エンコーダワークサイズ計算 */
+int32_t IMAADPCMWAVEncoder_CalculateWorkSize(void)
+{
+  return IMAADPCMWAVEncoder_CalculateWorkSizeInternal(0);
+}
+
+/* エンコーダハンドル作成 */
+struct IMAADPCMWAVEncoder *IMAADPCMWAVEncoder_Create(void *work, int32_t work_size)
+{
+  return IMAADPCMWAVEncoder_CreateInternal(work, work_size, 0);
+}
+
+/* 並列エンコード用のワークサイズ計算 */
+int32_t IMAADPCMWAVEncoder_CalculateParallelWorkSize(uint32_t max_num_tasks)
+{
+  /* 引数チェック */
+  if ((max_num_tasks == 0) || (max_num_tasks > IMAADPCM_MAX_NUM_TASKS)) {
+    return -1;
+  }
+
+  return IMAADPCMWAVEncoder_CalculateWorkSizeInternal(max_num_tasks);
+}
+
+/* 並列エンコード用のエンコーダハンドル作成 */
+struct IMAADPCMWAVEncoder *IMAADPCMWAVEncoder_CreateParallel(uint32_t max_num_tasks, void *work, int32_t work_size)
+{
+  /* 引数チェック */
+  if ((max_num_tasks == 0) || (max_num_tasks > IMAADPCM_MAX_NUM_TASKS)) {
+    return NULL;
+  }
+
+  return IMAADPCMWAVEncoder_CreateInternal(work, work_size, max_num_tasks);
+}
+
+/* エンコーダハンドル破棄 */
+void IMAADPCMWAVEncoder_Destroy(struct IMAADPCMWAVEncoder *encoder)
+{
+  if (encoder != NULL) {
+    /* 自分で領域確保していたら破棄 */
+    if (encoder->work != NULL) {
+      free(encoder->work);
+    }
+  }
+}
+
+/* 差分の絶対値の量子化 min(floor(diffabs * 4 / stepsize), 7)を返す */
+/* 除算を使わず、商の上位ビットから順に比較して求める（3ビットの筆算） */
+/* 商が8以上の場合は全ビットが立ち7に飽和する 分岐予測が外れないよう比較結果はマスクで使う */
+static uint8_t IMAADPCMCoreEncoder_QuantizeDiff(int32_t diffabs, int32_t stepsize)
+{
+  int32_t mask, qbits;
+  int32_t rest = diffabs << 2;
+
+  assert((diffabs >= 0) && (stepsize > 0));
+
+  /* 商の4のビット */
+  mask = -(int32_t)(rest >= (stepsize << 2));
+  qbits = mask & 4;
+  rest -= mask & (stepsize << 2);
+  /* 商の2のビット */
+  mask = -(int32_t)(rest >= (stepsize << 1));
+  qbits |= mask & 2;
+  rest -= mask & (stepsize << 1);
+  /* 商の1のビット */
+  qbits |= (int32_t)(rest >= stepsize);
+
+  return (uint8_t)qbits;
+}
+
+/* 1サンプルエンコード */
+static uint8_t IMAADPCMCoreEncoder_EncodeSample(
+    struct IMAADPCMCoreEncoder *encoder, int16_t sample)
+{
+  uint8_t nibble;
+  int32_t prev, idx, diff, diffabs, sign, transition;
+
+  assert(encoder != NULL);
+  
+  /* 頻繁に参照する変数をオート変数に受ける */
+  prev = encoder->prev_sample;
+  idx = encoder->stepsize_index;
+
+  /* 差分 */
+  diff = sample - prev;
+  sign = diff < 0;
+  diffabs = sign ? -diff : diff;
+
+  /* 差分を符号表現に変換 */
+  /* nibble = sign(diff) * min(floor(|diff| * 4 / stepsize), 7) */
+  nibble = IMAADPCMCoreEncoder_QuantizeDiff(diffabs, IMAADPCM_stepsize_table[idx]);
+  /* nibbleの最上位ビットは符号ビット */
+  nibble = (uint8_t)(nibble | (sign << 3));
+
+  /* 量子化した差分と次のインデックスは状態遷移テーブルから得る（デコーダと同じ計算） */
+  transition = IMAADPCM_transition_table[idx][nibble];
+
+  /* 量子化した差分を加える */
+  prev += transition >> 8;
+  prev = IMAADPCM_INNER_VAL(prev, -32768, 32767);
+
+  /* 計算結果の反映 */
+  encoder->prev_sample = (int16_t)prev;
+  encoder->stepsize_index = (int8_t)(transition & 0xFF);
+
+  return nibble;
+}
+
+/* モノラルブロックのエンコード */
+static IMAADPCMError IMAADPCMWAVEncoder_EncodeBlockMono(
+    struct IMAADPCMCoreEncoder *core_encoder, uint32_t num_channels,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+  uint8_t u8buf;
+  uint8_t nibble[2];
+  uint32_t smpl;
+  uint8_t *data_pos = data;
+
+  /* 引数チェック */
+  if ((core_encoder == NULL) || (num_channels != 1) || (input == NULL)
+      || (data == NULL) || (output_size == NULL)) {
+    return IMAADPCM_ERROR_INVALID_ARGUMENT;
+  }
+
+  /* 十分なデータサイズがあるか確認 */
+  if (data_size < IMAADPCMWAVEncoder_CalculateBlockOutputSize(num_channels, num_samples)) {
+    return IMAADPCM_ERROR_INSUFFICIENT_DATA;
+  }
+
+  /* 先頭サンプルをエンコーダにセット */
+  core_encoder->prev_sample = input[0][0];
+
+  /* ブロックヘッダエンコード */
+  ByteArray_PutUint16LE(data_pos, core_encoder->prev_sample);
+  ByteArray_PutUint8(data_pos, core_encoder->stepsize_index);
+  ByteArray_PutUint8(data_pos, 0); /* reserved */
+
+  /* ブロックデータエンコード */
+  /* 末尾のバイトで入力の範囲外になるサンプルは最終サンプルで埋める */
+  for (smpl = 1; smpl < num_samples; smpl += 2) {
+    assert((uint32_t)(data_pos - data) < data_size);
+    nibble[0] = IMAADPCMCoreEncoder_EncodeSample(core_encoder, input[0][smpl + 0]);
+    nibble[1] = IMAADPCMCoreEncoder_EncodeSample(core_encoder, input[0][IMAADPCM_MIN_VAL(smpl + 1, num_samples - 1)]);
+    assert((nibble[0] <= 0xF) && (nibble[1] <= 0xF));
+    u8buf = (uint8_t)((nibble[0] << 0) | (nibble[1] << 4));
+    ByteArray_PutUint8(data_pos, u8buf);
+  }
+
+  /* 書き出しサイズをセット */
+  (*output_size) = (uint32_t)(data_pos - data);
+  return IMAADPCM_ERROR_OK;
+}
+
+/* ステレオブロックのエンコード */
+static IMAADPCMError IMAADPCMWAVEncoder_EncodeBlockStereo(
+    struct IMAADPCMCoreEncoder *core_encoder, uint32_t num_channels,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+  uint32_t u32buf;
+  uint8_t nibble[8];
+  uint32_t ch, smpl;
+  uint8_t *data_pos = data;
+
+  /* 引数チェック */
+  if ((core_encoder == NULL) || (num_channels != 2) || (input == NULL)
+      || (data == NULL) || (output_size == NULL)) {
+    return IMAADPCM_ERROR_INVALID_ARGUMENT;
+  }
+
+  /* 十分なデータサイズがあるか確認 */
+  if (data_size < IMAADPCMWAVEncoder_CalculateBlockOutputSize(num_channels, num_samples)) {
+    return IMAADPCM_ERROR_INSUFFICIENT_DATA;
+  }
+
+  /* 先頭サンプルをエンコーダにセット */
+  for (ch = 0; ch < 2; ch++) {
+    core_encoder[ch].prev_sample = input[ch][0];
+  }
+
+  /* ブロックヘッダエンコード */
+  for (ch = 0; ch < 2; ch++) {
+    ByteArray_PutUint16LE(data_pos, core_encoder[ch].prev_sample);
+    ByteArray_PutUint8(data_pos, core_encoder[ch].stepsize_index);
+    ByteArray_PutUint8(data_pos, 0); /* reserved */
+  }
+
+  /* ブロックデータエンコード */
+  for (smpl = 1; smpl < num_samples; smpl += 8) {
+    for (ch = 0; ch < 2; ch++) {
+      const int16_t *pinput = &input[ch][smpl];
+      int16_t tail[8];
+      /* 末尾のワードで入力の範囲外になるサンプルは最終サンプルで埋める */
+      if ((smpl + 8) > num_samples) {
+        uint32_t smp;
+        for (smp = 0; smp < 8; smp++) {
+          tail[smp] = input[ch][IMAADPCM_MIN_VAL(smpl + smp, num_samples - 1)];
+        }
+        pinput = tail;
+      }
+      assert((uint32_t)(data_pos - data) < data_size);
+      nibble[0] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), pinput[0]);
+      nibble[1] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), pinput[1]);
+      nibble[2] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), pinput[2]);
+      nibble[3] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), pinput[3]);
+      nibble[4] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), pinput[4]);
+      nibble[5] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), pinput[5]);
+      nibble[6] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), pinput[6]);
+      nibble[7] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), pinput[7]);
+      assert((nibble[0] <= 0xF) && (nibble[1] <= 0xF) && (nibble[2] <= 0xF) && (nibble[3] <= 0xF)
+          && (nibble[4] <= 0xF) && (nibble[5] <= 0xF) && (nibble[6] <= 0xF) && (nibble[7] <= 0xF));
+      u32buf  = (uint32_t)(nibble[0] <<  0);
+      u32buf |= (uint32_t)(nibble[1] <<  4);
+      u32buf |= (uint32_t)(nibble[2] <<  8);
+      u32buf |= (uint32_t)(nibble[3] << 12);
+      u32buf |= (uint32_t)(nibble[4] << 16);
+      u32buf |= (uint32_t)(nibble[5] << 20);
+      u32buf |= (uint32_t)(nibble[6] << 24);
+      u32buf |= (uint32_t)(nibble[7] << 28);
+      ByteArray_PutUint32LE(data_pos, u32buf);
+    }
+  }
+
+  /* 書き出しサイズをセット */
+  (*output_size) = (uint32_t)(data_pos - data);
+  return IMAADPCM_ERROR_OK;
+}
+
+/* 多チャンネルブロックのエンコード準備 */
+/* 引数と出力サイズを確認し、先頭サンプルをエンコーダにセットしてブロックヘッダを書き出す */
+static IMAADPCMError IMAADPCMWAVEncoder_PrepareMultichannelBlock(
+    struct IMAADPCMCoreEncoder *core_encoder, uint32_t num_channels,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size)
+{
+  uint32_t ch;
+  uint8_t *data_pos = data;
+
+  /* 引数チェック */
+  if ((core_encoder == NULL) || (input == NULL) || (data == NULL)
+      || (num_channels <= 2) || (num_channels > IMAADPCM_MAX_NUM_CHANNELS)) {
+    return IMAADPCM_ERROR_INVALID_ARGUMENT;
+  }
+
+  /* 十分なデータサイズがあるか確認 */
+  if (data_size < IMAADPCMWAVEncoder_CalculateBlockOutputSize(num_channels, num_samples)) {
+    return IMAADPCM_ERROR_INSUFFICIENT_DATA;
+  }
+
+  /* 先頭サンプルをエンコーダにセット */
+  for (ch = 0; ch < num_channels; ch++) {
+    core_encoder[ch].prev_sample = input[ch][0];
+  }
+
+  /* ブロックヘッダエンコード */
+  for (ch = 0; ch < num_channels; ch++) {
+    ByteArray_PutUint16LE(data_pos, core_encoder[ch].prev_sample);
+    ByteArray_PutUint8(data_pos, core_encoder[ch].stepsize_index);
+    ByteArray_PutUint8(data_pos, 0); /* reserved */
+  }
+
+  return IMAADPCM_ERROR_OK;
+}
+
+/* 多チャンネル（3チャンネル以上）ブロックのエンコード */
+/* 1チャンネルを1レーンとし、各レーンが自チャンネルのワード（8サンプル）を1ステップ1サンプルずつ処理する */
+/* レーン毎の依存連鎖は独立なので、チャンネルを内側のループにして連鎖を重ねて実行させる */
+static IMAADPCMError IMAADPCMWAVEncoder_EncodeBlockMultichannel(
+    struct IMAADPCMCoreEncoder *core_encoder, uint32_t num_channels,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+  IMAADPCMError err;
+  uint32_t ch, smp, smpl;
+  uint32_t codes[IMAADPCM_MAX_NUM_CHANNELS];
+  uint8_t *data_pos;
+
+  /* 引数チェック */
+  if (output_size == NULL) {
+    return IMAADPCM_ERROR_INVALID_ARGUMENT;
+  }
+
+  /* 引数・出力サイズの確認とブロックヘッダエンコード */
+  if ((err = IMAADPCMWAVEncoder_PrepareMultichannelBlock(core_encoder, num_channels,
+          input, num_samples, data, data_size)) != IMAADPCM_ERROR_OK) {
+    return err;
+  }
+
+  /* ブロックデータエンコード: 全チャンネルのワードを並べて1ステップずつ処理 */
+  data_pos = data + 4 * num_channels;
+  for (smpl = 1; smpl < num_samples; smpl += 8) {
+    for (ch = 0; ch < num_channels; ch++) {
+      codes[ch] = 0;
+    }
+    for (smp = 0; smp < 8; smp++) {
+      /* 末尾のワードで入力の範囲外になるサンプルは最終サンプルで埋める */
+      const uint32_t pos = IMAADPCM_MIN_VAL(smpl + smp, num_samples - 1);
+      for (ch = 0; ch < num_channels; ch++) {
+        const uint8_t nibble = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), input[ch][pos]);
+        assert(nibble <= 0xF);
+        codes[ch] |= (uint32_t)nibble << (4 * smp);
+      }
+    }
+    for (ch = 0; ch < num_channels; ch++) {
+      assert((uint32_t)(data_pos - data) < data_size);
+      ByteArray_PutUint32LE(data_pos, codes[ch]);
+    }
+  }
+
+  /* 書き出しサイズをセット */
+  (*output_size) = (uint32_t)(data_pos - data);
+  return IMAADPCM_ERROR_OK;
+}
+
+#if defined(IMAADPCM_USE_X86_SIMD)
+/* 複数ブロックの同時エンコード（SSE4.1） */
+/* 1レーンが1ブロックを担当し、IMAADPCM_NUM_SIMD_LANES個の完全なブロックを同時にエンコードする */
+/* 4レーンのSSEレジスタを2本使用 */
+__attribute__((target("sse4.1")))
+static void IMAADPCMWAVEncoder_EncodeBlocksSSE41(
+    const int16_t *const *input, const int8_t *start_index, uint32_t num_channels,
+    uint32_t num_samples_per_block, uint32_t block_size, uint8_t *data)
+{
+  uint32_t ch, lane, word, smp, half;
+  int32_t buf[IMAADPCM_NUM_SIMD_LANES];
+  int32_t samples[8][IMAADPCM_NUM_SIMD_LANES];
+  __m128i prev[2], index[2], codes[2];
+  const uint32_t num_words = (block_size - 4 * num_channels) / (4 * num_channels);
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i two = _mm_set1_epi32(2);
+  const __m128i four = _mm_set1_epi32(4);
+  const __m128i sign_bit = _mm_set1_epi32(8);
+  const __m128i index_mask = _mm_set1_epi32(0xFF);
+  const __m128i min_sample = _mm_set1_epi32(-32768);
+  const __m128i max_sample = _mm_set1_epi32(32767);
+
+  assert((input != NULL) && (start_index != NULL) && (data != NULL));
+  assert(((block_size - 4 * num_channels) % (4 * num_channels)) == 0);
+  assert(num_samples_per_block == (num_words * 8 + 1));
+
+  for (ch = 0; ch < num_channels; ch++) {
+    /* ブロックヘッダエンコード */
+    for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+      uint8_t *block_header = &data[lane * block_size + 4 * ch];
+      assert((start_index[ch * IMAADPCM_NUM_SIMD_LANES + lane] >= 0)
+          && (start_index[ch * IMAADPCM_NUM_SIMD_LANES + lane] <= 88));
+      buf[lane] = input[ch][lane * num_samples_per_block];
+      ByteArray_WriteUint16LE(block_header, (uint16_t)buf[lane]);
+      block_header[2] = (uint8_t)start_index[ch * IMAADPCM_NUM_SIMD_LANES + lane];
+      block_header[3] = 0; /* reserved */
+    }
+    prev[0] = _mm_loadu_si128((const __m128i *)&buf[0]);
+    prev[1] = _mm_loadu_si128((const __m128i *)&buf[4]);
+    for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+      buf[lane] = start_index[ch * IMAADPCM_NUM_SIMD_LANES + lane];
+    }
+    index[0] = _mm_loadu_si128((const __m128i *)&buf[0]);
+    index[1] = _mm_loadu_si128((const __m128i *)&buf[4]);
+
+    /* ブロックデータエンコード: 1ワード(8サンプル)ずつ全レーン同時に処理 */
+    for (word = 0; word < num_words; word++) {
+      const uint32_t word_offset = 4 * num_channels + (word * num_channels + ch) * 4;
+      /* 各ブロックの同じ位置の入力を集める */
+      for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+        const int16_t *src = &input[ch][lane * num_samples_per_block + 1 + 8 * word];
+        for (smp = 0; smp < 8; smp++) {
+          samples[smp][lane] = src[smp];
+        }
+      }
+
+      codes[0] = codes[1] = _mm_setzero_si128();
+      for (smp = 0; smp < 8; smp++) {
+        for (half = 0; half < 2; half++) {
+          int32_t idx[4], nib[4];
+          __m128i diff, sign, rest, stepsize, mask, nibble, transition;
+          /* 差分の符号と絶対値 */
+          diff = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)&samples[smp][4 * half]), prev[half]);
+          sign = _mm_cmplt_epi32(diff, _mm_setzero_si128());
+          rest = _mm_slli_epi32(_mm_abs_epi32(diff), 2);
+          /* 除算を使わない量子化（IMAADPCMCoreEncoder_QuantizeDiffと同じ計算） */
+          _mm_storeu_si128((__m128i *)idx, index[half]);
+          stepsize = _mm_setr_epi32(
+              IMAADPCM_stepsize_table[idx[0]], IMAADPCM_stepsize_table[idx[1]],
+              IMAADPCM_stepsize_table[idx[2]], IMAADPCM_stepsize_table[idx[3]]);
+          mask = _mm_cmpgt_epi32(rest, _mm_sub_epi32(_mm_slli_epi32(stepsize, 2), one));
+          nibble = _mm_and_si128(mask, four);
+          rest = _mm_sub_epi32(rest, _mm_and_si128(mask, _mm_slli_epi32(stepsize, 2)));
+          mask = _mm_cmpgt_epi32(rest, _mm_sub_epi32(_mm_slli_epi32(stepsize, 1), one));
+          nibble = _mm_or_si128(nibble, _mm_and_si128(mask, two));
+          rest = _mm_sub_epi32(rest, _mm_and_si128(mask, _mm_slli_epi32(stepsize, 1)));
+          mask = _mm_cmpgt_epi32(rest, _mm_sub_epi32(stepsize, one));
+          nibble = _mm_or_si128(nibble, _mm_and_si128(mask, one));
+          nibble = _mm_or_si128(nibble, _mm_and_si128(sign, sign_bit));
+          /* 状態遷移テーブルから差分と次のインデックスを取得 */
+          _mm_storeu_si128((__m128i *)nib, nibble);
+          transition = _mm_setr_epi32(
+              IMAADPCM_transition_table[idx[0]][nib[0]], IMAADPCM_transition_table[idx[1]][nib[1]],
+              IMAADPCM_transition_table[idx[2]][nib[2]], IMAADPCM_transition_table[idx[3]][nib[3]]);
+          index[half] = _mm_and_si128(transition, index_mask);
+          /* 差分を加えて16bit幅にクリップ */
+          prev[half] = _mm_add_epi32(prev[half], _mm_srai_epi32(transition, 8));
+          prev[half] = _mm_min_epi32(_mm_max_epi32(prev[half], min_sample), max_sample);
+          /* ニブルを上位から詰める（8サンプル後に先頭サンプルが最下位に来る） */
+          codes[half] = _mm_or_si128(_mm_srli_epi32(codes[half], 4), _mm_slli_epi32(nibble, 28));
+        }
+      }
+
+      /* 各ブロックの出力位置に書き出し */
+      _mm_storeu_si128((__m128i *)&buf[0], codes[0]);
+      _mm_storeu_si128((__m128i *)&buf[4], codes[1]);
+      for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+        ByteArray_WriteUint32LE(&data[lane * block_size + word_offset], (uint32_t)buf[lane]);
+      }
+    }
+  }
+}
+
+/* 複数ブロックの同時エンコード（AVX2） */
+/* 1レーンが1ブロックを担当し、IMAADPCM_NUM_SIMD_LANES個の完全なブロックを同時にエンコードする */
+__attribute__((target("avx2")))
+static void IMAADPCMWAVEncoder_EncodeBlocksAVX2(
+    const int16_t *const *input, const int8_t *start_index, uint32_t num_channels,
+    uint32_t num_samples_per_block, uint32_t block_size, uint8_t *data)
+{
+  uint32_t ch, lane, word, smp;
+  int32_t buf[IMAADPCM_NUM_SIMD_LANES];
+  int32_t samples[8][IMAADPCM_NUM_SIMD_LANES];
+  __m256i prev, index, codes;
+  const uint32_t num_words = (block_size - 4 * num_channels) / (4 * num_channels);
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i two = _mm256_set1_epi32(2);
+  const __m256i four = _mm256_set1_epi32(4);
+  const __m256i sign_bit = _mm256_set1_epi32(8);
+  const __m256i stepsize_mask = _mm256_set1_epi32(0xFFFF);
+  const __m256i index_mask = _mm256_set1_epi32(0xFF);
+  const __m256i min_sample = _mm256_set1_epi32(-32768);
+  const __m256i max_sample = _mm256_set1_epi32(32767);
+
+  assert((input != NULL) && (start_index != NULL) && (data != NULL));
+  assert(((block_size - 4 * num_channels) % (4 * num_channels)) == 0);
+  assert(num_samples_per_block == (num_words * 8 + 1));
+
+  for (ch = 0; ch < num_channels; ch++) {
+    /* ブロックヘッダエンコード */
+    for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+      uint8_t *block_header = &data[lane * block_size + 4 * ch];
+      assert((start_index[ch * IMAADPCM_NUM_SIMD_LANES + lane] >= 0)
+          && (start_index[ch * IMAADPCM_NUM_SIMD_LANES + lane] <= 88));
+      buf[lane] = input[ch][lane * num_samples_per_block];
+      ByteArray_WriteUint16LE(block_header, (uint16_t)buf[lane]);
+      block_header[2] = (uint8_t)start_index[ch * IMAADPCM_NUM_SIMD_LANES + lane];
+      block_header[3] = 0; /* reserved */
+    }
+    prev = _mm256_loadu_si256((const __m256i *)buf);
+    for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+      buf[lane] = start_index[ch * IMAADPCM_NUM_SIMD_LANES + lane];
+    }
+    index = _mm256_loadu_si256((const __m256i *)buf);
+
+    /* ブロックデータエンコード: 1ワード(8サンプル)ずつ全レーン同時に処理 */
+    for (word = 0; word < num_words; word++) {
+      const uint32_t word_offset = 4 * num_channels + (word * num_channels + ch) * 4;
+      /* 各ブロックの同じ位置の入力を集める */
+      for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+        const int16_t *src = &input[ch][lane * num_samples_per_block + 1 + 8 * word];
+        for (smp = 0; smp < 8; smp++) {
+          samples[smp][lane] = src[smp];
+        }
+      }
+
+      codes = _mm256_setzero_si256();
+      for (smp = 0; smp < 8; smp++) {
+        __m256i diff, sign, rest, stepsize, mask, nibble, transition;
+        /* 差分の符号と絶対値 */
+        diff = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)samples[smp]), prev);
+        sign = _mm256_cmpgt_epi32(_mm256_setzero_si256(), diff);
+        rest = _mm256_slli_epi32(_mm256_abs_epi32(diff), 2);
+        /* 除算を使わない量子化（IMAADPCMCoreEncoder_QuantizeDiffと同じ計算） */
+        stepsize = _mm256_and_si256(stepsize_mask, _mm256_i32gather_epi32(
+              (const void *)IMAADPCM_stepsize_table, _mm256_slli_epi32(index, 1), 1));
+        mask = _mm256_cmpgt_epi32(rest, _mm256_sub_epi32(_mm256_slli_epi32(stepsize, 2), one));
+        nibble = _mm256_and_si256(mask, four);
+        rest = _mm256_sub_epi32(rest, _mm256_and_si256(mask, _mm256_slli_epi32(stepsize, 2)));
+        mask = _mm256_cmpgt_epi32(rest, _mm256_sub_epi32(_mm256_slli_epi32(stepsize, 1), one));
+        nibble = _mm256_or_si256(nibble, _mm256_and_si256(mask, two));
+        rest = _mm256_sub_epi32(rest, _mm256_and_si256(mask, _mm256_slli_epi32(stepsize, 1)));
+        mask = _mm256_cmpgt_epi32(rest, _mm256_sub_epi32(stepsize, one));
+        nibble = _mm256_or_si256(nibble, _mm256_and_si256(mask, one));
+        nibble = _mm256_or_si256(nibble, _mm256_and_si256(sign, sign_bit));
+        /* 状態遷移テーブルから差分と次のインデックスを取得 */
+        transition = _mm256_i32gather_epi32((const int *)IMAADPCM_transition_table,
+            _mm256_add_epi32(_mm256_slli_epi32(index, 4), nibble), 4);
+        index = _mm256_and_si256(transition, index_mask);
+        /* 差分を加えて16bit幅にクリップ */
+        prev = _mm256_add_epi32(prev, _mm256_srai_epi32(transition, 8));
+        prev = _mm256_min_epi32(_mm256_max_epi32(prev, min_sample), max_sample);
+        /* ニブルを上位から詰める（8サンプル後に先頭サンプルが最下位に来る） */
+        codes = _mm256_or_si256(_mm256_srli_epi32(codes, 4), _mm256_slli_epi32(nibble, 28));
+      }
+
+      /* 各ブロックの出力位置に書き出し */
+      _mm256_storeu_si256((__m256i *)buf, codes);
+      for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+        ByteArray_WriteUint32LE(&data[lane * block_size + word_offset], (uint32_t)buf[lane]);
+      }
+    }
+  }
+}
+
+/* 多チャンネルブロックのエンコード（SSE4.1） */
+/* 1チャンネルを1レーンとし、各レーンが自チャンネルのワード（8サンプル）を1ステップ1サンプルずつ処理する */
+/* 4レーンのSSEレジスタを（4チャンネル以下なら1本、それ以上は2本）使用 */
+__attribute__((target("sse4.1")))
+static IMAADPCMError IMAADPCMWAVEncoder_EncodeBlockMultichannelSSE41(
+    struct IMAADPCMCoreEncoder *core_encoder, uint32_t num_channels,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+  IMAADPCMError err;
+  uint32_t ch, smp, smpl, half;
+  int32_t buf[IMAADPCM_NUM_SIMD_LANES] = { 0, };
+  int32_t samples[8][IMAADPCM_NUM_SIMD_LANES] = { { 0, }, };
+  __m128i prev[2], index[2], codes[2];
+  uint8_t *data_pos;
+  const uint32_t num_halves = (num_channels + 3) / 4;
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i two = _mm_set1_epi32(2);
+  const __m128i four = _mm_set1_epi32(4);
+  const __m128i sign_bit = _mm_set1_epi32(8);
+  const __m128i index_mask = _mm_set1_epi32(0xFF);
+  const __m128i min_sample = _mm_set1_epi32(-32768);
+  const __m128i max_sample = _mm_set1_epi32(32767);
+
+  /* 引数チェック */
+  if (output_size == NULL) {
+    return IMAADPCM_ERROR_INVALID_ARGUMENT;
+  }
+
+  /* 引数・出力サイズの確認とブロックヘッダエンコード */
+  if ((err = IMAADPCMWAVEncoder_PrepareMultichannelBlock(core_encoder, num_channels,
+          input, num_samples, data, data_size)) != IMAADPCM_ERROR_OK) {
+    return err;
+  }
+
+  /* 使わないレーンは状態(0, 0)から入力0をエンコードして結果を捨てる */
+  for (ch = 0; ch < num_channels; ch++) {
+    buf[ch] = core_encoder[ch].prev_sample;
+  }
+  prev[0] = _mm_loadu_si128((const __m128i *)&buf[0]);
+  prev[1] = _mm_loadu_si128((const __m128i *)&buf[4]);
+  for (ch = 0; ch < num_channels; ch++) {
+    buf[ch] = core_encoder[ch].stepsize_index;
+  }
+  index[0] = _mm_loadu_si128((const __m128i *)&buf[0]);
+  index[1] = _mm_loadu_si128((const __m128i *)&buf[4]);
+
+  /* ブロックデータエンコード: 全チャンネルのワードを並べて1ステップずつ処理 */
+  data_pos = data + 4 * num_channels;
+  for (smpl = 1; smpl < num_samples; smpl += 8) {
+    /* 各チャンネルの入力を集める 末尾のワードで入力の範囲外になるサンプルは最終サンプルで埋める */
+    for (smp = 0; smp < 8; smp++) {
+      const uint32_t pos = IMAADPCM_MIN_VAL(smpl + smp, num_samples - 1);
+      for (ch = 0; ch < num_channels; ch++) {
+        samples[smp][ch] = input[ch][pos];
+      }
+    }
+
+    codes[0] = codes[1] = _mm_setzero_si128();
+    for (smp = 0; smp < 8; smp++) {
+      for (half = 0; half < num_halves; half++) {
+        int32_t idx[4], nib[4];
+        __m128i diff, sign, rest, stepsize, mask, nibble, transition;
+        /* 差分の符号と絶対値 */
+        diff = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)&samples[smp][4 * half]), prev[half]);
+        sign = _mm_cmplt_epi32(diff, _mm_setzero_si128());
+        rest = _mm_slli_epi32(_mm_abs_epi32(diff), 2);
+        /* 除算を使わない量子化（IMAADPCMCoreEncoder_QuantizeDiffと同じ計算） */
+        _mm_storeu_si128((__m128i *)idx, index[half]);
+        stepsize = _mm_setr_epi32(
+            IMAADPCM_stepsize_table[idx[0]], IMAADPCM_stepsize_table[idx[1]],
+            IMAADPCM_stepsize_table[idx[2]], IMAADPCM_stepsize_table[idx[3]]);
+        mask = _mm_cmpgt_epi32(rest, _mm_sub_epi32(_mm_slli_epi32(stepsize, 2), one));
+        nibble = _mm_and_si128(mask, four);
+        rest = _mm_sub_epi32(rest, _mm_and_si128(mask, _mm_slli_epi32(stepsize, 2)));
+        mask = _mm_cmpgt_epi32(rest, _mm_sub_epi32(_mm_slli_epi32(stepsize, 1), one));
+        nibble = _mm_or_si128(nibble, _mm_and_si128(mask, two));
+        rest = _mm_sub_epi32(rest, _mm_and_si128(mask, _mm_slli_epi32(stepsize, 1)));
+        mask = _mm_cmpgt_epi32(rest, _mm_sub_epi32(stepsize, one));
+        nibble = _mm_or_si128(nibble, _mm_and_si128(mask, one));
+        nibble = _mm_or_si128(nibble, _mm_and_si128(sign, sign_bit));
+        /* 状態遷移テーブルから差分と次のインデックスを取得 */
+        _mm_storeu_si128((__m128i *)nib, nibble);
+        transition = _mm_setr_epi32(
+            IMAADPCM_transition_table[idx[0]][nib[0]], IMAADPCM_transition_table[idx[1]][nib[1]],
+            IMAADPCM_transition_table[idx[2]][nib[2]], IMAADPCM_transition_table[idx[3]][nib[3]]);
+        index[half] = _mm_and_si128(transition, index_mask);
+        /* 差分を加えて16bit幅にクリップ */
+        prev[half] = _mm_add_epi32(prev[half], _mm_srai_epi32(transition, 8));
+        prev[half] = _mm_min_epi32(_mm_max_epi32(prev[half], min_sample), max_sample);
+        /* ニブルを上位から詰める（8サンプル後に先頭サンプルが最下位に来る） */
+        codes[half] = _mm_or_si128(_mm_srli_epi32(codes[half], 4), _mm_slli_epi32(nibble, 28));
+      }
+    }
+
+    /* 全チャンネルのワードを書き出し */
+    _mm_storeu_si128((__m128i *)&buf[0], codes[0]);
+    _mm_storeu_si128((__m128i *)&buf[4], codes[1]);
+    for (ch = 0; ch < num_channels; ch++) {
+      assert((uint32_t)(data_pos - data) < data_size);
+      ByteArray_PutUint32LE(data_pos, (uint32_t)buf[ch]);
+    }
+  }
+
+  /* エンコーダの状態を反映 */
+  _mm_storeu_si128((__m128i *)&buf[0], prev[0]);
+  _mm_storeu_si128((__m128i *)&buf[4], prev[1]);
+  for (ch = 0; ch < num_channels; ch++) {
+    core_encoder[ch].prev_sample = (int16_t)buf[ch];
+  }
+  _mm_storeu_si128((__m128i *)&buf[0], index[0]);
+  _mm_storeu_si128((__m128i *)&buf[4], index[1]);
+  for (ch = 0; ch < num_channels; ch++) {
+    core_encoder[ch].stepsize_index = (int8_t)buf[ch];
+  }
+
+  /* 書き出しサイズをセット */
+  (*output_size) = (uint32_t)(data_pos - data);
+  return IMAADPCM_ERROR_OK;
+}
+
+/* 多チャンネルブロックのエンコード（AVX2） */
+/* 1チャンネルを1レーンとし、各レーンが自チャンネルのワード（8サンプル）を1ステップ1サンプルずつ処理する */
+/* 全チャンネルのワードはブロック内で連続して並ぶため、1回のストアで全レーンのワードを書き出せる */
+__attribute__((target("avx2")))
+static IMAADPCMError IMAADPCMWAVEncoder_EncodeBlockMultichannelAVX2(
+    struct IMAADPCMCoreEncoder *core_encoder, uint32_t num_channels,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+  IMAADPCMError err;
+  uint32_t ch, smp, smpl;
+  int32_t buf[IMAADPCM_NUM_SIMD_LANES] = { 0, };
+  int32_t samples[8][IMAADPCM_NUM_SIMD_LANES] = { { 0, }, };
+  __m256i prev, index, codes, lane_mask;
+  uint8_t *data_pos;
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i two = _mm256_set1_epi32(2);
+  const __m256i four = _mm256_set1_epi32(4);
+  const __m256i sign_bit = _mm256_set1_epi32(8);
+  const __m256i stepsize_mask = _mm256_set1_epi32(0xFFFF);
+  const __m256i index_mask = _mm256_set1_epi32(0xFF);
+  const __m256i min_sample = _mm256_set1_epi32(-32768);
+  const __m256i max_sample = _mm256_set1_epi32(32767);
+
+  /* 引数チェック */
+  if (output_size == NULL) {
+    return IMAADPCM_ERROR_INVALID_ARGUMENT;
+  }
+
+  /* 引数・出力サイズの確認とブロックヘッダエンコード */
+  if ((err = IMAADPCMWAVEncoder_PrepareMultichannelBlock(core_encoder, num_channels,
+          input, num_samples, data, data_size)) != IMAADPCM_ERROR_OK) {
+    return err;
+  }
+
+  /* 使わないレーンは状態(0, 0)から入力0をエンコードして結果を捨てる */
+  for (ch = 0; ch < num_channels; ch++) {
+    buf[ch] = core_encoder[ch].prev_sample;
+  }
+  prev = _mm256_loadu_si256((const __m256i *)buf);
+  for (ch = 0; ch < num_channels; ch++) {
+    buf[ch] = core_encoder[ch].stepsize_index;
+  }
+  index = _mm256_loadu_si256((const __m256i *)buf);
+
+  /* チャンネルが割り当てられたレーンのマスク */
+  lane_mask = _mm256_cmpgt_epi32(
+      _mm256_set1_epi32((int32_t)num_channels), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+  /* ブロックデータエンコード: 全チャンネルのワードを並べて1ステップずつ処理 */
+  data_pos = data + 4 * num_channels;
+  for (smpl = 1; smpl < num_samples; smpl += 8) {
+    /* 各チャンネルの入力を集める 末尾のワードで入力の範囲外になるサンプルは最終サンプルで埋める */
+    for (smp = 0; smp < 8; smp++) {
+      const uint32_t pos = IMAADPCM_MIN_VAL(smpl + smp, num_samples - 1);
+      for (ch = 0; ch < num_channels; ch++) {
+        samples[smp][ch] = input[ch][pos];
+      }
+    }
+
+    codes = _mm256_setzero_si256();
+    for (smp = 0; smp < 8; smp++) {
+      __m256i diff, sign, rest, stepsize, mask, nibble, transition;
+      /* 差分の符号と絶対値 */
+      diff = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)samples[smp]), prev);
+      sign = _mm256_cmpgt_epi32(_mm256_setzero_si256(), diff);
+      rest = _mm256_slli_epi32(_mm256_abs_epi32(diff), 2);
+      /* 除算を使わない量子化（IMAADPCMCoreEncoder_QuantizeDiffと同じ計算） */
+      stepsize = _mm256_and_si256(stepsize_mask, _mm256_i32gather_epi32(
+            (const void *)IMAADPCM_stepsize_table, _mm256_slli_epi32(index, 1), 1));
+      mask = _mm256_cmpgt_epi32(rest, _mm256_sub_epi32(_mm256_slli_epi32(stepsize, 2), one));
+      nibble = _mm256_and_si256(mask, four);
+      rest = _mm256_sub_epi32(rest, _mm256_and_si256(mask, _mm256_slli_epi32(stepsize, 2)));
+      mask = _mm256_cmpgt_epi32(rest, _mm256_sub_epi32(_mm256_slli_epi32(stepsize, 1), one));
+      nibble = _mm256_or_si256(nibble, _mm256_and_si256(mask, two));
+      rest = _mm256_sub_epi32(rest, _mm256_and_si256(mask, _mm256_slli_epi32(stepsize, 1)));
+      mask = _mm256_cmpgt_epi32(rest, _mm256_sub_epi32(stepsize, one));
+      nibble = _mm256_or_si256(nibble, _mm256_and_si256(mask, one));
+      nibble = _mm256_or_si256(nibble, _mm256_and_si256(sign, sign_bit));
+      /* 状態遷移テーブルから差分と次のインデックスを取得 */
+      transition = _mm256_i32gather_epi32((const int *)IMAADPCM_transition_table,
+          _mm256_add_epi32(_mm256_slli_epi32(index, 4), nibble), 4);
+      index = _mm256_and_si256(transition, index_mask);
+      /* 差分を加えて16bit幅にクリップ */
+      prev = _mm256_add_epi32(prev, _mm256_srai_epi32(transition, 8));
+      prev = _mm256_min_epi32(_mm256_max_epi32(prev, min_sample), max_sample);
+      /* ニブルを上位から詰める（8サンプル後に先頭サンプルが最下位に来る） */
+      codes = _mm256_or_si256(_mm256_srli_epi32(codes, 4), _mm256_slli_epi32(nibble, 28));
+    }
+
+    /* 全チャンネルのワードを一度に書き出す（リトルエンディアン前提, 使わないレーンは書かない） */
+    assert((uint32_t)(data_pos - data + 4 * num_channels) <= data_size);
+    _mm256_maskstore_epi32((int *)data_pos, lane_mask, codes);
+    data_pos += 4 * num_channels;
+  }
+
+  /* エンコーダの状態を反映 */
+  _mm256_storeu_si256((__m256i *)buf, prev);
+  for (ch = 0; ch < num_channels; ch++) {
+    core_encoder[ch].prev_sample = (int16_t)buf[ch];
+  }
+  _mm256_storeu_si256((__m256i *)buf, index);
+  for (ch = 0; ch < num_channels; ch++) {
+    core_encoder[ch].stepsize_index = (int8_t)buf[ch];
+  }
+
+  /* 書き出しサイズをセット */
+  (*output_size) = (uint32_t)(data_pos - data);
+  return IMAADPCM_ERROR_OK;
+}
+#endif /* IMAADPCM_USE_X86_SIMD */
+
+/* 単一データブロックエンコード */
+static IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeBlock(
+    struct IMAADPCMWAVEncoder *encoder,
+    const int16_t *const *input, uint32_t num_samples, 
+    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+  IMAADPCMError err;
+  const struct IMAADPCMWAVEncodeParameter *enc_param;
+
+  /* 引数チェック */
+  if ((encoder == NULL) || (data == NULL)
+      || (input == NULL) || (output_size == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+  enc_param = &(encoder->encode_paramemter);
+
+  /* 対応していないチャンネル数 */
+  if ((enc_param->num_channels == 0) || (enc_param->num_channels > IMAADPCM_MAX_NUM_CHANNELS)) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* ブロックエンコード */
+  err = encoder->functions.encode_block[enc_param->num_channels - 1](encoder->core_encoder,
+      enc_param->num_channels, input, num_samples, data, data_size, output_size);
+
+  return IMAADPCM_ConvertErrorToApiResult(err);
+}
+
+/* エンコードパラメータをヘッダに変換 */
+static IMAADPCMError IMAADPCMWAVEncoder_ConvertParameterToHeader(
+    const struct IMAADPCMWAVEncodeParameter *enc_param, uint32_t num_samples,
+    struct IMAADPCMWAVHeaderInfo *header_info)
+{
+  uint32_t block_data_size;
+  struct IMAADPCMWAVHeaderInfo tmp_header = {0, };
+
+  /* 引数チェック */
+  if ((enc_param == NULL) || (header_info == NULL)) {
+    return IMAADPCM_ERROR_INVALID_ARGUMENT;
+  }
+
+  /* サンプルあたりビット数は4固定 */
+  if (enc_param->bits_per_sample != IMAADPCM_BITS_PER_SAMPLE) {
+    return IMAADPCM_ERROR_INVALID_FORMAT;
+  }
+
+  /* 対応していないチャンネル数 */
+  if ((enc_param->num_channels == 0) || (enc_param->num_channels > IMAADPCM_MAX_NUM_CHANNELS)) {
+    return IMAADPCM_ERROR_INVALID_FORMAT;
+  }
+
+  /* 総サンプル数 */
+  tmp_header.num_samples = num_samples;
+
+  /* そのままヘッダに入れられるメンバ */
+  tmp_header.num_channels = enc_param->num_channels;
+  tmp_header.sampling_rate = enc_param->sampling_rate;
+  tmp_header.bits_per_sample = enc_param->bits_per_sample;
+  tmp_header.block_size = enc_param->block_size;
+
+  /* 計算が必要なメンバ */
+  if (enc_param->block_size <= enc_param->num_channels * 4) {
+    /* データを入れる領域がない */
+    return IMAADPCM_ERROR_INVALID_FORMAT;
+  }
+  /* 4はチャンネルあたりのヘッダ領域サイズ */
+  assert(enc_param->block_size >= (enc_param->num_channels * 4));
+  block_data_size = (uint32_t)(enc_param->block_size - (enc_param->num_channels * 4));
+  /* 3チャンネル以上はチャンネル毎の4バイトのワードが揃っている必要がある */
+  if ((enc_param->num_channels > 2) && ((block_data_size % (4U * enc_param->num_channels)) != 0)) {
+    return IMAADPCM_ERROR_INVALID_FORMAT;
+  }
+  assert((block_data_size * 8) % (uint32_t)(enc_param->bits_per_sample * enc_param->num_channels) == 0);
+  assert((enc_param->bits_per_sample * enc_param->num_channels) != 0);
+  tmp_header.num_samples_per_block = (uint16_t)((block_data_size * 8) / (uint32_t)(enc_param->bits_per_sample * enc_param->num_channels));
+  /* ヘッダに入っている分+1 */
+  tmp_header.num_samples_per_block++;
+  assert(tmp_header.num_samples_per_block != 0);
+  tmp_header.bytes_per_sec = (enc_param->block_size * enc_param->sampling_rate) / tmp_header.num_samples_per_block;
+  /* ヘッダサイズ: dataチャンクが4GBを超える場合はRF64 */
+  tmp_header.header_size
+    = IMAADPCMWAVEncoder_CalculateHeaderSize(&tmp_header, IMAADPCMWAVEncoder_CalculateDataChunkSize(&tmp_header), 0);
+
+  /* 成功終了 */
+  (*header_info) = tmp_header;
+
+  return IMAADPCM_ERROR_OK;
+}
+
+/* エンコードパラメータの設定 */
+IMAADPCMApiResult IMAADPCMWAVEncoder_SetEncodeParameter(
+    struct IMAADPCMWAVEncoder *encoder, const struct IMAADPCMWAVEncodeParameter *parameter)
+{
+  struct IMAADPCMWAVHeaderInfo tmp_header = {0, };
+
+  /* 引数チェック */
+  if ((encoder == NULL) || (parameter == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* パラメータ設定がおかしくないか、ヘッダへの変換を通じて確認 */
+  /* 総サンプル数はダミー値を入れる */
+  if (IMAADPCMWAVEncoder_ConvertParameterToHeader(parameter, 0, &tmp_header) != IMAADPCM_ERROR_OK) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* パラメータ設定 */
+  encoder->encode_paramemter = (*parameter);
+
+  /* 進行中のストリーミングエンコードは破棄 */
+  encoder->stream.started = 0;
+
+  /* パラメータ設定済みフラグを立てる */
+  encoder->set_parameter = 1;
+
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* チャンネル配置の設定 */
+IMAADPCMApiResult IMAADPCMWAVEncoder_SetChannelMask(
+    struct IMAADPCMWAVEncoder *encoder, uint32_t channel_mask)
+{
+  /* 引数チェック */
+  if (encoder == NULL) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  encoder->channel_mask = channel_mask;
+
+  /* 進行中のストリーミングエンコードは破棄 */
+  encoder->stream.started = 0;
+
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ヘッダ含めファイル全体をエンコード */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWhole(
+    struct IMAADPCMWAVEncoder *encoder,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+  IMAADPCMApiResult ret;
+  uint64_t tmp_output_size;
+
+  /* 引数チェック */
+  if (output_size == NULL) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  if ((ret = IMAADPCMWAVEncoder_EncodeWhole64(encoder,
+          input, num_samples, data, data_size, &tmp_output_size)) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* 出力はdata_size以下に収まっている */
+  assert(tmp_output_size <= data_size);
+  (*output_size) = (uint32_t)tmp_output_size;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ヘッダ含めファイル全体をエンコード（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWhole64(
+    struct IMAADPCMWAVEncoder *encoder,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint64_t data_size, uint64_t *output_size)
+{
+  IMAADPCMApiResult ret;
+  uint32_t progress, ch, write_size, num_encode_samples;
+  uint64_t write_offset;
+  uint8_t *data_pos;
+  const int16_t *input_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+  struct IMAADPCMWAVHeaderInfo header = { 0, };
+
+  /* 引数チェック */
+  if ((encoder == NULL) || (input == NULL)
+      || (data == NULL) || (output_size == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* パラメータ未セットではエンコードできない */
+  if (encoder->set_parameter == 0) {
+    return IMAADPCM_APIRESULT_PARAMETER_NOT_SET;
+  }
+
+  /* 書き出し位置を取得 */
+  data_pos = data;
+
+  /* エンコードパラメータをヘッダに変換 */
+  if (IMAADPCMWAVEncoder_ConvertParameterToHeader(&(encoder->encode_paramemter), num_samples, &header) != IMAADPCM_ERROR_OK) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+  header.channel_mask = encoder->channel_mask;
+
+  /* ヘッダエンコード */
+  if ((ret = IMAADPCMWAVEncoder_EncodeHeader(&header,
+          data_pos, (uint32_t)IMAADPCM_MIN_VAL(data_size, UINT32_MAX))) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  progress = 0;
+  write_offset = header.header_size;
+  data_pos = data + header.header_size;
+  while (progress < num_samples) {
+    /* エンコードサンプル数の確定 */
+    num_encode_samples 
+      = IMAADPCM_MIN_VAL(header.num_samples_per_block, num_samples - progress);
+    /* サンプル参照位置のセット */
+    for (ch = 0; ch < header.num_channels; ch++) {
+      input_ptr[ch] = &input[ch][progress];
+    }
+
+    /* ブロックエンコード */
+    if ((ret = IMAADPCMWAVEncoder_EncodeBlock(encoder,
+            input_ptr, num_encode_samples,
+            data_pos, (uint32_t)IMAADPCM_MIN_VAL(data_size - write_offset, UINT32_MAX), &write_size)) != IMAADPCM_APIRESULT_OK) {
+      return ret;
+    }
+
+    /* 進捗更新 */
+    data_pos      += write_size;
+    write_offset  += write_size;
+    progress      += num_encode_samples;
+    assert(write_size <= header.block_size);
+    assert(write_offset <= data_size);
+  }
+
+  /* 成功終了 */
+  (*output_size) = write_offset;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* 指定サンプル数のブロックをエンコードした時の出力サイズ[byte]を計算 */
+static uint32_t IMAADPCMWAVEncoder_CalculateBlockOutputSize(uint32_t num_channels, uint32_t num_samples)
+{
+  assert(num_samples > 0);
+
+  switch (num_channels) {
+    case 1:
+      /* ヘッダ + 1バイトに2サンプル */
+      return 4 + num_samples / 2;
+    default:
+      /* ヘッダ + チャンネル毎に8サンプルずつ4バイトのワード */
+      assert((num_channels >= 2) && (num_channels <= IMAADPCM_MAX_NUM_CHANNELS));
+      return 4 * num_channels + ((num_samples - 1 + 7) / 8) * 4 * num_channels;
+  }
+}
+
+/* ヘッダ情報の総サンプル数をエンコードした時のdataチャンクのサイズ[byte]を計算 */
+static uint64_t IMAADPCMWAVEncoder_CalculateDataChunkSize(const struct IMAADPCMWAVHeaderInfo *header)
+{
+  uint32_t num_blocks, tail_num_samples;
+
+  assert(header != NULL);
+  assert(header->num_samples_per_block != 0);
+
+  if (header->num_samples == 0) {
+    return 0;
+  }
+
+  /* 末尾以外は完全なブロック 末尾のブロックは残りサンプル分だけ */
+  num_blocks = (header->num_samples + header->num_samples_per_block - 1) / header->num_samples_per_block;
+  tail_num_samples = header->num_samples - (num_blocks - 1) * header->num_samples_per_block;
+  return (uint64_t)(num_blocks - 1) * IMAADPCMWAVEncoder_CalculateBlockOutputSize(header->num_channels, header->num_samples_per_block)
+    + IMAADPCMWAVEncoder_CalculateBlockOutputSize(header->num_channels, tail_num_samples);
+}
+
+/* dataチャンクサイズからヘッダサイズ[byte]を計算 */
+/* WAVE_FORMAT_EXTENSIBLE形式ではfmtチャンクが大きくなる */
+/* RIFFチャンクのサイズが32bitに収まらない場合（またはds64チャンクを予約する場合）はRF64のヘッダ */
+static uint32_t IMAADPCMWAVEncoder_CalculateHeaderSize(
+    const struct IMAADPCMWAVHeaderInfo *header, uint64_t data_chunk_size, uint8_t reserve_ds64)
+{
+  uint32_t header_size = IMAADPCMWAVENCODER_HEADER_SIZE;
+
+  assert(header != NULL);
+
+  if (IMAADPCM_USE_EXTENSIBLE_FORMAT(header->num_channels)) {
+    header_size += IMAADPCM_EXTENSIBLE_FMT_EXTRA_SIZE;
+  }
+
+  if ((reserve_ds64 != 0)
+      || ((header_size - 8 + data_chunk_size) > UINT32_MAX)) {
+    header_size += IMAADPCM_DS64_CHUNK_SIZE;
+  }
+
+  return header_size;
+}
+
+/* num_samplesサンプルをエンコードした時のヘッダを含む出力サイズ[byte]を計算（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVEncoder_CalculateOutputSize64(
+    const struct IMAADPCMWAVEncodeParameter *parameter, uint32_t num_samples, uint64_t *output_size)
+{
+  struct IMAADPCMWAVHeaderInfo header;
+
+  /* 引数チェック */
+  if ((parameter == NULL) || (output_size == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* パラメータをヘッダに変換（エンコード時と同じ） */
+  if ((parameter->num_channels == 0) || (parameter->num_channels > IMAADPCM_MAX_NUM_CHANNELS)
+      || (IMAADPCMWAVEncoder_ConvertParameterToHeader(parameter, num_samples, &header) != IMAADPCM_ERROR_OK)) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  (*output_size) = header.header_size + IMAADPCMWAVEncoder_CalculateDataChunkSize(&header);
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* num_samplesサンプルをエンコードした時のヘッダを含む出力サイズ[byte]を計算 */
+IMAADPCMApiResult IMAADPCMWAVEncoder_CalculateOutputSize(
+    const struct IMAADPCMWAVEncodeParameter *parameter, uint32_t num_samples, uint32_t *output_size)
+{
+  IMAADPCMApiResult ret;
+  uint64_t tmp_output_size;
+
+  /* 引数チェック */
+  if (output_size == NULL) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  if ((ret = IMAADPCMWAVEncoder_CalculateOutputSize64(parameter, num_samples, &tmp_output_size)) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* 32bitで表せないサイズは64bit版のAPIを使う */
+  if (tmp_output_size > UINT32_MAX) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  (*output_size) = (uint32_t)tmp_output_size;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ブロック先頭のステップサイズインデックスを推定 */
+/* 直前の入力サンプルをインデックス0からエンコードし、終了時のインデックスを返す */
+/* 逐次エンコードで直前のブロックから引き継がれるインデックスを、ブロック単位で独立に近似する */
+static int8_t IMAADPCMWAVEncoder_EstimateStartIndex(const int16_t *input, uint32_t block_start)
+{
+  uint32_t smpl, begin;
+  struct IMAADPCMCoreEncoder core_encoder;
+
+  /* 先頭ブロックは逐次エンコードと同じ */
+  if (block_start == 0) {
+    return 0;
+  }
+
+  begin = (block_start > IMAADPCM_INDEX_ESTIMATION_NUM_SAMPLES)
+    ? (block_start - IMAADPCM_INDEX_ESTIMATION_NUM_SAMPLES) : 0;
+  core_encoder.prev_sample = input[begin];
+  core_encoder.stepsize_index = 0;
+  for (smpl = begin + 1; smpl < block_start; smpl++) {
+    (void)IMAADPCMCoreEncoder_EncodeSample(&core_encoder, input[smpl]);
+  }
+
+  return core_encoder.stepsize_index;
+}
+
+/* 入力レイアウトのサンプルをチャンネル毎のint16に変換して読み込み */
+/* 入力のprogressサンプル目からnum_samples個をoutputの先頭から書き出す */
+static void IMAADPCMWAVEncoder_LoadFromLayout(
+    const struct IMAADPCMInputLayout *layout,
+    const void *const *input, uint32_t input_num_channels, uint32_t num_channels,
+    uint32_t progress, uint32_t num_samples, int16_t **output)
+{
+  uint32_t ch, smpl, stride;
+  size_t offset;
+
+  assert((layout != NULL) && (input != NULL) && (output != NULL));
+
+  /* インターリーブ時のストライドはinput_num_channels */
+  stride = (layout->interleaved) ? input_num_channels : 1;
+
+  for (ch = 0; ch < num_channels; ch++) {
+    int16_t *dst = output[ch];
+    const void *src = (layout->interleaved) ? input[0] : input[ch];
+    offset = (size_t)progress * stride + ((layout->interleaved) ? ch : 0);
+    switch (layout->sample_format) {
+    case IMAADPCM_SAMPLE_FORMAT_INT16:
+      if (stride == 1) {
+        memcpy(dst, (const int16_t *)src + offset, sizeof(int16_t) * num_samples);
+      } else {
+        const int16_t *psrc = (const int16_t *)src + offset;
+        for (smpl = 0; smpl < num_samples; smpl++) {
+          dst[smpl] = psrc[(size_t)smpl * stride];
+        }
+      }
+      break;
+    case IMAADPCM_SAMPLE_FORMAT_INT32:
+      {
+        /* 上位16bitを取り出す */
+        const int32_t *psrc = (const int32_t *)src + offset;
+        for (smpl = 0; smpl < num_samples; smpl++) {
+          dst[smpl] = (int16_t)(psrc[(size_t)smpl * stride] >> 16);
+        }
+      }
+      break;
+    case IMAADPCM_SAMPLE_FORMAT_FLOAT32:
+      {
+        /* 32768倍して最近接丸め、範囲外（とNaN）は飽和 */
+        const float *psrc = (const float *)src + offset;
+        for (smpl = 0; smpl < num_samples; smpl++) {
+          const float val = psrc[(size_t)smpl * stride] * 32768.0f;
+          if (val >= 32767.0f) {
+            dst[smpl] = 32767;
+          } else if (val > -32768.0f) {
+            dst[smpl] = (int16_t)((val >= 0.0f) ? (val + 0.5f) : (val - 0.5f));
+          } else {
+            dst[smpl] = -32768;
+          }
+        }
+      }
+      break;
+    default:
+      assert(0);
+    }
+  }
+}
+
+/* タイルに収まらない大きなブロックを入力レイアウトから読み込みながらエンコード */
+/* タイル単位に読み込み、ストリーミングエンコードと同じ手順で1サンプルずつエンコードする */
+/* ブロック先頭の状態はencoder->core_encoderから取り、ブロック末尾の状態を書き戻す（IMAADPCMWAVEncoder_EncodeBlockと同じ） */
+/* tileはチャンネルあたりtile_num_samplesの作業領域 */
+static IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeLargeBlockFromLayout(
+    struct IMAADPCMWAVEncoder *encoder,
+    const struct IMAADPCMInputLayout *layout,
+    const void *const *input, uint32_t input_num_channels,
+    uint32_t progress, uint32_t num_samples, int16_t **tile, uint32_t tile_num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+  uint32_t ch, smpl, tile_smpl, num_tile_samples;
+  uint8_t *data_pos;
+  struct IMAADPCMEncodeStream stream;
+  const uint32_t num_channels = encoder->encode_paramemter.num_channels;
+
+  assert((num_samples > 0) && (num_channels <= IMAADPCM_MAX_NUM_CHANNELS));
+
+  /* 十分なデータサイズがあるか確認 */
+  if (data_size < IMAADPCMWAVEncoder_CalculateBlockOutputSize(num_channels, num_samples)) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_DATA;
+  }
+
+  /* ストリーミングエンコードの状態を借りる（進行中のストリーミングエンコードは後で戻す） */
+  /* ブロックのサンプル数をブロックあたりサンプル数とすることで、末尾で埋め合わせて閉じる */
+  stream = encoder->stream;
+  memset(&(encoder->stream), 0, sizeof(struct IMAADPCMEncodeStream));
+  encoder->stream.num_samples_per_block = num_samples;
+  for (ch = 0; ch < num_channels; ch++) {
+    encoder->stream.core_encoder[ch] = encoder->core_encoder[ch];
+  }
+
+  data_pos = data;
+  for (smpl = 0; smpl < num_samples; smpl += num_tile_samples) {
+    num_tile_samples = IMAADPCM_MIN_VAL(num_samples - smpl, tile_num_samples);
+    IMAADPCMWAVEncoder_LoadFromLayout(layout,
+        input, input_num_channels, num_channels, progress + smpl, num_tile_samples, tile);
+    for (tile_smpl = 0; tile_smpl < num_tile_samples; tile_smpl++) {
+      data_pos += IMAADPCMWAVEncoder_EncodeStreamSample(encoder,
+          (const int16_t *const *)tile, tile_smpl, data_pos);
+    }
+  }
+  assert(encoder->stream.block_progress == 0);
+
+  for (ch = 0; ch < num_channels; ch++) {
+    encoder->core_encoder[ch] = encoder->stream.core_encoder[ch];
+  }
+  encoder->stream = stream;
+
+  (*output_size) = (uint32_t)(data_pos - data);
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* 並列エンコードのタスクコンテキスト */
+struct IMAADPCMEncodeTaskContext {
+  const struct IMAADPCMWAVEncoder       *encoder;
+  const int16_t *const                  *input;
+  const struct IMAADPCMInputLayout      *layout;                /* NULLならinputから直接読む    */
+  const void *const                     *layout_input;          /* レイアウト指定時の入力       */
+  uint32_t                              input_num_channels;     /* レイアウト指定時の入力チャンネル数 */
+  uint32_t                              num_samples;
+  uint8_t                               *data;                  /* データブロック領域の先頭   */
+  uint64_t                              data_size;              /* データブロック領域のサイズ */
+  uint32_t                              num_samples_per_block;
+  uint32_t                              block_output_size;      /* 完全なブロックの出力サイズ */
+  uint32_t                              num_blocks;
+  uint32_t                              num_blocks_per_task;    /* タスクあたりのブロック数   */
+  IMAADPCMApiResult                     result[IMAADPCM_MAX_NUM_TASKS]; /* タスク毎の結果 */
+};
+
+/* 並列エンコードでブロック番号beginからendまでをエンコード */
+/* input[ch][i]はinput_offset + i番目のサンプル（ブロック先頭のインデックス推定に使う直前のサンプルも含むこと） */
+static IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeTaskBlocks(
+    const struct IMAADPCMEncodeTaskContext *context,
+    struct IMAADPCMWAVEncoder *task_encoder, IMAADPCMEncodeBlocksFunction encode_blocks,
+    const int16_t *const *input, uint32_t input_offset, uint32_t begin, uint32_t end)
+{
+  IMAADPCMApiResult ret;
+  uint32_t blk, ch, lane, write_size;
+  const int16_t *input_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+  int8_t start_index[IMAADPCM_MAX_NUM_CHANNELS * IMAADPCM_NUM_SIMD_LANES];
+  const uint32_t num_channels = context->encoder->encode_paramemter.num_channels;
+  const uint32_t block_size = context->encoder->encode_paramemter.block_size;
+
+  blk = begin;
+  while (blk < end) {
+    const uint32_t progress = blk * context->num_samples_per_block;
+    const uint64_t write_offset = (uint64_t)blk * context->block_output_size;
+    const uint32_t num_encode_samples
+      = IMAADPCM_MIN_VAL(context->num_samples_per_block, context->num_samples - progress);
+
+    assert(progress >= input_offset);
+
+    /* 全レーンを完全なブロックで埋められるならば同時エンコード */
+    if ((encode_blocks != NULL)
+        && ((end - blk) >= IMAADPCM_NUM_SIMD_LANES)
+        && ((context->num_samples - progress) >= (IMAADPCM_NUM_SIMD_LANES * context->num_samples_per_block))
+        && (context->data_size >= write_offset)
+        && ((context->data_size - write_offset) >= (IMAADPCM_NUM_SIMD_LANES * block_size))) {
+      assert(context->block_output_size == block_size);
+      for (ch = 0; ch < num_channels; ch++) {
+        input_ptr[ch] = &input[ch][progress - input_offset];
+        for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+          start_index[ch * IMAADPCM_NUM_SIMD_LANES + lane] = IMAADPCMWAVEncoder_EstimateStartIndex(
+              input[ch], progress - input_offset + lane * context->num_samples_per_block);
+        }
+      }
+      encode_blocks(input_ptr, start_index, num_channels,
+          context->num_samples_per_block, block_size, &context->data[write_offset]);
+      blk += IMAADPCM_NUM_SIMD_LANES;
+      continue;
+    }
+
+    /* 書き出し位置が領域外 */
+    if (write_offset >= context->data_size) {
+      return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+    }
+
+    /* サンプル参照位置とブロック先頭のインデックスのセット */
+    for (ch = 0; ch < num_channels; ch++) {
+      input_ptr[ch] = &input[ch][progress - input_offset];
+      task_encoder->core_encoder[ch].stepsize_index
+        = IMAADPCMWAVEncoder_EstimateStartIndex(input[ch], progress - input_offset);
+    }
+
+    /* ブロックエンコード */
+    if ((ret = IMAADPCMWAVEncoder_EncodeBlock(task_encoder,
+            input_ptr, num_encode_samples,
+            &context->data[write_offset], (uint32_t)IMAADPCM_MIN_VAL(context->data_size - write_offset, block_size),
+            &write_size)) != IMAADPCM_APIRESULT_OK) {
+      return ret;
+    }
+    assert((num_encode_samples < context->num_samples_per_block) || (write_size == context->block_output_size));
+    blk++;
+  }
+
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* 並列エンコードでブロック番号beginからendまでをタスクの状態task_encoderでエンコード */
+/* task_encoderはハンドルの複製 レイアウト指定時はtileにIMAADPCM_LAYOUT_TILE_NUM_SAMPLES個の領域が必要 */
+static IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeTaskRange(
+    const struct IMAADPCMEncodeTaskContext *context,
+    struct IMAADPCMWAVEncoder *task_encoder, int16_t *tile, uint32_t begin, uint32_t end)
+{
+  IMAADPCMApiResult ret;
+  uint32_t blk, ch, group_end, group_progress, num_history, num_group_samples, num_tile_blocks, write_size;
+  uint32_t tile_num_samples;
+  int16_t *tile_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+  IMAADPCMEncodeBlocksFunction encode_blocks;
+  const uint32_t num_channels = context->encoder->encode_paramemter.num_channels;
+  const uint32_t block_size = context->encoder->encode_paramemter.block_size;
+
+  assert((task_encoder != NULL) && ((context->layout == NULL) || (tile != NULL)));
+
+  /* 複数ブロック同時エンコード関数はカーネル設定時に選択済み */
+  /* 同時エンコードはブロックのデータ部がワード（チャンネルあたり4byte）単位で割り切れる時のみ */
+  encode_blocks = context->encoder->functions.encode_blocks[num_channels - 1];
+  if ((block_size <= (4 * num_channels))
+      || (((block_size - 4 * num_channels) % (4 * num_channels)) != 0)) {
+    encode_blocks = NULL;
+  }
+
+  /* int16のチャンネル毎バッファはそのまま参照 */
+  if (context->layout == NULL) {
+    return IMAADPCMWAVEncoder_EncodeTaskBlocks(context,
+        task_encoder, encode_blocks, context->input, 0, begin, end);
+  }
+
+  /* レイアウト指定時はブロック先頭のインデックス推定に使う直前のサンプルと共にタイルに変換して読み込む */
+  tile_num_samples = IMAADPCM_SplitLayoutTile(tile, num_channels, tile_ptr);
+  num_tile_blocks = (tile_num_samples - IMAADPCM_INDEX_ESTIMATION_NUM_SAMPLES) / context->num_samples_per_block;
+
+  blk = begin;
+  while (blk < end) {
+    group_progress = blk * context->num_samples_per_block;
+    num_history = IMAADPCM_MIN_VAL(group_progress, IMAADPCM_INDEX_ESTIMATION_NUM_SAMPLES);
+
+    if (num_tile_blocks > 0) {
+      /* タイルに収まるだけのブロックをまとめてエンコード */
+      group_end = IMAADPCM_MIN_VAL(end, blk + num_tile_blocks);
+      num_group_samples
+        = IMAADPCM_MIN_VAL(group_end * context->num_samples_per_block, context->num_samples) - group_progress;
+      IMAADPCMWAVEncoder_LoadFromLayout(context->layout, context->layout_input, context->input_num_channels,
+          num_channels, group_progress - num_history, num_history + num_group_samples, tile_ptr);
+      if ((ret = IMAADPCMWAVEncoder_EncodeTaskBlocks(context, task_encoder, encode_blocks,
+              (const int16_t *const *)tile_ptr, group_progress - num_history, blk, group_end)) != IMAADPCM_APIRESULT_OK) {
+        return ret;
+      }
+      blk = group_end;
+    } else {
+      /* タイルに収まらない大きなブロックは直前のサンプルだけ読み込んでインデックスを推定 */
+      const uint64_t write_offset = (uint64_t)blk * context->block_output_size;
+      IMAADPCMWAVEncoder_LoadFromLayout(context->layout, context->layout_input, context->input_num_channels,
+          num_channels, group_progress - num_history, num_history, tile_ptr);
+      for (ch = 0; ch < num_channels; ch++) {
+        task_encoder->core_encoder[ch].stepsize_index
+          = IMAADPCMWAVEncoder_EstimateStartIndex(tile_ptr[ch], num_history);
+      }
+      if (write_offset >= context->data_size) {
+        return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+      }
+      if ((ret = IMAADPCMWAVEncoder_EncodeLargeBlockFromLayout(task_encoder,
+              context->layout, context->layout_input, context->input_num_channels, group_progress,
+              IMAADPCM_MIN_VAL(context->num_samples_per_block, context->num_samples - group_progress),
+              tile_ptr, tile_num_samples,
+              &context->data[write_offset], (uint32_t)IMAADPCM_MIN_VAL(context->data_size - write_offset, block_size),
+              &write_size)) != IMAADPCM_APIRESULT_OK) {
+        return ret;
+      }
+      blk++;
+    }
+  }
+
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* 並列エンコードのタスク */
+static void IMAADPCMWAVEncoder_EncodeTask(void *task_context, uint32_t task_index)
+{
+  uint32_t begin, end;
+  struct IMAADPCMWAVEncoder *task_encoder;
+  struct IMAADPCMEncodeTaskContext *context = (struct IMAADPCMEncodeTaskContext *)task_context;
+
+  assert(task_index < context->encoder->max_num_tasks);
+
+  /* 担当するブロック範囲 */
+  begin = IMAADPCM_MIN_VAL(task_index * context->num_blocks_per_task, context->num_blocks);
+  end = IMAADPCM_MIN_VAL(begin + context->num_blocks_per_task, context->num_blocks);
+
+  /* エンコーダの状態だけを各タスクで独立に持つため、ワーク領域のタスク毎の領域にハンドルを複製して使う */
+  /* （複製はDestroyしないので自前確保の領域は解放されない） */
+  task_encoder = &(context->encoder->task_encoder[task_index]);
+  (*task_encoder) = *(context->encoder);
+
+  context->result[task_index] = IMAADPCMWAVEncoder_EncodeTaskRange(context, task_encoder,
+      &(context->encoder->task_tile[(size_t)task_index * IMAADPCM_LAYOUT_TILE_NUM_SAMPLES]), begin, end);
+}
+
+/* 並列エンコードの全ブロックを呼び出しスレッドでエンコード（タスク毎の領域が無いハンドル用） */
+static IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeTaskRangeOnCaller(
+    const struct IMAADPCMEncodeTaskContext *context)
+{
+  int16_t tile[IMAADPCM_LAYOUT_TILE_NUM_SAMPLES];
+  struct IMAADPCMWAVEncoder task_encoder;
+
+  task_encoder = *(context->encoder);
+  return IMAADPCMWAVEncoder_EncodeTaskRange(context, &task_encoder, tile, 0, context->num_blocks);
+}
+
+/* 入力レイアウトが対応しているか 対応していれば1を返す */
+static uint8_t IMAADPCMWAVEncoder_IsSupportedInputLayout(
+    const struct IMAADPCMInputLayout *layout, uint32_t input_num_channels, uint32_t num_channels)
+{
+  assert(layout != NULL);
+
+  if ((layout->sample_format != IMAADPCM_SAMPLE_FORMAT_INT16)
+      && (layout->sample_format != IMAADPCM_SAMPLE_FORMAT_INT32)
+      && (layout->sample_format != IMAADPCM_SAMPLE_FORMAT_FLOAT32)) {
+    return 0;
+  }
+
+  /* 入力のチャンネル数（インターリーブ時のストライド）が足りない */
+  if (input_num_channels < num_channels) {
+    return 0;
+  }
+
+  return 1;
+}
+
+/* ヘッダ含めファイル全体を並列にエンコード */
+/* layoutがNULLならinputから、そうでなければlayout_inputからレイアウトに従って読み込む */
+static IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWholeParallelCore(
+    struct IMAADPCMWAVEncoder *encoder,
+    const struct IMAADPCMInputLayout *layout, const int16_t *const *input,
+    const void *const *layout_input, uint32_t input_num_channels, uint32_t num_samples,
+    uint8_t *data, uint64_t data_size, uint64_t *output_size,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context)
+{
+  IMAADPCMApiResult ret;
+  uint32_t task, num_blocks, block_output_size;
+  struct IMAADPCMWAVHeaderInfo header = { 0, };
+  struct IMAADPCMEncodeTaskContext context;
+
+  /* 引数チェック */
+  if ((encoder == NULL)
+      || ((layout == NULL) && (input == NULL))
+      || ((layout != NULL) && (layout_input == NULL))
+      || (data == NULL) || (output_size == NULL) || (num_tasks == 0)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* パラメータ未セットではエンコードできない */
+  if (encoder->set_parameter == 0) {
+    return IMAADPCM_APIRESULT_PARAMETER_NOT_SET;
+  }
+
+  /* エンコードパラメータをヘッダに変換 */
+  if (IMAADPCMWAVEncoder_ConvertParameterToHeader(&(encoder->encode_paramemter), num_samples, &header) != IMAADPCM_ERROR_OK) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+  header.channel_mask = encoder->channel_mask;
+
+  /* 対応していないチャンネル数 */
+  if ((header.num_channels == 0) || (header.num_channels > IMAADPCM_MAX_NUM_CHANNELS)) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* 対応していない入力レイアウト */
+  if ((layout != NULL)
+      && !IMAADPCMWAVEncoder_IsSupportedInputLayout(layout, input_num_channels, header.num_channels)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ヘッダエンコード */
+  if ((ret = IMAADPCMWAVEncoder_EncodeHeader(&header,
+          data, (uint32_t)IMAADPCM_MIN_VAL(data_size, UINT32_MAX))) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* 全ブロックを書き出す領域が無い */
+  if ((data_size - header.header_size) < IMAADPCMWAVEncoder_CalculateDataChunkSize(&header)) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+  }
+
+  /* ブロック数と出力位置の計算 */
+  /* 最後のブロック以外は完全なブロックなので、出力位置はブロック番号から確定する */
+  num_blocks = (num_samples + header.num_samples_per_block - 1) / header.num_samples_per_block;
+  block_output_size = IMAADPCMWAVEncoder_CalculateBlockOutputSize(header.num_channels, header.num_samples_per_block);
+
+  /* タスク数の確定 */
+  num_tasks = IMAADPCM_MIN_VAL(num_tasks, encoder->max_num_tasks);
+  num_tasks = IMAADPCM_MIN_VAL(num_tasks, num_blocks);
+
+  context.encoder = encoder;
+  context.input = input;
+  context.layout = layout;
+  context.layout_input = layout_input;
+  context.input_num_channels = input_num_channels;
+  context.num_samples = num_samples;
+  context.data = data + header.header_size;
+  context.data_size = data_size - header.header_size;
+  context.num_samples_per_block = header.num_samples_per_block;
+  context.block_output_size = block_output_size;
+  context.num_blocks = num_blocks;
+  context.num_blocks_per_task = num_blocks;
+
+  /* ブロック列を分割して並列にエンコード */
+  if (num_tasks > 0) {
+    context.num_blocks_per_task = (num_blocks + num_tasks - 1) / num_tasks;
+
+    if (executor != NULL) {
+      executor(executor_context, IMAADPCMWAVEncoder_EncodeTask, &context, num_tasks);
+    } else {
+      for (task = 0; task < num_tasks; task++) {
+        IMAADPCMWAVEncoder_EncodeTask(&context, task);
+      }
+    }
+
+    /* 先頭側のタスクのエラーを優先して返す */
+    for (task = 0; task < num_tasks; task++) {
+      if (context.result[task] != IMAADPCM_APIRESULT_OK) {
+        return context.result[task];
+      }
+    }
+  } else if (num_blocks > 0) {
+    /* タスク毎の領域が無いハンドルでは呼び出しスレッドで全ブロックをエンコード（結果はタスク数によらない） */
+    if ((ret = IMAADPCMWAVEncoder_EncodeTaskRangeOnCaller(&context)) != IMAADPCM_APIRESULT_OK) {
+      return ret;
+    }
+  }
+
+  /* 出力サイズの計算 */
+  (*output_size) = header.header_size + IMAADPCMWAVEncoder_CalculateDataChunkSize(&header);
+
+  /* 成功終了 */
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ヘッダ含めファイル全体を並列にエンコード */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWholeParallel(
+    struct IMAADPCMWAVEncoder *encoder,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context)
+{
+  IMAADPCMApiResult ret;
+  uint64_t tmp_output_size;
+
+  /* 引数チェック */
+  if (output_size == NULL) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  if ((ret = IMAADPCMWAVEncoder_EncodeWholeParallel64(encoder,
+          input, num_samples, data, data_size, &tmp_output_size,
+          num_tasks, executor, executor_context)) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* 出力はdata_size以下に収まっている */
+  assert(tmp_output_size <= data_size);
+  (*output_size) = (uint32_t)tmp_output_size;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ヘッダ含めファイル全体を並列にエンコード（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWholeParallel64(
+    struct IMAADPCMWAVEncoder *encoder,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint64_t data_size, uint64_t *output_size,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context)
+{
+  return IMAADPCMWAVEncoder_EncodeWholeParallelCore(encoder,
+      NULL, input, NULL, 0, num_samples, data, data_size, output_size,
+      num_tasks, executor, executor_context);
+}
+
+/* 入力レイアウトに従ってヘッダ含めファイル全体を並列にエンコード */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWholeParallelFromLayout(
+    struct IMAADPCMWAVEncoder *encoder,
+    const struct IMAADPCMInputLayout *layout,
+    const void *const *input, uint32_t input_num_channels, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context)
+{
+  IMAADPCMApiResult ret;
+  uint64_t tmp_output_size;
+
+  /* 引数チェック */
+  if (output_size == NULL) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  if ((ret = IMAADPCMWAVEncoder_EncodeWholeParallelFromLayout64(encoder,
+          layout, input, input_num_channels, num_samples, data, data_size, &tmp_output_size,
+          num_tasks, executor, executor_context)) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* 出力はdata_size以下に収まっている */
+  assert(tmp_output_size <= data_size);
+  (*output_size) = (uint32_t)tmp_output_size;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* 入力レイアウトに従ってヘッダ含めファイル全体を並列にエンコード（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWholeParallelFromLayout64(
+    struct IMAADPCMWAVEncoder *encoder,
+    const struct IMAADPCMInputLayout *layout,
+    const void *const *input, uint32_t input_num_channels, uint32_t num_samples,
+    uint8_t *data, uint64_t data_size, uint64_t *output_size,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context)
+{
+  /* 引数チェック */
+  if (layout == NULL) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  return IMAADPCMWAVEncoder_EncodeWholeParallelCore(encoder,
+      layout, NULL, input, input_num_channels, num_samples, data, data_size, output_size,
+      num_tasks, executor, executor_context);
+}
+
+/* 入力レイアウトに従ってヘッダ含めファイル全体をエンコード */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWholeFromLayout(
+    struct IMAADPCMWAVEncoder *encoder,
+    const struct IMAADPCMInputLayout *layout,
+    const void *const *input, uint32_t input_num_channels, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+  IMAADPCMApiResult ret;
+  uint64_t tmp_output_size;
+
+  /* 引数チェック */
+  if (output_size == NULL) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  if ((ret = IMAADPCMWAVEncoder_EncodeWholeFromLayout64(encoder,
+          layout, input, input_num_channels, num_samples, data, data_size, &tmp_output_size)) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* 出力はdata_size以下に収まっている */
+  assert(tmp_output_size <= data_size);
+  (*output_size) = (uint32_t)tmp_output_size;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* 入力レイアウトに従ってヘッダ含めファイル全体をエンコード（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWholeFromLayout64(
+    struct IMAADPCMWAVEncoder *encoder,
+    const struct IMAADPCMInputLayout *layout,
+    const void *const *input, uint32_t input_num_channels, uint32_t num_samples,
+    uint8_t *data, uint64_t data_size, uint64_t *output_size)
+{
+  IMAADPCMApiResult ret;
+  uint32_t ch, smpl, progress, write_size, num_encode_samples, num_tile_blocks, num_tile_samples;
+  uint32_t tile_num_samples;
+  uint64_t write_offset;
+  int16_t tile[IMAADPCM_LAYOUT_TILE_NUM_SAMPLES];
+  const int16_t *input_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+  int16_t *tile_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+  struct IMAADPCMWAVHeaderInfo header = { 0, };
+
+  /* 引数チェック */
+  if ((encoder == NULL) || (layout == NULL) || (input == NULL)
+      || (data == NULL) || (output_size == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* パラメータ未セットではエンコードできない */
+  if (encoder->set_parameter == 0) {
+    return IMAADPCM_APIRESULT_PARAMETER_NOT_SET;
+  }
+
+  /* エンコードパラメータをヘッダに変換 */
+  if (IMAADPCMWAVEncoder_ConvertParameterToHeader(&(encoder->encode_paramemter), num_samples, &header) != IMAADPCM_ERROR_OK) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+  header.channel_mask = encoder->channel_mask;
+
+  /* 対応していないチャンネル数 */
+  if ((header.num_channels == 0) || (header.num_channels > IMAADPCM_MAX_NUM_CHANNELS)) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* 対応していない入力レイアウト */
+  if (!IMAADPCMWAVEncoder_IsSupportedInputLayout(layout, input_num_channels, header.num_channels)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ヘッダエンコード */
+  if ((ret = IMAADPCMWAVEncoder_EncodeHeader(&header,
+          data, (uint32_t)IMAADPCM_MIN_VAL(data_size, UINT32_MAX))) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* タイルをチャンネル毎に分割 */
+  tile_num_samples = IMAADPCM_SplitLayoutTile(tile, header.num_channels, tile_ptr);
+
+  /* タイルに収まるブロック数 */
+  num_tile_blocks = tile_num_samples / header.num_samples_per_block;
+
+  progress = 0;
+  write_offset = header.header_size;
+  while (progress < num_samples) {
+    if (num_tile_blocks > 0) {
+      /* タイルに収まるだけのブロックを変換して読み込み、ブロック毎にエンコード */
+      num_tile_samples = IMAADPCM_MIN_VAL(num_tile_blocks * header.num_samples_per_block, num_samples - progress);
+      IMAADPCMWAVEncoder_LoadFromLayout(layout,
+          input, input_num_channels, header.num_channels, progress, num_tile_samples, tile_ptr);
+      for (smpl = 0; smpl < num_tile_samples; smpl += num_encode_samples) {
+        num_encode_samples = IMAADPCM_MIN_VAL(header.num_samples_per_block, num_tile_samples - smpl);
+        for (ch = 0; ch < header.num_channels; ch++) {
+          input_ptr[ch] = &tile_ptr[ch][smpl];
+        }
+        if ((ret = IMAADPCMWAVEncoder_EncodeBlock(encoder,
+                input_ptr, num_encode_samples,
+                data + write_offset, (uint32_t)IMAADPCM_MIN_VAL(data_size - write_offset, UINT32_MAX), &write_size)) != IMAADPCM_APIRESULT_OK) {
+          return ret;
+        }
+        write_offset += write_size;
+        assert(write_offset <= data_size);
+      }
+      progress += num_tile_samples;
+    } else {
+      /* タイルに収まらない大きなブロック */
+      num_encode_samples = IMAADPCM_MIN_VAL(header.num_samples_per_block, num_samples - progress);
+      if ((ret = IMAADPCMWAVEncoder_EncodeLargeBlockFromLayout(encoder,
+              layout, input, input_num_channels, progress, num_encode_samples, tile_ptr, tile_num_samples,
+              data + write_offset, (uint32_t)IMAADPCM_MIN_VAL(data_size - write_offset, UINT32_MAX), &write_size)) != IMAADPCM_APIRESULT_OK) {
+        return ret;
+      }
+      write_offset += write_size;
+      progress += num_encode_samples;
+      assert(write_offset <= data_size);
+    }
+  }
+
+  /* 成功終了 */
+  (*output_size) = write_offset;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ストリーミングエンコードのチャンネルあたりの書き出し単位[byte] */
+/* モノラルは1byte（2サンプル）、ステレオ以上は4byte（8サンプル）ずつインターリーブされる */
+static uint32_t IMAADPCMWAVEncoder_GetStreamUnitSize(uint32_t num_channels)
+{
+  return (num_channels == 1) ? 1 : 4;
+}
+
+/* ストリーミングエンコードでブロック先頭からnum_samplesを処理した時点での書き出し済みサイズ[byte] */
+/* flushが0の場合は書き出し単位に満たない末尾のデータを含めない */
+static uint32_t IMAADPCMWAVEncoder_CalculateStreamBlockOutputSize(
+    uint32_t num_channels, uint32_t num_samples, uint8_t flush)
+{
+  uint32_t size;
+  const uint32_t unit_size = IMAADPCMWAVEncoder_GetStreamUnitSize(num_channels);
+
+  if (num_samples == 0) {
+    return 0;
+  }
+
+  size = IMAADPCMWAVEncoder_CalculateBlockOutputSize(num_channels, num_samples);
+  if (!flush && (((num_samples - 1) % (2 * unit_size)) != 0)) {
+    size -= unit_size * num_channels;
+  }
+
+  return size;
+}
+
+/* ストリーミングエンコードで書き出し単位に満たないデータを最終サンプルで埋めて書き出す */
+/* 書き出したサイズを返す */
+static uint32_t IMAADPCMWAVEncoder_FlushStream(struct IMAADPCMWAVEncoder *encoder, uint8_t *data)
+{
+  uint32_t ch, smpl, num_pending_samples;
+  uint8_t *data_pos = data;
+  struct IMAADPCMEncodeStream *stream = &(encoder->stream);
+  const uint32_t num_channels = encoder->encode_paramemter.num_channels;
+  const uint32_t unit_size = IMAADPCMWAVEncoder_GetStreamUnitSize(num_channels);
+
+  /* ブロックヘッダのみ、または書き出し単位ちょうどで終わっている */
+  if ((stream->block_progress == 0)
+      || (((stream->block_progress - 1) % (2 * unit_size)) == 0)) {
+    return 0;
+  }
+
+  num_pending_samples = (stream->block_progress - 1) % (2 * unit_size);
+  for (ch = 0; ch < num_channels; ch++) {
+    for (smpl = num_pending_samples; smpl < 2 * unit_size; smpl++) {
+      const uint8_t nibble = IMAADPCMCoreEncoder_EncodeSample(&(stream->core_encoder[ch]), stream->last_sample[ch]);
+      stream->codes[ch] |= (uint32_t)nibble << (4 * smpl);
+    }
+    for (smpl = 0; smpl < unit_size; smpl++) {
+      ByteArray_PutUint8(data_pos, (uint8_t)((stream->codes[ch] >> (8 * smpl)) & 0xFF));
+    }
+    stream->codes[ch] = 0;
+  }
+
+  return (uint32_t)(data_pos - data);
+}
+
+/* ストリーミングエンコードで1サンプル（全チャンネル分）を処理し、確定したデータを書き出す */
+/* 書き出したサイズを返す */
+static uint32_t IMAADPCMWAVEncoder_EncodeStreamSample(
+    struct IMAADPCMWAVEncoder *encoder, const int16_t *const *input, uint32_t smpl, uint8_t *data)
+{
+  uint32_t ch, i, shift;
+  uint8_t *data_pos = data;
+  struct IMAADPCMEncodeStream *stream = &(encoder->stream);
+  const uint32_t num_channels = encoder->encode_paramemter.num_channels;
+  const uint32_t unit_size = IMAADPCMWAVEncoder_GetStreamUnitSize(num_channels);
+
+  if (stream->block_progress == 0) {
+    /* ブロックヘッダエンコード */
+    for (ch = 0; ch < num_channels; ch++) {
+      stream->core_encoder[ch].prev_sample = input[ch][smpl];
+      ByteArray_PutUint16LE(data_pos, stream->core_encoder[ch].prev_sample);
+      ByteArray_PutUint8(data_pos, stream->core_encoder[ch].stepsize_index);
+      ByteArray_PutUint8(data_pos, 0); /* reserved */
+    }
+  } else {
+    /* ニブルを溜め、書き出し単位に達したら書き出す */
+    shift = 4 * ((stream->block_progress - 1) % (2 * unit_size));
+    for (ch = 0; ch < num_channels; ch++) {
+      const uint8_t nibble = IMAADPCMCoreEncoder_EncodeSample(&(stream->core_encoder[ch]), input[ch][smpl]);
+      stream->codes[ch] |= (uint32_t)nibble << shift;
+    }
+    if (shift == (4 * (2 * unit_size - 1))) {
+      for (ch = 0; ch < num_channels; ch++) {
+        for (i = 0; i < unit_size; i++) {
+          ByteArray_PutUint8(data_pos, (uint8_t)((stream->codes[ch] >> (8 * i)) & 0xFF));
+        }
+        stream->codes[ch] = 0;
+      }
+    }
+  }
+
+  for (ch = 0; ch < num_channels; ch++) {
+    stream->last_sample[ch] = input[ch][smpl];
+  }
+
+  /* ブロック末尾に達したらブロックを閉じる */
+  stream->block_progress++;
+  if (stream->block_progress == stream->num_samples_per_block) {
+    data_pos += IMAADPCMWAVEncoder_FlushStream(encoder, data_pos);
+    stream->block_progress = 0;
+  }
+
+  return (uint32_t)(data_pos - data);
+}
+
+/* ストリーミングエンコードの開始 */
+/* reserve_ds64が1ならRF64のヘッダに書き換えられるようにds64チャンクの領域を予約する */
+static IMAADPCMApiResult IMAADPCMWAVEncoder_BeginEncodeCore(
+    struct IMAADPCMWAVEncoder *encoder, uint8_t reserve_ds64,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+  IMAADPCMApiResult ret;
+  struct IMAADPCMWAVHeaderInfo header = { 0, };
+  struct IMAADPCMEncodeStream *stream;
+
+  /* 引数チェック */
+  if ((encoder == NULL) || (data == NULL) || (output_size == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* パラメータ未セットではエンコードできない */
+  if (encoder->set_parameter == 0) {
+    return IMAADPCM_APIRESULT_PARAMETER_NOT_SET;
+  }
+
+  /* 総サンプル数0で暫定のヘッダを作成 */
+  if (IMAADPCMWAVEncoder_ConvertParameterToHeader(&(encoder->encode_paramemter), 0, &header) != IMAADPCM_ERROR_OK) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+  header.channel_mask = encoder->channel_mask;
+
+  /* 対応していないチャンネル数 */
+  if ((header.num_channels == 0) || (header.num_channels > IMAADPCM_MAX_NUM_CHANNELS)) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* ヘッダエンコード */
+  if ((ret = IMAADPCMWAVEncoder_EncodeHeaderCore(&header, reserve_ds64, data, data_size)) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* 状態の初期化 */
+  stream = &(encoder->stream);
+  memset(stream, 0, sizeof(struct IMAADPCMEncodeStream));
+  stream->num_samples_per_block = header.num_samples_per_block;
+  stream->started = 1;
+  stream->reserve_ds64 = reserve_ds64;
+
+  (*output_size) = IMAADPCMWAVEncoder_CalculateHeaderSize(&header, 0, reserve_ds64);
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ストリーミングエンコードの開始 */
+IMAADPCMApiResult IMAADPCMWAVEncoder_BeginEncode(
+    struct IMAADPCMWAVEncoder *encoder, uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+  return IMAADPCMWAVEncoder_BeginEncodeCore(encoder, 0, data, data_size, output_size);
+}
+
+/* 4GBを超えうるストリーミングエンコードの開始 */
+IMAADPCMApiResult IMAADPCMWAVEncoder_BeginEncode64(
+    struct IMAADPCMWAVEncoder *encoder, uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+  return IMAADPCMWAVEncoder_BeginEncodeCore(encoder, 1, data, data_size, output_size);
+}
+
+/* ストリーミングエンコードにサンプルを供給 */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeSamples(
+    struct IMAADPCMWAVEncoder *encoder,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+{
+  uint32_t ch, smpl, progress, num_block_samples, required_size;
+  uint8_t *data_pos;
+  struct IMAADPCMEncodeStream *stream;
+  uint32_t num_channels;
+  struct IMAADPCMWAVHeaderInfo header;
+
+  /* 引数チェック */
+  if ((encoder == NULL) || (output_size == NULL)
+      || ((num_samples > 0) && ((input == NULL) || (data == NULL)))) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+  stream = &(encoder->stream);
+  num_channels = encoder->encode_paramemter.num_channels;
+
+  /* 開始していない */
+  if (!stream->started) {
+    return IMAADPCM_APIRESULT_NG;
+  }
+
+  for (ch = 0; ch < num_channels; ch++) {
+    if ((num_samples > 0) && (input[ch] == NULL)) {
+      return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+    }
+  }
+
+  /* 総サンプル数がヘッダに書ける範囲を超える */
+  if (num_samples > (UINT32_MAX - stream->num_samples)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ds64チャンクを予約していない場合、RF64のヘッダが必要なサイズまでは書けない */
+  if (!stream->reserve_ds64) {
+    if (IMAADPCMWAVEncoder_ConvertParameterToHeader(&(encoder->encode_paramemter),
+          stream->num_samples + num_samples, &header) != IMAADPCM_ERROR_OK) {
+      return IMAADPCM_APIRESULT_INVALID_FORMAT;
+    }
+    if (header.header_size != IMAADPCMWAVEncoder_CalculateHeaderSize(&header, 0, 0)) {
+      return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+    }
+  }
+
+  /* 書き出すサイズを先に計算し、書き出しきれない場合は状態を変えずに終了 */
+  required_size = 0;
+  progress = stream->block_progress;
+  for (smpl = 0; smpl < num_samples; smpl += num_block_samples) {
+    num_block_samples = IMAADPCM_MIN_VAL(num_samples - smpl, stream->num_samples_per_block - progress);
+    required_size += IMAADPCMWAVEncoder_CalculateStreamBlockOutputSize(num_channels,
+        progress + num_block_samples, (progress + num_block_samples) == stream->num_samples_per_block);
+    required_size -= IMAADPCMWAVEncoder_CalculateStreamBlockOutputSize(num_channels, progress, 0);
+    progress = (progress + num_block_samples) % stream->num_samples_per_block;
+  }
+  if (required_size > data_size) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+  }
+
+  /* エンコード */
+  data_pos = data;
+  for (smpl = 0; smpl < num_samples; smpl++) {
+    data_pos += IMAADPCMWAVEncoder_EncodeStreamSample(encoder, input, smpl, data_pos);
+  }
+  stream->num_samples += num_samples;
+  assert((uint32_t)(data_pos - data) == required_size);
+
+  (*output_size) = required_size;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ストリーミングエンコードの終了 */
+IMAADPCMApiResult IMAADPCMWAVEncoder_FinishEncode(
+    struct IMAADPCMWAVEncoder *encoder,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size,
+    uint8_t *header_data, uint32_t header_data_size)
+{
+  IMAADPCMApiResult ret;
+  uint32_t required_size;
+  struct IMAADPCMWAVHeaderInfo header = { 0, };
+  struct IMAADPCMEncodeStream *stream;
+  uint32_t num_channels;
+
+  /* 引数チェック */
+  if ((encoder == NULL) || (data == NULL)
+      || (output_size == NULL) || (header_data == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+  stream = &(encoder->stream);
+  num_channels = encoder->encode_paramemter.num_channels;
+
+  /* 開始していない */
+  if (!stream->started) {
+    return IMAADPCM_APIRESULT_NG;
+  }
+
+  /* 書き出しきれない場合は状態を変えずに終了 */
+  required_size = IMAADPCMWAVEncoder_CalculateStreamBlockOutputSize(num_channels, stream->block_progress, 1)
+    - IMAADPCMWAVEncoder_CalculateStreamBlockOutputSize(num_channels, stream->block_progress, 0);
+  if (required_size > data_size) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+  }
+
+  /* 総サンプル数を反映したヘッダを作成 */
+  if (IMAADPCMWAVEncoder_ConvertParameterToHeader(&(encoder->encode_paramemter), stream->num_samples, &header) != IMAADPCM_ERROR_OK) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+  header.channel_mask = encoder->channel_mask;
+  if ((ret = IMAADPCMWAVEncoder_EncodeHeaderCore(&header,
+          stream->reserve_ds64, header_data, header_data_size)) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* 末尾のブロックを閉じる */
+  (*output_size) = IMAADPCMWAVEncoder_FlushStream(encoder, data);
+  assert((*output_size) == required_size);
+
+  stream->started = 0;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ストリーミングデコードの一時バッファにsizeバイトまでデータを溜める 溜まったら1を返す */
+static uint8_t IMAADPCMWAVDecoder_FillStreamBuffer(
+    struct IMAADPCMDecodeStream *stream, const uint8_t **data_pos, uint32_t *remain_size, uint32_t size)
+{
+  uint32_t copy_size;
+
+  assert(size <= IMAADPCM_MAX_BLOCK_SIZE);
+  assert(stream->buffered_size <= size);
+
+  copy_size = IMAADPCM_MIN_VAL(size - stream->buffered_size, *remain_size);
+  memcpy(&stream->buffer[stream->buffered_size], *data_pos, copy_size);
+  stream->buffered_size += copy_size;
+  stream->read_offset += copy_size;
+  (*data_pos) += copy_size;
+  (*remain_size) -= copy_size;
+
+  return (stream->buffered_size == size) ? 1 : 0;
+}
+
+/* ストリーミングデコードのヘッダ像にデータを追加 追加できなければ0を返す */
+static uint8_t IMAADPCMWAVDecoder_AppendStreamHeaderImage(
+    struct IMAADPCMDecodeStream *stream, const uint8_t *data, uint32_t size)
+{
+  if ((stream->header_image_size + size) > IMAADPCMWAVENCODER_MAX_HEADER_SIZE) {
+    return 0;
+  }
+
+  memcpy(&stream->header_image[stream->header_image_size], data, size);
+  stream->header_image_size += size;
+  return 1;
+}
+
+/* ストリーミングデコードのヘッダ読み込み */
+/* dataチャンクの先頭まで読み込んだらヘッダ像をデコードし、ブロック読み込みの段階に進める */
+/* 読み込み途中でデータが尽きた場合もIMAADPCM_APIRESULT_OKを返す */
+static IMAADPCMApiResult IMAADPCMWAVDecoder_ReadStreamHeader(
+    struct IMAADPCMWAVDecoder *decoder, const uint8_t **data_pos, uint32_t *remain_size)
+{
+  uint32_t chunk_id;
+  IMAADPCMApiResult ret;
+  struct IMAADPCMWAVHeaderInfo header;
+  struct IMAADPCMDecodeStream *stream = &(decoder->stream);
+
+  while ((*remain_size) > 0) {
+    switch (stream->stage) {
+      case IMAADPCM_DECODESTREAM_STAGE_RIFF:
+        /* RIFFチャンクID, RIFFチャンクサイズ, WAVEチャンクID */
+        if (!IMAADPCMWAVDecoder_FillStreamBuffer(stream, data_pos, remain_size, 12)) {
+          break;
+        }
+        (void)IMAADPCMWAVDecoder_AppendStreamHeaderImage(stream, stream->buffer, 12);
+        stream->buffered_size = 0;
+        stream->stage = IMAADPCM_DECODESTREAM_STAGE_CHUNK_HEADER;
+        break;
+      case IMAADPCM_DECODESTREAM_STAGE_CHUNK_HEADER:
+        /* チャンクIDとサイズ */
+        if (!IMAADPCMWAVDecoder_FillStreamBuffer(stream, data_pos, remain_size, 8)) {
+          break;
+        }
+        chunk_id = ByteArray_ReadUint32LE(&stream->buffer[0]);
+        stream->chunk_size = ByteArray_ReadUint32LE(&stream->buffer[4]);
+        stream->buffered_size = 0;
+        if (IMAADPCM_CHECK_FOURCC(chunk_id, 'f', 'm', 't', ' ')
+            || IMAADPCM_CHECK_FOURCC(chunk_id, 'f', 'a', 'c', 't')
+            || IMAADPCM_CHECK_FOURCC(chunk_id, 'd', 's', '6', '4')) {
+          /* ヘッダのデコードに必要なチャンクはヘッダ像に含める */
+          /* サイズはDecodeHeaderで受け付けるもの（fmt: 20かWAVE_FORMAT_EXTENSIBLEの40, fact: 4, ds64: テーブル無しの28）のみ */
+          if ((IMAADPCM_CHECK_FOURCC(chunk_id, 'f', 'm', 't', ' ')
+                && (stream->chunk_size != 20) && (stream->chunk_size != (20 + IMAADPCM_EXTENSIBLE_FMT_EXTRA_SIZE)))
+              || (IMAADPCM_CHECK_FOURCC(chunk_id, 'f', 'a', 'c', 't') && (stream->chunk_size != 4))
+              || (IMAADPCM_CHECK_FOURCC(chunk_id, 'd', 's', '6', '4') && (stream->chunk_size != (IMAADPCM_DS64_CHUNK_SIZE - 8)))
+              || !IMAADPCMWAVDecoder_AppendStreamHeaderImage(stream, stream->buffer, 8)) {
+            return IMAADPCM_APIRESULT_INVALID_FORMAT;
+          }
+          stream->stage = IMAADPCM_DECODESTREAM_STAGE_CHUNK_BODY;
+        } else if (IMAADPCM_CHECK_FOURCC(chunk_id, 'd', 'a', 't', 'a')) {
+          /* dataチャンクまで来たらヘッダ像をデコード */
+          if (!IMAADPCMWAVDecoder_AppendStreamHeaderImage(stream, stream->buffer, 8)) {
+            return IMAADPCM_APIRESULT_INVALID_FORMAT;
+          }
+          if ((ret = IMAADPCMWAVDecoder_DecodeHeader(stream->header_image,
+                  stream->header_image_size, &header)) != IMAADPCM_APIRESULT_OK) {
+            return ret;
+          }
+          /* ブロックに読み込むデータが無いものは扱えない */
+          if ((header.num_channels == 0) || (header.num_channels > IMAADPCM_MAX_NUM_CHANNELS)
+              || (header.block_size <= (4 * header.num_channels)) || (header.num_samples_per_block == 0)) {
+            return IMAADPCM_APIRESULT_INVALID_FORMAT;
+          }
+          /* データ領域先頭までのオフセットは読み飛ばしたチャンクも含めたもの */
+          header.header_size = (uint32_t)stream->read_offset;
+          decoder->header = header;
+          stream->stage = IMAADPCM_DECODESTREAM_STAGE_BLOCK;
+          return IMAADPCM_APIRESULT_OK;
+        } else {
+          stream->stage = IMAADPCM_DECODESTREAM_STAGE_SKIP_CHUNK;
+        }
+        break;
+      case IMAADPCM_DECODESTREAM_STAGE_CHUNK_BODY:
+        if (!IMAADPCMWAVDecoder_FillStreamBuffer(stream, data_pos, remain_size, stream->chunk_size)) {
+          break;
+        }
+        if (!IMAADPCMWAVDecoder_AppendStreamHeaderImage(stream, stream->buffer, stream->chunk_size)) {
+          return IMAADPCM_APIRESULT_INVALID_FORMAT;
+        }
+        stream->buffered_size = 0;
+        stream->stage = IMAADPCM_DECODESTREAM_STAGE_CHUNK_HEADER;
+        break;
+      case IMAADPCM_DECODESTREAM_STAGE_SKIP_CHUNK:
+        {
+          /* 他のチャンクは溜めずに読み飛ばす */
+          const uint32_t skip_size = IMAADPCM_MIN_VAL(stream->chunk_size, *remain_size);
+          stream->chunk_size -= skip_size;
+          stream->read_offset += skip_size;
+          (*data_pos) += skip_size;
+          (*remain_size) -= skip_size;
+          if (stream->chunk_size == 0) {
+            stream->stage = IMAADPCM_DECODESTREAM_STAGE_CHUNK_HEADER;
+          }
+        }
+        break;
+      default:
+        return IMAADPCM_APIRESULT_OK;
+    }
+  }
+
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ストリーミングデコードの開始 */
+IMAADPCMApiResult IMAADPCMWAVDecoder_BeginDecode(struct IMAADPCMWAVDecoder *decoder)
+{
+  /* 引数チェック ストリーミング用に作成したハンドルでなければならない */
+  if ((decoder == NULL) || (decoder->stream.buffer == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 状態の初期化 一時バッファの中身は初期化不要 */
+  decoder->stream.started = 1;
+  decoder->stream.stage = IMAADPCM_DECODESTREAM_STAGE_RIFF;
+  decoder->stream.read_offset = 0;
+  decoder->stream.chunk_size = 0;
+  decoder->stream.progress = 0;
+  decoder->stream.header_image_size = 0;
+  decoder->stream.buffered_size = 0;
+
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ストリーミングデコードで読み込んだヘッダ情報の取得 */
+IMAADPCMApiResult IMAADPCMWAVDecoder_GetStreamHeader(
+    const struct IMAADPCMWAVDecoder *decoder, struct IMAADPCMWAVHeaderInfo *header_info)
+{
+  /* 引数チェック */
+  if ((decoder == NULL) || (header_info == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 開始していない */
+  if (!decoder->stream.started) {
+    return IMAADPCM_APIRESULT_NG;
+  }
+
+  /* ヘッダをまだ読み終えていない */
+  if (decoder->stream.stage != IMAADPCM_DECODESTREAM_STAGE_BLOCK) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_DATA;
+  }
+
+  (*header_info) = decoder->header;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ストリーミングデコードにデータを供給 */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeData(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size, uint32_t *read_size,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
+{
+  IMAADPCMApiResult ret;
+  uint32_t ch, remain_size, output_progress, num_block_samples, read_block_size, tmp_num_decode_samples;
+  const uint8_t *data_pos, *block_pos;
+  int16_t *buffer_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+  struct IMAADPCMDecodeStream *stream;
+  const struct IMAADPCMWAVHeaderInfo *header;
+
+  /* 引数チェック */
+  if ((decoder == NULL) || ((data == NULL) && (data_size > 0))
+      || (read_size == NULL) || (buffer == NULL) || (num_decode_samples == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+  stream = &(decoder->stream);
+  header = &(decoder->header);
+
+  /* 開始していない */
+  if (!stream->started) {
+    return IMAADPCM_APIRESULT_NG;
+  }
+
+  ret = IMAADPCM_APIRESULT_OK;
+  data_pos = data;
+  remain_size = data_size;
+  output_progress = 0;
+
+  /* ヘッダ読み込み */
+  if (stream->stage != IMAADPCM_DECODESTREAM_STAGE_BLOCK) {
+    if ((ret = IMAADPCMWAVDecoder_ReadStreamHeader(decoder, &data_pos, &remain_size)) != IMAADPCM_APIRESULT_OK) {
+      goto DECODE_END;
+    }
+    if (stream->stage != IMAADPCM_DECODESTREAM_STAGE_BLOCK) {
+      goto DECODE_END;
+    }
+  }
+
+  /* バッファチャンネル数チェック */
+  if (buffer_num_channels < header->num_channels) {
+    ret = IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+    goto DECODE_END;
+  }
+
+  /* 揃ったブロックから順にデコード */
+  while (remain_size > 0) {
+    /* 総サンプル数に達したら残りのデータは読み捨てる（DecodeWholeと同じ） */
+    if (stream->progress >= header->num_samples) {
+      stream->read_offset += remain_size;
+      data_pos += remain_size;
+      remain_size = 0;
+      break;
+    }
+
+    /* 次のブロックのサンプル数と読み込みサイズ 末尾のブロックは必要な分だけ読む */
+    num_block_samples = IMAADPCM_MIN_VAL(header->num_samples_per_block, header->num_samples - stream->progress);
+    read_block_size = IMAADPCM_MIN_VAL(header->block_size,
+        IMAADPCMWAVEncoder_CalculateBlockOutputSize(header->num_channels, num_block_samples));
+
+    /* 出力バッファに入りきらなければ読み込みを止める */
+    if ((buffer_num_samples - output_progress) < num_block_samples) {
+      /* 空のバッファにも入らない */
+      if (output_progress == 0) {
+        ret = IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+      }
+      break;
+    }
+
+    if ((stream->buffered_size == 0) && (remain_size >= read_block_size)) {
+      /* ブロック全体が入力にあればそのままデコード */
+      block_pos = data_pos;
+      stream->read_offset += read_block_size;
+      data_pos += read_block_size;
+      remain_size -= read_block_size;
+    } else {
+      /* ブロックが入力をまたぐ場合は溜めてからデコード */
+      if (!IMAADPCMWAVDecoder_FillStreamBuffer(stream, &data_pos, &remain_size, read_block_size)) {
+        break;
+      }
+      block_pos = stream->buffer;
+      stream->buffered_size = 0;
+    }
+
+    /* ブロックデコード */
+    for (ch = 0; ch < header->num_channels; ch++) {
+      buffer_ptr[ch] = &buffer[ch][output_progress];
+    }
+    if ((ret = IMAADPCMWAVDecoder_DecodeBlock(decoder,
+            block_pos, read_block_size, buffer_ptr, buffer_num_channels,
+            num_block_samples, &tmp_num_decode_samples)) != IMAADPCM_APIRESULT_OK) {
+      goto DECODE_END;
+    }
+    assert(tmp_num_decode_samples == num_block_samples);
+    stream->progress += tmp_num_decode_samples;
+    output_progress += tmp_num_decode_samples;
+  }
+
+DECODE_END:
+  (*read_size) = (uint32_t)(data_pos - data);
+  (*num_decode_samples) = output_progress;
+  return ret;
+}
+
+/* ストリーミングデコードの終了 */
+IMAADPCMApiResult IMAADPCMWAVDecoder_FinishDecode(
+    struct IMAADPCMWAVDecoder *decoder,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
+{
+  IMAADPCMApiResult ret;
+  uint32_t num_block_samples;
+  struct IMAADPCMDecodeStream *stream;
+  const struct IMAADPCMWAVHeaderInfo *header;
+
+  /* 引数チェック */
+  if ((decoder == NULL) || (buffer == NULL) || (num_decode_samples == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+  stream = &(decoder->stream);
+  header = &(decoder->header);
+
+  /* 開始していない */
+  if (!stream->started) {
+    return IMAADPCM_APIRESULT_NG;
+  }
+
+  /* ヘッダを読み終えていない */
+  if (stream->stage != IMAADPCM_DECODESTREAM_STAGE_BLOCK) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_DATA;
+  }
+
+  /* 途中で途切れたブロックがあればデコード */
+  (*num_decode_samples) = 0;
+  if (stream->buffered_size > 0) {
+    assert(stream->progress < header->num_samples);
+    num_block_samples = IMAADPCM_MIN_VAL(header->num_samples_per_block, header->num_samples - stream->progress);
+    if (buffer_num_samples < num_block_samples) {
+      return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+    }
+    if ((ret = IMAADPCMWAVDecoder_DecodeBlock(decoder,
+            stream->buffer, stream->buffered_size, buffer, buffer_num_channels,
+            num_block_samples, num_decode_samples)) != IMAADPCM_APIRESULT_OK) {
+      return ret;
+    }
+    stream->progress += (*num_decode_samples);
+    stream->buffered_size = 0;
+  }
+
+  stream->started = 0;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ブロック内の一部のサンプルをデコード */
+/* ブロック内のbegin_sample番目までデコードした状態から1サンプルずつ進め、skip_samples番目から続くnum_samples個をbufferに書き出す */
+/* begin_sampleが0の場合はブロックヘッダから状態を読み込む それ以外はデコーダに状態が設定済みであること */
+static IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeBlockPartial(
+    struct IMAADPCMWAVDecoder *decoder, const uint8_t *block_data,
+    uint32_t begin_sample, uint32_t skip_samples, uint32_t num_samples, int16_t **buffer)
+{
+  uint8_t reserved;
+  uint32_t ch, smpl, nibble_pos, word_size;
+  int16_t sample;
+  const uint8_t *read_pos;
+  const struct IMAADPCMWAVHeaderInfo *header;
+
+  assert((decoder != NULL) && (block_data != NULL) && (buffer != NULL));
+  assert((begin_sample <= skip_samples) && (num_samples > 0));
+
+  header = &(decoder->header);
+  /* チャンネル毎に4バイト（8サンプル）のワードが並ぶ（モノラルは単にバイト列） */
+  word_size = 4 * (uint32_t)header->num_channels;
+
+  /* ブロックヘッダデコード */
+  if (begin_sample == 0) {
+    read_pos = block_data;
+    for (ch = 0; ch < header->num_channels; ch++) {
+      struct IMAADPCMCoreDecoder *core_decoder = &(decoder->core_decoder[ch]);
+      ByteArray_GetUint16LE(read_pos, (uint16_t *)&(core_decoder->sample_val));
+      ByteArray_GetUint8(read_pos, (uint8_t *)&(core_decoder->stepsize_index));
+      ByteArray_GetUint8(read_pos, &reserved);
+      if (reserved != 0) {
+        return IMAADPCM_APIRESULT_INVALID_FORMAT;
+      }
+      if ((core_decoder->stepsize_index < 0) || (core_decoder->stepsize_index > 88)) {
+        return IMAADPCM_APIRESULT_INVALID_FORMAT;
+      }
+    }
+  }
+
+  /* 範囲の末尾まで1サンプルずつデコードし、範囲内のサンプルだけを書き出す */
+  for (ch = 0; ch < header->num_channels; ch++) {
+    struct IMAADPCMCoreDecoder *core_decoder = &(decoder->core_decoder[ch]);
+    if (skip_samples == begin_sample) {
+      buffer[ch][0] = core_decoder->sample_val;
+    }
+    for (smpl = begin_sample + 1; smpl < (skip_samples + num_samples); smpl++) {
+      nibble_pos = smpl - 1;
+      read_pos = block_data + word_size * (1 + nibble_pos / 8) + 4 * ch + (nibble_pos % 8) / 2;
+      sample = IMAADPCMCoreDecoder_DecodeSample(core_decoder,
+          (uint8_t)((read_pos[0] >> (4 * (nibble_pos % 2))) & 0xF));
+      if (smpl >= skip_samples) {
+        buffer[ch][smpl - skip_samples] = sample;
+      }
+    }
+  }
+
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ブロックあたりサンプル数の計算（ブロックの構成がデコード可能でなければ0を返す） */
+static uint32_t IMAADPCMWAVDecoder_CalculateNumSamplesPerBlock(const struct IMAADPCMWAVHeaderInfo *header)
+{
+  assert(header != NULL);
+
+  if ((header->num_channels == 0) || (header->num_channels > IMAADPCM_MAX_NUM_CHANNELS)
+      || (header->block_size <= (4 * header->num_channels))) {
+    return 0;
+  }
+
+  /* ブロック内の位置はブロックサイズから求めたサンプル数で決まる（DecodeWholeと同じ） */
+  return (uint32_t)((header->block_size - 4 * header->num_channels) * 2) / header->num_channels + 1;
+}
+
+/* ファイル先頭からend_sample番目のサンプルの手前までをデコードするのに必要なデータサイズ */
+static uint64_t IMAADPCMWAVDecoder_CalculateRequiredDataSize(
+    const struct IMAADPCMWAVHeaderInfo *header, uint32_t num_samples_per_block, uint32_t end_sample)
+{
+  uint32_t last_block;
+
+  assert((header != NULL) && (num_samples_per_block > 0) && (end_sample > 0));
+
+  last_block = (end_sample - 1) / num_samples_per_block;
+  return header->header_size + (uint64_t)last_block * header->block_size
+    + IMAADPCM_MIN_VAL(header->block_size, IMAADPCMWAVEncoder_CalculateBlockOutputSize(header->num_channels,
+          end_sample - last_block * num_samples_per_block));
+}
+
+/* シークインデックスのシーク点数の計算 */
+/* 各ブロックの先頭を除くinterval個毎のサンプル位置がシーク点 末尾のブロックは総サンプル数までの分だけ */
+static uint32_t IMAADPCMWAVDecoder_CalculateNumSeekPoints(
+    const struct IMAADPCMWAVHeaderInfo *header, uint32_t num_samples_per_block, uint32_t interval)
+{
+  uint32_t num_blocks, num_last_block_samples;
+
+  assert((header != NULL) && (num_samples_per_block > 0) && (interval > 0));
+
+  if (header->num_samples == 0) {
+    return 0;
+  }
+
+  num_blocks = (header->num_samples + num_samples_per_block - 1) / num_samples_per_block;
+  num_last_block_samples = header->num_samples - (num_blocks - 1) * num_samples_per_block;
+  return (num_blocks - 1) * ((num_samples_per_block - 1) / interval) + (num_last_block_samples - 1) / interval;
+}
+
+/* シークインデックスの解釈 成功時はシーク点列の先頭とシーク点の間隔を返す */
+static IMAADPCMApiResult IMAADPCMWAVDecoder_ParseSeekIndex(
+    const struct IMAADPCMWAVHeaderInfo *header, uint32_t num_samples_per_block,
+    const uint8_t *index, uint32_t index_size, const uint8_t **seek_points, uint32_t *interval)
+{
+  uint32_t u32buf, tmp_interval, num_points;
+  uint16_t u16buf;
+  const uint8_t *read_pos;
+
+  assert((header != NULL) && (index != NULL) && (seek_points != NULL) && (interval != NULL));
+
+  if (index_size < IMAADPCM_SEEKINDEX_HEADER_SIZE) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_DATA;
+  }
+
+  read_pos = index;
+  ByteArray_GetUint32LE(read_pos, &u32buf);
+  if (!IMAADPCM_CHECK_FOURCC(u32buf, 's', 'e', 'e', 'k')) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+  ByteArray_GetUint32LE(read_pos, &u32buf);
+  if ((index_size < 8) || (u32buf > index_size - 8)) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_DATA;
+  }
+
+  /* 対象ファイルのブロック構成・サンプル数と一致しなければ使えない */
+  ByteArray_GetUint32LE(read_pos, &tmp_interval);
+  ByteArray_GetUint16LE(read_pos, &u16buf);
+  if ((tmp_interval == 0) || (u16buf != header->num_channels)) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+  ByteArray_GetUint16LE(read_pos, &u16buf);
+  if (u16buf != header->block_size) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+  ByteArray_GetUint32LE(read_pos, &num_points);
+  if ((num_points != IMAADPCMWAVDecoder_CalculateNumSeekPoints(header, num_samples_per_block, tmp_interval))
+      || (u32buf != (IMAADPCM_SEEKINDEX_HEADER_SIZE - 8) + num_points * 4 * header->num_channels)) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  (*seek_points) = read_pos;
+  (*interval) = tmp_interval;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* 範囲デコードの本体 seek_pointsがNULLでなければ先頭ブロックは直前のシーク点から再開する */
+static IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRangeCore(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    const uint8_t *seek_points, uint32_t interval,
+    uint32_t start_sample, uint32_t num_samples,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
+{
+  IMAADPCMApiResult ret;
+  uint32_t ch, num_samples_per_block, start_block, begin_samples, skip_samples, num_head_samples;
+  uint64_t required_size;
+  int16_t *buffer_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+  const struct IMAADPCMWAVHeaderInfo *header;
+
+  assert((decoder != NULL) && (data != NULL) && (buffer != NULL) && (num_decode_samples != NULL));
+
+  header = &(decoder->header);
+  num_samples_per_block = IMAADPCMWAVDecoder_CalculateNumSamplesPerBlock(header);
+  assert(num_samples_per_block > 0);
+
+  /* 範囲をファイル末尾で切り詰め */
+  (*num_decode_samples) = 0;
+  if (start_sample >= header->num_samples) {
+    return IMAADPCM_APIRESULT_OK;
+  }
+  num_samples = IMAADPCM_MIN_VAL(num_samples, header->num_samples - start_sample);
+  if (num_samples == 0) {
+    return IMAADPCM_APIRESULT_OK;
+  }
+
+  /* バッファサイズチェック */
+  if ((buffer_num_channels < header->num_channels) || (buffer_num_samples < num_samples)) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+  }
+
+  /* 範囲末尾のサンプルまでのデータがあるか */
+  required_size = IMAADPCMWAVDecoder_CalculateRequiredDataSize(header, num_samples_per_block, start_sample + num_samples);
+  if (data_size < required_size) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_DATA;
+  }
+
+  /* 範囲に重なるブロックはサンプル位置の除算で求まる */
+  start_block = start_sample / num_samples_per_block;
+  skip_samples = start_sample - start_block * num_samples_per_block;
+
+  /* 先頭ブロックの途中から始まる場合は、手前のサンプルを読み捨てて範囲内だけを書き出す */
+  num_head_samples = 0;
+  if (skip_samples > 0) {
+    num_head_samples = IMAADPCM_MIN_VAL(num_samples, num_samples_per_block - skip_samples);
+    /* 直前のシーク点があればそこから再開 */
+    begin_samples = 0;
+    if ((seek_points != NULL) && (skip_samples >= interval)) {
+      const uint8_t *point_pos = seek_points + 4 * (uint32_t)header->num_channels
+        * (start_block * ((num_samples_per_block - 1) / interval) + skip_samples / interval - 1);
+      begin_samples = (skip_samples / interval) * interval;
+      for (ch = 0; ch < header->num_channels; ch++) {
+        uint8_t reserved;
+        ByteArray_GetUint16LE(point_pos, (uint16_t *)&(decoder->core_decoder[ch].sample_val));
+        ByteArray_GetUint8(point_pos, (uint8_t *)&(decoder->core_decoder[ch].stepsize_index));
+        ByteArray_GetUint8(point_pos, &reserved);
+        if ((reserved != 0)
+            || (decoder->core_decoder[ch].stepsize_index < 0) || (decoder->core_decoder[ch].stepsize_index > 88)) {
+          return IMAADPCM_APIRESULT_INVALID_FORMAT;
+        }
+      }
+    }
+    if ((ret = IMAADPCMWAVDecoder_DecodeBlockPartial(decoder,
+            data + header->header_size + (uint64_t)start_block * header->block_size,
+            begin_samples, skip_samples, num_head_samples, buffer)) != IMAADPCM_APIRESULT_OK) {
+      return ret;
+    }
+    start_block++;
+  }
+
+  /* 残りはブロック先頭から始まるので、範囲末尾までブロック列としてデコード */
+  if (num_head_samples < num_samples) {
+    for (ch = 0; ch < header->num_channels; ch++) {
+      buffer_ptr[ch] = &buffer[ch][num_head_samples];
+    }
+    /* バッファサイズを範囲で切ることで、末尾のブロックも範囲外には書き出さない */
+    if ((ret = IMAADPCMWAVDecoder_DecodeBlockSequence(decoder,
+            data, required_size, header->header_size + (uint64_t)start_block * header->block_size,
+            buffer_ptr, header->num_channels, num_samples - num_head_samples,
+            0, num_samples - num_head_samples, NULL)) != IMAADPCM_APIRESULT_OK) {
+      return ret;
+    }
+  }
+
+  (*num_decode_samples) = num_samples;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* ヘッダ含めファイル全体から指定範囲のサンプルをデコード */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRange(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    uint32_t start_sample, uint32_t num_samples,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
+{
+  return IMAADPCMWAVDecoder_DecodeRange64(decoder, data, data_size,
+      start_sample, num_samples, buffer, buffer_num_channels, buffer_num_samples, num_decode_samples);
+}
+
+/* ヘッダ含めファイル全体から指定範囲のサンプルをデコード（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRange64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    uint32_t start_sample, uint32_t num_samples,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
+{
+  IMAADPCMApiResult ret;
+
+  /* 引数チェック */
+  if ((decoder == NULL) || (data == NULL)
+      || (buffer == NULL) || (num_decode_samples == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ヘッダデコード */
+  if ((ret = IMAADPCMWAVDecoder_DecodeHeader64(data, data_size, &(decoder->header))) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* 対応していないブロック構成 */
+  if (IMAADPCMWAVDecoder_CalculateNumSamplesPerBlock(&(decoder->header)) == 0) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  return IMAADPCMWAVDecoder_DecodeRangeCore(decoder, data, data_size, NULL, 0,
+      start_sample, num_samples, buffer, buffer_num_channels, buffer_num_samples, num_decode_samples);
+}
+
+/* シークインデックスのサイズ計算 */
+IMAADPCMApiResult IMAADPCMWAVDecoder_CalculateSeekIndexSize(
+    const struct IMAADPCMWAVHeaderInfo *header_info, uint32_t interval, uint32_t *index_size)
+{
+  uint32_t num_samples_per_block;
+
+  /* 引数チェック */
+  if ((header_info == NULL) || (index_size == NULL) || (interval == 0)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 対応していないブロック構成 */
+  if ((num_samples_per_block = IMAADPCMWAVDecoder_CalculateNumSamplesPerBlock(header_info)) == 0) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* ヘッダ + シーク点毎にチャンネル数分の状態（ブロックヘッダと同じ4byte） */
+  (*index_size) = IMAADPCM_SEEKINDEX_HEADER_SIZE
+    + IMAADPCMWAVDecoder_CalculateNumSeekPoints(header_info, num_samples_per_block, interval)
+    * 4 * (uint32_t)header_info->num_channels;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* シークインデックスの作成 */
+IMAADPCMApiResult IMAADPCMWAVDecoder_CreateSeekIndex(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size, uint32_t interval,
+    uint8_t *index, uint32_t index_size, uint32_t *output_size)
+{
+  return IMAADPCMWAVDecoder_CreateSeekIndex64(decoder,
+      data, data_size, interval, index, index_size, output_size);
+}
+
+/* シークインデックスの作成（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVDecoder_CreateSeekIndex64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size, uint32_t interval,
+    uint8_t *index, uint32_t index_size, uint32_t *output_size)
+{
+  IMAADPCMApiResult ret;
+  uint32_t ch, blk, smpl, nibble_pos, num_samples_per_block, num_blocks, num_block_samples, word_size, tmp_index_size;
+  const uint8_t *block_data, *read_pos;
+  uint8_t *write_pos;
+  const struct IMAADPCMWAVHeaderInfo *header;
+
+  /* 引数チェック */
+  if ((decoder == NULL) || (data == NULL) || (index == NULL) || (output_size == NULL) || (interval == 0)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ヘッダデコード */
+  if ((ret = IMAADPCMWAVDecoder_DecodeHeader64(data, data_size, &(decoder->header))) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+  header = &(decoder->header);
+
+  /* 出力サイズチェック */
+  if ((ret = IMAADPCMWAVDecoder_CalculateSeekIndexSize(header, interval, &tmp_index_size))
+      != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+  if (index_size < tmp_index_size) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+  }
+
+  /* 全サンプル分のデータがあるか */
+  num_samples_per_block = IMAADPCMWAVDecoder_CalculateNumSamplesPerBlock(header);
+  if ((header->num_samples > 0)
+      && (data_size < IMAADPCMWAVDecoder_CalculateRequiredDataSize(header, num_samples_per_block, header->num_samples))) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_DATA;
+  }
+
+  /* インデックスのヘッダ（そのままRIFFチャンクとして埋め込める形式） */
+  write_pos = index;
+  ByteArray_PutUint8(write_pos, 's');
+  ByteArray_PutUint8(write_pos, 'e');
+  ByteArray_PutUint8(write_pos, 'e');
+  ByteArray_PutUint8(write_pos, 'k');
+  ByteArray_PutUint32LE(write_pos, tmp_index_size - 8);
+  ByteArray_PutUint32LE(write_pos, interval);
+  ByteArray_PutUint16LE(write_pos, header->num_channels);
+  ByteArray_PutUint16LE(write_pos, header->block_size);
+  ByteArray_PutUint32LE(write_pos, (tmp_index_size - IMAADPCM_SEEKINDEX_HEADER_SIZE) / (4 * (uint32_t)header->num_channels));
+
+  /* 全ブロックをデコードし、シーク点でのデコーダの状態を記録 */
+  word_size = 4 * (uint32_t)header->num_channels;
+  num_blocks = (header->num_samples + num_samples_per_block - 1) / num_samples_per_block;
+  for (blk = 0; blk < num_blocks; blk++) {
+    block_data = data + header->header_size + (uint64_t)blk * header->block_size;
+    num_block_samples = IMAADPCM_MIN_VAL(num_samples_per_block, header->num_samples - blk * num_samples_per_block);
+    /* ブロックヘッダデコード */
+    read_pos = block_data;
+    for (ch = 0; ch < header->num_channels; ch++) {
+      uint8_t reserved;
+      struct IMAADPCMCoreDecoder *core_decoder = &(decoder->core_decoder[ch]);
+      ByteArray_GetUint16LE(read_pos, (uint16_t *)&(core_decoder->sample_val));
+      ByteArray_GetUint8(read_pos, (uint8_t *)&(core_decoder->stepsize_index));
+      ByteArray_GetUint8(read_pos, &reserved);
+      if ((reserved != 0) || (core_decoder->stepsize_index < 0) || (core_decoder->stepsize_index > 88)) {
+        return IMAADPCM_APIRESULT_INVALID_FORMAT;
+      }
+    }
+    /* シーク点はサンプル位置順、同じ位置ではチャンネル順に並べる */
+    for (smpl = interval; smpl < num_block_samples; smpl += interval) {
+      for (ch = 0; ch < header->num_channels; ch++) {
+        struct IMAADPCMCoreDecoder *core_decoder = &(decoder->core_decoder[ch]);
+        for (nibble_pos = smpl - interval; nibble_pos < smpl; nibble_pos++) {
+          read_pos = block_data + word_size * (1 + nibble_pos / 8) + 4 * ch + (nibble_pos % 8) / 2;
+          (void)IMAADPCMCoreDecoder_DecodeSample(core_decoder,
+              (uint8_t)((read_pos[0] >> (4 * (nibble_pos % 2))) & 0xF));
+        }
+        ByteArray_PutUint16LE(write_pos, (uint16_t)core_decoder->sample_val);
+        ByteArray_PutUint8(write_pos, (uint8_t)core_decoder->stepsize_index);
+        ByteArray_PutUint8(write_pos, 0); /* reserved */
+      }
+    }
+  }
+  assert((uint32_t)(write_pos - index) == tmp_index_size);
+
+  (*output_size) = tmp_index_size;
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* シークインデックスを使ってファイル全体から指定範囲のサンプルをデコード */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRangeWithSeekIndex(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    const uint8_t *index, uint32_t index_size,
+    uint32_t start_sample, uint32_t num_samples,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
+{
+  return IMAADPCMWAVDecoder_DecodeRangeWithSeekIndex64(decoder, data, data_size, index, index_size,
+      start_sample, num_samples, buffer, buffer_num_channels, buffer_num_samples, num_decode_samples);
+}
+
+/* シークインデックスを使ってファイル全体から指定範囲のサンプルをデコード（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRangeWithSeekIndex64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    const uint8_t *index, uint32_t index_size,
+    uint32_t start_sample, uint32_t num_samples,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
+{
+  IMAADPCMApiResult ret;
+  uint32_t num_samples_per_block, interval;
+  const uint8_t *seek_points;
+
+  /* 引数チェック */
+  if ((decoder == NULL) || (data == NULL) || (index == NULL)
+      || (buffer == NULL) || (num_decode_samples == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ヘッダデコード */
+  if ((ret = IMAADPCMWAVDecoder_DecodeHeader64(data, data_size, &(decoder->header))) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* 対応していないブロック構成 */
+  if ((num_samples_per_block = IMAADPCMWAVDecoder_CalculateNumSamplesPerBlock(&(decoder->header))) == 0) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* インデックスの解釈 */
+  if ((ret = IMAADPCMWAVDecoder_ParseSeekIndex(&(decoder->header), num_samples_per_block,
+          index, index_size, &seek_points, &interval)) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  return IMAADPCMWAVDecoder_DecodeRangeCore(decoder, data, data_size, seek_points, interval,
+      start_sample, num_samples, buffer, buffer_num_channels, buffer_num_samples, num_decode_samples);
+}
+
+/* デコードしたサンプル列にゲインを掛けてミックスバスのbus_offsetの位置から加算 int_busとfloat_busのどちらか一方を指定する */
+static void IMAADPCMWAVDecoder_MixSamples(
+    const int16_t *samples, uint32_t num_samples, int32_t gain,
+    int32_t *int_bus, float *float_bus, uint32_t bus_offset)
+{
+  uint32_t smpl;
+
+  assert(samples != NULL);
+  assert((int_bus != NULL) != (float_bus != NULL));
+
+  if (int_bus != NULL) {
+    /* Q15の積を四捨五入して加算 */
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      int_bus[bus_offset + smpl] += (samples[smpl] * gain + (1 << 14)) >> 15;
+    }
+  } else {
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      float_bus[bus_offset + smpl] += (float)(samples[smpl] * gain) * IMAADPCM_MIX_FLOAT_SCALE;
+    }
+  }
+}
+
+/* ブロック内の一部のサンプルをデコードしながらミックスバスに加算 */
+/* skip_samples番目から続くnum_samples個にゲインを掛け、バスのbus_offsetの位置から加算する */
+/* デコード結果はワード（8サンプル）単位で受けてすぐに加算するため、ブロック分の中間バッファを持たない */
+static IMAADPCMApiResult IMAADPCMWAVDecoder_MixBlock(
+    struct IMAADPCMWAVDecoder *decoder, const uint8_t *block_data,
+    uint32_t skip_samples, uint32_t num_samples, int32_t gain,
+    int32_t **int_bus, float **float_bus, uint32_t bus_offset)
+{
+  uint8_t reserved, u8buf;
+  uint32_t ch, smpl, smp, word_pos, num_word_samples, end_sample, mix_start, word_size;
+  int16_t buf[8];
+  const uint8_t *read_pos;
+  const struct IMAADPCMWAVHeaderInfo *header;
+
+  assert((decoder != NULL) && (block_data != NULL));
+  assert((int_bus != NULL) != (float_bus != NULL));
+  assert(num_samples > 0);
+
+  header = &(decoder->header);
+  /* チャンネル毎に4バイト（8サンプル）のワードが並ぶ（モノラルは単にバイト列） */
+  word_size = 4 * (uint32_t)header->num_channels;
+  end_sample = skip_samples + num_samples;
+
+  /* ブロックヘッダデコード */
+  read_pos = block_data;
+  for (ch = 0; ch < header->num_channels; ch++) {
+    struct IMAADPCMCoreDecoder *core_decoder = &(decoder->core_decoder[ch]);
+    ByteArray_GetUint16LE(read_pos, (uint16_t *)&(core_decoder->sample_val));
+    ByteArray_GetUint8(read_pos, (uint8_t *)&(core_decoder->stepsize_index));
+    ByteArray_GetUint8(read_pos, &reserved);
+    if (reserved != 0) {
+      return IMAADPCM_APIRESULT_INVALID_FORMAT;
+    }
+    if ((core_decoder->stepsize_index < 0) || (core_decoder->stepsize_index > 88)) {
+      return IMAADPCM_APIRESULT_INVALID_FORMAT;
+    }
+  }
+
+  for (ch = 0; ch < header->num_channels; ch++) {
+    struct IMAADPCMCoreDecoder *core_decoder = &(decoder->core_decoder[ch]);
+    int32_t *int_bus_ch = (int_bus != NULL) ? int_bus[ch] : NULL;
+    float *float_bus_ch = (float_bus != NULL) ? float_bus[ch] : NULL;
+
+    /* 先頭サンプルはヘッダに入っている */
+    if (skip_samples == 0) {
+      buf[0] = core_decoder->sample_val;
+      IMAADPCMWAVDecoder_MixSamples(buf, 1, gain, int_bus_ch, float_bus_ch, bus_offset);
+    }
+
+    /* ワード毎にデコードし、範囲内のサンプルだけを加算 */
+    /* 範囲末尾のサンプルを含むバイトまでしか読まない */
+    for (smpl = 1, word_pos = 0; smpl < end_sample; smpl += 8, word_pos++) {
+      num_word_samples = IMAADPCM_MIN_VAL(8, end_sample - smpl);
+      read_pos = block_data + word_size * (1 + word_pos) + 4 * ch;
+      for (smp = 0; smp < num_word_samples; smp += 2) {
+        ByteArray_GetUint8(read_pos, &u8buf);
+        buf[smp] = IMAADPCMCoreDecoder_DecodeSample(core_decoder, (uint8_t)((u8buf >> 0) & 0xF));
+        if ((smp + 1) < num_word_samples) {
+          buf[smp + 1] = IMAADPCMCoreDecoder_DecodeSample(core_decoder, (uint8_t)((u8buf >> 4) & 0xF));
+        }
+      }
+      if ((smpl + num_word_samples) > skip_samples) {
+        mix_start = (skip_samples > smpl) ? (skip_samples - smpl) : 0;
+        IMAADPCMWAVDecoder_MixSamples(&buf[mix_start], num_word_samples - mix_start, gain,
+            int_bus_ch, float_bus_ch, bus_offset + smpl + mix_start - skip_samples);
+      }
+    }
+  }
+
+  return IMAADPCM_APIRESULT_OK;
+}
+
+/* 範囲デコード・ミックスの本体 */
+static IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRangeMixCore(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    uint32_t start_sample, uint32_t num_samples, int32_t gain,
+    int32_t **int_bus, float **float_bus, uint32_t bus_num_channels, uint32_t bus_num_samples,
+    uint32_t *num_decode_samples)
+{
+  IMAADPCMApiResult ret;
+  uint32_t num_samples_per_block, block, skip_samples, num_block_samples, progress;
+  const struct IMAADPCMWAVHeaderInfo *header;
+
+  assert((decoder != NULL) && (data != NULL) && (num_decode_samples != NULL));
+  assert((int_bus != NULL) != (float_bus != NULL));
+
+  /* ゲインの範囲チェック */
+  if ((gain < -IMAADPCM_MIX_MAX_GAIN) || (gain > IMAADPCM_MIX_MAX_GAIN)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ヘッダデコード */
+  if ((ret = IMAADPCMWAVDecoder_DecodeHeader64(data, data_size, &(decoder->header))) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+  header = &(decoder->header);
+
+  /* 対応していないブロック構成 */
+  if ((num_samples_per_block = IMAADPCMWAVDecoder_CalculateNumSamplesPerBlock(header)) == 0) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* 範囲をファイル末尾で切り詰め */
+  (*num_decode_samples) = 0;
+  if (start_sample >= header->num_samples) {
+    return IMAADPCM_APIRESULT_OK;
+  }
+  num_samples = IMAADPCM_MIN_VAL(num_samples, header->num_samples - start_sample);
+  if (num_samples == 0) {
+    return IMAADPCM_APIRESULT_OK;
+  }
+
+  /* バッファサイズチェック */
+  if ((bus_num_channels < header->num_channels) || (bus_num_samples < num_samples)) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+  }
+
+  /* 範囲末尾のサンプルまでのデータがあるか */
+  if (data_size < IMAADPCMWAVDecoder_CalculateRequiredDataSize(header, num_samples_per_block, start_sample + num_samples)) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_DATA;
+  }
 
-    /* ブロックデコード */
-    if ((ret = IMAADPCMWAVDecoder_DecodeBlock(decoder,
-          read_pos, read_block_size,
-          buffer_ptr, buffer_num_channels, buffer_num_samples - progress, 
-          &num_decode_samples)) != IMAADPCM_APIRESULT_OK) {
+  /* 範囲に重なるブロックを順にデコードしながら加算 */
+  block = start_sample / num_samples_per_block;
+  skip_samples = start_sample - block * num_samples_per_block;
+  for (progress = 0; progress < num_samples; progress += num_block_samples) {
+    num_block_samples = IMAADPCM_MIN_VAL(num_samples - progress, num_samples_per_block - skip_samples);
+    if ((ret = IMAADPCMWAVDecoder_MixBlock(decoder,
+            data + header->header_size + (uint64_t)block * header->block_size,
+            skip_samples, num_block_samples, gain, int_bus, float_bus, progress)) != IMAADPCM_APIRESULT_OK) {
       return ret;
     }
-
-    /* 進捗更新 */
-    read_pos    += read_block_size;
-    read_offset += read_block_size;
-    progress    += num_decode_samples;
+    skip_samples = 0;
+    block++;
   }
 
-  /* 成功終了 */
+  (*num_decode_samples) = num_samples;
   return IMAADPCM_APIRESULT_OK;
 }
 
-/* ヘッダエンコード */
-IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeHeader(
-    const struct IMAADPCMWAVHeaderInfo *header_info, uint8_t *data, uint32_t data_size)
+/* ファイル全体から指定範囲のサンプルをデコードし、ゲインを掛けて32bit整数のミックスバスに加算 */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRangeMix(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    uint32_t start_sample, uint32_t num_samples, int32_t gain,
+    int32_t **mix_buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
 {
-  uint8_t *data_pos;
-  uint32_t num_blocks, data_chunk_size;
-  uint32_t tail_block_num_samples, tail_block_size;
+  return IMAADPCMWAVDecoder_DecodeRangeMix64(decoder, data, data_size,
+      start_sample, num_samples, gain, mix_buffer, buffer_num_channels, buffer_num_samples, num_decode_samples);
+}
 
+/* ファイル全体から指定範囲のサンプルをデコードし、ゲインを掛けて32bit整数のミックスバスに加算（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRangeMix64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    uint32_t start_sample, uint32_t num_samples, int32_t gain,
+    int32_t **mix_buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
+{
   /* 引数チェック */
-  if ((header_info == NULL) || (data == NULL)) {
+  if ((decoder == NULL) || (data == NULL)
+      || (mix_buffer == NULL) || (num_decode_samples == NULL)) {
     return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
   }
 
-  /* ヘッダサイズと入力データサイズの比較 */
-  if (data_size < IMAADPCMWAVENCODER_HEADER_SIZE) {
-    return IMAADPCM_APIRESULT_INSUFFICIENT_DATA;
+  return IMAADPCMWAVDecoder_DecodeRangeMixCore(decoder, data, data_size,
+      start_sample, num_samples, gain, mix_buffer, NULL, buffer_num_channels, buffer_num_samples, num_decode_samples);
+}
+
+/* ファイル全体から指定範囲のサンプルをデコードし、ゲインを掛けて浮動小数点のミックスバスに加算 */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRangeMixFloat(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    uint32_t start_sample, uint32_t num_samples, int32_t gain,
+    float **mix_buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
+{
+  return IMAADPCMWAVDecoder_DecodeRangeMixFloat64(decoder, data, data_size,
+      start_sample, num_samples, gain, mix_buffer, buffer_num_channels, buffer_num_samples, num_decode_samples);
+}
+
+/* ファイル全体から指定範囲のサンプルをデコードし、ゲインを掛けて浮動小数点のミックスバスに加算（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRangeMixFloat64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    uint32_t start_sample, uint32_t num_samples, int32_t gain,
+    float **mix_buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
+{
+  /* 引数チェック */
+  if ((decoder == NULL) || (data == NULL)
+      || (mix_buffer == NULL) || (num_decode_samples == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
   }
 
-  /* ヘッダの簡易チェック: ブロックサイズはサンプルデータを全て入れられるはず */
-  if (IMAADPCM_CALCULATE_DATASIZE_BYTE(header_info->num_samples_per_block, header_info->bits_per_sample) > header_info->block_size) {
-    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  return IMAADPCMWAVDecoder_DecodeRangeMixCore(decoder, data, data_size,
+      start_sample, num_samples, gain, NULL, mix_buffer, buffer_num_channels, buffer_num_samples, num_decode_samples);
+}
+
+/* リサンプリングの多相フィルタ係数の作成 */
+/* 窓付きsinc関数を位相毎に直流利得が1になるよう正規化してQ15に量子化する cutoffはナイキスト周波数に対する比 */
+static void IMAADPCMWAVDecoder_MakeResampleFilter(int16_t *coef, double cutoff)
+{
+  uint32_t phase, tap;
+  int32_t qsum;
+  double h[IMAADPCM_RESAMPLE_NUM_TAPS], sum;
+  const int32_t center = IMAADPCM_RESAMPLE_NUM_TAPS / 2 - 1;
+
+  assert((coef != NULL) && (cutoff > 0.0) && (cutoff <= 1.0));
+
+  for (phase = 0; phase < IMAADPCM_RESAMPLE_NUM_PHASES; phase++) {
+    int16_t *row = &coef[phase * IMAADPCM_RESAMPLE_NUM_TAPS];
+    sum = 0.0;
+    for (tap = 0; tap < IMAADPCM_RESAMPLE_NUM_TAPS; tap++) {
+      /* 出力位置から見たタップの位置 */
+      const double t = (double)((int32_t)tap - center) - (double)phase / IMAADPCM_RESAMPLE_NUM_PHASES;
+      const double x = IMAADPCM_PI * cutoff * t;
+      /* Blackman窓（タップの範囲[-N/2, N/2]に合わせる） */
+      const double window = 0.42 + 0.5 * cos(2.0 * IMAADPCM_PI * t / IMAADPCM_RESAMPLE_NUM_TAPS)
+        + 0.08 * cos(4.0 * IMAADPCM_PI * t / IMAADPCM_RESAMPLE_NUM_TAPS);
+      h[tap] = ((fabs(x) < 1.0e-9) ? 1.0 : (sin(x) / x)) * window;
+      sum += h[tap];
+    }
+    qsum = 0;
+    for (tap = 0; tap < IMAADPCM_RESAMPLE_NUM_TAPS; tap++) {
+      row[tap] = (int16_t)floor(32768.0 * h[tap] / sum + 0.5);
+      qsum += row[tap];
+    }
+    /* 量子化誤差は出力位置に近いタップで吸収し、直流利得をちょうど1にする */
+    row[center + ((phase >= (IMAADPCM_RESAMPLE_NUM_PHASES / 2)) ? 1 : 0)] += (int16_t)(32768 - qsum);
   }
-  
-  /* データサイズ計算 */
-  assert(header_info->num_samples_per_block != 0);
-  num_blocks = (header_info->num_samples / header_info->num_samples_per_block) + 1;
-  data_chunk_size = header_info->block_size * num_blocks;
-  /* 末尾のブロックの剰余サンプルサイズだけ減じる */
-  tail_block_num_samples = header_info->num_samples % header_info->num_samples_per_block;
-  tail_block_size = IMAADPCM_CALCULATE_DATASIZE_BYTE(header_info->num_samples_per_block - tail_block_num_samples, header_info->bits_per_sample);
-  data_chunk_size -= tail_block_size;
+}
 
-  /* 書き出し用ポインタ設定 */
-  data_pos = data;
+/* リサンプリングデコードの開始 */
+IMAADPCMApiResult IMAADPCMWAVDecoder_BeginResample(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    uint32_t output_sampling_rate, IMAADPCMResampleMode mode, uint32_t *num_output_samples)
+{
+  return IMAADPCMWAVDecoder_BeginResample64(decoder,
+      data, data_size, output_sampling_rate, mode, num_output_samples);
+}
 
-  /* RIFFチャンクID */
-  ByteArray_PutUint8(data_pos, 'R');
-  ByteArray_PutUint8(data_pos, 'I');
-  ByteArray_PutUint8(data_pos, 'F');
-  ByteArray_PutUint8(data_pos, 'F');
-  /* RIFFチャンクサイズ */
-  ByteArray_PutUint32LE(data_pos, IMAADPCMWAVENCODER_HEADER_SIZE + data_chunk_size - 8);
-  /* WAVEチャンクID */
-  ByteArray_PutUint8(data_pos, 'W');
-  ByteArray_PutUint8(data_pos, 'A');
-  ByteArray_PutUint8(data_pos, 'V');
-  ByteArray_PutUint8(data_pos, 'E');
-  /* FMTチャンクID */
-  ByteArray_PutUint8(data_pos, 'f');
-  ByteArray_PutUint8(data_pos, 'm');
-  ByteArray_PutUint8(data_pos, 't');
-  ByteArray_PutUint8(data_pos, ' ');
-  /* FMTチャンクサイズは20で決め打ち */
-  ByteArray_PutUint32LE(data_pos, 20);
-  /* WAVEフォーマットタイプ: IMA-ADPCM(17)で決め打ち */
-  ByteArray_PutUint16LE(data_pos, 17);
-  /* チャンネル数 */
-  if (header_info->num_channels > IMAADPCM_MAX_NUM_CHANNELS) {
-    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+/* リサンプリングデコードの開始（64bit版） */
+IMAADPCMApiResult IMAADPCMWAVDecoder_BeginResample64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    uint32_t output_sampling_rate, IMAADPCMResampleMode mode, uint32_t *num_output_samples)
+{
+  IMAADPCMApiResult ret;
+  uint32_t num_samples_per_block;
+  uint64_t tmp_num_output_samples;
+  struct IMAADPCMWAVHeaderInfo header;
+  struct IMAADPCMResampleStream *resample;
+
+  /* 引数チェック */
+  if ((decoder == NULL) || (data == NULL) || (num_output_samples == NULL) || (output_sampling_rate == 0)
+      || ((mode != IMAADPCM_RESAMPLE_LINEAR) && (mode != IMAADPCM_RESAMPLE_POLYPHASE))) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
   }
-  ByteArray_PutUint16LE(data_pos, header_info->num_channels);
-  /* サンプリングレート */
-  ByteArray_PutUint32LE(data_pos, header_info->sampling_rate);
-  /* データ速度[byte/sec] */
-  ByteArray_PutUint32LE(data_pos, header_info->bytes_per_sec);
-  /* ブロックサイズ */
-  ByteArray_PutUint16LE(data_pos, header_info->block_size);
-  /* サンプルあたりビット数: 4で決め打ち */
-  if (header_info->bits_per_sample != IMAADPCM_BITS_PER_SAMPLE) {
+  resample = &(decoder->resample);
+
+  /* ヘッダデコード */
+  if ((ret = IMAADPCMWAVDecoder_DecodeHeader64(data, data_size, &header)) != IMAADPCM_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* 対応していないブロック構成・サンプリングレート */
+  if (((num_samples_per_block = IMAADPCMWAVDecoder_CalculateNumSamplesPerBlock(&header)) == 0)
+      || (header.sampling_rate == 0)) {
     return IMAADPCM_APIRESULT_INVALID_FORMAT;
   }
-  ByteArray_PutUint16LE(data_pos, header_info->bits_per_sample);
-  /* fmtチャンクのエキストラサイズ: 2で決め打ち */
-  ByteArray_PutUint16LE(data_pos, 2);
-  /* ブロックあたりサンプル数 */
-  ByteArray_PutUint16LE(data_pos, header_info->num_samples_per_block);
 
-  /* FACTチャンクID */
-  ByteArray_PutUint8(data_pos, 'f');
-  ByteArray_PutUint8(data_pos, 'a');
-  ByteArray_PutUint8(data_pos, 'c');
-  ByteArray_PutUint8(data_pos, 't');
-  /* FACTチャンクのエキストラサイズ: 4で決め打ち */
-  ByteArray_PutUint32LE(data_pos, 4);
-  /* サンプル数 */
-  ByteArray_PutUint32LE(data_pos, header_info->num_samples);
+  /* 全サンプル分のデータがあるか */
+  if ((header.num_samples > 0)
+      && (data_size < IMAADPCMWAVDecoder_CalculateRequiredDataSize(&header, num_samples_per_block, header.num_samples))) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_DATA;
+  }
 
-  /* その他のチャンクは書き出さず、すぐにdataチャンクへ */
+  /* 変換後のサンプル数 入力の末尾より手前の位置に対応する出力の数 */
+  tmp_num_output_samples = ((uint64_t)header.num_samples * output_sampling_rate + header.sampling_rate - 1) / header.sampling_rate;
+  if (tmp_num_output_samples > UINT32_MAX) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  }
 
-  /* dataチャンクID */
-  ByteArray_PutUint8(data_pos, 'd');
-  ByteArray_PutUint8(data_pos, 'a');
-  ByteArray_PutUint8(data_pos, 't');
-  ByteArray_PutUint8(data_pos, 'a');
-  /* データチャンクサイズ */
-  ByteArray_PutUint32LE(data_pos, data_chunk_size);
+  /* 状態の初期化 */
+  resample->mode = mode;
+  resample->data = data;
+  resample->header = header;
+  resample->num_samples_per_block = num_samples_per_block;
+  resample->num_taps = (mode == IMAADPCM_RESAMPLE_LINEAR) ? 2 : IMAADPCM_RESAMPLE_NUM_TAPS;
+  resample->read_progress = 0;
+  resample->block_offset = header.header_size;
+  resample->block_progress = 0;
+  resample->num_output_samples = (uint32_t)tmp_num_output_samples;
+  resample->output_progress = 0;
+  resample->position = 0;
+  resample->position_frac = 0;
+  resample->step_int = header.sampling_rate / output_sampling_rate;
+  resample->step_frac = (uint32_t)(((uint64_t)(header.sampling_rate % output_sampling_rate) << 32) / output_sampling_rate);
+  resample->history_start = 0;
+  resample->history_length = 0;
+
+  /* 間引く場合は出力のナイキスト周波数で帯域制限する */
+  if (mode == IMAADPCM_RESAMPLE_POLYPHASE) {
+    IMAADPCMWAVDecoder_MakeResampleFilter(resample->coef, IMAADPCM_RESAMPLE_CUTOFF
+        * IMAADPCM_MIN_VAL(1.0, (double)output_sampling_rate / header.sampling_rate));
+  }
 
-  /* 成功終了 */
+  resample->started = 1;
+  (*num_output_samples) = resample->num_output_samples;
   return IMAADPCM_APIRESULT_OK;
 }
 
-/* エンコーダワークサイズ計算 */
-int32_t IMAADPCMWAVEncoder_CalculateWorkSize(void)
+/* リサンプリングの入力列からnum_samples個を読み、discardが0ならば履歴の末尾に追加する */
+/* 入力列はデコード結果の先頭に(窓のサンプル数/2 - 1)個、末尾以降に0を詰めたもの 同じブロック内のサンプルはまとめてデコードする */
+static IMAADPCMApiResult IMAADPCMWAVDecoder_ReadResampleInput(
+    struct IMAADPCMResampleStream *resample, uint32_t num_samples, uint8_t discard)
 {
-  return IMAADPCM_ALIGNMENT + sizeof(struct IMAADPCMWAVEncoder);
+  uint8_t reserved;
+  uint32_t smpl, ch, run, nibble_pos, num_lead_samples, word_size, input_pos;
+  int16_t sample;
+  const uint8_t *block_data, *read_pos;
+  const struct IMAADPCMWAVHeaderInfo *header;
+
+  assert(resample != NULL);
+  assert(discard || ((resample->history_length + num_samples) <= IMAADPCM_RESAMPLE_HISTORY_LENGTH));
+
+  header = &(resample->header);
+  num_lead_samples = resample->num_taps / 2 - 1;
+  word_size = 4 * (uint32_t)header->num_channels;
+
+  while (num_samples > 0) {
+    if ((resample->read_progress < num_lead_samples)
+        || ((resample->read_progress - num_lead_samples) >= header->num_samples)) {
+      /* 先頭の詰め物・末尾以降は0 */
+      run = (resample->read_progress < num_lead_samples)
+        ? IMAADPCM_MIN_VAL(num_samples, num_lead_samples - resample->read_progress) : num_samples;
+      if (!discard) {
+        for (ch = 0; ch < header->num_channels; ch++) {
+          memset(&resample->history[ch][resample->history_length], 0, sizeof(int16_t) * run);
+        }
+      }
+    } else if (resample->block_progress == 0) {
+      /* ブロックヘッダデコード 先頭サンプルはヘッダに入っている */
+      run = 1;
+      read_pos = resample->data + resample->block_offset;
+      for (ch = 0; ch < header->num_channels; ch++) {
+        struct IMAADPCMCoreDecoder *core_decoder = &(resample->core_decoder[ch]);
+        ByteArray_GetUint16LE(read_pos, (uint16_t *)&(core_decoder->sample_val));
+        ByteArray_GetUint8(read_pos, (uint8_t *)&(core_decoder->stepsize_index));
+        ByteArray_GetUint8(read_pos, &reserved);
+        if ((reserved != 0) || (core_decoder->stepsize_index < 0) || (core_decoder->stepsize_index > 88)) {
+          return IMAADPCM_APIRESULT_INVALID_FORMAT;
+        }
+        if (!discard) {
+          resample->history[ch][resample->history_length] = core_decoder->sample_val;
+        }
+      }
+    } else {
+      /* ブロック末尾・入力末尾までのサンプルをチャンネル毎にまとめてデコード */
+      input_pos = resample->read_progress - num_lead_samples;
+      run = IMAADPCM_MIN_VAL(num_samples, resample->num_samples_per_block - resample->block_progress);
+      run = IMAADPCM_MIN_VAL(run, header->num_samples - input_pos);
+      block_data = resample->data + resample->block_offset;
+      for (ch = 0; ch < header->num_channels; ch++) {
+        /* 履歴への書き込みと別名にならないよう、状態はオート変数に受ける */
+        struct IMAADPCMCoreDecoder core_decoder = resample->core_decoder[ch];
+        int16_t *history = &resample->history[ch][resample->history_length];
+        nibble_pos = resample->block_progress - 1;
+        for (smpl = 0; smpl < run; smpl++, nibble_pos++) {
+          read_pos = block_data + word_size * (1 + nibble_pos / 8) + 4 * ch + (nibble_pos % 8) / 2;
+          sample = IMAADPCMCoreDecoder_DecodeSample(&core_decoder,
+              (uint8_t)((read_pos[0] >> (4 * (nibble_pos % 2))) & 0xF));
+          if (!discard) {
+            history[smpl] = sample;
+          }
+        }
+        resample->core_decoder[ch] = core_decoder;
+      }
+    }
+
+    /* 進捗更新 ブロックの末尾に達したら次のブロックへ */
+    if ((resample->read_progress >= num_lead_samples)
+        && ((resample->read_progress - num_lead_samples) < header->num_samples)) {
+      resample->block_progress += run;
+      if (resample->block_progress >= resample->num_samples_per_block) {
+        resample->block_progress = 0;
+        resample->block_offset += header->block_size;
+      }
+    }
+    if (!discard) {
+      resample->history_length += run;
+    }
+    resample->read_progress += run;
+    num_samples -= run;
+  }
+
+  return IMAADPCM_APIRESULT_OK;
 }
 
-/* エンコーダハンドル作成 */
-struct IMAADPCMWAVEncoder *IMAADPCMWAVEncoder_Create(void *work, int32_t work_size)
+/* リサンプリングの履歴の更新 */
+/* 次の出力の窓より手前の履歴を捨て、履歴がいっぱいになるまで入力を読み足す */
+static IMAADPCMApiResult IMAADPCMWAVDecoder_RefillResampleHistory(struct IMAADPCMResampleStream *resample)
 {
-  struct IMAADPCMWAVEncoder *encoder;
-  uint8_t *work_ptr;
-  uint32_t alloced_by_malloc = 0;
+  IMAADPCMApiResult ret;
+  uint32_t ch, num_drop_samples;
 
-  /* 領域自前確保の場合 */
-  if ((work == NULL) && (work_size == 0)) {
-    work_size = IMAADPCMWAVEncoder_CalculateWorkSize();
-    work = malloc((uint32_t)work_size);
-    alloced_by_malloc = 1;
+  assert(resample != NULL);
+  assert(resample->position >= resample->history_start);
+
+  num_drop_samples = resample->position - resample->history_start;
+  if (num_drop_samples >= resample->history_length) {
+    /* 窓の先頭が履歴を越えている（大きく間引く）場合は間の入力を読み捨てる */
+    if ((ret = IMAADPCMWAVDecoder_ReadResampleInput(resample,
+            num_drop_samples - resample->history_length, 1)) != IMAADPCM_APIRESULT_OK) {
+      return ret;
+    }
+    resample->history_length = 0;
+  } else {
+    for (ch = 0; ch < resample->header.num_channels; ch++) {
+      memmove(&resample->history[ch][0], &resample->history[ch][num_drop_samples],
+          sizeof(int16_t) * (resample->history_length - num_drop_samples));
+    }
+    resample->history_length -= num_drop_samples;
   }
+  resample->history_start = resample->position;
+
+  return IMAADPCMWAVDecoder_ReadResampleInput(resample,
+      IMAADPCM_RESAMPLE_HISTORY_LENGTH - resample->history_length, 0);
+}
+
+/* リサンプリングデコード */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeResample(
+    struct IMAADPCMWAVDecoder *decoder,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples)
+{
+  IMAADPCMApiResult ret;
+  uint32_t ch, smpl, next_smpl, tap, num_samples;
+  struct IMAADPCMResampleStream *resample;
 
   /* 引数チェック */
-  if ((work == NULL) || (work_size < IMAADPCMWAVEncoder_CalculateWorkSize())) {
-    return NULL;
+  if ((decoder == NULL) || (buffer == NULL) || (num_decode_samples == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
   }
+  resample = &(decoder->resample);
 
-  work_ptr = (uint8_t *)work;
+  /* 開始していない */
+  if (!resample->started) {
+    return IMAADPCM_APIRESULT_NG;
+  }
 
-  /* アラインメントを揃えてから構造体を配置 */
-  work_ptr = (uint8_t *)IMAADPCM_ROUND_UP((uintptr_t)work_ptr, IMAADPCM_ALIGNMENT);
-  encoder = (struct IMAADPCMWAVEncoder *)work_ptr;
+  /* バッファチャンネル数チェック */
+  if (buffer_num_channels < resample->header.num_channels) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+  }
 
-  /* ハンドルの中身を0初期化 */
-  memset(encoder, 0, sizeof(struct IMAADPCMWAVEncoder));
+  /* 末尾で切り詰め */
+  num_samples = IMAADPCM_MIN_VAL(buffer_num_samples, resample->num_output_samples - resample->output_progress);
 
-  /* パラメータは未セット状態に */
-  encoder->set_parameter = 0;
+  ret = IMAADPCM_APIRESULT_OK;
+  smpl = 0;
+  while (smpl < num_samples) {
+    uint32_t position, position_frac, start_position, end_position;
 
-  /* 自前確保の場合はメモリを記憶しておく */
-  encoder->work = alloced_by_malloc ? work : NULL;
+    /* 窓が履歴に収まっていなければ読み足す */
+    if ((resample->position + resample->num_taps) > (resample->history_start + resample->history_length)) {
+      if ((ret = IMAADPCMWAVDecoder_RefillResampleHistory(resample)) != IMAADPCM_APIRESULT_OK) {
+        break;
+      }
+    }
 
-  return encoder;
+    /* 窓が履歴に収まる間はまとめて出力 入力位置は履歴先頭からの相対位置で進める */
+    /* 各チャンネルで同じ位置の列をたどる */
+    start_position = resample->position - resample->history_start;
+    end_position = resample->history_length - resample->num_taps;
+    position = start_position;
+    position_frac = resample->position_frac;
+    next_smpl = smpl;
+    for (ch = 0; ch < resample->header.num_channels; ch++) {
+      const int16_t *history = resample->history[ch];
+      int16_t *output = buffer[ch];
+      uint32_t tmp_smpl = smpl;
+      position = start_position;
+      position_frac = resample->position_frac;
+      if (resample->mode == IMAADPCM_RESAMPLE_LINEAR) {
+        /* 小数部の上位15bitで隣り合う2サンプルを内分 */
+        for (; (tmp_smpl < num_samples) && (position <= end_position); tmp_smpl++) {
+          const int32_t weight = (int32_t)(position_frac >> 17);
+          const int32_t x0 = history[position], x1 = history[position + 1];
+          output[tmp_smpl] = (int16_t)(x0 + (((x1 - x0) * weight + (1 << 14)) >> 15));
+          position_frac += resample->step_frac;
+          position += resample->step_int + ((position_frac < resample->step_frac) ? 1 : 0);
+        }
+      } else {
+        /* 小数部の上位ビットで位相を選び、窓との積和をとる */
+        for (; (tmp_smpl < num_samples) && (position <= end_position); tmp_smpl++) {
+          int32_t acc = 0;
+          const int16_t *x = &history[position];
+          const int16_t *row
+            = &resample->coef[(position_frac >> (32 - IMAADPCM_RESAMPLE_PHASE_BITS)) * IMAADPCM_RESAMPLE_NUM_TAPS];
+          for (tap = 0; tap < IMAADPCM_RESAMPLE_NUM_TAPS; tap++) {
+            acc += row[tap] * x[tap];
+          }
+          acc = (acc + (1 << 14)) >> 15;
+          output[tmp_smpl] = (int16_t)IMAADPCM_INNER_VAL(acc, -32768, 32767);
+          position_frac += resample->step_frac;
+          position += resample->step_int + ((position_frac < resample->step_frac) ? 1 : 0);
+        }
+      }
+      next_smpl = tmp_smpl;
+    }
+    smpl = next_smpl;
+    resample->position = resample->history_start + position;
+    resample->position_frac = position_frac;
+  }
+
+  resample->output_progress += smpl;
+  (*num_decode_samples) = smpl;
+  return ret;
 }
 
-/* エンコーダハンドル破棄 */
-void IMAADPCMWAVEncoder_Destroy(struct IMAADPCMWAVEncoder *encoder)
+/* デコーダバンクワークサイズ計算 */
+int32_t IMAADPCMDecoderBank_CalculateWorkSize(uint32_t max_num_streams)
 {
-  if (encoder != NULL) {
-    /* 自分で領域確保していたら破棄 */
-    if (encoder->work != NULL) {
-      free(encoder->work);
-    }
+  uint32_t num_groups;
+  size_t work_size;
+
+  /* 引数チェック */
+  if ((max_num_streams == 0) || (max_num_streams > IMAADPCM_DECODERBANK_MAX_NUM_STREAMS)) {
+    return -1;
   }
+
+  num_groups = (max_num_streams + IMAADPCM_DECODERBANK_NUM_STREAMS_PER_GROUP - 1) / IMAADPCM_DECODERBANK_NUM_STREAMS_PER_GROUP;
+
+  /* ハンドル + ストリーム状態 + レーン毎の状態 + 空きIDスタック */
+  work_size = IMAADPCM_ALIGNMENT + sizeof(struct IMAADPCMDecoderBank);
+  work_size += IMAADPCM_ALIGNMENT + sizeof(struct IMAADPCMDecoderBankStream) * num_groups * IMAADPCM_DECODERBANK_NUM_STREAMS_PER_GROUP;
+  work_size += 3 * (IMAADPCM_ALIGNMENT + sizeof(int32_t) * num_groups * IMAADPCM_NUM_SIMD_LANES);
+  work_size += IMAADPCM_ALIGNMENT + sizeof(uint32_t) * max_num_streams;
+  assert(work_size <= INT32_MAX);
+
+  return (int32_t)work_size;
 }
 
-/* 1サンプルエンコード */
-static uint8_t IMAADPCMCoreEncoder_EncodeSample(
-    struct IMAADPCMCoreEncoder *encoder, int16_t sample)
+/* デコーダバンクの処理関数の設定 */
+static void IMAADPCMDecoderBank_BindKernel(
+    struct IMAADPCMDecoderBank *bank, IMAADPCMKernel kernel)
 {
-  uint8_t nibble;
-  int8_t idx;
-  int32_t prev, diff, qdiff, delta, stepsize, diffabs, sign;
+  assert(bank != NULL);
+  assert(IMAADPCM_IsKernelAvailable(kernel));
+
+  bank->decode_steps = IMAADPCMDecoderBank_DecodeStepsScalar;
+  switch (kernel) {
+    case IMAADPCM_KERNEL_AUTO:
+      /* 最速のものを選ぶ */
+#if defined(IMAADPCM_USE_X86_SIMD)
+      if (IMAADPCM_GetCPUFeatures() & IMAADPCM_CPU_FEATURE_AVX2) {
+        bank->decode_steps = IMAADPCMDecoderBank_DecodeStepsAVX2;
+      } else if (IMAADPCM_GetCPUFeatures() & IMAADPCM_CPU_FEATURE_SSE41) {
+        bank->decode_steps = IMAADPCMDecoderBank_DecodeStepsSSE41;
+      }
+#endif
+      break;
+#if defined(IMAADPCM_USE_X86_SIMD)
+    case IMAADPCM_KERNEL_SSE41:
+      bank->decode_steps = IMAADPCMDecoderBank_DecodeStepsSSE41;
+      break;
+    case IMAADPCM_KERNEL_AVX2:
+      bank->decode_steps = IMAADPCMDecoderBank_DecodeStepsAVX2;
+      break;
+#endif
+    default:
+      break;
+  }
 
-  assert(encoder != NULL);
-  
-  /* 頻繁に参照する変数をオート変数に受ける */
-  prev = encoder->prev_sample;
-  idx = encoder->stepsize_index;
+  bank->kernel = kernel;
+}
 
-  /* ステップサイズの取得 */
-  stepsize = IMAADPCM_stepsize_table[idx];
+/* デコーダバンク作成 */
+struct IMAADPCMDecoderBank *IMAADPCMDecoderBank_Create(uint32_t max_num_streams, void *work, int32_t work_size)
+{
+  uint32_t i, num_groups;
+  struct IMAADPCMDecoderBank *bank;
+  uint8_t *work_ptr;
+  uint32_t alloced_by_malloc = 0;
 
-  /* 差分 */
-  diff = sample - prev;
-  sign = diff < 0;
-  diffabs = sign ? -diff : diff;
+  /* 引数チェック */
+  if ((max_num_streams == 0) || (max_num_streams > IMAADPCM_DECODERBANK_MAX_NUM_STREAMS)) {
+    return NULL;
+  }
 
-  /* 差分を符号表現に変換 */
-  /* nibble = sign(diff) * round(|diff| * 4 / stepsize) */
-  nibble = (uint8_t)IMAADPCM_MIN_VAL((diffabs << 2) / stepsize, 7);
-  /* nibbleの最上位ビットは符号ビット */
-  if (sign) {
-    nibble |= 0x8;
+  /* 領域自前確保の場合 */
+  if ((work == NULL) && (work_size == 0)) {
+    work_size = IMAADPCMDecoderBank_CalculateWorkSize(max_num_streams);
+    work = malloc((uint32_t)work_size);
+    alloced_by_malloc = 1;
   }
 
-  /* 量子化した差分を計算 */
-  delta = nibble & 7;
-  qdiff = (stepsize * ((delta << 1) + 1)) >> 3;
+  /* 引数チェック */
+  if ((work == NULL) || (work_size < IMAADPCMDecoderBank_CalculateWorkSize(max_num_streams))) {
+    if (alloced_by_malloc) {
+      free(work);
+    }
+    return NULL;
+  }
+
+  num_groups = (max_num_streams + IMAADPCM_DECODERBANK_NUM_STREAMS_PER_GROUP - 1) / IMAADPCM_DECODERBANK_NUM_STREAMS_PER_GROUP;
+
+  /* 構造体・配列をアラインメントを揃えて配置 */
+  work_ptr = (uint8_t *)IMAADPCM_ROUND_UP((uintptr_t)work, IMAADPCM_ALIGNMENT);
+  bank = (struct IMAADPCMDecoderBank *)work_ptr;
+  memset(bank, 0, sizeof(struct IMAADPCMDecoderBank));
+  work_ptr += sizeof(struct IMAADPCMDecoderBank);
+
+  work_ptr = (uint8_t *)IMAADPCM_ROUND_UP((uintptr_t)work_ptr, IMAADPCM_ALIGNMENT);
+  bank->streams = (struct IMAADPCMDecoderBankStream *)work_ptr;
+  memset(bank->streams, 0, sizeof(struct IMAADPCMDecoderBankStream) * num_groups * IMAADPCM_DECODERBANK_NUM_STREAMS_PER_GROUP);
+  work_ptr += sizeof(struct IMAADPCMDecoderBankStream) * num_groups * IMAADPCM_DECODERBANK_NUM_STREAMS_PER_GROUP;
 
-  /* ここで量子化誤差が出る */
-  /* printf("%d \n", sign ? (-qdiff - diff) : (qdiff - diff)); */
+  work_ptr = (uint8_t *)IMAADPCM_ROUND_UP((uintptr_t)work_ptr, IMAADPCM_ALIGNMENT);
+  bank->predict = (int32_t *)work_ptr;
+  work_ptr += sizeof(int32_t) * num_groups * IMAADPCM_NUM_SIMD_LANES;
+  work_ptr = (uint8_t *)IMAADPCM_ROUND_UP((uintptr_t)work_ptr, IMAADPCM_ALIGNMENT);
+  bank->index = (int32_t *)work_ptr;
+  work_ptr += sizeof(int32_t) * num_groups * IMAADPCM_NUM_SIMD_LANES;
+  work_ptr = (uint8_t *)IMAADPCM_ROUND_UP((uintptr_t)work_ptr, IMAADPCM_ALIGNMENT);
+  bank->codes = (uint32_t *)work_ptr;
+  work_ptr += sizeof(uint32_t) * num_groups * IMAADPCM_NUM_SIMD_LANES;
+  memset(bank->predict, 0, sizeof(int32_t) * num_groups * IMAADPCM_NUM_SIMD_LANES);
+  memset(bank->index, 0, sizeof(int32_t) * num_groups * IMAADPCM_NUM_SIMD_LANES);
+  memset(bank->codes, 0, sizeof(uint32_t) * num_groups * IMAADPCM_NUM_SIMD_LANES);
 
-  /* 量子化した差分を加える */
-  if (sign) {
-    prev -= qdiff;
-  } else {
-    prev += qdiff;
+  work_ptr = (uint8_t *)IMAADPCM_ROUND_UP((uintptr_t)work_ptr, IMAADPCM_ALIGNMENT);
+  bank->free_ids = (uint32_t *)work_ptr;
+  work_ptr += sizeof(uint32_t) * max_num_streams;
+  assert((work_ptr - (uint8_t *)work) <= work_size);
+
+  /* 小さいIDから使われるように積む（使用中のレーングループを詰めておくため） */
+  for (i = 0; i < max_num_streams; i++) {
+    bank->free_ids[i] = max_num_streams - 1 - i;
   }
-  prev = IMAADPCM_INNER_VAL(prev, -32768, 32767);
+  bank->num_free_ids = max_num_streams;
+  bank->max_num_streams = max_num_streams;
+  bank->num_groups = num_groups;
 
-  /* インデックス更新 */
-  idx = (int8_t)(idx + IMAADPCM_index_table[nibble]);
-  idx = IMAADPCM_INNER_VAL(idx, 0, 88);
+  /* 実行中のCPUに合わせたカーネルを設定 */
+  IMAADPCMDecoderBank_BindKernel(bank, IMAADPCM_GetDefaultKernel());
 
-  /* 計算結果の反映 */
-  encoder->prev_sample = (int16_t)prev;
-  encoder->stepsize_index = idx;
+  /* 自前確保の場合はメモリを記憶しておく */
+  bank->work = alloced_by_malloc ? work : NULL;
 
-  return nibble;
+  return bank;
 }
 
-/* モノラルブロックのエンコード */
-static IMAADPCMError IMAADPCMWAVEncoder_EncodeBlockMono(
-    struct IMAADPCMCoreEncoder *core_encoder,
-    const int16_t *const *input, uint32_t num_samples,
-    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+/* デコーダバンク破棄 */
+void IMAADPCMDecoderBank_Destroy(struct IMAADPCMDecoderBank *bank)
 {
-  uint8_t u8buf;
-  uint8_t nibble[2];
-  uint32_t smpl;
-  uint8_t *data_pos = data;
+  if (bank != NULL) {
+    /* 自分で領域確保していたら破棄 */
+    if (bank->work != NULL) {
+      free(bank->work);
+    }
+  }
+}
 
+/* デコーダバンクで使用するカーネルの設定 */
+IMAADPCMApiResult IMAADPCMDecoderBank_SetKernel(
+    struct IMAADPCMDecoderBank *bank, IMAADPCMKernel kernel)
+{
   /* 引数チェック */
-  if ((core_encoder == NULL) || (input == NULL)
-      || (data == NULL) || (output_size == NULL)) {
-    return IMAADPCM_ERROR_INVALID_ARGUMENT;
+  if (bank == NULL) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
   }
 
-  /* 十分なデータサイズがあるか確認 */
-  if (data_size < (num_samples / 2 + 4)) {
-    return IMAADPCM_ERROR_INSUFFICIENT_DATA;
+  /* 実行中のCPUで使えないカーネルは設定できない */
+  if (!IMAADPCM_IsKernelAvailable(kernel)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
   }
 
-  /* 先頭サンプルをエンコーダにセット */
-  core_encoder->prev_sample = input[0][0];
-
-  /* ブロックヘッダエンコード */
-  ByteArray_PutUint16LE(data_pos, core_encoder->prev_sample);
-  ByteArray_PutUint8(data_pos, core_encoder->stepsize_index);
-  ByteArray_PutUint8(data_pos, 0); /* reserved */
-
-  /* ブロックデータエンコード */
-  for (smpl = 1; smpl < num_samples; smpl += 2) {
-    assert((uint32_t)(data_pos - data) < data_size);
-    nibble[0] = IMAADPCMCoreEncoder_EncodeSample(core_encoder, input[0][smpl + 0]);
-    nibble[1] = IMAADPCMCoreEncoder_EncodeSample(core_encoder, input[0][smpl + 1]);
-    assert((nibble[0] <= 0xF) && (nibble[1] <= 0xF));
-    u8buf = (uint8_t)((nibble[0] << 0) | (nibble[1] << 4));
-    ByteArray_PutUint8(data_pos, u8buf);
-  }
+  IMAADPCMDecoderBank_BindKernel(bank, kernel);
 
-  /* 書き出しサイズをセット */
-  (*output_size) = (uint32_t)(data_pos - data);
-  return IMAADPCM_ERROR_OK;
+  return IMAADPCM_APIRESULT_OK;
 }
 
-/* ステレオブロックのエンコード */
-static IMAADPCMError IMAADPCMWAVEncoder_EncodeBlockStereo(
-    struct IMAADPCMCoreEncoder *core_encoder,
-    const int16_t *const *input, uint32_t num_samples,
-    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+/* デコーダバンクにストリームを追加 */
+IMAADPCMApiResult IMAADPCMDecoderBank_AddStream(
+    struct IMAADPCMDecoderBank *bank, const uint8_t *data, uint32_t data_size, uint32_t *stream_id)
 {
-  uint32_t u32buf;
-  uint8_t nibble[8];
-  uint32_t ch, smpl;
-  uint8_t *data_pos = data;
+  IMAADPCMApiResult ret;
+  uint32_t id, num_samples_per_block, num_blocks, remain_size, num_available_samples;
+  struct IMAADPCMWAVHeaderInfo header;
+  struct IMAADPCMDecoderBankStream *stream;
 
   /* 引数チェック */
-  if ((core_encoder == NULL) || (input == NULL)
-      || (data == NULL) || (output_size == NULL)) {
-    return IMAADPCM_ERROR_INVALID_ARGUMENT;
+  if ((bank == NULL) || (data == NULL) || (stream_id == NULL)) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
   }
 
-  /* 十分なデータサイズがあるか確認 */
-  if (data_size < (num_samples + 4)) {
-    return IMAADPCM_ERROR_INSUFFICIENT_DATA;
+  /* ヘッダデコード */
+  if ((ret = IMAADPCMWAVDecoder_DecodeHeader(data, data_size, &header)) != IMAADPCM_APIRESULT_OK) {
+    return ret;
   }
 
-  /* 先頭サンプルをエンコーダにセット */
-  for (ch = 0; ch < 2; ch++) {
-    core_encoder[ch].prev_sample = input[ch][0];
+  /* 対応していないブロック構成 */
+  if ((num_samples_per_block = IMAADPCMWAVDecoder_CalculateNumSamplesPerBlock(&header)) == 0) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
   }
 
-  /* ブロックヘッダエンコード */
-  for (ch = 0; ch < 2; ch++) {
-    ByteArray_PutUint16LE(data_pos, core_encoder[ch].prev_sample);
-    ByteArray_PutUint8(data_pos, core_encoder[ch].stepsize_index);
-    ByteArray_PutUint8(data_pos, 0); /* reserved */
+  /* 1ストリームに割り当てるレーン数を超えるチャンネル数 */
+  if (header.num_channels > IMAADPCM_DECODERBANK_MAX_NUM_CHANNELS) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
   }
 
-  /* ブロックデータエンコード */
-  for (smpl = 1; smpl < num_samples; smpl += 8) {
-    for (ch = 0; ch < 2; ch++) {
-      assert((uint32_t)(data_pos - data) < data_size);
-      nibble[0] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), input[ch][smpl + 0]);
-      nibble[1] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), input[ch][smpl + 1]);
-      nibble[2] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), input[ch][smpl + 2]);
-      nibble[3] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), input[ch][smpl + 3]);
-      nibble[4] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), input[ch][smpl + 4]);
-      nibble[5] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), input[ch][smpl + 5]);
-      nibble[6] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), input[ch][smpl + 6]);
-      nibble[7] = IMAADPCMCoreEncoder_EncodeSample(&(core_encoder[ch]), input[ch][smpl + 7]);
-      assert((nibble[0] <= 0xF) && (nibble[1] <= 0xF) && (nibble[2] <= 0xF) && (nibble[3] <= 0xF)
-          && (nibble[4] <= 0xF) && (nibble[5] <= 0xF) && (nibble[6] <= 0xF) && (nibble[7] <= 0xF));
-      u32buf  = (uint32_t)(nibble[0] <<  0);
-      u32buf |= (uint32_t)(nibble[1] <<  4);
-      u32buf |= (uint32_t)(nibble[2] <<  8);
-      u32buf |= (uint32_t)(nibble[3] << 12);
-      u32buf |= (uint32_t)(nibble[4] << 16);
-      u32buf |= (uint32_t)(nibble[5] << 20);
-      u32buf |= (uint32_t)(nibble[6] << 24);
-      u32buf |= (uint32_t)(nibble[7] << 28);
-      ByteArray_PutUint32LE(data_pos, u32buf);
+  /* 空きが無い */
+  if (bank->num_free_ids == 0) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
+  }
+
+  /* データに含まれるサンプル数 途切れたブロックはワード単位で読める分まで（DecodeWholeと同じ） */
+  num_available_samples = 0;
+  if (data_size > header.header_size) {
+    num_blocks = (data_size - header.header_size) / header.block_size;
+    remain_size = (data_size - header.header_size) % header.block_size;
+    num_available_samples = num_blocks * num_samples_per_block;
+    if (remain_size >= (4 * (uint32_t)header.num_channels)) {
+      remain_size -= 4 * (uint32_t)header.num_channels;
+      num_available_samples += 1
+        + ((header.num_channels == 1) ? (remain_size * 2) : ((remain_size / (4 * (uint32_t)header.num_channels)) * 8));
     }
   }
 
-  /* 書き出しサイズをセット */
-  (*output_size) = (uint32_t)(data_pos - data);
-  return IMAADPCM_ERROR_OK;
+  /* ストリーム状態の初期化 */
+  id = bank->free_ids[--bank->num_free_ids];
+  stream = &(bank->streams[id]);
+  stream->data = data;
+  stream->data_size = data_size;
+  stream->block_offset = header.header_size;
+  stream->block_progress = 0;
+  stream->num_remain_samples = IMAADPCM_MIN_VAL(header.num_samples, num_available_samples);
+  stream->num_samples_per_block = num_samples_per_block;
+  stream->num_channels = header.num_channels;
+  stream->block_size = header.block_size;
+  stream->active = 1;
+  stream->broken = 0;
+
+  (*stream_id) = id;
+  return IMAADPCM_APIRESULT_OK;
 }
 
-/* 単一データブロックエンコード */
-static IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeBlock(
-    struct IMAADPCMWAVEncoder *encoder,
-    const int16_t *const *input, uint32_t num_samples, 
-    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+/* デコーダバンクからストリームを削除 */
+IMAADPCMApiResult IMAADPCMDecoderBank_RemoveStream(struct IMAADPCMDecoderBank *bank, uint32_t stream_id)
 {
-  IMAADPCMError err;
-  const struct IMAADPCMWAVEncodeParameter *enc_param;
-
   /* 引数チェック */
-  if ((encoder == NULL) || (data == NULL)
-      || (input == NULL) || (output_size == NULL)) {
+  if ((bank == NULL) || (stream_id >= bank->max_num_streams) || !bank->streams[stream_id].active) {
     return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
   }
-  enc_param = &(encoder->encode_paramemter);
-
-  /* ブロックデコード */
-  switch (enc_param->num_channels) {
-    case 1:
-      err = IMAADPCMWAVEncoder_EncodeBlockMono(encoder->core_encoder, 
-          input, num_samples, data, data_size, output_size);
-      break;
-    case 2:
-      err = IMAADPCMWAVEncoder_EncodeBlockStereo(encoder->core_encoder, 
-          input, num_samples, data, data_size, output_size);
-      break;
-    default:
-      return IMAADPCM_APIRESULT_INVALID_FORMAT;
-  }
 
-  /* デコード時のエラーハンドル */
-  if (err != IMAADPCM_ERROR_OK) {
-    switch (err) {
-      case IMAADPCM_ERROR_INVALID_ARGUMENT:
-        return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
-      case IMAADPCM_ERROR_INVALID_FORMAT:
-        return IMAADPCM_APIRESULT_INVALID_FORMAT;
-      case IMAADPCM_ERROR_INSUFFICIENT_BUFFER:
-        return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
-      default:
-        return IMAADPCM_APIRESULT_NG;
-    }
-  }
+  bank->streams[stream_id].active = 0;
+  bank->free_ids[bank->num_free_ids++] = stream_id;
+  assert(bank->num_free_ids <= bank->max_num_streams);
 
   return IMAADPCM_APIRESULT_OK;
 }
 
-/* エンコードパラメータをヘッダに変換 */
-static IMAADPCMError IMAADPCMWAVEncoder_ConvertParameterToHeader(
-    const struct IMAADPCMWAVEncodeParameter *enc_param, uint32_t num_samples,
-    struct IMAADPCMWAVHeaderInfo *header_info)
+/* デコーダバンクのストリームの残りサンプル数の取得 */
+IMAADPCMApiResult IMAADPCMDecoderBank_GetNumRemainSamples(
+    const struct IMAADPCMDecoderBank *bank, uint32_t stream_id, uint32_t *num_remain_samples)
 {
-  uint32_t block_data_size;
-  struct IMAADPCMWAVHeaderInfo tmp_header = {0, };
-
   /* 引数チェック */
-  if ((enc_param == NULL) || (header_info == NULL)) {
-    return IMAADPCM_ERROR_INVALID_ARGUMENT;
+  if ((bank == NULL) || (num_remain_samples == NULL)
+      || (stream_id >= bank->max_num_streams) || !bank->streams[stream_id].active) {
+    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
   }
 
-  /* サンプルあたりビット数は4固定 */
-  if (enc_param->bits_per_sample != IMAADPCM_BITS_PER_SAMPLE) {
-    return IMAADPCM_ERROR_INVALID_FORMAT;
+  (*num_remain_samples) = bank->streams[stream_id].num_remain_samples;
+
+  /* 不正なデータで停止していた */
+  if (bank->streams[stream_id].broken) {
+    return IMAADPCM_APIRESULT_INVALID_FORMAT;
   }
 
-  /* ヘッダサイズは決め打ち */
-  tmp_header.header_size = IMAADPCMWAVENCODER_HEADER_SIZE;
-  /* 総サンプル数 */
-  tmp_header.num_samples = num_samples;
+  return IMAADPCM_APIRESULT_OK;
+}
 
-  /* そのままヘッダに入れられるメンバ */
-  tmp_header.num_channels = enc_param->num_channels;
-  tmp_header.sampling_rate = enc_param->sampling_rate;
-  tmp_header.bits_per_sample = enc_param->bits_per_sample;
-  tmp_header.block_size = enc_param->block_size;
+/* デコーダバンクのレーングループ処理（スカラ） */
+/* レーン毎の依存連鎖は独立なので、レーンを内側のループにして連鎖を重ねて実行させる */
+static void IMAADPCMDecoderBank_DecodeStepsScalar(
+    const struct IMAADPCMDecoderBankSteps *steps, uint32_t num_steps,
+    int32_t *predict, int32_t *index, int16_t *output, uint32_t output_stride)
+{
+  uint32_t step, lane;
+
+  assert((steps != NULL) && (predict != NULL) && (index != NULL) && (output != NULL));
+
+  for (step = 0; step < num_steps; step++) {
+    for (lane = 0; lane < IMAADPCM_NUM_SIMD_LANES; lane++) {
+      const int32_t nibble = steps->nibble[step][lane];
+      if (nibble >= IMAADPCM_DECODERBANK_RESET_NIBBLE) {
+        predict[lane] = steps->reset_sample[step][lane];
+        index[lane] = steps->reset_index[step][lane];
+      } else {
+        const int32_t transition = IMAADPCM_transition_table[index[lane]][nibble];
+        predict[lane] = IMAADPCM_INNER_VAL(predict[lane] + (transition >> 8), -32768, 32767);
+        index[lane] = transition & 0xFF;
+      }
+      output[step * output_stride + lane] = (int16_t)predict[lane];
+    }
+  }
+}
 
-  /* 計算が必要なメンバ */
-  if (enc_param->block_size <= enc_param->num_channels * 4) {
-    /* データを入れる領域がない */
-    return IMAADPCM_ERROR_INVALID_FORMAT;
+#if defined(IMAADPCM_USE_X86_SIMD)
+/* デコーダバンクのレーングループ処理（SSE4.1） */
+__attribute__((target("sse4.1")))
+static void IMAADPCMDecoderBank_DecodeStepsSSE41(
+    const struct IMAADPCMDecoderBankSteps *steps, uint32_t num_steps,
+    int32_t *predict, int32_t *index, int16_t *output, uint32_t output_stride)
+{
+  uint32_t step, half;
+  __m128i vpredict[2], vindex[2];
+  const __m128i nibble_mask = _mm_set1_epi32(0xF);
+  const __m128i index_mask = _mm_set1_epi32(0xFF);
+  const __m128i reset_threshold = _mm_set1_epi32(IMAADPCM_DECODERBANK_RESET_NIBBLE - 1);
+  const __m128i min_sample = _mm_set1_epi32(-32768);
+  const __m128i max_sample = _mm_set1_epi32(32767);
+
+  assert((steps != NULL) && (predict != NULL) && (index != NULL) && (output != NULL));
+
+  vpredict[0] = _mm_loadu_si128((const __m128i *)&predict[0]);
+  vpredict[1] = _mm_loadu_si128((const __m128i *)&predict[4]);
+  vindex[0] = _mm_loadu_si128((const __m128i *)&index[0]);
+  vindex[1] = _mm_loadu_si128((const __m128i *)&index[4]);
+
+  for (step = 0; step < num_steps; step++) {
+    for (half = 0; half < 2; half++) {
+      int32_t idx[4], nib[4], packed;
+      __m128i nibble, reset, transition;
+      memcpy(&packed, &steps->nibble[step][4 * half], sizeof(int32_t));
+      nibble = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed));
+      reset = _mm_cmpgt_epi32(nibble, reset_threshold);
+      /* 状態遷移テーブルから差分と次のインデックスを取得 */
+      _mm_storeu_si128((__m128i *)idx, vindex[half]);
+      _mm_storeu_si128((__m128i *)nib, _mm_and_si128(nibble, nibble_mask));
+      transition = _mm_setr_epi32(
+          IMAADPCM_transition_table[idx[0]][nib[0]], IMAADPCM_transition_table[idx[1]][nib[1]],
+          IMAADPCM_transition_table[idx[2]][nib[2]], IMAADPCM_transition_table[idx[3]][nib[3]]);
+      /* 差分を加えて16bit幅にクリップ */
+      vpredict[half] = _mm_add_epi32(vpredict[half], _mm_srai_epi32(transition, 8));
+      vpredict[half] = _mm_min_epi32(_mm_max_epi32(vpredict[half], min_sample), max_sample);
+      vindex[half] = _mm_and_si128(transition, index_mask);
+      /* リセットするレーンは指定の状態に置き換え */
+      vpredict[half] = _mm_blendv_epi8(vpredict[half],
+          _mm_loadu_si128((const __m128i *)&steps->reset_sample[step][4 * half]), reset);
+      vindex[half] = _mm_blendv_epi8(vindex[half],
+          _mm_loadu_si128((const __m128i *)&steps->reset_index[step][4 * half]), reset);
+    }
+    _mm_storeu_si128((__m128i *)&output[step * output_stride], _mm_packs_epi32(vpredict[0], vpredict[1]));
   }
-  /* 4はチャンネルあたりのヘッダ領域サイズ */
-  assert(enc_param->block_size >= (enc_param->num_channels * 4));
-  block_data_size = (uint32_t)(enc_param->block_size - (enc_param->num_channels * 4));
-  assert((block_data_size * 8) % (uint32_t)(enc_param->bits_per_sample * enc_param->num_channels) == 0);
-  assert((enc_param->bits_per_sample * enc_param->num_channels) != 0);
-  tmp_header.num_samples_per_block = (uint16_t)((block_data_size * 8) / (uint32_t)(enc_param->bits_per_sample * enc_param->num_channels));
-  /* ヘッダに入っている分+1 */
-  tmp_header.num_samples_per_block++;
-  assert(tmp_header.num_samples_per_block != 0);
-  tmp_header.bytes_per_sec = (enc_param->block_size * enc_param->sampling_rate) / tmp_header.num_samples_per_block;
 
-  /* 成功終了 */
-  (*header_info) = tmp_header;
+  _mm_storeu_si128((__m128i *)&predict[0], vpredict[0]);
+  _mm_storeu_si128((__m128i *)&predict[4], vpredict[1]);
+  _mm_storeu_si128((__m128i *)&index[0], vindex[0]);
+  _mm_storeu_si128((__m128i *)&index[4], vindex[1]);
+}
 
-  return IMAADPCM_ERROR_OK;
+/* デコーダバンクのレーングループ処理（AVX2） */
+__attribute__((target("avx2")))
+static void IMAADPCMDecoderBank_DecodeStepsAVX2(
+    const struct IMAADPCMDecoderBankSteps *steps, uint32_t num_steps,
+    int32_t *predict, int32_t *index, int16_t *output, uint32_t output_stride)
+{
+  uint32_t step;
+  __m256i vpredict, vindex;
+  const __m256i nibble_mask = _mm256_set1_epi32(0xF);
+  const __m256i index_mask = _mm256_set1_epi32(0xFF);
+  const __m256i reset_threshold = _mm256_set1_epi32(IMAADPCM_DECODERBANK_RESET_NIBBLE - 1);
+  const __m256i min_sample = _mm256_set1_epi32(-32768);
+  const __m256i max_sample = _mm256_set1_epi32(32767);
+
+  assert((steps != NULL) && (predict != NULL) && (index != NULL) && (output != NULL));
+
+  vpredict = _mm256_loadu_si256((const __m256i *)predict);
+  vindex = _mm256_loadu_si256((const __m256i *)index);
+
+  for (step = 0; step < num_steps; step++) {
+    __m256i nibble, reset, transition;
+    nibble = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)steps->nibble[step]));
+    reset = _mm256_cmpgt_epi32(nibble, reset_threshold);
+    /* 状態遷移テーブルから差分と次のインデックスを取得 */
+    transition = _mm256_i32gather_epi32((const int *)IMAADPCM_transition_table,
+        _mm256_add_epi32(_mm256_slli_epi32(vindex, 4), _mm256_and_si256(nibble, nibble_mask)), 4);
+    /* 差分を加えて16bit幅にクリップ */
+    vpredict = _mm256_add_epi32(vpredict, _mm256_srai_epi32(transition, 8));
+    vpredict = _mm256_min_epi32(_mm256_max_epi32(vpredict, min_sample), max_sample);
+    vindex = _mm256_and_si256(transition, index_mask);
+    /* リセットするレーンは指定の状態に置き換え */
+    vpredict = _mm256_blendv_epi8(vpredict, _mm256_loadu_si256((const __m256i *)steps->reset_sample[step]), reset);
+    vindex = _mm256_blendv_epi8(vindex, _mm256_loadu_si256((const __m256i *)steps->reset_index[step]), reset);
+    _mm_storeu_si128((__m128i *)&output[step * output_stride],
+        _mm_packs_epi32(_mm256_castsi256_si128(vpredict), _mm256_extracti128_si256(vpredict, 1)));
+  }
+
+  _mm256_storeu_si256((__m256i *)predict, vpredict);
+  _mm256_storeu_si256((__m256i *)index, vindex);
 }
+#endif /* IMAADPCM_USE_X86_SIMD */
 
-/* エンコードパラメータの設定 */
-IMAADPCMApiResult IMAADPCMWAVEncoder_SetEncodeParameter(
-    struct IMAADPCMWAVEncoder *encoder, const struct IMAADPCMWAVEncodeParameter *parameter)
+/* デコーダバンクのストリームから次のワードを読み込む（ファイル末尾を越える分は0） */
+static uint32_t IMAADPCMDecoderBank_ReadWord(const struct IMAADPCMDecoderBankStream *stream, uint32_t offset)
 {
-  struct IMAADPCMWAVHeaderInfo tmp_header = {0, };
+  uint32_t i, word;
 
-  /* 引数チェック */
-  if ((encoder == NULL) || (parameter == NULL)) {
-    return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
+  assert(stream != NULL);
+
+  if ((offset + 4) <= stream->data_size) {
+    return ByteArray_ReadUint32LE(&stream->data[offset]);
   }
 
-  /* パラメータ設定がおかしくないか、ヘッダへの変換を通じて確認 */
-  /* 総サンプル数はダミー値を入れる */
-  if (IMAADPCMWAVEncoder_ConvertParameterToHeader(parameter, 0, &tmp_header) != IMAADPCM_ERROR_OK) {
-    return IMAADPCM_APIRESULT_INVALID_FORMAT;
+  /* モノラルのブロック末尾のワードはファイル末尾で途切れうる */
+  word = 0;
+  for (i = 0; (offset + i) < stream->data_size; i++) {
+    word |= (uint32_t)stream->data[offset + i] << (8 * i);
   }
+  return word;
+}
 
-  /* パラメータ設定 */
-  encoder->encode_paramemter = (*parameter);
+/* デコーダバンクのレーングループの入力列作成 */
+/* グループ内の各ストリームをnum_steps進め、ニブルとリセットを並べる */
+/* デコードしないレーンは状態(0, 0)にリセットしてからニブル0を与え続ける（状態が(0, 0)のまま無音を出力する） */
+static void IMAADPCMDecoderBank_FillSteps(
+    struct IMAADPCMDecoderBank *bank, uint32_t group, uint32_t num_steps, struct IMAADPCMDecoderBankSteps *steps)
+{
+  uint32_t i, ch, smp, step, lane, run, nibble_pos;
+  struct IMAADPCMDecoderBankStream *stream;
+
+  assert((bank != NULL) && (steps != NULL));
+  assert(num_steps <= IMAADPCM_DECODERBANK_NUM_STEPS);
+
+  for (i = 0; i < IMAADPCM_DECODERBANK_NUM_STREAMS_PER_GROUP; i++) {
+    const uint32_t lane_offset = i * IMAADPCM_DECODERBANK_MAX_NUM_CHANNELS;
+    stream = &(bank->streams[group * IMAADPCM_DECODERBANK_NUM_STREAMS_PER_GROUP + i]);
+
+    step = 0;
+    while (step < num_steps) {
+      /* 空き・終端に達したストリームは無音 */
+      if (!stream->active || (stream->num_remain_samples == 0)) {
+        for (ch = 0; ch < IMAADPCM_DECODERBANK_MAX_NUM_CHANNELS; ch++) {
+          steps->nibble[step][lane_offset + ch] = IMAADPCM_DECODERBANK_RESET_NIBBLE;
+          steps->reset_sample[step][lane_offset + ch] = 0;
+          steps->reset_index[step][lane_offset + ch] = 0;
+          for (smp = step + 1; smp < num_steps; smp++) {
+            steps->nibble[smp][lane_offset + ch] = 0;
+          }
+        }
+        break;
+      }
 
-  /* パラメータ設定済みフラグを立てる */
-  encoder->set_parameter = 1;
+      /* ブロック先頭ではヘッダの値でリセット */
+      if (stream->block_progress == 0) {
+        const uint8_t *block_header = &stream->data[stream->block_offset];
+        for (ch = 0; ch < IMAADPCM_DECODERBANK_MAX_NUM_CHANNELS; ch++) {
+          steps->nibble[step][lane_offset + ch] = IMAADPCM_DECODERBANK_RESET_NIBBLE;
+          steps->reset_sample[step][lane_offset + ch] = 0;
+          steps->reset_index[step][lane_offset + ch] = 0;
+        }
+        for (ch = 0; ch < stream->num_channels; ch++) {
+          if ((block_header[4 * ch + 2] > 88) || (block_header[4 * ch + 3] != 0)) {
+            /* 不正なヘッダのストリームは停止 */
+            stream->broken = 1;
+            stream->num_remain_samples = 0;
+            break;
+          }
+          steps->reset_sample[step][lane_offset + ch] = (int16_t)ByteArray_ReadUint16LE(&block_header[4 * ch]);
+          steps->reset_index[step][lane_offset + ch] = block_header[4 * ch + 2];
+        }
+        if (stream->broken) {
+          continue;
+        }
+        stream->num_remain_samples--;
+        stream->block_progress = 1;
+        step++;
+      } else {
+        /* ブロック末尾・終端・入力列末尾までのニブルを並べる */
+        run = IMAADPCM_MIN_VAL(num_steps - step, stream->num_remain_samples);
+        run = IMAADPCM_MIN_VAL(run, stream->num_samples_per_block - stream->block_progress);
+        nibble_pos = stream->block_progress - 1;
+        for (ch = 0; ch < stream->num_channels; ch++) {
+          /* ワード（チャンネル毎に8サンプル）単位で読み込み、下位ニブルから取り出す */
+          uint32_t codes;
+          lane = group * IMAADPCM_NUM_SIMD_LANES + lane_offset + ch;
+          codes = bank->codes[lane];
+          for (smp = 0; smp < run; smp++) {
+            if (((nibble_pos + smp) % 8) == 0) {
+              codes = IMAADPCMDecoderBank_ReadWord(stream, stream->block_offset
+                  + 4 * (uint32_t)stream->num_channels * (1 + (nibble_pos + smp) / 8) + 4 * ch);
+            }
+            steps->nibble[step + smp][lane_offset + ch] = (uint8_t)(codes & 0xF);
+            codes >>= 4;
+          }
+          bank->codes[lane] = codes;
+        }
+        /* モノラルの2チャンネル目はブロック先頭で(0, 0)にリセット済み */
+        for (ch = stream->num_channels; ch < IMAADPCM_DECODERBANK_MAX_NUM_CHANNELS; ch++) {
+          for (smp = 0; smp < run; smp++) {
+            steps->nibble[step + smp][lane_offset + ch] = 0;
+          }
+        }
+        stream->num_remain_samples -= run;
+        stream->block_progress += run;
+        step += run;
+      }
 
-  return IMAADPCM_APIRESULT_OK;
+      /* 次のブロックへ */
+      if (stream->block_progress == stream->num_samples_per_block) {
+        stream->block_offset += stream->block_size;
+        stream->block_progress = 0;
+      }
+    }
+  }
 }
 
-/* ヘッダ含めファイル全体をエンコード */
-IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWhole(
-    struct IMAADPCMWAVEncoder *encoder,
-    const int16_t *const *input, uint32_t num_samples,
-    uint8_t *data, uint32_t data_size, uint32_t *output_size)
+/* デコーダバンクの全ストリームのデコード */
+IMAADPCMApiResult IMAADPCMDecoderBank_Decode(
+    struct IMAADPCMDecoderBank *bank, int16_t *output, uint32_t output_size, uint32_t num_frames)
 {
-  IMAADPCMApiResult ret;
-  uint32_t progress, ch, write_size, write_offset, num_encode_samples;
-  uint8_t *data_pos;
-  const int16_t *input_ptr[IMAADPCM_MAX_NUM_CHANNELS];
-  struct IMAADPCMWAVHeaderInfo header = { 0, };
+  uint32_t i, group, frame, num_steps, output_stride, num_group_lanes;
+  uint8_t group_active;
+  struct IMAADPCMDecoderBankSteps steps;
+  int16_t tail_output[IMAADPCM_DECODERBANK_NUM_STEPS][IMAADPCM_NUM_SIMD_LANES];
 
   /* 引数チェック */
-  if ((encoder == NULL) || (input == NULL)
-      || (data == NULL) || (output_size == NULL)) {
+  if ((bank == NULL) || (output == NULL)) {
     return IMAADPCM_APIRESULT_INVALID_ARGUMENT;
   }
 
-  /* パラメータ未セットではエンコードできない */
-  if (encoder->set_parameter == 0) {
-    return IMAADPCM_APIRESULT_PARAMETER_NOT_SET;
-  }
-
-  /* 書き出し位置を取得 */
-  data_pos = data;
-
-  /* エンコードパラメータをヘッダに変換 */
-  if (IMAADPCMWAVEncoder_ConvertParameterToHeader(&(encoder->encode_paramemter), num_samples, &header) != IMAADPCM_ERROR_OK) {
-    return IMAADPCM_APIRESULT_INVALID_FORMAT;
-  }
-
-  /* ヘッダエンコード */
-  if ((ret = IMAADPCMWAVEncoder_EncodeHeader(&header, data_pos, data_size)) != IMAADPCM_APIRESULT_OK) {
-    return ret;
+  /* バッファサイズチェック */
+  output_stride = bank->max_num_streams * IMAADPCM_DECODERBANK_MAX_NUM_CHANNELS;
+  if ((output_size / output_stride) < num_frames) {
+    return IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER;
   }
 
-  progress = 0;
-  write_offset = IMAADPCMWAVENCODER_HEADER_SIZE;
-  data_pos = data + IMAADPCMWAVENCODER_HEADER_SIZE;
-  while (progress < num_samples) {
-    /* エンコードサンプル数の確定 */
-    num_encode_samples 
-      = IMAADPCM_MIN_VAL(header.num_samples_per_block, num_samples - progress);
-    /* サンプル参照位置のセット */
-    for (ch = 0; ch < header.num_channels; ch++) {
-      input_ptr[ch] = &input[ch][progress];
+  for (group = 0; group < bank->num_groups; group++) {
+    int32_t *predict = &bank->predict[group * IMAADPCM_NUM_SIMD_LANES];
+    int32_t *index = &bank->index[group * IMAADPCM_NUM_SIMD_LANES];
+    int16_t *group_output = &output[group * IMAADPCM_NUM_SIMD_LANES];
+    num_group_lanes = IMAADPCM_MIN_VAL(IMAADPCM_NUM_SIMD_LANES, output_stride - group * IMAADPCM_NUM_SIMD_LANES);
+
+    /* デコードするストリームが無いグループは無音 */
+    group_active = 0;
+    for (i = 0; i < IMAADPCM_DECODERBANK_NUM_STREAMS_PER_GROUP; i++) {
+      const struct IMAADPCMDecoderBankStream *stream
+        = &bank->streams[group * IMAADPCM_DECODERBANK_NUM_STREAMS_PER_GROUP + i];
+      if (stream->active && (stream->num_remain_samples > 0)) {
+        group_active = 1;
+        break;
+      }
     }
-
-    /* ブロックエンコード */
-    if ((ret = IMAADPCMWAVEncoder_EncodeBlock(encoder,
-            input_ptr, num_encode_samples,
-            data_pos, data_size - write_offset, &write_size)) != IMAADPCM_APIRESULT_OK) {
-      return ret;
+    if (!group_active) {
+      for (frame = 0; frame < num_frames; frame++) {
+        memset(&group_output[frame * output_stride], 0, sizeof(int16_t) * num_group_lanes);
+      }
+      continue;
     }
 
-    /* 進捗更新 */
-    data_pos      += write_size;
-    write_offset  += write_size;
-    progress      += num_encode_samples;
-    assert(write_size <= header.block_size);
-    assert(write_offset <= data_size);
+    for (frame = 0; frame < num_frames; frame += num_steps) {
+      num_steps = IMAADPCM_MIN_VAL(IMAADPCM_DECODERBANK_NUM_STEPS, num_frames - frame);
+      IMAADPCMDecoderBank_FillSteps(bank, group, num_steps, &steps);
+      if (num_group_lanes == IMAADPCM_NUM_SIMD_LANES) {
+        bank->decode_steps(&steps, num_steps, predict, index, &group_output[frame * output_stride], output_stride);
+      } else {
+        /* 出力の末尾にはみ出すグループは一旦受けてからコピー */
+        uint32_t step;
+        bank->decode_steps(&steps, num_steps, predict, index, &tail_output[0][0], IMAADPCM_NUM_SIMD_LANES);
+        for (step = 0; step < num_steps; step++) {
+          memcpy(&group_output[(frame + step) * output_stride], tail_output[step], sizeof(int16_t) * num_group_lanes);
+        }
+      }
+    }
   }
 
-  /* 成功終了 */
-  (*output_size) = write_offset;
   return IMAADPCM_APIRESULT_OK;
 }
-
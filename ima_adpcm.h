@@ -4,11 +4,24 @@
 #include <stdint.h>
 
 /* 処理可能な最大チャンネル数 */
-#define IMAADPCM_MAX_NUM_CHANNELS       2
+#define IMAADPCM_MAX_NUM_CHANNELS       8
+
+/* デコーダバンクで扱える最大チャンネル数 */
+#define IMAADPCM_DECODERBANK_MAX_NUM_CHANNELS 2
+
+/* デコーダバンクで扱える最大ストリーム数（ワークサイズがint32_tで表せる範囲に収まる数） */
+#define IMAADPCM_DECODERBANK_MAX_NUM_STREAMS  (1UL << 24)
 
 /* サンプルあたりビット数は4で固定 */
 #define IMAADPCM_BITS_PER_SAMPLE        4
 
+/* 並列処理で分割する最大タスク数 */
+#define IMAADPCM_MAX_NUM_TASKS          256
+
+/* ミックスのゲイン（Q15）の等倍値と絶対値の上限 */
+#define IMAADPCM_MIX_GAIN_ONE           32768
+#define IMAADPCM_MIX_MAX_GAIN           65535
+
 /* API結果型 */
 typedef enum IMAADPCMApiResultTag {
   IMAADPCM_APIRESULT_OK = 0,              /* 成功                         */
@@ -20,6 +33,27 @@ typedef enum IMAADPCMApiResultTag {
   IMAADPCM_APIRESULT_NG                   /* 分類不能な失敗               */
 } IMAADPCMApiResult; 
 
+/* 処理カーネル */
+typedef enum IMAADPCMKernelTag {
+  IMAADPCM_KERNEL_AUTO = 0,               /* 実行中のCPUで最速の処理を選ぶ     */
+  IMAADPCM_KERNEL_SCALAR,                 /* スカラ処理                        */
+  IMAADPCM_KERNEL_SSE41,                  /* SSE4.1                            */
+  IMAADPCM_KERNEL_AVX2                    /* AVX2                              */
+} IMAADPCMKernel;
+
+/* リサンプリング方式 */
+typedef enum IMAADPCMResampleModeTag {
+  IMAADPCM_RESAMPLE_LINEAR = 0,           /* 線形補間（軽量）                  */
+  IMAADPCM_RESAMPLE_POLYPHASE             /* 多相FIRフィルタ（16タップ）       */
+} IMAADPCMResampleMode;
+
+/* デコード出力のサンプル形式 */
+typedef enum IMAADPCMSampleFormatTag {
+  IMAADPCM_SAMPLE_FORMAT_INT16 = 0,       /* 16bit整数                         */
+  IMAADPCM_SAMPLE_FORMAT_INT32,           /* 32bit整数（上位16bitに左詰め）    */
+  IMAADPCM_SAMPLE_FORMAT_FLOAT32          /* 32bit浮動小数（[-1,1)に正規化）   */
+} IMAADPCMSampleFormat;
+
 /* IMA-ADPCM形式のwavファイルのヘッダ情報 */
 struct IMAADPCMWAVHeaderInfo {
   uint16_t num_channels;          /* チャンネル数                                 */
@@ -30,6 +64,7 @@ struct IMAADPCMWAVHeaderInfo {
   uint16_t num_samples_per_block; /* ブロックあたりサンプル数                     */
   uint32_t num_samples;           /* 1チャンネルあたり総サンプル数                */
   uint32_t header_size;           /* ファイル先頭からdata領域先頭までのオフセット */
+  uint32_t channel_mask;          /* チャンネル配置（WAVE_FORMAT_EXTENSIBLEのdwChannelMask, 0は指定なし, 3チャンネル以上でのみ有効） */
 };
 
 /* エンコードパラメータ */
@@ -40,12 +75,35 @@ struct IMAADPCMWAVEncodeParameter {
   uint16_t block_size;            /* ブロックサイズ[byte]                         */
 };
 
+/* 並列処理のタスク関数型 */
+typedef void (*IMAADPCMTaskFunction)(void *task_context, uint32_t task_index);
+
+/* 並列処理の実行関数型 */
+/* task_function(task_context, 0)からtask_function(task_context, num_tasks - 1)までを（並列に）実行し、全タスクの完了後に戻る */
+typedef void (*IMAADPCMParallelExecutor)(
+    void *executor_context, IMAADPCMTaskFunction task_function, void *task_context, uint32_t num_tasks);
+
+/* デコード出力のレイアウト */
+struct IMAADPCMOutputLayout {
+  IMAADPCMSampleFormat sample_format;     /* サンプル形式                                     */
+  uint8_t interleaved;                    /* 0: チャンネル毎のバッファ, 1: buffer[0]に交互に格納 */
+};
+
+/* エンコード入力のレイアウト */
+struct IMAADPCMInputLayout {
+  IMAADPCMSampleFormat sample_format;     /* サンプル形式                                     */
+  uint8_t interleaved;                    /* 0: チャンネル毎のバッファ, 1: input[0]に交互に格納 */
+};
+
 /* デコーダハンドル */
 struct IMAADPCMWAVDecoder;
 
 /* エンコーダハンドル */
 struct IMAADPCMWAVEncoder;
 
+/* デコーダバンクハンドル */
+struct IMAADPCMDecoderBank;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -55,6 +113,7 @@ IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeHeader(
     const uint8_t *data, uint32_t data_size, struct IMAADPCMWAVHeaderInfo *header_info);
 
 /* ヘッダエンコード */
+/* 3チャンネル以上の場合はfmtチャンクをWAVE_FORMAT_EXTENSIBLE形式で書き出す（channel_maskは3チャンネル以上でのみ書き出す） */
 IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeHeader(
     const struct IMAADPCMWAVHeaderInfo *header_info, uint8_t *data, uint32_t data_size);
 
@@ -64,34 +123,428 @@ int32_t IMAADPCMWAVDecoder_CalculateWorkSize(void);
 /* デコーダハンドル作成 */
 struct IMAADPCMWAVDecoder *IMAADPCMWAVDecoder_Create(void *work, int32_t work_size);
 
+/* ストリーミングデコード用のデコーダワークサイズ計算 */
+/* 1ブロック分の一時バッファを含むため、IMAADPCMWAVDecoder_CalculateWorkSizeより大きい */
+int32_t IMAADPCMWAVDecoder_CalculateStreamWorkSize(void);
+
+/* ストリーミングデコード用のデコーダハンドル作成 */
+/* IMAADPCMWAVDecoder_BeginDecodeはこのハンドルでのみ使える それ以外の機能は通常のハンドルと同じ */
+struct IMAADPCMWAVDecoder *IMAADPCMWAVDecoder_CreateStream(void *work, int32_t work_size);
+
+/* 並列デコード用のデコーダワークサイズ計算 */
+/* max_num_tasksタスク分の状態とタイルを含む max_num_tasksが0またはIMAADPCM_MAX_NUM_TASKSを超える場合は-1を返す */
+int32_t IMAADPCMWAVDecoder_CalculateParallelWorkSize(uint32_t max_num_tasks);
+
+/* 並列デコード用のデコーダハンドル作成 */
+/* 各タスクはワーク領域に置いた状態とタイルを使うため、実行スレッドのスタックをほとんど使わない */
+/* それ以外の機能は通常のハンドルと同じ */
+struct IMAADPCMWAVDecoder *IMAADPCMWAVDecoder_CreateParallel(uint32_t max_num_tasks, void *work, int32_t work_size);
+
 /* デコーダハンドル破棄 */
 void IMAADPCMWAVDecoder_Destroy(struct IMAADPCMWAVDecoder *decoder);
 
+/* デコードに使用するカーネルの設定 */
+/* 補足）ハンドル作成時は環境変数IMAADPCM_KERNEL（auto, scalar, sse41, avx2）の指定、なければAUTOで設定される */
+IMAADPCMApiResult IMAADPCMWAVDecoder_SetKernel(
+    struct IMAADPCMWAVDecoder *decoder, IMAADPCMKernel kernel);
+
+/* デコードに使用するカーネルの取得（設定したカーネルを返す） */
+IMAADPCMKernel IMAADPCMWAVDecoder_GetKernel(const struct IMAADPCMWAVDecoder *decoder);
+
 /* ヘッダ含めファイル全体をデコード */
 IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWhole(
     struct IMAADPCMWAVDecoder *decoder,
     const uint8_t *data, uint32_t data_size,
     int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples);
 
+/* IMAADPCMWAVDecoder_DecodeWholeの64bit版 4GBを超えるRF64ファイルのデコードに使う */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWhole64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples);
+
+/* ヘッダ含めファイル全体を並列にデコード */
+/* ブロック列をnum_tasks個のタスクに分割してexecutorで実行する executorがNULLの場合は呼び出しスレッドで順に実行する */
+/* タスク数はIMAADPCMWAVDecoder_CreateParallelで指定した最大タスク数で制限される（それ以外のハンドルでは呼び出しスレッドで逐次デコードする） */
+/* 結果はIMAADPCMWAVDecoder_DecodeWholeと一致する */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWholeParallel(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context);
+
+/* IMAADPCMWAVDecoder_DecodeWholeParallelの64bit版 4GBを超えるRF64ファイルのデコードに使う */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWholeParallel64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context);
+
+/* ヘッダ情報からデコード結果の1チャンネルあたりサンプル数と、出力レイアウトで必要なバッファサイズ[byte]（全チャンネル合計）を計算 */
+/* num_samplesはIMAADPCMWAVDecoder_DecodeWhole等がデコードするサンプル数と一致する */
+IMAADPCMApiResult IMAADPCMWAVDecoder_CalculateOutputSize(
+    const struct IMAADPCMWAVHeaderInfo *header_info, const struct IMAADPCMOutputLayout *layout,
+    uint32_t *num_samples, uint32_t *buffer_size);
+
+/* IMAADPCMWAVDecoder_CalculateOutputSizeの64bit版 バッファサイズが4GBを超える場合に使う */
+IMAADPCMApiResult IMAADPCMWAVDecoder_CalculateOutputSize64(
+    const struct IMAADPCMWAVHeaderInfo *header_info, const struct IMAADPCMOutputLayout *layout,
+    uint32_t *num_samples, uint64_t *buffer_size);
+
+/* ヘッダ含めファイル全体を出力レイアウトに従ってデコード */
+/* bufferの要素型はlayout->sample_formatに従う（int16_t, int32_t, float） */
+/* インターリーブ時はbuffer[0]にbuffer_num_channels個おきに格納する（buffer_num_samplesはフレーム数） */
+/* 値はIMAADPCMWAVDecoder_DecodeWholeの結果を各形式に変換したものと一致する */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWholeToLayout(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    const struct IMAADPCMOutputLayout *layout,
+    void **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples);
+
+/* IMAADPCMWAVDecoder_DecodeWholeToLayoutの64bit版 4GBを超えるRF64ファイルのデコードに使う */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWholeToLayout64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    const struct IMAADPCMOutputLayout *layout,
+    void **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples);
+
+/* ヘッダ含めファイル全体を出力レイアウトに従って並列にデコード */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWholeParallelToLayout(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    const struct IMAADPCMOutputLayout *layout,
+    void **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context);
+
+/* IMAADPCMWAVDecoder_DecodeWholeParallelToLayoutの64bit版 4GBを超えるRF64ファイルのデコードに使う */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeWholeParallelToLayout64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    const struct IMAADPCMOutputLayout *layout,
+    void **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context);
+
+/* ヘッダ含めファイル全体から指定範囲のサンプルをデコード */
+/* start_sampleから始まるnum_samples個のサンプルをbufferの先頭から書き出す 範囲に重なるブロックのみをデコードする */
+/* 範囲がファイル末尾を超える場合は末尾までで切り詰め、デコードしたサンプル数をnum_decode_samplesに返す */
+/* 結果はIMAADPCMWAVDecoder_DecodeWholeの結果の同じ範囲と一致する */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRange(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    uint32_t start_sample, uint32_t num_samples,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
+/* IMAADPCMWAVDecoder_DecodeRangeの64bit版 4GBを超えるRF64ファイルのデコードに使う */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRange64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    uint32_t start_sample, uint32_t num_samples,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
+/* シークインデックスのサイズ計算 */
+/* interval: ブロック内のシーク点の間隔[sample] */
+IMAADPCMApiResult IMAADPCMWAVDecoder_CalculateSeekIndexSize(
+    const struct IMAADPCMWAVHeaderInfo *header_info, uint32_t interval, uint32_t *index_size);
+
+/* シークインデックスの作成 */
+/* 各ブロック内でintervalサンプル毎にデコーダの状態を記録する 出力は"seek"チャンク（RIFFチャンク）の形式で、 */
+/* そのまま別ファイルに保存するか、wavファイルのチャンクとして埋め込んで使う（ヘッダデコードでは読み飛ばされる） */
+IMAADPCMApiResult IMAADPCMWAVDecoder_CreateSeekIndex(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size, uint32_t interval,
+    uint8_t *index, uint32_t index_size, uint32_t *output_size);
+
+/* IMAADPCMWAVDecoder_CreateSeekIndexの64bit版 4GBを超えるRF64ファイルのデコードに使う */
+IMAADPCMApiResult IMAADPCMWAVDecoder_CreateSeekIndex64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size, uint32_t interval,
+    uint8_t *index, uint32_t index_size, uint32_t *output_size);
+
+/* シークインデックスを使ってファイル全体から指定範囲のサンプルをデコード */
+/* 範囲の先頭は直前のシーク点から再開するため、ブロックサイズによらずinterval未満のサンプルの読み捨てで済む */
+/* 結果はIMAADPCMWAVDecoder_DecodeRangeと一致する */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRangeWithSeekIndex(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    const uint8_t *index, uint32_t index_size,
+    uint32_t start_sample, uint32_t num_samples,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
+/* IMAADPCMWAVDecoder_DecodeRangeWithSeekIndexの64bit版 4GBを超えるRF64ファイルのデコードに使う */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRangeWithSeekIndex64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    const uint8_t *index, uint32_t index_size,
+    uint32_t start_sample, uint32_t num_samples,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
+/* ファイル全体から指定範囲のサンプルをデコードし、ゲインを掛けて32bit整数のミックスバスに加算 */
+/* gainはQ15（IMAADPCM_MIX_GAIN_ONEで等倍, 絶対値IMAADPCM_MIX_MAX_GAINまで） mix_buffer[ch][i] += (sample * gain) / 32768（四捨五入） */
+/* 中間のサンプルバッファを介さずに加算する 範囲の扱いはIMAADPCMWAVDecoder_DecodeRangeと同じ */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRangeMix(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    uint32_t start_sample, uint32_t num_samples, int32_t gain,
+    int32_t **mix_buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
+/* IMAADPCMWAVDecoder_DecodeRangeMixの64bit版 4GBを超えるRF64ファイルのデコードに使う */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRangeMix64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    uint32_t start_sample, uint32_t num_samples, int32_t gain,
+    int32_t **mix_buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
+/* ファイル全体から指定範囲のサンプルをデコードし、ゲインを掛けて浮動小数点のミックスバスに加算 */
+/* mix_buffer[ch][i] += (sample / 32768) * (gain / 32768) 16bitのフルスケールが1.0になる */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRangeMixFloat(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    uint32_t start_sample, uint32_t num_samples, int32_t gain,
+    float **mix_buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
+/* IMAADPCMWAVDecoder_DecodeRangeMixFloatの64bit版 4GBを超えるRF64ファイルのデコードに使う */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeRangeMixFloat64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    uint32_t start_sample, uint32_t num_samples, int32_t gain,
+    float **mix_buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
+/* リサンプリングデコードの開始 */
+/* ヘッダ含めファイル全体を受け取り、output_sampling_rateに変換しながらデコードする状態を初期化する */
+/* 変換後の総サンプル数をnum_output_samplesに返す dataはデコードが終わるまで保持すること */
+IMAADPCMApiResult IMAADPCMWAVDecoder_BeginResample(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size,
+    uint32_t output_sampling_rate, IMAADPCMResampleMode mode, uint32_t *num_output_samples);
+
+/* IMAADPCMWAVDecoder_BeginResampleの64bit版 4GBを超えるRF64ファイルのデコードに使う */
+IMAADPCMApiResult IMAADPCMWAVDecoder_BeginResample64(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint64_t data_size,
+    uint32_t output_sampling_rate, IMAADPCMResampleMode mode, uint32_t *num_output_samples);
+
+/* リサンプリングデコード */
+/* 変換後のサンプルを続きからbuffer_num_samples個（末尾で切り詰め）bufferに書き出す 末尾に達していれば0サンプル */
+/* 内部に保持するのはフィルタ長程度の入力の履歴とブロック途中のデコーダの状態のみで、ブロック境界・呼び出しをまたいで連続に変換する */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeResample(
+    struct IMAADPCMWAVDecoder *decoder,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
+/* ストリーミングデコードの開始 */
+/* IMAADPCMWAVDecoder_CreateStreamで作成していないハンドルにはIMAADPCM_APIRESULT_INVALID_ARGUMENTを返す */
+IMAADPCMApiResult IMAADPCMWAVDecoder_BeginDecode(struct IMAADPCMWAVDecoder *decoder);
+
+/* ストリーミングデコードで読み込んだヘッダ情報の取得 */
+/* ヘッダ（dataチャンク先頭まで）を読み終えていなければIMAADPCM_APIRESULT_INSUFFICIENT_DATAを返す */
+IMAADPCMApiResult IMAADPCMWAVDecoder_GetStreamHeader(
+    const struct IMAADPCMWAVDecoder *decoder, struct IMAADPCMWAVHeaderInfo *header_info);
+
+/* ストリーミングデコードにデータを供給 */
+/* 任意の位置で区切られたファイルのデータを先頭から順に受け取り、揃ったブロックからbufferにデコードする */
+/* bufferに次のブロックが入りきらなくなった時点で読み込みを止める 読み込んだサイズをread_sizeに返すので、残りは次の呼び出しで渡す */
+/* 内部に保持するのは高々1ブロック分のデータのみ bufferには1ブロック分（num_samples_per_block）以上のサンプル数が必要 */
+IMAADPCMApiResult IMAADPCMWAVDecoder_DecodeData(
+    struct IMAADPCMWAVDecoder *decoder,
+    const uint8_t *data, uint32_t data_size, uint32_t *read_size,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
+/* ストリーミングデコードの終了 */
+/* 途中で途切れたブロックがあればデコードする 出力全体はIMAADPCMWAVDecoder_DecodeWholeの結果と一致する */
+IMAADPCMApiResult IMAADPCMWAVDecoder_FinishDecode(
+    struct IMAADPCMWAVDecoder *decoder,
+    int16_t **buffer, uint32_t buffer_num_channels, uint32_t buffer_num_samples,
+    uint32_t *num_decode_samples);
+
 /* エンコーダワークサイズ計算 */
 int32_t IMAADPCMWAVEncoder_CalculateWorkSize(void);
 
 /* エンコーダハンドル作成 */
 struct IMAADPCMWAVEncoder *IMAADPCMWAVEncoder_Create(void *work, int32_t work_size);
 
+/* 並列エンコード用のエンコーダワークサイズ計算 */
+/* max_num_tasksタスク分の状態とタイルを含む max_num_tasksが0またはIMAADPCM_MAX_NUM_TASKSを超える場合は-1を返す */
+int32_t IMAADPCMWAVEncoder_CalculateParallelWorkSize(uint32_t max_num_tasks);
+
+/* 並列エンコード用のエンコーダハンドル作成 */
+/* 各タスクはワーク領域に置いた状態とタイルを使うため、実行スレッドのスタックをほとんど使わない */
+/* それ以外の機能は通常のハンドルと同じ */
+struct IMAADPCMWAVEncoder *IMAADPCMWAVEncoder_CreateParallel(uint32_t max_num_tasks, void *work, int32_t work_size);
+
 /* エンコーダハンドル破棄 */
 void IMAADPCMWAVEncoder_Destroy(struct IMAADPCMWAVEncoder *encoder);
 
+/* エンコードに使用するカーネルの設定 */
+/* 補足）ハンドル作成時の設定はデコーダと同様 */
+IMAADPCMApiResult IMAADPCMWAVEncoder_SetKernel(
+    struct IMAADPCMWAVEncoder *encoder, IMAADPCMKernel kernel);
+
+/* エンコードに使用するカーネルの取得（設定したカーネルを返す） */
+IMAADPCMKernel IMAADPCMWAVEncoder_GetKernel(const struct IMAADPCMWAVEncoder *encoder);
+
 /* エンコードパラメータの設定 */
+/* 3チャンネル以上ではブロックサイズからヘッダ分（4*チャンネル数）を除いたサイズが4*チャンネル数の倍数である必要がある */
 IMAADPCMApiResult IMAADPCMWAVEncoder_SetEncodeParameter(
     struct IMAADPCMWAVEncoder *encoder, const struct IMAADPCMWAVEncodeParameter *parameter);
 
+/* チャンネル配置（WAVE_FORMAT_EXTENSIBLEのdwChannelMask）の設定 */
+/* 3チャンネル以上のエンコード時のみヘッダに書き出す。ハンドル作成時は0（指定なし） */
+IMAADPCMApiResult IMAADPCMWAVEncoder_SetChannelMask(
+    struct IMAADPCMWAVEncoder *encoder, uint32_t channel_mask);
+
+/* num_samplesサンプルをエンコードした時のヘッダを含む出力サイズ[byte]を計算 */
+/* エンコード関数が書き出すサイズ（output_size）およびヘッダに記録するサイズと一致する */
+/* 4GBを超える場合はIMAADPCM_APIRESULT_INVALID_FORMATを返す */
+IMAADPCMApiResult IMAADPCMWAVEncoder_CalculateOutputSize(
+    const struct IMAADPCMWAVEncodeParameter *parameter, uint32_t num_samples, uint32_t *output_size);
+
+/* IMAADPCMWAVEncoder_CalculateOutputSizeの64bit版 */
+/* 4GBを超える場合のサイズはRF64（ds64チャンクを含むヘッダ）のもの */
+IMAADPCMApiResult IMAADPCMWAVEncoder_CalculateOutputSize64(
+    const struct IMAADPCMWAVEncodeParameter *parameter, uint32_t num_samples, uint64_t *output_size);
+
 /* ヘッダ含めファイル全体をエンコード */
 IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWhole(
     struct IMAADPCMWAVEncoder *encoder,
     const int16_t *const *input, uint32_t num_samples,
     uint8_t *data, uint32_t data_size, uint32_t *output_size);
 
+/* IMAADPCMWAVEncoder_EncodeWholeの64bit版 出力が4GBを超える場合はRF64で書き出す */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWhole64(
+    struct IMAADPCMWAVEncoder *encoder,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint64_t data_size, uint64_t *output_size);
+
+/* ヘッダ含めファイル全体を並列にエンコード */
+/* 各ブロック先頭のステップサイズインデックスを直前の入力サンプルから推定し、ブロック毎に独立にエンコードする */
+/* 結果はタスク数やタスクの実行順によらず一致する（ただしIMAADPCMWAVEncoder_EncodeWholeの結果とは異なりうる） */
+/* タスク数はIMAADPCMWAVEncoder_CreateParallelで指定した最大タスク数で制限される（それ以外のハンドルでは呼び出しスレッドでエンコードする） */
+/* dataにファイル全体を書き出せない場合はIMAADPCM_APIRESULT_INSUFFICIENT_BUFFERを返す */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWholeParallel(
+    struct IMAADPCMWAVEncoder *encoder,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context);
+
+/* IMAADPCMWAVEncoder_EncodeWholeParallelの64bit版 出力が4GBを超える場合はRF64で書き出す */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWholeParallel64(
+    struct IMAADPCMWAVEncoder *encoder,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint64_t data_size, uint64_t *output_size,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context);
+
+/* 入力レイアウトに従ってヘッダ含めファイル全体をエンコード */
+/* inputの要素型はlayout->sample_formatに従う（int16_t, int32_t, float） 変換はブロック単位でエンコードしながら行う */
+/* インターリーブ時はinput[0]からinput_num_channels個おきに読み込む（num_samplesはフレーム数） */
+/* int32は上位16bitを、floatは32768倍して丸め・飽和した値をエンコードする */
+/* 結果は変換後のint16をIMAADPCMWAVEncoder_EncodeWholeでエンコードしたものと一致する */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWholeFromLayout(
+    struct IMAADPCMWAVEncoder *encoder,
+    const struct IMAADPCMInputLayout *layout,
+    const void *const *input, uint32_t input_num_channels, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size);
+
+/* IMAADPCMWAVEncoder_EncodeWholeFromLayoutの64bit版 出力が4GBを超える場合はRF64で書き出す */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWholeFromLayout64(
+    struct IMAADPCMWAVEncoder *encoder,
+    const struct IMAADPCMInputLayout *layout,
+    const void *const *input, uint32_t input_num_channels, uint32_t num_samples,
+    uint8_t *data, uint64_t data_size, uint64_t *output_size);
+
+/* 入力レイアウトに従ってヘッダ含めファイル全体を並列にエンコード */
+/* 結果は変換後のint16をIMAADPCMWAVEncoder_EncodeWholeParallelでエンコードしたものと一致する */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWholeParallelFromLayout(
+    struct IMAADPCMWAVEncoder *encoder,
+    const struct IMAADPCMInputLayout *layout,
+    const void *const *input, uint32_t input_num_channels, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context);
+
+/* IMAADPCMWAVEncoder_EncodeWholeParallelFromLayoutの64bit版 */
+/* 出力が4GBを超える場合はRF64で書き出す */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeWholeParallelFromLayout64(
+    struct IMAADPCMWAVEncoder *encoder,
+    const struct IMAADPCMInputLayout *layout,
+    const void *const *input, uint32_t input_num_channels, uint32_t num_samples,
+    uint8_t *data, uint64_t data_size, uint64_t *output_size,
+    uint32_t num_tasks, IMAADPCMParallelExecutor executor, void *executor_context);
+
+/* ストリーミングエンコードの開始 */
+/* 総サンプル数を0とした暫定のヘッダをdataに書き出す */
+/* RF64のヘッダが必要になる（出力が4GBを超える）サンプル数はIMAADPCMWAVEncoder_EncodeSamplesで受け付けない */
+IMAADPCMApiResult IMAADPCMWAVEncoder_BeginEncode(
+    struct IMAADPCMWAVEncoder *encoder, uint8_t *data, uint32_t data_size, uint32_t *output_size);
+
+/* 4GBを超えうるストリーミングエンコードの開始 */
+/* ds64チャンクの領域をJUNKチャンクとして予約したヘッダを書き出す */
+/* IMAADPCMWAVEncoder_FinishEncodeは4GBを超えていればRF64、そうでなければJUNKチャンクを含むRIFFのヘッダで上書きする */
+IMAADPCMApiResult IMAADPCMWAVEncoder_BeginEncode64(
+    struct IMAADPCMWAVEncoder *encoder, uint8_t *data, uint32_t data_size, uint32_t *output_size);
+
+/* ストリーミングエンコードにサンプルを供給 */
+/* 確定したデータをdataに書き出す 内部に保持するのは書き出し単位（モノラル1byte, ステレオ4byte）に満たない分のみ */
+/* dataに書き出しきれない場合は状態を変えずにIMAADPCM_APIRESULT_INSUFFICIENT_BUFFERを返す */
+IMAADPCMApiResult IMAADPCMWAVEncoder_EncodeSamples(
+    struct IMAADPCMWAVEncoder *encoder,
+    const int16_t *const *input, uint32_t num_samples,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size);
+
+/* ストリーミングエンコードの終了 */
+/* 残りのデータをdataに書き出し、総サンプル数を反映したヘッダをheader_dataに書き出す（暫定のヘッダを上書きする） */
+/* 出力全体はハンドル作成直後にIMAADPCMWAVEncoder_EncodeWholeでエンコードした結果と一致する */
+IMAADPCMApiResult IMAADPCMWAVEncoder_FinishEncode(
+    struct IMAADPCMWAVEncoder *encoder,
+    uint8_t *data, uint32_t data_size, uint32_t *output_size,
+    uint8_t *header_data, uint32_t header_data_size);
+
+/* デコーダバンクワークサイズ計算 */
+/* max_num_streamsが0またはIMAADPCM_DECODERBANK_MAX_NUM_STREAMSを超える場合は-1を返す */
+int32_t IMAADPCMDecoderBank_CalculateWorkSize(uint32_t max_num_streams);
+
+/* デコーダバンク作成 */
+/* 最大max_num_streams本のストリームの状態をまとめて持ち、全ストリームを同時にデコードする */
+struct IMAADPCMDecoderBank *IMAADPCMDecoderBank_Create(uint32_t max_num_streams, void *work, int32_t work_size);
+
+/* デコーダバンク破棄 */
+void IMAADPCMDecoderBank_Destroy(struct IMAADPCMDecoderBank *bank);
+
+/* デコーダバンクで使用するカーネルの設定 */
+/* 補足）作成時の設定はデコーダと同様 */
+IMAADPCMApiResult IMAADPCMDecoderBank_SetKernel(
+    struct IMAADPCMDecoderBank *bank, IMAADPCMKernel kernel);
+
+/* デコーダバンクにストリームを追加 */
+/* dataはヘッダ含めたファイル全体 ストリームを削除するまで参照するので、領域を保持しておくこと */
+/* 割り当てたストリームID（0からmax_num_streams-1）をstream_idに返す 空きが無ければIMAADPCM_APIRESULT_INSUFFICIENT_BUFFERを返す */
+/* IMAADPCM_DECODERBANK_MAX_NUM_CHANNELSを超えるチャンネル数のデータはIMAADPCM_APIRESULT_INVALID_FORMATを返す */
+IMAADPCMApiResult IMAADPCMDecoderBank_AddStream(
+    struct IMAADPCMDecoderBank *bank, const uint8_t *data, uint32_t data_size, uint32_t *stream_id);
+
+/* デコーダバンクからストリームを削除 削除したIDは次の追加で再利用される */
+IMAADPCMApiResult IMAADPCMDecoderBank_RemoveStream(struct IMAADPCMDecoderBank *bank, uint32_t stream_id);
+
+/* デコーダバンクのストリームの残りサンプル数の取得 */
+/* 不正なデータでデコードを停止していた場合はIMAADPCM_APIRESULT_INVALID_FORMATを返す */
+IMAADPCMApiResult IMAADPCMDecoderBank_GetNumRemainSamples(
+    const struct IMAADPCMDecoderBank *bank, uint32_t stream_id, uint32_t *num_remain_samples);
+
+/* デコーダバンクの全ストリームのデコード */
+/* 各ストリームの次のnum_framesサンプルをoutputに書き出す ストリームidのチャンネルchのf番目のサンプルの位置は */
+/* output[f * (max_num_streams * IMAADPCM_DECODERBANK_MAX_NUM_CHANNELS) + id * IMAADPCM_DECODERBANK_MAX_NUM_CHANNELS + ch] */
+/* 空き・終端に達したストリームと、モノラルのストリームの2チャンネル目は0を書き出す */
+/* output_size: outputの要素数 */
+IMAADPCMApiResult IMAADPCMDecoderBank_Decode(
+    struct IMAADPCMDecoderBank *bank, int16_t *output, uint32_t output_size, uint32_t num_frames);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -4,6 +4,11 @@
  * To Public License, Version 2, as published by Sam Hocevar. See
  * http://www.wtfpl.net/ for more details. */
 
+/* sysconf, posix_madvise, posix_fallocateを使うため */
+#define _POSIX_C_SOURCE 200112L
+/* 4GBを超えるファイルを扱うため */
+#define _FILE_OFFSET_BITS 64
+
 #include "ima_adpcm.h"
 #include "wav.h"
 
@@ -11,6 +16,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
 
 /* バージョン文字列 */
 #define IMAADPCMCUI_VERSION_STRING  "1.1.1"
@@ -18,167 +27,511 @@
 /* ブロックサイズ 今の所1024で固定 */
 #define IMAADPCMCUI_BLOCK_SIZE      1024
 
+/* 3チャンネル以上のチャンネルあたりのブロックサイズ（チャンネル毎の4byteのワードが揃う大きさ） */
+#define IMAADPCMCUI_MULTICHANNEL_BLOCK_SIZE_PER_CHANNEL 512
+
+/* チャンネル数に応じたブロックサイズ */
+#define IMAADPCMCUI_CALCULATE_BLOCK_SIZE(num_channels) \
+  (((num_channels) > 2) ? (IMAADPCMCUI_MULTICHANNEL_BLOCK_SIZE_PER_CHANNEL * (num_channels)) : IMAADPCMCUI_BLOCK_SIZE)
+
+/* パイプ等から読み込む際のバッファの初期サイズ */
+#define IMAADPCMCUI_READ_BUFFER_SIZE (64 * 1024)
+
+/* 入力ファイル */
+struct IMAADPCMCUIInputFile {
+  uint8_t   *data;      /* ファイル先頭 */
+  uint64_t  size;       /* ファイルサイズ */
+  uint8_t   is_mapped;  /* 1: メモリマップ, 0: mallocしたバッファ */
+};
+
+/* 出力ファイル */
+struct IMAADPCMCUIOutputFile {
+  int       fd;         /* ファイルディスクリプタ */
+  uint8_t   *data;      /* マップ先頭 */
+  uint64_t  size;       /* マップサイズ */
+};
+
+/* スレッドに渡すタスク */
+struct IMAADPCMCUITask {
+  IMAADPCMTaskFunction  task_function;
+  void                  *task_context;
+  uint32_t              task_index;
+};
+
+/* スレッドのエントリ */
+static void *task_thread_entry(void *arg)
+{
+  struct IMAADPCMCUITask *task = (struct IMAADPCMCUITask *)arg;
+  task->task_function(task->task_context, task->task_index);
+  return NULL;
+}
+
+/* タスクを1つずつスレッドで実行 */
+static void execute_tasks(
+    void *executor_context, IMAADPCMTaskFunction task_function, void *task_context, uint32_t num_tasks)
+{
+  uint32_t i;
+  pthread_t threads[IMAADPCM_MAX_NUM_TASKS];
+  uint8_t is_created[IMAADPCM_MAX_NUM_TASKS];
+  struct IMAADPCMCUITask tasks[IMAADPCM_MAX_NUM_TASKS];
+
+  (void)executor_context;
+
+  for (i = 0; i < num_tasks; i++) {
+    tasks[i].task_function = task_function;
+    tasks[i].task_context = task_context;
+    tasks[i].task_index = i;
+    /* スレッドが作れなければこのスレッドで実行 */
+    is_created[i] = (pthread_create(&threads[i], NULL, task_thread_entry, &tasks[i]) == 0) ? 1 : 0;
+    if (!is_created[i]) {
+      task_function(task_context, i);
+    }
+  }
+
+  for (i = 0; i < num_tasks; i++) {
+    if (is_created[i]) {
+      pthread_join(threads[i], NULL);
+    }
+  }
+}
+
+/* 並列処理のタスク数（オンラインのCPU数）を取得 */
+static uint32_t get_num_tasks(void)
+{
+  const long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+  if (num_cpus < 1) {
+    return 1;
+  } else if (num_cpus > IMAADPCM_MAX_NUM_TASKS) {
+    return IMAADPCM_MAX_NUM_TASKS;
+  }
+
+  return (uint32_t)num_cpus;
+}
+
+/* 通常ファイルを読み取り専用でメモリマップ（先頭から順に読む） */
+static int map_input_file(const char *filename, struct IMAADPCMCUIInputFile *file)
+{
+  int         fd;
+  struct stat st;
+  void        *map = MAP_FAILED;
+
+  file->data = NULL;
+  file->size = 0;
+  file->is_mapped = 0;
+
+  fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return 1;
+  }
+
+  /* 通常ファイルでアドレス空間に収まるものだけマップ */
+  if ((fstat(fd, &st) == 0) && S_ISREG(st.st_mode)
+      && (st.st_size > 0) && ((uint64_t)st.st_size <= (size_t)-1)) {
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  /* マップはクローズ後も有効 */
+  close(fd);
+
+  if (map == MAP_FAILED) {
+    return 1;
+  }
+
+  posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+  file->data = (uint8_t *)map;
+  file->size = (uint64_t)st.st_size;
+  file->is_mapped = 1;
+
+  return 0;
+}
+
+/* 入力ファイルを開く（マップできないパイプ等はバッファに全て読み込む） */
+static int open_input_file(const char *filename, struct IMAADPCMCUIInputFile *file)
+{
+  FILE      *fp;
+  uint8_t   *data = NULL;
+  size_t    capacity = 0, size = 0;
+
+  if (map_input_file(filename, file) == 0) {
+    return 0;
+  }
+
+  fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    return 1;
+  }
+
+  /* 足りなくなったら倍に拡げながら末尾まで読み込む */
+  do {
+    if (size == capacity) {
+      uint8_t *tmp;
+      capacity = (capacity == 0) ? IMAADPCMCUI_READ_BUFFER_SIZE : (2 * capacity);
+      if ((capacity < size) || ((tmp = (uint8_t *)realloc(data, capacity)) == NULL)) {
+        free(data);
+        fclose(fp);
+        return 1;
+      }
+      data = tmp;
+    }
+    size += fread(&data[size], sizeof(uint8_t), capacity - size, fp);
+  } while (!feof(fp) && !ferror(fp));
+
+  if (ferror(fp)) {
+    free(data);
+    fclose(fp);
+    return 1;
+  }
+  fclose(fp);
+
+  file->data = data;
+  file->size = size;
+  file->is_mapped = 0;
+
+  return 0;
+}
+
+/* 入力ファイルの指定範囲を先読みさせる（マップしている場合のみ） */
+static void prefetch_input_file(const struct IMAADPCMCUIInputFile *file, uint64_t offset, uint64_t size)
+{
+  const long page_size = sysconf(_SC_PAGESIZE);
+  uint64_t begin;
+
+  if (!file->is_mapped || (page_size <= 0) || (offset >= file->size)) {
+    return;
+  }
+
+  /* マップ先頭はページ境界なのでオフセットをページ境界に切り下げる */
+  begin = offset - (offset % (uint64_t)page_size);
+  size = (size < (file->size - offset)) ? size : (file->size - offset);
+  posix_madvise(&file->data[begin], (size_t)(size + (offset - begin)), POSIX_MADV_WILLNEED);
+}
+
+/* 入力ファイルを閉じる */
+static void close_input_file(struct IMAADPCMCUIInputFile *file)
+{
+  if (file->data != NULL) {
+    if (file->is_mapped) {
+      munmap(file->data, (size_t)file->size);
+    } else {
+      free(file->data);
+    }
+  }
+  file->data = NULL;
+  file->size = 0;
+}
+
+/* 出力先が通常ファイル（または新規作成）か？ */
+static int is_regular_output_file(const char *filename)
+{
+  struct stat st;
+
+  /* 存在しなければ通常ファイルとして作られる */
+  if (stat(filename, &st) != 0) {
+    return 1;
+  }
+
+  return S_ISREG(st.st_mode) ? 1 : 0;
+}
+
+/* 出力ファイルをsizeバイトに拡げて書き込み可能でマップ（既存の内容は保持） */
+static int map_output_file(const char *filename, uint64_t size, struct IMAADPCMCUIOutputFile *file)
+{
+  int   fd;
+  void  *map;
+
+  file->fd = -1;
+  file->data = NULL;
+  file->size = 0;
+
+  /* パイプ等やアドレス空間に収まらないサイズはマップできない */
+  if ((size == 0) || (size > (size_t)-1) || !is_regular_output_file(filename)) {
+    return 1;
+  }
+
+  fd = open(filename, O_RDWR | O_CREAT, 0666);
+  if (fd < 0) {
+    return 1;
+  }
+
+  /* マップへの書き込み中にディスクが溢れないよう領域を確保しておく */
+  if ((ftruncate(fd, (off_t)size) != 0) || (posix_fallocate(fd, 0, (off_t)size) != 0)) {
+    close(fd);
+    return 1;
+  }
+
+  map = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) {
+    close(fd);
+    return 1;
+  }
+
+  file->fd = fd;
+  file->data = (uint8_t *)map;
+  file->size = size;
+
+  return 0;
+}
+
+/* マップを解除し、ファイルをsizeバイトに切り詰めて閉じる */
+static int unmap_output_file(struct IMAADPCMCUIOutputFile *file, uint64_t size)
+{
+  int ret = 0;
+
+  if (munmap(file->data, (size_t)file->size) != 0) {
+    ret = 1;
+  }
+  if (ftruncate(file->fd, (off_t)size) != 0) {
+    ret = 1;
+  }
+  if (close(file->fd) != 0) {
+    ret = 1;
+  }
+
+  file->fd = -1;
+  file->data = NULL;
+  file->size = 0;
+
+  return ret;
+}
+
+/* 実行環境がリトルエンディアンか？ */
+static int is_little_endian(void)
+{
+  const uint16_t one = 1;
+  return (*(const uint8_t *)&one == 1) ? 1 : 0;
+}
+
 /* デコード処理 */
 static int do_decode(const char *adpcm_filename, const char *decoded_filename)
 {
-  FILE                          *fp;
-  struct stat                   fstat;
+  struct IMAADPCMCUIInputFile   input;
   uint8_t                       *buffer;
-  uint32_t                      buffer_size;
+  uint64_t                      buffer_size, pcm_size;
   struct IMAADPCMWAVDecoder     *decoder;
   struct IMAADPCMWAVHeaderInfo  header;
-  struct WAVFile                *wav;
+  struct WAVFile                *wav = NULL;
   struct WAVFileFormat          wavformat;
-  int16_t                       *output[IMAADPCM_MAX_NUM_CHANNELS];
-  uint32_t                      ch, smpl;
+  struct IMAADPCMCUIOutputFile  output_file;
+  struct IMAADPCMOutputLayout   layout;
+  void                          *output[IMAADPCM_MAX_NUM_CHANNELS];
+  uint32_t                      ch, wav_header_size, num_samples;
   IMAADPCMApiResult             ret;
 
-  /* ファイルオープン */
-  fp = fopen(adpcm_filename, "rb");
-  if (fp == NULL) {
+  /* 入力ファイルをマップ（できなければ読み込み） */
+  if (open_input_file(adpcm_filename, &input) != 0) {
     fprintf(stderr, "Failed to open %s. \n", adpcm_filename);
     return 1;
   }
+  buffer = input.data;
+  buffer_size = input.size;
 
-  /* 入力ファイルのサイズ取得 / バッファ領域割り当て */
-  stat(adpcm_filename, &fstat);
-  buffer_size = (uint32_t)fstat.st_size;
-  buffer = (uint8_t *)malloc(buffer_size);
-  /* バッファ領域にデータをロード */
-  fread(buffer, sizeof(uint8_t), buffer_size, fp);
-  fclose(fp);
-
-  /* デコーダ作成 */
-  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+  /* デコーダ作成（タスク毎の領域を含める） */
+  decoder = IMAADPCMWAVDecoder_CreateParallel(get_num_tasks(), NULL, 0);
 
-  /* ヘッダ読み取り */
-  if ((ret = IMAADPCMWAVDecoder_DecodeHeader(buffer, buffer_size, &header))
+  /* ヘッダ読み取り（ヘッダはファイル先頭にあるので32bitで表せる範囲を渡す） */
+  if ((ret = IMAADPCMWAVDecoder_DecodeHeader(buffer,
+          (uint32_t)((buffer_size < 0xFFFFFFFFUL) ? buffer_size : 0xFFFFFFFFUL), &header))
       != IMAADPCM_APIRESULT_OK) {
     fprintf(stderr, "Failed to read header. API result: %d \n", ret);
     return 1;
   }
 
-  /* 出力バッファ領域確保 */
-  for (ch = 0; ch < header.num_channels; ch++) {
-    output[ch] = malloc(sizeof(int16_t) * header.num_samples);
+  /* 並列タスクはdata領域の離れたブロックを同時に読むため、data領域全体（ブロック単位）を先読みさせる */
+  if ((header.block_size > 0) && (buffer_size > header.header_size)) {
+    prefetch_input_file(&input, header.header_size,
+        ((buffer_size - header.header_size + header.block_size - 1) / header.block_size) * header.block_size);
   }
 
-  /* 全データをデコード */
-  if ((ret = IMAADPCMWAVDecoder_DecodeWhole(decoder, 
-        buffer, buffer_size, output, 
-        header.num_channels, header.num_samples)) != IMAADPCM_APIRESULT_OK) {
-    fprintf(stderr, "Failed to decode. API result: %d \n", ret);
+  /* デコード結果（16bitインターリーブ）のサイズ */
+  layout.sample_format = IMAADPCM_SAMPLE_FORMAT_INT16;
+  layout.interleaved = 1;
+  if ((ret = IMAADPCMWAVDecoder_CalculateOutputSize64(&header, &layout, &num_samples, &pcm_size))
+      != IMAADPCM_APIRESULT_OK) {
+    fprintf(stderr, "Failed to calculate output size. API result: %d \n", ret);
     return 1;
   }
 
-  /* 出力ファイルを作成 */
+  /* 出力ファイルのフォーマット */
   wavformat.data_format = WAV_DATA_FORMAT_PCM;
   wavformat.num_channels = header.num_channels;
   wavformat.sampling_rate = header.sampling_rate;
   wavformat.bits_per_sample = 16;
-  wavformat.num_samples = header.num_samples;
-  wav = WAV_Create(&wavformat);
-
-  /* PCM書き出し */
-  for (ch = 0; ch < header.num_channels; ch++) {
-    for (smpl = 0; smpl < header.num_samples; smpl++) {
-      WAVFile_PCM(wav, smpl, ch) = (output[ch][smpl] << 16);
+  wavformat.num_samples = num_samples;
+  wavformat.channel_mask = header.channel_mask;
+
+  if (is_little_endian() && is_regular_output_file(decoded_filename)
+      && (WAV_WriteHeaderToFile(decoded_filename, &wavformat, &wav_header_size) == WAV_APIRESULT_OK)
+      && (map_output_file(decoded_filename, wav_header_size + pcm_size, &output_file) == 0)) {
+    /* ヘッダを書いた出力ファイルをマップし、ヘッダ直後に16bit PCM（インターリーブ）を直接書き出す */
+    output[0] = &output_file.data[wav_header_size];
+  } else {
+    /* マップできなければWAVファイルのPCMバッファ（左詰めの32bit整数）に書き出す */
+    wav = WAV_Create(&wavformat);
+    layout.sample_format = IMAADPCM_SAMPLE_FORMAT_INT32;
+    layout.interleaved = 0;
+    for (ch = 0; ch < header.num_channels; ch++) {
+      output[ch] = wav->data[ch];
     }
   }
 
-  WAV_WriteToFile(decoded_filename, wav);
+  /* 全データを並列にデコード */
+  if ((ret = IMAADPCMWAVDecoder_DecodeWholeParallelToLayout64(decoder, 
+        buffer, buffer_size, &layout, output, 
+        header.num_channels, num_samples,
+        get_num_tasks(), execute_tasks, NULL)) != IMAADPCM_APIRESULT_OK) {
+    fprintf(stderr, "Failed to decode. API result: %d \n", ret);
+    return 1;
+  }
 
-  IMAADPCMWAVDecoder_Destroy(decoder);
-  for (ch = 0; ch < header.num_channels; ch++) {
-    free(output[ch]);
+  /* ファイル書き出し */
+  if (wav == NULL) {
+    if (unmap_output_file(&output_file, output_file.size) != 0) {
+      fprintf(stderr, "Failed to write %s. \n", decoded_filename);
+      return 1;
+    }
+  } else {
+    WAV_WriteToFile(decoded_filename, wav);
+    WAV_Destroy(wav);
   }
-  WAV_Destroy(wav);
-  free(buffer);
+
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  close_input_file(&input);
 
   return 0;
 }
 
 /* エンコード処理 */
-static int do_encode(const char *wav_file, const char *encoded_filename)
+/* parallelが0でなければ並列エンコーダを使う（出力は逐次エンコーダと異なりうる） */
+static int do_encode(const char *wav_file, const char *encoded_filename, uint8_t parallel)
 {
   FILE                              *fp;
-  struct WAVFile                    *wavfile;
-  struct stat                       fstat;
-  int16_t                           *input[IMAADPCM_MAX_NUM_CHANNELS];
-  uint32_t                          ch, smpl, buffer_size, output_size;
+  struct WAVFile                    *wavfile = NULL;
+  struct WAVFileFormat              wavformat;
+  struct IMAADPCMCUIInputFile       mapped;
+  struct IMAADPCMCUIOutputFile      output_file;
+  const void                        *input[IMAADPCM_MAX_NUM_CHANNELS];
+  uint32_t                          ch, data_offset;
   uint32_t                          num_channels, num_samples;
+  uint64_t                          buffer_size, output_size;
   uint8_t                           *buffer;
   struct IMAADPCMWAVEncodeParameter enc_param;
   struct IMAADPCMWAVEncoder         *encoder;
+  struct IMAADPCMInputLayout        layout;
   IMAADPCMApiResult                 api_result;
 
-  /* 入力wav取得 */
-  wavfile = WAV_CreateFromFile(wav_file);
-  if (wavfile == NULL) {
-    fprintf(stderr, "Failed to open %s. \n", wav_file);
-    return 1;
-  }
-
-  num_channels = wavfile->format.num_channels;
-  num_samples = wavfile->format.num_samples;
-
-  /* 出力データの領域割当て */
-  for (ch = 0; ch < num_channels; ch++) {
-    input[ch] = malloc(sizeof(int16_t) * num_samples);
-  }
-  /* 入力wavと同じサイズの出力領域を確保（増えることはないと期待） */
-  stat(wav_file, &fstat);
-  buffer_size = (uint32_t)fstat.st_size;
-  buffer = malloc(buffer_size);
-
-  /* 16bit幅でデータ取得 */
-  for (ch = 0; ch < num_channels; ch++) {
-    for (smpl = 0; smpl < num_samples; smpl++) {
-      input[ch][smpl] = (int16_t)(WAVFile_PCM(wavfile, smpl, ch) >> 16);
+  /* 16bit/32bitのWAVはマップしたPCMデータ（インターリーブ）から直接エンコード */
+  if ((map_input_file(wav_file, &mapped) == 0)
+      && (WAV_GetWAVFormatAndDataOffsetFromFile(wav_file, &wavformat, &data_offset) == WAV_APIRESULT_OK)
+      && ((wavformat.bits_per_sample == 16) || (wavformat.bits_per_sample == 32))
+      && (wavformat.num_channels <= IMAADPCM_MAX_NUM_CHANNELS)
+      && is_little_endian()
+      && ((data_offset % (wavformat.bits_per_sample / 8)) == 0)
+      && (data_offset <= mapped.size)
+      && ((mapped.size - data_offset) / (wavformat.bits_per_sample / 8) / wavformat.num_channels >= wavformat.num_samples)) {
+    layout.sample_format
+      = (wavformat.bits_per_sample == 16) ? IMAADPCM_SAMPLE_FORMAT_INT16 : IMAADPCM_SAMPLE_FORMAT_INT32;
+    layout.interleaved = 1;
+    input[0] = &mapped.data[data_offset];
+    prefetch_input_file(&mapped, data_offset, mapped.size - data_offset);
+  } else {
+    /* それ以外（パイプ含む）はWAVファイルのPCMバッファ（左詰めの32bit整数）から読み込む */
+    close_input_file(&mapped);
+    wavfile = WAV_CreateFromFile(wav_file);
+    if (wavfile == NULL) {
+      fprintf(stderr, "Failed to open %s. \n", wav_file);
+      return 1;
+    }
+    wavformat = wavfile->format;
+    if (wavformat.num_channels > IMAADPCM_MAX_NUM_CHANNELS) {
+      fprintf(stderr, "Unsupported number of channels: %d \n", wavformat.num_channels);
+      return 1;
+    }
+    layout.sample_format = IMAADPCM_SAMPLE_FORMAT_INT32;
+    layout.interleaved = 0;
+    for (ch = 0; ch < wavformat.num_channels; ch++) {
+      input[ch] = wavfile->data[ch];
     }
   }
 
-  /* ハンドル作成 */
-  encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  num_channels = wavformat.num_channels;
+  num_samples = wavformat.num_samples;
+
+  /* ハンドル作成（並列エンコードではタスク毎の領域を含める） */
+  encoder = parallel ? IMAADPCMWAVEncoder_CreateParallel(get_num_tasks(), NULL, 0) : IMAADPCMWAVEncoder_Create(NULL, 0);
 
   /* エンコードパラメータをセット */
   enc_param.num_channels    = (uint16_t)num_channels;
-  enc_param.sampling_rate   = wavfile->format.sampling_rate;
+  enc_param.sampling_rate   = wavformat.sampling_rate;
   enc_param.bits_per_sample = 4;
-  enc_param.block_size      = IMAADPCMCUI_BLOCK_SIZE;
+  enc_param.block_size      = (uint16_t)IMAADPCMCUI_CALCULATE_BLOCK_SIZE(num_channels);
   if ((api_result = IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param))
       != IMAADPCM_APIRESULT_OK) {
     fprintf(stderr, "Failed to set encode parameter. API result:%d \n", api_result);
     return 1;
   }
+  if ((api_result = IMAADPCMWAVEncoder_SetChannelMask(encoder, wavformat.channel_mask))
+      != IMAADPCM_APIRESULT_OK) {
+    fprintf(stderr, "Failed to set channel mask. API result:%d \n", api_result);
+    return 1;
+  }
+
+  /* エンコード結果ちょうどのサイズの出力領域を確保 */
+  if ((api_result = IMAADPCMWAVEncoder_CalculateOutputSize64(&enc_param, num_samples, &buffer_size))
+      != IMAADPCM_APIRESULT_OK) {
+    fprintf(stderr, "Failed to calculate output size. API result:%d \n", api_result);
+    return 1;
+  }
+  /* 出力ファイルをマップできればそこに直接書き出す */
+  if (map_output_file(encoded_filename, buffer_size, &output_file) == 0) {
+    buffer = output_file.data;
+  } else {
+    buffer = malloc((size_t)buffer_size);
+  }
 
   /* エンコード */
-  if ((api_result = IMAADPCMWAVEncoder_EncodeWhole(
-        encoder, (const int16_t *const *)input, num_samples,
-        buffer, buffer_size, &output_size)) != IMAADPCM_APIRESULT_OK) {
+  if (parallel) {
+    /* 並列にエンコード（出力はスレッド数によらない） */
+    api_result = IMAADPCMWAVEncoder_EncodeWholeParallelFromLayout64(
+        encoder, &layout, input, num_channels, num_samples,
+        buffer, buffer_size, &output_size,
+        get_num_tasks(), execute_tasks, NULL);
+  } else {
+    api_result = IMAADPCMWAVEncoder_EncodeWholeFromLayout64(
+        encoder, &layout, input, num_channels, num_samples,
+        buffer, buffer_size, &output_size);
+  }
+  if (api_result != IMAADPCM_APIRESULT_OK) {
     fprintf(stderr, "Failed to encode. API result:%d \n", api_result);
     return 1;
   }
 
   /* ファイル書き出し */
-  fp = fopen(encoded_filename, "wb");
-  if (fp == NULL) {
-    fprintf(stderr, "Failed to open output file %s \n", encoded_filename);
-    return 1;
-  }
-  if (fwrite(buffer, sizeof(uint8_t), output_size, fp) < output_size) {
-    fprintf(stderr, "Warning: failed to write encoded data \n");
-    return 1;
+  if (output_file.data != NULL) {
+    /* マップしていればエンコード結果のサイズに切り詰めるだけ */
+    if (unmap_output_file(&output_file, output_size) != 0) {
+      fprintf(stderr, "Warning: failed to write encoded data \n");
+      return 1;
+    }
+  } else {
+    fp = fopen(encoded_filename, "wb");
+    if (fp == NULL) {
+      fprintf(stderr, "Failed to open output file %s \n", encoded_filename);
+      return 1;
+    }
+    if (fwrite(buffer, sizeof(uint8_t), (size_t)output_size, fp) < output_size) {
+      fprintf(stderr, "Warning: failed to write encoded data \n");
+      return 1;
+    }
+    fclose(fp);
+    free(buffer);
   }
-  fclose(fp);
 
   /* 領域開放 */
   IMAADPCMWAVEncoder_Destroy(encoder);
-  free(buffer);
-  for (ch = 0; ch < num_channels; ch++) {
-    free(input[ch]);
+  close_input_file(&mapped);
+  if (wavfile != NULL) {
+    WAV_Destroy(wavfile);
   }
-  WAV_Destroy(wavfile);
 
   return 0;
 }
@@ -187,7 +540,6 @@ static int do_encode(const char *wav_file, const char *encoded_filename)
 static int do_residual_output(const char *wav_file, const char *residual_filename)
 {
   struct WAVFile                    *wavfile;
-  struct stat                       fstat;
   int16_t                           *pcmdata[IMAADPCM_MAX_NUM_CHANNELS];
   uint32_t                          ch, smpl, buffer_size, output_size;
   uint32_t                          num_channels, num_samples;
@@ -206,16 +558,15 @@ static int do_residual_output(const char *wav_file, const char *residual_filenam
 
   num_channels = wavfile->format.num_channels;
   num_samples = wavfile->format.num_samples;
+  if (num_channels > IMAADPCM_MAX_NUM_CHANNELS) {
+    fprintf(stderr, "Unsupported number of channels: %d \n", num_channels);
+    return 1;
+  }
 
   /* 出力データの領域割当て */
   for (ch = 0; ch < num_channels; ch++) {
     pcmdata[ch] = malloc(sizeof(int16_t) * num_samples);
   }
-  /* 入力wavと同じサイズの出力領域を確保（増えることはないと期待） */
-  stat(wav_file, &fstat);
-  buffer_size = (uint32_t)fstat.st_size;
-  buffer = malloc(buffer_size);
-
   /* 16bit幅でデータ取得 */
   for (ch = 0; ch < num_channels; ch++) {
     for (smpl = 0; smpl < num_samples; smpl++) {
@@ -231,13 +582,21 @@ static int do_residual_output(const char *wav_file, const char *residual_filenam
   enc_param.num_channels    = (uint16_t)num_channels;
   enc_param.sampling_rate   = wavfile->format.sampling_rate;
   enc_param.bits_per_sample = 4;
-  enc_param.block_size      = IMAADPCMCUI_BLOCK_SIZE;
+  enc_param.block_size      = (uint16_t)IMAADPCMCUI_CALCULATE_BLOCK_SIZE(num_channels);
   if ((api_result = IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param))
       != IMAADPCM_APIRESULT_OK) {
     fprintf(stderr, "Failed to set encode parameter. API result:%d \n", api_result);
     return 1;
   }
 
+  /* エンコード結果ちょうどのサイズの出力領域を確保 */
+  if ((api_result = IMAADPCMWAVEncoder_CalculateOutputSize(&enc_param, num_samples, &buffer_size))
+      != IMAADPCM_APIRESULT_OK) {
+    fprintf(stderr, "Failed to calculate output size. API result:%d \n", api_result);
+    return 1;
+  }
+  buffer = malloc(buffer_size);
+
   /* エンコード */
   if ((api_result = IMAADPCMWAVEncoder_EncodeWhole(
         encoder, (const int16_t *const *)pcmdata, num_samples,
@@ -281,8 +640,9 @@ static void print_usage(const char* program_name)
 {
   printf(
       "IMA-ADPCM encoder/decoder Version." IMAADPCMCUI_VERSION_STRING "\n" \
-      "Usage: %s -[edr] INPUT.wav OUTPUT.wav \n" \
+      "Usage: %s -[e|ep|d|r] INPUT.wav OUTPUT.wav \n" \
       "-e: encode mode (PCM wav -> IMA-ADPCM wav)\n" \
+      "-ep: parallel encode mode (output may differ from -e)\n" \
       "-d: decode mode (IMA-ADPCM wav -> PCM wav)\n" \
       "-r: output residual (PCM wav -> Residual PCM wav)\n", 
       program_name);
@@ -313,8 +673,10 @@ int main(int argc, char **argv)
   }
   
   /* エンコード/デコード呼び分け */
-  if (strncmp(option, "-e", 2) == 0) {
-    ret = do_encode(in_filename, out_filename);
+  if (strncmp(option, "-ep", 3) == 0) {
+    ret = do_encode(in_filename, out_filename, 1);
+  } else if (strncmp(option, "-e", 2) == 0) {
+    ret = do_encode(in_filename, out_filename, 0);
   } else if (strncmp(option, "-d", 2) == 0) {
     ret = do_decode(in_filename, out_filename);
   } else if (strncmp(option, "-r", 2) == 0) {
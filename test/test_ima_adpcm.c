@@ -43,6 +43,7 @@ static void testIMAADPCM_HeaderEncodeDecodeTest(void *obj)
   header__p->num_samples_per_block  = 505;                            \
   header__p->num_samples            = 1024;                           \
   header__p->header_size            = IMAADPCMWAVENCODER_HEADER_SIZE; \
+  header__p->channel_mask           = 0;                              \
 }
 
   /* 成功例 */
@@ -84,7 +85,7 @@ static void testIMAADPCM_HeaderEncodeDecodeTest(void *obj)
 
     /* チャンネル数異常 */
     IMAADPCM_SetValidHeader(&header);
-    header.num_channels = 3;
+    header.num_channels = IMAADPCM_MAX_NUM_CHANNELS + 1;
     Test_AssertEqual(IMAADPCMWAVEncoder_EncodeHeader(&header, data, sizeof(data)), IMAADPCM_APIRESULT_INVALID_FORMAT);
 
     /* ビット深度異常 */
@@ -160,6 +161,9 @@ static void testIMAADPCMWAVDecoder_CreateDestroyTest(void *obj)
 
     work_size = IMAADPCMWAVDecoder_CalculateWorkSize();
     Test_AssertCondition(work_size >= (int32_t)sizeof(struct IMAADPCMWAVDecoder));
+
+    /* ストリーミング用は1ブロック分の一時バッファだけ大きい */
+    Test_AssertCondition(IMAADPCMWAVDecoder_CalculateStreamWorkSize() >= (work_size + IMAADPCM_MAX_BLOCK_SIZE));
   }
 
   /* ワーク領域渡しによるハンドル作成（成功例） */
@@ -174,6 +178,19 @@ static void testIMAADPCMWAVDecoder_CreateDestroyTest(void *obj)
     decoder = IMAADPCMWAVDecoder_Create(work, work_size);
     Test_AssertCondition(decoder != NULL);
     Test_AssertCondition(decoder->work == NULL);
+    Test_AssertCondition(decoder->stream.buffer == NULL);
+
+    IMAADPCMWAVDecoder_Destroy(decoder);
+    free(work);
+
+    /* ストリーミング用 */
+    work_size = IMAADPCMWAVDecoder_CalculateStreamWorkSize();
+    work = malloc(work_size);
+
+    decoder = IMAADPCMWAVDecoder_CreateStream(work, work_size);
+    Test_AssertCondition(decoder != NULL);
+    Test_AssertCondition(decoder->work == NULL);
+    Test_AssertCondition(decoder->stream.buffer != NULL);
 
     IMAADPCMWAVDecoder_Destroy(decoder);
     free(work);
@@ -208,11 +225,124 @@ static void testIMAADPCMWAVDecoder_CreateDestroyTest(void *obj)
     /* ワークサイズ不足 */
     decoder = IMAADPCMWAVDecoder_Create(work, work_size - 1);
     Test_AssertCondition(decoder == NULL);
+    decoder = IMAADPCMWAVDecoder_CreateStream(work, work_size);
+    Test_AssertCondition(decoder == NULL);
 
     free(work);
   }
 }
 
+/* 状態遷移テーブルテスト */
+static void testIMAADPCMCoreDecoder_TransitionTableTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 全インデックス・全ニブルについて演算による結果と一致するか */
+  {
+    int32_t idx, nibble, is_ok;
+
+    is_ok = 1;
+    for (idx = 0; idx <= 88; idx++) {
+      for (nibble = 0; nibble < 16; nibble++) {
+        const int32_t transition = IMAADPCM_transition_table[idx][nibble];
+        int32_t qdiff = (IMAADPCM_stepsize_table[idx] * (((nibble & 7) << 1) + 1)) >> 3;
+        int32_t next_idx = IMAADPCM_INNER_VAL(idx + IMAADPCM_index_table[nibble], 0, 88);
+        if (nibble & 8) {
+          qdiff = -qdiff;
+        }
+        if (((transition >> 8) != qdiff) || ((transition & 0xFF) != next_idx)) {
+          is_ok = 0;
+        }
+      }
+    }
+    Test_AssertEqual(is_ok, 1);
+  }
+}
+
+/* バイト単位デコードテスト */
+static void testIMAADPCMWAVDecoder_ByteDecodeTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 全インデックス・全バイトについて1ニブルずつ遷移させた結果と一致するか */
+  {
+    int32_t idx, byte, is_ok;
+    struct IMAADPCMWAVDecoder *decoder;
+
+    decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+
+    is_ok = 1;
+    for (idx = 0; idx <= 88; idx++) {
+      for (byte = 0; byte < 256; byte++) {
+        const int32_t first = IMAADPCM_transition_table[idx][byte & 0xF];
+        const int32_t second = IMAADPCM_transition_table[first & 0xFF][byte >> 4];
+        if (IMAADPCM_byte_transition_table[idx][byte] != second) {
+          is_ok = 0;
+        }
+      }
+    }
+    Test_AssertEqual(is_ok, 1);
+
+    IMAADPCMWAVDecoder_Destroy(decoder);
+  }
+
+  /* クリップが頻発するブロックで1ニブルずつのデコード結果と一致するか */
+  {
+#define BLOCK_SIZE 256
+    uint8_t data[BLOCK_SIZE];
+    int16_t output[BLOCK_SIZE * 2], reference[BLOCK_SIZE * 2];
+    int16_t *buffer[1];
+    uint32_t i, trial, num_decode_samples, num_samples_per_block, is_ok;
+    struct IMAADPCMWAVDecoder *decoder;
+    struct IMAADPCMCoreDecoder core_decoder;
+    const int16_t head_samples[] = { 0, 32767, -32768, 30000, -30000 };
+
+    decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+    decoder->header.num_channels = 1;
+    num_samples_per_block = (BLOCK_SIZE - 4) * 2 + 1;
+    buffer[0] = output;
+
+    is_ok = 1;
+    srand(0);
+    for (trial = 0; trial < 256; trial++) {
+      const int16_t head_sample = head_samples[trial % (sizeof(head_samples) / sizeof(head_samples[0]))];
+      for (i = 0; i < BLOCK_SIZE; i++) {
+        data[i] = (uint8_t)(rand() & 0xFF);
+      }
+      data[0] = (uint8_t)(head_sample & 0xFF);
+      data[1] = (uint8_t)((head_sample >> 8) & 0xFF);
+      data[2] = (uint8_t)(trial % 89);
+      data[3] = 0;
+
+      if (IMAADPCMWAVDecoder_DecodeBlock(decoder, data, BLOCK_SIZE,
+            buffer, 1, BLOCK_SIZE * 2, &num_decode_samples) != IMAADPCM_APIRESULT_OK) {
+        is_ok = 0;
+        break;
+      }
+
+      /* 1ニブルずつデコード */
+      core_decoder.sample_val = head_sample;
+      core_decoder.stepsize_index = (int8_t)data[2];
+      reference[0] = head_sample;
+      for (i = 1; i < num_samples_per_block; i++) {
+        const uint8_t byte = data[4 + (i - 1) / 2];
+        reference[i] = IMAADPCMCoreDecoder_DecodeSample(&core_decoder,
+            (uint8_t)(((i - 1) % 2 == 0) ? (byte & 0xF) : (byte >> 4)));
+      }
+
+      if ((num_decode_samples != num_samples_per_block)
+          || (memcmp(output, reference, sizeof(int16_t) * num_samples_per_block) != 0)) {
+        is_ok = 0;
+        break;
+      }
+    }
+    Test_AssertEqual(is_ok, 1);
+
+    IMAADPCMWAVDecoder_Destroy(decoder);
+#undef BLOCK_SIZE
+  }
+}
+
 /* デコード結果が一致するか確認するサブルーチン 一致していたら1, していなければ0を返す */
 static uint8_t testIMAADPCMDecoder_CheckDecodeResult(const char *adpcm_filename, const char *decodedwav_filename)
 {
@@ -367,346 +497,3843 @@ static void testIMAADPCMWAVDecoder_DecodeTest(void *obj)
   }
 }
 
-/* エンコードハンドル作成破棄テスト */
-static void testIMAADPCMWAVEncoder_CreateDestroyTest(void *obj)
+/* 複数ブロック同時デコードテスト 1ブロックずつデコードした結果と一致すれば1を返す */
+static uint8_t testIMAADPCMWAVDecoder_CheckDecodeBlocks(
+    IMAADPCMDecodeBlocksFunction decode_blocks, uint16_t num_channels, uint16_t block_size)
 {
-  TEST_UNUSED_PARAMETER(obj);
+  uint8_t *data;
+  uint32_t ch, blk, smpl, is_ok, num_samples_per_block, num_decode_samples;
+  int16_t *simd_output[IMAADPCM_MAX_NUM_CHANNELS];
+  int16_t *scalar_output[IMAADPCM_MAX_NUM_CHANNELS];
+  int16_t *buffer_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+  struct IMAADPCMWAVDecoder *decoder;
 
-  /* ワークサイズ計算テスト */
-  {
-    int32_t work_size;
+  num_samples_per_block = ((block_size - 4 * num_channels) * 2) / num_channels + 1;
 
-    work_size = IMAADPCMWAVEncoder_CalculateWorkSize();
-    Test_AssertCondition(work_size >= (int32_t)sizeof(struct IMAADPCMWAVEncoder));
+  /* 乱数でブロックを作成（ヘッダは有効な値にする） */
+  data = (uint8_t *)malloc(block_size * IMAADPCM_NUM_SIMD_LANES);
+  srand(0);
+  for (smpl = 0; smpl < block_size * IMAADPCM_NUM_SIMD_LANES; smpl++) {
+    data[smpl] = (uint8_t)(rand() & 0xFF);
+  }
+  for (blk = 0; blk < IMAADPCM_NUM_SIMD_LANES; blk++) {
+    for (ch = 0; ch < num_channels; ch++) {
+      data[blk * block_size + 4 * ch + 2] = (uint8_t)(rand() % 89);
+      data[blk * block_size + 4 * ch + 3] = 0;
+    }
   }
 
-  /* ワーク領域渡しによるハンドル作成（成功例） */
-  {
-    void *work;
-    int32_t work_size;
-    struct IMAADPCMWAVEncoder *encoder;
+  for (ch = 0; ch < num_channels; ch++) {
+    simd_output[ch] = malloc(sizeof(int16_t) * num_samples_per_block * IMAADPCM_NUM_SIMD_LANES);
+    scalar_output[ch] = malloc(sizeof(int16_t) * num_samples_per_block * IMAADPCM_NUM_SIMD_LANES);
+  }
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+  decoder->header.num_channels = num_channels;
 
-    work_size = IMAADPCMWAVEncoder_CalculateWorkSize();
-    work = malloc(work_size);
+  /* 同時デコード */
+  decode_blocks(data, block_size, num_channels, num_samples_per_block, simd_output);
 
-    encoder = IMAADPCMWAVEncoder_Create(work, work_size);
-    Test_AssertCondition(encoder != NULL);
-    Test_AssertCondition(encoder->work == NULL);
-    Test_AssertCondition(encoder->set_parameter == 0);
+  /* 1ブロックずつデコード */
+  for (blk = 0; blk < IMAADPCM_NUM_SIMD_LANES; blk++) {
+    for (ch = 0; ch < num_channels; ch++) {
+      buffer_ptr[ch] = &scalar_output[ch][blk * num_samples_per_block];
+    }
+    if (IMAADPCMWAVDecoder_DecodeBlock(decoder, &data[blk * block_size], block_size,
+          buffer_ptr, num_channels, num_samples_per_block, &num_decode_samples) != IMAADPCM_APIRESULT_OK) {
+      is_ok = 0;
+      goto CHECK_END;
+    }
+  }
 
-    IMAADPCMWAVEncoder_Destroy(encoder);
-    free(work);
+  /* 一致確認 */
+  is_ok = 1;
+  for (ch = 0; ch < num_channels; ch++) {
+    if (memcmp(simd_output[ch], scalar_output[ch],
+          sizeof(int16_t) * num_samples_per_block * IMAADPCM_NUM_SIMD_LANES) != 0) {
+      is_ok = 0;
+      break;
+    }
   }
 
-  /* 自前確保によるハンドル作成（成功例） */
-  {
-    struct IMAADPCMWAVEncoder *encoder;
+CHECK_END:
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(simd_output[ch]);
+    free(scalar_output[ch]);
+  }
+  free(data);
 
-    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
-    Test_AssertCondition(encoder != NULL);
-    Test_AssertCondition(encoder->work != NULL);
+  return is_ok;
+}
 
-    IMAADPCMWAVEncoder_Destroy(encoder);
-  }
+/* 複数ブロック同時デコードテスト */
+static void testIMAADPCMWAVDecoder_DecodeBlocksSIMDTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
 
-  /* ワーク領域渡しによるハンドル作成（失敗ケース） */
+  /* ブロックヘッダチェック */
   {
-    void *work;
-    int32_t work_size;
-    struct IMAADPCMWAVEncoder *encoder;
-
-    work_size = IMAADPCMWAVEncoder_CalculateWorkSize();
-    work = malloc(work_size);
+    uint8_t data[2 * 256] = { 0, };
+    Test_AssertEqual(IMAADPCMWAVDecoder_CheckBlockHeaders(data, 256, 2, 2), 1);
+    data[256 + 4 + 2] = 89;
+    Test_AssertEqual(IMAADPCMWAVDecoder_CheckBlockHeaders(data, 256, 2, 2), 0);
+    data[256 + 4 + 2] = 88;
+    data[256 + 4 + 3] = 1;
+    Test_AssertEqual(IMAADPCMWAVDecoder_CheckBlockHeaders(data, 256, 2, 2), 0);
+  }
 
-    /* 引数が不正 */
-    encoder = IMAADPCMWAVEncoder_Create(NULL, work_size);
-    Test_AssertCondition(encoder == NULL);
-    encoder = IMAADPCMWAVEncoder_Create(work, 0);
-    Test_AssertCondition(encoder == NULL);
+#if defined(IMAADPCM_USE_X86_SIMD)
+  {
+    const uint32_t cpu_features = IMAADPCM_GetCPUFeatures();
 
-    /* ワークサイズ不足 */
-    encoder = IMAADPCMWAVEncoder_Create(work, work_size - 1);
-    Test_AssertCondition(encoder == NULL);
+    /* SSE4.1 */
+    if (cpu_features & IMAADPCM_CPU_FEATURE_SSE41) {
+      Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeBlocks(IMAADPCMWAVDecoder_DecodeBlocksSSE41, 1,  256), 1);
+      Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeBlocks(IMAADPCMWAVDecoder_DecodeBlocksSSE41, 1, 1024), 1);
+      Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeBlocks(IMAADPCMWAVDecoder_DecodeBlocksSSE41, 2,  256), 1);
+      Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeBlocks(IMAADPCMWAVDecoder_DecodeBlocksSSE41, 2, 1024), 1);
+    }
 
-    free(work);
+    /* AVX2 */
+    if (cpu_features & IMAADPCM_CPU_FEATURE_AVX2) {
+      Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeBlocks(IMAADPCMWAVDecoder_DecodeBlocksAVX2, 1,  256), 1);
+      Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeBlocks(IMAADPCMWAVDecoder_DecodeBlocksAVX2, 1, 1024), 1);
+      Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeBlocks(IMAADPCMWAVDecoder_DecodeBlocksAVX2, 2,  256), 1);
+      Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeBlocks(IMAADPCMWAVDecoder_DecodeBlocksAVX2, 2, 1024), 1);
+    }
   }
+#endif
 }
 
-/* エンコードパラメータ設定テスト */
-static void testIMAADPCMWAVEncoder_SetEncodeParameterTest(void *obj)
+/* カーネル設定テスト */
+static void testIMAADPCM_SetKernelTest(void *obj)
 {
   TEST_UNUSED_PARAMETER(obj);
 
-  /* 有効なパラメータをセット */
-#define IMAADPCM_SetValidParameter(p_param) {               \
-    struct IMAADPCMWAVEncodeParameter *p__param = p_param;  \
-    p__param->num_channels    = 1;                          \
-    p__param->sampling_rate   = 8000;                       \
-    p__param->bits_per_sample = IMAADPCM_BITS_PER_SAMPLE;   \
-    p__param->block_size      = 256;                        \
-}
-
-  /* 成功例 */
+  /* 設定と取得 */
   {
+    struct IMAADPCMWAVDecoder *decoder;
     struct IMAADPCMWAVEncoder *encoder;
-    struct IMAADPCMWAVEncodeParameter param;
 
+    decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
     encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
-    
-    IMAADPCM_SetValidParameter(&param);
-    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &param), IMAADPCM_APIRESULT_OK);
-    Test_AssertEqual(encoder->set_parameter, 1);
-    Test_AssertEqual(memcmp(&(encoder->encode_paramemter), &param, sizeof(struct IMAADPCMWAVEncodeParameter)), 0);
 
+    /* スカラ処理はどこでも設定できる */
+    Test_AssertEqual(IMAADPCMWAVDecoder_SetKernel(decoder, IMAADPCM_KERNEL_SCALAR), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVDecoder_GetKernel(decoder), IMAADPCM_KERNEL_SCALAR);
+    Test_AssertCondition(decoder->functions.decode_blocks[0] == NULL);
+    Test_AssertCondition(decoder->functions.decode_blocks[1] == NULL);
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetKernel(encoder, IMAADPCM_KERNEL_SCALAR), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVEncoder_GetKernel(encoder), IMAADPCM_KERNEL_SCALAR);
+
+    /* AUTOはどこでも設定できる */
+    Test_AssertEqual(IMAADPCMWAVDecoder_SetKernel(decoder, IMAADPCM_KERNEL_AUTO), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVDecoder_GetKernel(decoder), IMAADPCM_KERNEL_AUTO);
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetKernel(encoder, IMAADPCM_KERNEL_AUTO), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVEncoder_GetKernel(encoder), IMAADPCM_KERNEL_AUTO);
+
+    /* 不正な引数 */
+    Test_AssertEqual(IMAADPCMWAVDecoder_SetKernel(NULL, IMAADPCM_KERNEL_SCALAR), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_SetKernel(decoder, (IMAADPCMKernel)100), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetKernel(NULL, IMAADPCM_KERNEL_SCALAR), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetKernel(encoder, (IMAADPCMKernel)100), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+
+    IMAADPCMWAVDecoder_Destroy(decoder);
     IMAADPCMWAVEncoder_Destroy(encoder);
   }
 
-  /* 失敗ケース */
+  /* 使用可能な全カーネルでデコード結果がスカラ処理と一致するか */
   {
+#define NUM_CHANNELS 2
+#define NUM_SAMPLES  (8 * 1017 + 100)
+    uint32_t ch, smpl, output_size, is_ok;
+    int32_t kernel;
+    int16_t *input[NUM_CHANNELS], *reference[NUM_CHANNELS], *output[NUM_CHANNELS];
+    uint8_t *data;
+    const uint32_t data_size = NUM_SAMPLES * NUM_CHANNELS;
+    struct IMAADPCMWAVDecoder *decoder;
     struct IMAADPCMWAVEncoder *encoder;
-    struct IMAADPCMWAVEncodeParameter param;
+    struct IMAADPCMWAVEncodeParameter enc_param;
 
-    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    srand(0);
+    for (ch = 0; ch < NUM_CHANNELS; ch++) {
+      input[ch] = malloc(sizeof(int16_t) * NUM_SAMPLES);
+      reference[ch] = malloc(sizeof(int16_t) * NUM_SAMPLES);
+      output[ch] = malloc(sizeof(int16_t) * NUM_SAMPLES);
+      for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+        input[ch][smpl] = (int16_t)(8000.0 * sin(0.01 * smpl * (ch + 1)) + (rand() % 512) - 256);
+      }
+    }
+    data = malloc(data_size);
 
-    /* 引数が不正 */
-    IMAADPCM_SetValidParameter(&param);
-    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(NULL,  &param), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
-    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+    enc_param.num_channels = NUM_CHANNELS;
+    enc_param.sampling_rate = 44100;
+    enc_param.bits_per_sample = 4;
+    enc_param.block_size = 1024;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWhole(encoder,
+          (const int16_t *const *)input, NUM_SAMPLES, data, data_size, &output_size), IMAADPCM_APIRESULT_OK);
 
-    /* サンプルあたりビット数が異常 */
-    IMAADPCM_SetValidParameter(&param);
-    param.bits_per_sample = 0;
-    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &param), IMAADPCM_APIRESULT_INVALID_FORMAT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_SetKernel(decoder, IMAADPCM_KERNEL_SCALAR), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeWhole(decoder,
+          data, output_size, reference, NUM_CHANNELS, NUM_SAMPLES), IMAADPCM_APIRESULT_OK);
 
-    /* ブロックサイズが小さすぎる */
-    IMAADPCM_SetValidParameter(&param);
-    param.block_size = 0;
-    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &param), IMAADPCM_APIRESULT_INVALID_FORMAT);
-    IMAADPCM_SetValidParameter(&param);
-    param.block_size = param.num_channels * 4;
-    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &param), IMAADPCM_APIRESULT_INVALID_FORMAT);
+    is_ok = 1;
+    for (kernel = IMAADPCM_KERNEL_AUTO; kernel <= IMAADPCM_KERNEL_AVX2; kernel++) {
+      if (IMAADPCMWAVDecoder_SetKernel(decoder, (IMAADPCMKernel)kernel) != IMAADPCM_APIRESULT_OK) {
+        /* 実行中のCPUで使えない */
+        continue;
+      }
+      if (IMAADPCMWAVDecoder_DecodeWhole(decoder,
+            data, output_size, output, NUM_CHANNELS, NUM_SAMPLES) != IMAADPCM_APIRESULT_OK) {
+        is_ok = 0;
+        break;
+      }
+      for (ch = 0; ch < NUM_CHANNELS; ch++) {
+        if (memcmp(output[ch], reference[ch], sizeof(int16_t) * NUM_SAMPLES) != 0) {
+          is_ok = 0;
+        }
+      }
+    }
+    Test_AssertEqual(is_ok, 1);
 
+    IMAADPCMWAVDecoder_Destroy(decoder);
     IMAADPCMWAVEncoder_Destroy(encoder);
+    free(data);
+    for (ch = 0; ch < NUM_CHANNELS; ch++) {
+      free(input[ch]);
+      free(reference[ch]);
+      free(output[ch]);
+    }
+#undef NUM_CHANNELS
+#undef NUM_SAMPLES
   }
 }
 
-/* エンコード→デコードテスト 成功時は1, 失敗時は0を返す */
-static uint8_t testIMAADPCMWAVEncoder_EncodeDecodeTest(
-    const char *wav_filename, uint16_t bits_per_sample, uint16_t block_size, double rms_epsilon)
+/* タスクを逆順に実行する（タスク間の依存がないことの確認用） */
+static void testIMAADPCMWAVDecoder_ExecuteTasksReverse(
+    void *executor_context, IMAADPCMTaskFunction task_function, void *task_context, uint32_t num_tasks)
 {
-  struct WAVFile *wavfile;
-  struct stat fstat;
-  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS];
-  int16_t *decoded[IMAADPCM_MAX_NUM_CHANNELS];
-  uint8_t is_ok;
-  uint32_t ch, smpl, buffer_size, output_size;
-  uint32_t num_channels, num_samples;
-  uint8_t *buffer;
-  double rms_error;
-  struct IMAADPCMWAVEncodeParameter enc_param;
-  struct IMAADPCMWAVEncoder *encoder;
-  struct IMAADPCMWAVDecoder *decoder;
+  uint32_t i;
 
-  assert((wav_filename != NULL) && (rms_epsilon >= 0.0f));
+  (*(uint32_t *)executor_context) += num_tasks;
+  for (i = num_tasks; i > 0; i--) {
+    task_function(task_context, i - 1);
+  }
+}
 
-  /* 入力wav取得 */
-  wavfile = WAV_CreateFromFile(wav_filename);
-  assert(wavfile != NULL);
-  num_channels = wavfile->format.num_channels;
-  num_samples = wavfile->format.num_samples;
+/* 正弦波に雑音を加えた入力を作成する 領域はチャンネル毎に確保する */
+static void testIMAADPCM_CreateSineNoiseInput(
+    uint16_t num_channels, uint32_t num_samples, int16_t **input)
+{
+  uint32_t ch, smpl;
 
-  /* 出力データの領域割当て */
+  srand(0);
   for (ch = 0; ch < num_channels; ch++) {
-    input[ch]   = malloc(sizeof(int16_t) * num_samples);
-    decoded[ch] = malloc(sizeof(int16_t) * num_samples);
+    input[ch] = malloc(sizeof(int16_t) * num_samples);
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      input[ch][smpl] = (int16_t)(8000.0 * sin(0.003 * smpl * (ch + 1)) + (rand() % 1024) - 512);
+    }
   }
-  /* 入力wavと同じサイズの出力領域を確保（増えることはないと期待） */
-  stat(wav_filename, &fstat);
-  buffer_size = fstat.st_size;
-  buffer = malloc(buffer_size);
+}
 
-  /* 16bit幅でデータ取得 */
+/* 正弦波に雑音を加えた入力をエンコードし、その一括デコード結果を参照として作成する 成功したら1, 失敗したら0を返す */
+/* 入力・データ・参照の領域は失敗時も確保されるため、呼び出し側で解放する */
+static uint8_t testIMAADPCM_CreateEncodedFixture(
+    uint16_t num_channels, uint32_t num_samples, uint16_t block_size,
+    int16_t **input, uint8_t **data, uint32_t *data_size, int16_t **reference)
+{
+  uint32_t ch;
+  uint8_t is_ok = 0;
+  const uint32_t buffer_size = 2 * num_samples * num_channels + block_size;
+  struct IMAADPCMWAVEncoder *encoder;
+  struct IMAADPCMWAVDecoder *decoder;
+  struct IMAADPCMWAVEncodeParameter enc_param;
+
+  testIMAADPCM_CreateSineNoiseInput(num_channels, num_samples, input);
   for (ch = 0; ch < num_channels; ch++) {
-    for (smpl = 0; smpl < num_samples; smpl++) {
-      input[ch][smpl] = WAVFile_PCM(wavfile, smpl, ch) >> 16;
-    }
+    reference[ch] = malloc(sizeof(int16_t) * num_samples);
   }
+  *data = malloc(buffer_size);
 
-  /* ハンドル作成 */
   encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
   decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+  enc_param.num_channels = num_channels;
+  enc_param.sampling_rate = 44100;
+  enc_param.bits_per_sample = 4;
+  enc_param.block_size = block_size;
 
-  /* エンコードパラメータをセット */
-  enc_param.num_channels    = num_channels;
-  enc_param.sampling_rate   = wavfile->format.sampling_rate;
-  enc_param.bits_per_sample = bits_per_sample;
-  enc_param.block_size      = block_size;
-  if (IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK) {
-    is_ok = 0;
+  if ((IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_EncodeWhole(encoder,
+          (const int16_t *const *)input, num_samples, *data, buffer_size, data_size) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVDecoder_DecodeWhole(decoder,
+          *data, *data_size, reference, num_channels, num_samples) != IMAADPCM_APIRESULT_OK)) {
     goto CHECK_END;
   }
 
-  /* エンコード */
-  if (IMAADPCMWAVEncoder_EncodeWhole(
-        encoder, (const int16_t *const *)input, num_samples,
-        buffer, buffer_size, &output_size) != IMAADPCM_APIRESULT_OK) {
-    is_ok = 0;
-    goto CHECK_END;
-  }
-  /* 半分以下にはなるはず */
-  if (output_size >= (buffer_size / 2)) {
-    is_ok = 0;
-    goto CHECK_END;
-  }
+  is_ok = 1;
 
-  /* デコード */
-  if (IMAADPCMWAVDecoder_DecodeWhole(
-        decoder, buffer, output_size,
-        decoded, num_channels, num_samples) != IMAADPCM_APIRESULT_OK) {
-    is_ok = 0;
+CHECK_END:
+  IMAADPCMWAVEncoder_Destroy(encoder);
+  IMAADPCMWAVDecoder_Destroy(decoder);
+
+  return is_ok;
+}
+
+/* 並列デコードの結果が逐次デコードと一致するか確認するサブルーチン 一致していたら1, していなければ0を返す */
+static uint8_t testIMAADPCMWAVDecoder_CheckDecodeParallel(
+    uint16_t num_channels, uint16_t block_size, uint32_t num_samples, uint32_t num_tasks)
+{
+  uint32_t ch, output_size, is_ok, num_executed_tasks;
+  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS], *reference[IMAADPCM_MAX_NUM_CHANNELS], *output[IMAADPCM_MAX_NUM_CHANNELS];
+  uint8_t *data;
+  struct IMAADPCMWAVDecoder *decoder, *serial_decoder;
+
+  for (ch = 0; ch < num_channels; ch++) {
+    output[ch] = malloc(sizeof(int16_t) * num_samples);
+  }
+  decoder = IMAADPCMWAVDecoder_CreateParallel(IMAADPCM_MIN_VAL(num_tasks, IMAADPCM_MAX_NUM_TASKS), NULL, 0);
+  serial_decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+
+  is_ok = 0;
+  if (testIMAADPCM_CreateEncodedFixture(num_channels, num_samples, block_size,
+        input, &data, &output_size, reference) != 1) {
     goto CHECK_END;
   }
 
-  /* ロスがあるのでRMSE基準でチェック */
-  rms_error = 0.0;
+  /* 呼び出しスレッドで順に実行 */
+  if (IMAADPCMWAVDecoder_DecodeWholeParallel(decoder,
+        data, output_size, output, num_channels, num_samples, num_tasks, NULL, NULL) != IMAADPCM_APIRESULT_OK) {
+    goto CHECK_END;
+  }
   for (ch = 0; ch < num_channels; ch++) {
-    for (smpl = 0; smpl < num_samples; smpl++) {
-      double pcm1, pcm2, abs_error;
-      pcm1 = (double)input[ch][smpl] / INT16_MAX;
-      pcm2 = (double)decoded[ch][smpl] / INT16_MAX;
-      abs_error = fabs(pcm1 - pcm2);
-      rms_error += abs_error * abs_error;
+    if (memcmp(output[ch], reference[ch], sizeof(int16_t) * num_samples) != 0) {
+      goto CHECK_END;
     }
   }
-  rms_error = sqrt(rms_error / (num_samples * num_channels));
 
-  /* マージンチェック */
-  if (rms_error < rms_epsilon) {
-    is_ok = 1;
-  } else {
-    is_ok = 0;
+  /* 逆順に実行 */
+  num_executed_tasks = 0;
+  memset(output[0], 0, sizeof(int16_t) * num_samples);
+  if (IMAADPCMWAVDecoder_DecodeWholeParallel(decoder,
+        data, output_size, output, num_channels, num_samples, num_tasks,
+        testIMAADPCMWAVDecoder_ExecuteTasksReverse, &num_executed_tasks) != IMAADPCM_APIRESULT_OK) {
+    goto CHECK_END;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    if (memcmp(output[ch], reference[ch], sizeof(int16_t) * num_samples) != 0) {
+      goto CHECK_END;
+    }
+  }
+
+  /* タスク数はブロック数と最大タスク数で制限される */
+  if ((num_executed_tasks > num_tasks) || (num_executed_tasks > IMAADPCM_MAX_NUM_TASKS)) {
+    goto CHECK_END;
+  }
+
+  /* タスク毎の領域が無いハンドルでは呼び出しスレッドで逐次デコード */
+  num_executed_tasks = 0;
+  memset(output[0], 0, sizeof(int16_t) * num_samples);
+  if (IMAADPCMWAVDecoder_DecodeWholeParallel(serial_decoder,
+        data, output_size, output, num_channels, num_samples, num_tasks,
+        testIMAADPCMWAVDecoder_ExecuteTasksReverse, &num_executed_tasks) != IMAADPCM_APIRESULT_OK) {
+    goto CHECK_END;
+  }
+  if (num_executed_tasks != 0) {
+    goto CHECK_END;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    if (memcmp(output[ch], reference[ch], sizeof(int16_t) * num_samples) != 0) {
+      goto CHECK_END;
+    }
   }
 
+  is_ok = 1;
+
 CHECK_END:
-  /* 領域開放 */
-  IMAADPCMWAVEncoder_Destroy(encoder);
   IMAADPCMWAVDecoder_Destroy(decoder);
-  free(buffer);
+  IMAADPCMWAVDecoder_Destroy(serial_decoder);
+  free(data);
   for (ch = 0; ch < num_channels; ch++) {
     free(input[ch]);
-    free(decoded[ch]);
+    free(reference[ch]);
+    free(output[ch]);
   }
 
   return is_ok;
 }
 
-/* エンコードテスト */
-static void testIMAADPCMWAVDecoder_EncodeTest(void *obj)
+/* 並列デコードテスト */
+static void testIMAADPCMWAVDecoder_DecodeParallelTest(void *obj)
 {
   TEST_UNUSED_PARAMETER(obj);
 
-  /* 簡単なデータをエンコード→デコードしてみる */
+  /* ワークサイズ計算・ハンドル作成 */
   {
-#define NUM_CHANNELS  1
-#define NUM_SAMPLES   1024
-    int16_t *input[IMAADPCM_MAX_NUM_CHANNELS];
-    int16_t *decoded[IMAADPCM_MAX_NUM_CHANNELS];
-    uint32_t ch, smpl, buffer_size, output_size;
-    uint8_t *buffer;
-    double rms_error;
-    struct IMAADPCMWAVEncodeParameter enc_param;
-    struct IMAADPCMWAVEncoder *encoder;
+    void *work;
+    int32_t work_size;
     struct IMAADPCMWAVDecoder *decoder;
 
-    /* 出力データの領域割当て */
-    for (ch = 0; ch < NUM_CHANNELS; ch++) {
-      input[ch] = malloc(sizeof(int16_t) * NUM_SAMPLES);
-      decoded[ch] = malloc(sizeof(int16_t) * NUM_SAMPLES);
-    }
-    /* 入力wavと同じサイズの出力領域を確保（増えることはないと期待） */
-    buffer_size = NUM_CHANNELS * NUM_SAMPLES * sizeof(int16_t);
-    buffer = malloc(buffer_size);
+    /* タスク数が不正 */
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateParallelWorkSize(0), -1);
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateParallelWorkSize(IMAADPCM_MAX_NUM_TASKS + 1), -1);
+    Test_AssertCondition(IMAADPCMWAVDecoder_CreateParallel(0, NULL, 0) == NULL);
+    Test_AssertCondition(IMAADPCMWAVDecoder_CreateParallel(IMAADPCM_MAX_NUM_TASKS + 1, NULL, 0) == NULL);
 
-    /* データ作成: 正弦波 */
-    for (ch = 0; ch < NUM_CHANNELS; ch++) {
-      for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
-        input[ch][smpl] = (int16_t)(INT16_MAX * sin((2.0 * 3.1415 * 440.0 * smpl) / 48000.0));
+    /* タスク毎の領域の分だけ大きい */
+    work_size = IMAADPCMWAVDecoder_CalculateParallelWorkSize(4);
+    Test_AssertCondition(work_size > IMAADPCMWAVDecoder_CalculateParallelWorkSize(3));
+    Test_AssertCondition(IMAADPCMWAVDecoder_CalculateParallelWorkSize(1) > IMAADPCMWAVDecoder_CalculateWorkSize());
+    Test_AssertCondition(IMAADPCMWAVDecoder_CalculateParallelWorkSize(IMAADPCM_MAX_NUM_TASKS) > 0);
+
+    /* ワーク領域渡し */
+    work = malloc(work_size);
+    decoder = IMAADPCMWAVDecoder_CreateParallel(4, work, work_size);
+    Test_AssertCondition(decoder != NULL);
+    Test_AssertCondition(decoder->work == NULL);
+    IMAADPCMWAVDecoder_Destroy(decoder);
+    Test_AssertCondition(IMAADPCMWAVDecoder_CreateParallel(4, work, work_size - 1) == NULL);
+    Test_AssertCondition(IMAADPCMWAVDecoder_CreateParallel(5, work, work_size) == NULL);
+    free(work);
+  }
+
+  /* 不正な引数 */
+  {
+    uint8_t data[64] = { 0, };
+    int16_t buf[16];
+    int16_t *buffer[1];
+    struct IMAADPCMWAVDecoder *decoder;
+
+    buffer[0] = buf;
+    decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeWholeParallel(NULL,
+          data, sizeof(data), buffer, 1, 16, 1, NULL, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeWholeParallel(decoder,
+          NULL, sizeof(data), buffer, 1, 16, 1, NULL, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeWholeParallel(decoder,
+          data, sizeof(data), NULL, 1, 16, 1, NULL, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeWholeParallel(decoder,
+          data, sizeof(data), buffer, 1, 16, 0, NULL, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    IMAADPCMWAVDecoder_Destroy(decoder);
+  }
+
+  /* 逐次デコードとの一致確認 */
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeParallel(1,  256, 1, 4), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeParallel(1,  256, 505 * 37, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeParallel(1,  256, 505 * 37 + 100, 3), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeParallel(1, 1024, 2041 * 20 + 1, 7), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeParallel(2,  256, 249 * 41 + 17, 4), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeParallel(2, 1024, 1017 * 64 + 500, 5), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeParallel(2,  256, 249 * 300, IMAADPCM_MAX_NUM_TASKS + 10), 1);
+}
+
+/* レイアウト指定デコードの結果が一括デコード結果を変換したものと一致するか確認するサブルーチン 一致していたら1, していなければ0を返す */
+/* インターリーブ時は実際のチャンネル数より1つ多いストライドで書き出し、隙間と末尾に書き込まれていないことも確認する */
+static uint8_t testIMAADPCMWAVDecoder_CheckDecodeLayout(
+    uint16_t num_channels, uint16_t block_size, uint32_t num_samples, uint32_t num_tasks)
+{
+  uint32_t ch, smpl, output_size, is_ok, format, interleaved, stride, num_elements;
+  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS], *reference[IMAADPCM_MAX_NUM_CHANNELS];
+  void *output[IMAADPCM_MAX_NUM_CHANNELS + 1];
+  uint8_t *data;
+  struct IMAADPCMWAVDecoder *decoder;
+  struct IMAADPCMOutputLayout layout;
+  IMAADPCMApiResult ret;
+
+  /* 最大の要素型（4byte）でインターリーブ時の大きさを確保 */
+  num_elements = (num_samples + 1) * (num_channels + 1U);
+  for (ch = 0; ch <= num_channels; ch++) {
+    output[ch] = malloc(sizeof(int32_t) * num_elements);
+  }
+  decoder = IMAADPCMWAVDecoder_CreateParallel(IMAADPCM_MIN_VAL(num_tasks, IMAADPCM_MAX_NUM_TASKS), NULL, 0);
+
+  is_ok = 0;
+  if (testIMAADPCM_CreateEncodedFixture(num_channels, num_samples, block_size,
+        input, &data, &output_size, reference) != 1) {
+    goto CHECK_END;
+  }
+
+  for (format = 0; format < 3; format++) {
+    for (interleaved = 0; interleaved < 2; interleaved++) {
+      layout.sample_format = (IMAADPCMSampleFormat)format;
+      layout.interleaved = (uint8_t)interleaved;
+      stride = interleaved ? (num_channels + 1U) : 1;
+      for (ch = 0; ch <= num_channels; ch++) {
+        memset(output[ch], 0xA5, sizeof(int32_t) * num_elements);
+      }
+      /* 逐次・並列の両方で確認 */
+      if (num_tasks == 1) {
+        ret = IMAADPCMWAVDecoder_DecodeWholeToLayout(decoder,
+            data, output_size, &layout, output, interleaved ? (num_channels + 1U) : num_channels, num_samples);
+      } else {
+        ret = IMAADPCMWAVDecoder_DecodeWholeParallelToLayout(decoder,
+            data, output_size, &layout, output, interleaved ? (num_channels + 1U) : num_channels, num_samples,
+            num_tasks, testIMAADPCMWAVDecoder_ExecuteTasksReverse, &smpl);
+      }
+      if (ret != IMAADPCM_APIRESULT_OK) {
+        goto CHECK_END;
+      }
+      for (ch = 0; ch < num_channels; ch++) {
+        void *buf = interleaved ? output[0] : output[ch];
+        const uint32_t offset = interleaved ? ch : 0;
+        for (smpl = 0; smpl <= num_samples; smpl++) {
+          const uint32_t pos = smpl * stride + offset;
+          switch (layout.sample_format) {
+            case IMAADPCM_SAMPLE_FORMAT_INT16:
+              if ((smpl < num_samples) ? (((int16_t *)buf)[pos] != reference[ch][smpl])
+                  : (((uint16_t *)buf)[pos] != 0xA5A5)) {
+                goto CHECK_END;
+              }
+              break;
+            case IMAADPCM_SAMPLE_FORMAT_INT32:
+              if ((smpl < num_samples) ? (((int32_t *)buf)[pos] != (int32_t)reference[ch][smpl] * 65536)
+                  : (((uint32_t *)buf)[pos] != 0xA5A5A5A5UL)) {
+                goto CHECK_END;
+              }
+              break;
+            default:
+              if ((smpl < num_samples) ? (((float *)buf)[pos] != (float)reference[ch][smpl] / 32768.0f)
+                  : (((uint32_t *)buf)[pos] != 0xA5A5A5A5UL)) {
+                goto CHECK_END;
+              }
+              break;
+          }
+        }
+      }
+      /* インターリーブの隙間には書き込まない */
+      if (interleaved) {
+        for (smpl = 0; smpl < num_samples; smpl++) {
+          if (((uint8_t *)output[0])[(smpl * stride + num_channels) * (layout.sample_format == IMAADPCM_SAMPLE_FORMAT_INT16 ? 2 : 4)] != 0xA5) {
+            goto CHECK_END;
+          }
+        }
       }
     }
+  }
 
-    /* ハンドル作成 */
-    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  is_ok = 1;
+
+CHECK_END:
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  free(data);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(input[ch]);
+    free(reference[ch]);
+  }
+  for (ch = 0; ch <= num_channels; ch++) {
+    free(output[ch]);
+  }
+
+  return is_ok;
+}
+
+/* レイアウト指定デコードテスト */
+static void testIMAADPCMWAVDecoder_DecodeLayoutTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 不正な引数 */
+  {
+    uint8_t data[64] = { 0, };
+    int16_t buf[16];
+    void *buffer[1];
+    struct IMAADPCMWAVDecoder *decoder;
+    struct IMAADPCMOutputLayout layout;
+
+    buffer[0] = buf;
+    layout.sample_format = IMAADPCM_SAMPLE_FORMAT_INT16;
+    layout.interleaved = 0;
     decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeWholeToLayout(NULL,
+          data, sizeof(data), &layout, buffer, 1, 16), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeWholeToLayout(decoder,
+          NULL, sizeof(data), &layout, buffer, 1, 16), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeWholeToLayout(decoder,
+          data, sizeof(data), NULL, buffer, 1, 16), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeWholeToLayout(decoder,
+          data, sizeof(data), &layout, NULL, 1, 16), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeWholeParallelToLayout(decoder,
+          data, sizeof(data), &layout, buffer, 1, 16, 0, NULL, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    layout.sample_format = (IMAADPCMSampleFormat)(IMAADPCM_SAMPLE_FORMAT_FLOAT32 + 1);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeWholeToLayout(decoder,
+          data, sizeof(data), &layout, buffer, 1, 16), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    IMAADPCMWAVDecoder_Destroy(decoder);
+  }
 
-    /* エンコードパラメータをセット */
-    enc_param.num_channels    = NUM_CHANNELS;
-    enc_param.sampling_rate   = 8000;
-    enc_param.bits_per_sample = IMAADPCM_BITS_PER_SAMPLE;
-    enc_param.block_size      = 256;
-    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param), IMAADPCM_APIRESULT_OK);
+  /* 一括デコードとの一致確認 */
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeLayout(1,  256, 1, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeLayout(1,  256, 505 * 37 + 100, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeLayout(1, 1024, 2041 * 20 + 1, 3), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeLayout(2,  256, 249 * 41 + 17, 4), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeLayout(2, 1024, 1017 * 64 + 500, 1), 1);
+  /* タイルに収まらない大きなブロック */
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeLayout(1, 16384, 32761 * 2 + 20000, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeLayout(2, 40000, 39993 * 2 + 7, 2), 1);
+  /* チャンネルあたりのタイルが小さくなる多チャンネル */
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeLayout(8, 8 * 1024, 2041 * 9 + 300, 2), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeLayout(8, 8 * 2048, 4089 * 5 + 300, 2), 1);
+}
 
-    /* エンコード */
-    Test_AssertEqual(
-        IMAADPCMWAVEncoder_EncodeWhole(
-          encoder, (const int16_t *const *)input, NUM_SAMPLES,
-          buffer, buffer_size, &output_size), IMAADPCM_APIRESULT_OK);
-    /* 半分以下にはなるはず */
-    Test_AssertCondition(output_size < (buffer_size / 2));
+/* 量子化テスト */
+static void testIMAADPCMCoreEncoder_QuantizeDiffTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
 
-    /* デコード */
-    Test_AssertEqual(
-        IMAADPCMWAVDecoder_DecodeWhole(
-          decoder, buffer, output_size,
-          decoded, NUM_CHANNELS, NUM_SAMPLES), IMAADPCM_APIRESULT_OK);
+  /* 全ステップサイズ・全差分について除算による結果と一致するか */
+  {
+    int32_t idx, diffabs, is_ok;
 
-    /* ロスがあるのでRMSE基準でチェック */
-    rms_error = 0.0;
-    for (ch = 0; ch < NUM_CHANNELS; ch++) {
-      for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
-        double pcm1, pcm2, abs_error;
-        pcm1 = (double)input[ch][smpl] / INT16_MAX;
-        pcm2 = (double)decoded[ch][smpl] / INT16_MAX;
-        abs_error = fabs(pcm1 - pcm2);
-        rms_error += abs_error * abs_error;
+    is_ok = 1;
+    for (idx = 0; idx <= 88; idx++) {
+      const int32_t stepsize = IMAADPCM_stepsize_table[idx];
+      for (diffabs = 0; diffabs <= 65535; diffabs++) {
+        const int32_t qbits = IMAADPCM_MIN_VAL((diffabs << 2) / stepsize, 7);
+        if (IMAADPCMCoreEncoder_QuantizeDiff(diffabs, stepsize) != qbits) {
+          is_ok = 0;
+        }
       }
     }
-    rms_error = sqrt(rms_error / (NUM_SAMPLES * NUM_CHANNELS));
+    Test_AssertEqual(is_ok, 1);
+  }
+}
 
-    /* 経験的に0.05 */
-    Test_AssertCondition(rms_error < 5.0e-2);
+/* ストリーミングデコードの結果が一括デコードと一致するか確認 一致すれば1を返す */
+/* ヘッダには読み飛ばすべきチャンクを挿入し、truncateが1の場合はブロックの途中でファイルを切る */
+static uint8_t testIMAADPCMWAVDecoder_CheckDecodeStream(
+    uint16_t num_channels, uint16_t block_size, uint32_t num_blocks, uint32_t max_num_feed_bytes, uint8_t truncate)
+{
+  uint32_t ch, smpl, is_ok, data_size, offset, num_feed_bytes, read_size, num_decode_samples;
+  uint32_t num_output_samples, num_expected_samples;
+  uint8_t *data;
+  int16_t *reference[IMAADPCM_MAX_NUM_CHANNELS], *output[IMAADPCM_MAX_NUM_CHANNELS];
+  int16_t *output_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+  struct IMAADPCMWAVDecoder *decoder;
+  struct IMAADPCMWAVHeaderInfo header, stream_header;
+  static const uint8_t list_chunk[] = { 'L', 'I', 'S', 'T', 6, 0, 0, 0, 'a', 'b', 'c', 'd', 'e', 'f' };
+  /* 3チャンネル以上はWAVE_FORMAT_EXTENSIBLE形式のヘッダ */
+  const uint32_t header_size = IMAADPCMWAVENCODER_HEADER_SIZE + ((num_channels > 2) ? IMAADPCM_EXTENSIBLE_FMT_EXTRA_SIZE : 0);
+  const uint32_t list_chunk_offset = header_size - 8; /* factチャンクの直後 */
 
-    /* 領域開放 */
-    IMAADPCMWAVEncoder_Destroy(encoder);
-    IMAADPCMWAVDecoder_Destroy(decoder);
-    free(buffer);
-    for (ch = 0; ch < NUM_CHANNELS; ch++) {
-      free(input[ch]);
-      free(decoded[ch]);
+  /* ランダムなブロックを持つファイルを作成 */
+  header.num_channels = num_channels;
+  header.sampling_rate = 44100;
+  header.bytes_per_sec = 0;
+  header.block_size = block_size;
+  header.channel_mask = 0;
+  header.bits_per_sample = 4;
+  header.num_samples_per_block = (uint16_t)((block_size - 4 * num_channels) * 2 / num_channels + 1);
+  header.num_samples = header.num_samples_per_block * num_blocks;
+  data_size = header_size + sizeof(list_chunk) + (uint32_t)block_size * num_blocks;
+  data = malloc(data_size);
+  if (IMAADPCMWAVEncoder_EncodeHeader(&header, data, data_size) != IMAADPCM_APIRESULT_OK) {
+    free(data);
+    return 0;
+  }
+  memmove(&data[list_chunk_offset + sizeof(list_chunk)], &data[list_chunk_offset],
+      header_size - list_chunk_offset);
+  memcpy(&data[list_chunk_offset], list_chunk, sizeof(list_chunk));
+  srand(2);
+  for (offset = header_size + sizeof(list_chunk); offset < data_size; offset++) {
+    data[offset] = (uint8_t)(rand() & 0xFF);
+  }
+  for (offset = header_size + sizeof(list_chunk); offset < data_size; offset += block_size) {
+    for (ch = 0; ch < num_channels; ch++) {
+      data[offset + 4 * ch + 2] = (uint8_t)(rand() % 89);
+      data[offset + 4 * ch + 3] = 0;
     }
-#undef NUM_CHANNELS
-#undef NUM_SAMPLES
+  }
+  num_expected_samples = header.num_samples;
+  /* 最後のブロックの途中（ブロックヘッダと16byteのデータの後）で切る */
+  if (truncate) {
+    data_size -= block_size - (4 * num_channels + 16);
+    num_expected_samples -= header.num_samples_per_block - (1 + 16 * 2 / num_channels);
   }
 
-  /* エンコードデコードテスト */
+  for (ch = 0; ch < num_channels; ch++) {
+    reference[ch] = malloc(sizeof(int16_t) * header.num_samples);
+    output[ch] = malloc(sizeof(int16_t) * (header.num_samples + header.num_samples_per_block));
+  }
+
+  decoder = IMAADPCMWAVDecoder_CreateStream(NULL, 0);
+
+  is_ok = 0;
+  if ((IMAADPCMWAVDecoder_DecodeHeader(data, data_size, &header) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVDecoder_DecodeWhole(decoder,
+          data, data_size, reference, num_channels, header.num_samples) != IMAADPCM_APIRESULT_OK)) {
+    goto CHECK_END;
+  }
+
+  /* 乱数で決めたサイズずつ供給し、出力は1ブロック分のバッファで受ける */
+  if ((IMAADPCMWAVDecoder_BeginDecode(decoder) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVDecoder_GetStreamHeader(decoder, &stream_header) != IMAADPCM_APIRESULT_INSUFFICIENT_DATA)) {
+    goto CHECK_END;
+  }
+  offset = 0;
+  num_output_samples = 0;
+  while (offset < data_size) {
+    /* マクロ内で乱数を2回引かないよう先に決める */
+    num_feed_bytes = 1 + (uint32_t)rand() % max_num_feed_bytes;
+    num_feed_bytes = IMAADPCM_MIN_VAL(num_feed_bytes, data_size - offset);
+    for (ch = 0; ch < num_channels; ch++) {
+      output_ptr[ch] = &output[ch][num_output_samples];
+    }
+    if (IMAADPCMWAVDecoder_DecodeData(decoder, &data[offset], num_feed_bytes, &read_size,
+          output_ptr, num_channels, header.num_samples_per_block, &num_decode_samples) != IMAADPCM_APIRESULT_OK) {
+      goto CHECK_END;
+    }
+    /* 読み込みも出力も進まないのは異常 */
+    if ((read_size == 0) && (num_decode_samples == 0)) {
+      goto CHECK_END;
+    }
+    offset += read_size;
+    num_output_samples += num_decode_samples;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    output_ptr[ch] = &output[ch][num_output_samples];
+  }
+  if (IMAADPCMWAVDecoder_FinishDecode(decoder,
+        output_ptr, num_channels, header.num_samples_per_block, &num_decode_samples) != IMAADPCM_APIRESULT_OK) {
+    goto CHECK_END;
+  }
+  num_output_samples += num_decode_samples;
+
+  /* ヘッダ情報は一括デコードと一致 */
+  if ((IMAADPCMWAVDecoder_GetStreamHeader(decoder, &stream_header) != IMAADPCM_APIRESULT_NG)
+      || (decoder->header.header_size != header.header_size)
+      || (decoder->header.num_samples != header.num_samples)
+      || (decoder->header.block_size != header.block_size)
+      || (decoder->header.num_samples_per_block != header.num_samples_per_block)) {
+    goto CHECK_END;
+  }
+
+  /* 出力サンプルは一括デコードと一致 */
+  if (num_output_samples != num_expected_samples) {
+    goto CHECK_END;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    for (smpl = 0; smpl < num_output_samples; smpl++) {
+      if (output[ch][smpl] != reference[ch][smpl]) {
+        goto CHECK_END;
+      }
+    }
+  }
+
+  is_ok = 1;
+
+CHECK_END:
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  free(data);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(reference[ch]);
+    free(output[ch]);
+  }
+
+  return is_ok;
+}
+
+/* ストリーミングデコードテスト */
+static void testIMAADPCMWAVDecoder_DecodeStreamTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 不正な引数・状態 */
   {
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse_mono.wav", 4,  128, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse_mono.wav", 4,  256, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse_mono.wav", 4,  512, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse_mono.wav", 4, 1024, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse.wav",      4,  128, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse.wav",      4,  256, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse.wav",      4,  512, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse.wav",      4, 1024, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz_mono.wav",     4,  128, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz_mono.wav",     4,  256, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz_mono.wav",     4,  512, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz_mono.wav",     4, 1024, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz.wav",          4,  128, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz.wav",          4,  256, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz.wav",          4,  512, 5.0e-2), 1);
-    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz.wav",          4, 1024, 5.0e-2), 1);
+    uint8_t data[IMAADPCMWAVENCODER_HEADER_SIZE + 256];
+    int16_t buf[1024];
+    int16_t *output[1];
+    uint32_t read_size, num_decode_samples;
+    struct IMAADPCMWAVDecoder *decoder;
+    struct IMAADPCMWAVHeaderInfo header;
+
+    header.num_channels = 1;
+    header.sampling_rate = 44100;
+    header.bytes_per_sec = 0;
+    header.block_size = 256;
+    header.bits_per_sample = 4;
+    header.num_samples_per_block = 505;
+    header.num_samples = 505;
+    memset(data, 0, sizeof(data));
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeHeader(&header, data, sizeof(data)), IMAADPCM_APIRESULT_OK);
+
+    output[0] = buf;
+    decoder = IMAADPCMWAVDecoder_CreateStream(NULL, 0);
+    Test_AssertEqual(IMAADPCMWAVDecoder_BeginDecode(NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+
+    /* ストリーミング用でないハンドルでは開始できない */
+    {
+      struct IMAADPCMWAVDecoder *whole_decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+      Test_AssertEqual(IMAADPCMWAVDecoder_BeginDecode(whole_decoder), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+      Test_AssertEqual(IMAADPCMWAVDecoder_DecodeData(whole_decoder,
+            data, sizeof(data), &read_size, output, 1, 1024, &num_decode_samples), IMAADPCM_APIRESULT_NG);
+      IMAADPCMWAVDecoder_Destroy(whole_decoder);
+    }
+
+    /* 開始前は供給・終了できない */
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeData(decoder,
+          data, sizeof(data), &read_size, output, 1, 1024, &num_decode_samples), IMAADPCM_APIRESULT_NG);
+    Test_AssertEqual(IMAADPCMWAVDecoder_FinishDecode(decoder,
+          output, 1, 1024, &num_decode_samples), IMAADPCM_APIRESULT_NG);
+
+    Test_AssertEqual(IMAADPCMWAVDecoder_BeginDecode(decoder), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeData(NULL,
+          data, sizeof(data), &read_size, output, 1, 1024, &num_decode_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeData(decoder,
+          NULL, sizeof(data), &read_size, output, 1, 1024, &num_decode_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeData(decoder,
+          data, sizeof(data), NULL, output, 1, 1024, &num_decode_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeData(decoder,
+          data, sizeof(data), &read_size, NULL, 1, 1024, &num_decode_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeData(decoder,
+          data, sizeof(data), &read_size, output, 1, 1024, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+
+    /* ヘッダを読み終えるまでは終了できない */
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeData(decoder,
+          data, 30, &read_size, output, 1, 1024, &num_decode_samples), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(read_size, 30);
+    Test_AssertEqual(num_decode_samples, 0);
+    Test_AssertEqual(IMAADPCMWAVDecoder_FinishDecode(decoder,
+          output, 1, 1024, &num_decode_samples), IMAADPCM_APIRESULT_INSUFFICIENT_DATA);
+
+    /* 1ブロックが入らない出力バッファ ヘッダは読み込まれる */
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeData(decoder,
+          &data[30], sizeof(data) - 30, &read_size, output, 1, 504, &num_decode_samples), IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER);
+    Test_AssertEqual(read_size, IMAADPCMWAVENCODER_HEADER_SIZE - 30);
+    Test_AssertEqual(num_decode_samples, 0);
+    Test_AssertEqual(IMAADPCMWAVDecoder_GetStreamHeader(decoder, &header), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(header.num_samples_per_block, 505);
+    Test_AssertEqual(header.header_size, IMAADPCMWAVENCODER_HEADER_SIZE);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeData(decoder,
+          &data[IMAADPCMWAVENCODER_HEADER_SIZE], 256, &read_size, output, 1, 505, &num_decode_samples), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(read_size, 256);
+    Test_AssertEqual(num_decode_samples, 505);
+    Test_AssertEqual(IMAADPCMWAVDecoder_FinishDecode(decoder,
+          output, 1, 1024, &num_decode_samples), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(num_decode_samples, 0);
+
+    IMAADPCMWAVDecoder_Destroy(decoder);
+  }
+
+  /* 供給の区切り方によらず一括デコードと一致 */
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeStream(1,  256, 10, 1, 0), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeStream(1,  256, 10, 100, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeStream(1, 1024, 10, 3000, 0), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeStream(2,  256, 10, 1, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeStream(2,  256, 10, 100, 0), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeStream(2, 1024, 10, 3000, 1), 1);
+}
+
+/* 範囲デコードの結果が一括デコードの同じ範囲と一致するか確認するサブルーチン 一致していたら1, していなければ0を返す */
+static uint8_t testIMAADPCMWAVDecoder_CheckDecodeRange(
+    uint16_t num_channels, uint16_t block_size, uint32_t num_samples)
+{
+  uint32_t ch, smpl, trial, output_size, is_ok, start, count, num_decode_samples;
+  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS], *reference[IMAADPCM_MAX_NUM_CHANNELS], *output[IMAADPCM_MAX_NUM_CHANNELS];
+  uint8_t *data;
+  const uint32_t num_samples_per_block = (uint32_t)(block_size - 4 * num_channels) * 2 / num_channels + 1;
+  struct IMAADPCMWAVDecoder *decoder;
+
+  for (ch = 0; ch < num_channels; ch++) {
+    output[ch] = malloc(sizeof(int16_t) * (num_samples + 1));
+  }
+
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+
+  is_ok = 0;
+  if (testIMAADPCM_CreateEncodedFixture(num_channels, num_samples, block_size,
+        input, &data, &output_size, reference) != 1) {
+    goto CHECK_END;
+  }
+
+  /* ブロック境界をまたぐ範囲・境界ちょうどの範囲・末尾を超える範囲を含めて確認 */
+  for (trial = 0; trial < 200; trial++) {
+    switch (trial % 4) {
+      case 0:
+        start = (uint32_t)rand() % num_samples;
+        count = (uint32_t)rand() % (3 * num_samples_per_block) + 1;
+        break;
+      case 1:
+        start = ((uint32_t)rand() % num_samples / num_samples_per_block) * num_samples_per_block;
+        count = num_samples_per_block;
+        break;
+      case 2:
+        start = (uint32_t)rand() % num_samples;
+        count = (uint32_t)rand() % 16 + 1;
+        break;
+      default:
+        start = (uint32_t)rand() % num_samples;
+        count = num_samples;
+        break;
+    }
+    /* 範囲外に書き出していないか確認するため番兵を置く */
+    for (ch = 0; ch < num_channels; ch++) {
+      for (smpl = 0; smpl <= num_samples; smpl++) {
+        output[ch][smpl] = 0x7EEF;
+      }
+    }
+    if (IMAADPCMWAVDecoder_DecodeRange(decoder, data, output_size,
+          start, count, output, num_channels, num_samples + 1, &num_decode_samples) != IMAADPCM_APIRESULT_OK) {
+      goto CHECK_END;
+    }
+    if (num_decode_samples != IMAADPCM_MIN_VAL(count, num_samples - start)) {
+      goto CHECK_END;
+    }
+    for (ch = 0; ch < num_channels; ch++) {
+      if ((memcmp(output[ch], &reference[ch][start], sizeof(int16_t) * num_decode_samples) != 0)
+          || (output[ch][num_decode_samples] != 0x7EEF)) {
+        goto CHECK_END;
+      }
+    }
+  }
+
+  /* 末尾以降の範囲は0サンプル */
+  if ((IMAADPCMWAVDecoder_DecodeRange(decoder, data, output_size,
+          num_samples, 10, output, num_channels, num_samples, &num_decode_samples) != IMAADPCM_APIRESULT_OK)
+      || (num_decode_samples != 0)) {
+    goto CHECK_END;
+  }
+
+  /* 範囲末尾までのデータが無い */
+  if (IMAADPCMWAVDecoder_DecodeRange(decoder, data, output_size - 1,
+        num_samples - 1, 1, output, num_channels, num_samples, &num_decode_samples) != IMAADPCM_APIRESULT_INSUFFICIENT_DATA) {
+    goto CHECK_END;
+  }
+
+  is_ok = 1;
+
+CHECK_END:
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  free(data);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(input[ch]);
+    free(reference[ch]);
+    free(output[ch]);
+  }
+
+  return is_ok;
+}
+
+/* 範囲デコードテスト */
+static void testIMAADPCMWAVDecoder_DecodeRangeTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 不正な引数 */
+  {
+    uint8_t data[64] = { 0, };
+    int16_t buf[16];
+    int16_t *buffer[1];
+    uint32_t num_decode_samples;
+    struct IMAADPCMWAVDecoder *decoder;
+
+    buffer[0] = buf;
+    decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeRange(NULL,
+          data, sizeof(data), 0, 16, buffer, 1, 16, &num_decode_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeRange(decoder,
+          NULL, sizeof(data), 0, 16, buffer, 1, 16, &num_decode_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeRange(decoder,
+          data, sizeof(data), 0, 16, NULL, 1, 16, &num_decode_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeRange(decoder,
+          data, sizeof(data), 0, 16, buffer, 1, 16, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    IMAADPCMWAVDecoder_Destroy(decoder);
+  }
+
+  /* 一括デコードとの一致確認 */
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeRange(1,  256, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeRange(1,  256, 505 * 20 + 100), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeRange(1, 1024, 2041 * 20 + 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeRange(2,  256, 249 * 41 + 17), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeRange(2, 1024, 1017 * 20 + 500), 1);
+}
+
+/* シークインデックスを使った範囲デコードの結果が一括デコードと一致するか確認するサブルーチン 一致していたら1, していなければ0を返す */
+/* インデックスはdataチャンクの直前にチャンクとして埋め込んだファイルで使う */
+static uint8_t testIMAADPCMWAVDecoder_CheckDecodeSeekIndex(
+    uint16_t num_channels, uint16_t block_size, uint32_t num_samples, uint32_t interval)
+{
+  uint32_t ch, trial, output_size, index_size, tmp_index_size, is_ok, start, count, num_decode_samples;
+  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS], *reference[IMAADPCM_MAX_NUM_CHANNELS], *output[IMAADPCM_MAX_NUM_CHANNELS];
+  uint8_t *data, *embedded, *index;
+  struct IMAADPCMWAVDecoder *decoder;
+  struct IMAADPCMWAVHeaderInfo header;
+
+  for (ch = 0; ch < num_channels; ch++) {
+    output[ch] = malloc(sizeof(int16_t) * num_samples);
+  }
+  embedded = NULL;
+  index = NULL;
+
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+
+  is_ok = 0;
+  if ((testIMAADPCM_CreateEncodedFixture(num_channels, num_samples, block_size,
+          input, &data, &output_size, reference) != 1)
+      || (IMAADPCMWAVDecoder_DecodeHeader(data, output_size, &header) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVDecoder_CalculateSeekIndexSize(&header, interval, &index_size) != IMAADPCM_APIRESULT_OK)) {
+    goto CHECK_END;
+  }
+
+  /* インデックス作成 */
+  index = malloc(index_size);
+  if ((IMAADPCMWAVDecoder_CreateSeekIndex(decoder,
+          data, output_size, interval, index, index_size - 1, &tmp_index_size) != IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER)
+      || (IMAADPCMWAVDecoder_CreateSeekIndex(decoder,
+          data, output_size, interval, index, index_size, &tmp_index_size) != IMAADPCM_APIRESULT_OK)
+      || (tmp_index_size != index_size)) {
+    goto CHECK_END;
+  }
+
+  /* dataチャンクの直前に埋め込む ヘッダデコードでは読み飛ばされる */
+  embedded = malloc(output_size + index_size);
+  memcpy(embedded, data, header.header_size - 8);
+  memcpy(embedded + header.header_size - 8, index, index_size);
+  memcpy(embedded + header.header_size - 8 + index_size,
+      data + header.header_size - 8, output_size - (header.header_size - 8));
+  ByteArray_WriteUint32LE(&embedded[4], output_size + index_size - 8);
+  free(index);
+  index = embedded + header.header_size - 8;
+  if ((IMAADPCMWAVDecoder_DecodeHeader(embedded, output_size + index_size, &header) != IMAADPCM_APIRESULT_OK)
+      || (header.num_samples != num_samples)) {
+    goto CHECK_END;
+  }
+
+  for (trial = 0; trial < 200; trial++) {
+    start = (uint32_t)rand() % num_samples;
+    count = (trial % 2) ? ((uint32_t)rand() % 16 + 1) : ((uint32_t)rand() % 4096 + 1);
+    if (IMAADPCMWAVDecoder_DecodeRangeWithSeekIndex(decoder, embedded, output_size + index_size, index, index_size,
+          start, count, output, num_channels, num_samples, &num_decode_samples) != IMAADPCM_APIRESULT_OK) {
+      goto CHECK_END;
+    }
+    if (num_decode_samples != IMAADPCM_MIN_VAL(count, num_samples - start)) {
+      goto CHECK_END;
+    }
+    for (ch = 0; ch < num_channels; ch++) {
+      if (memcmp(output[ch], &reference[ch][start], sizeof(int16_t) * num_decode_samples) != 0) {
+        goto CHECK_END;
+      }
+    }
+  }
+
+  /* 途切れたインデックス・他のブロック構成で作ったインデックスは使えない */
+  if (IMAADPCMWAVDecoder_DecodeRangeWithSeekIndex(decoder, embedded, output_size + index_size, index, index_size - 1,
+        0, 1, output, num_channels, num_samples, &num_decode_samples) != IMAADPCM_APIRESULT_INSUFFICIENT_DATA) {
+    goto CHECK_END;
+  }
+  /* チャンクサイズに8を足すと桁あふれする値でも途切れたインデックスとして扱う */
+  /* 埋め込み先のヘッダデコードが壊れたチャンクを読み飛ばさないよう、埋め込む前のファイルと組み合わせる */
+  ByteArray_WriteUint32LE(&index[4], UINT32_MAX - 7);
+  if (IMAADPCMWAVDecoder_DecodeRangeWithSeekIndex(decoder, data, output_size, index, index_size,
+        0, 1, output, num_channels, num_samples, &num_decode_samples) != IMAADPCM_APIRESULT_INSUFFICIENT_DATA) {
+    goto CHECK_END;
+  }
+  ByteArray_WriteUint32LE(&index[4], index_size - 8);
+  ByteArray_WriteUint16LE(&index[14], block_size + 4);
+  if (IMAADPCMWAVDecoder_DecodeRangeWithSeekIndex(decoder, embedded, output_size + index_size, index, index_size,
+        0, 1, output, num_channels, num_samples, &num_decode_samples) != IMAADPCM_APIRESULT_INVALID_FORMAT) {
+    goto CHECK_END;
+  }
+
+  is_ok = 1;
+
+CHECK_END:
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  free(data);
+  if (embedded != NULL) {
+    free(embedded);
+  } else {
+    free(index);
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    free(input[ch]);
+    free(reference[ch]);
+    free(output[ch]);
+  }
+
+  return is_ok;
+}
+
+/* シークインデックステスト */
+static void testIMAADPCMWAVDecoder_DecodeSeekIndexTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 不正な引数 */
+  {
+    uint8_t data[64] = { 0, };
+    int16_t buf[16];
+    int16_t *buffer[1];
+    uint32_t size;
+    struct IMAADPCMWAVDecoder *decoder;
+    struct IMAADPCMWAVHeaderInfo header;
+
+    buffer[0] = buf;
+    memset(&header, 0, sizeof(header));
+    header.num_channels = 1;
+    header.block_size = 256;
+    decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateSeekIndexSize(NULL, 64, &size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateSeekIndexSize(&header, 0, &size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateSeekIndexSize(&header, 64, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_CreateSeekIndex(NULL,
+          data, sizeof(data), 64, data, sizeof(data), &size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_CreateSeekIndex(decoder,
+          data, sizeof(data), 0, data, sizeof(data), &size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_CreateSeekIndex(decoder,
+          data, sizeof(data), 64, NULL, sizeof(data), &size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeRangeWithSeekIndex(decoder,
+          data, sizeof(data), NULL, sizeof(data), 0, 16, buffer, 1, 16, &size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+
+    /* サンプル数0ならシーク点も無い */
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateSeekIndexSize(&header, 64, &size), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(size, IMAADPCM_SEEKINDEX_HEADER_SIZE);
+    /* 各ブロック505サンプルのうち、先頭を除く64サンプル毎の7点 */
+    header.num_samples = 505 * 3;
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateSeekIndexSize(&header, 64, &size), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(size, IMAADPCM_SEEKINDEX_HEADER_SIZE + 3 * 7 * 4);
+    IMAADPCMWAVDecoder_Destroy(decoder);
+  }
+
+  /* 一括デコードとの一致確認 */
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeSeekIndex(1,  256, 505 * 20 + 100, 64), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeSeekIndex(1, 4096, 8185 * 5 + 1, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeSeekIndex(1, 4096, 8185 * 5 + 1000, 1000), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeSeekIndex(2,  256, 249 * 41 + 17, 8), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeSeekIndex(2, 4096, 4089 * 5 + 17, 255), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeSeekIndex(2, 1024, 1017 * 3, 2000), 1);
+}
+
+/* デコーダバンクの結果が各ストリームの一括デコードと一致するか確認するサブルーチン 一致していたら1, していなければ0を返す */
+/* 途中でストリームを削除・追加し、IDの再利用も確認する */
+static uint8_t testIMAADPCMDecoderBank_CheckDecode(uint32_t max_num_streams, IMAADPCMKernel kernel)
+{
+#define NUM_TEST_FILES 6
+  static const struct { uint16_t num_channels; uint16_t block_size; uint32_t num_samples; } config[NUM_TEST_FILES] = {
+    { 1, 256, 505 * 3 + 100 }, { 2, 256, 249 * 4 + 17 }, { 1, 258, 509 * 2 }, { 2, 1024, 1017 + 1 }, { 1, 1024, 1 }, { 2, 128, 57 * 9 + 56 },
+  };
+  uint32_t i, ch, smpl, frame, num_frames, is_ok, output_stride;
+  uint8_t *data[NUM_TEST_FILES];
+  uint32_t data_size[NUM_TEST_FILES];
+  int16_t *reference[NUM_TEST_FILES][IMAADPCM_MAX_NUM_CHANNELS];
+  uint32_t *stream_file, *stream_progress, *stream_id;
+  int16_t *output;
+  struct IMAADPCMDecoderBank *bank;
+  struct IMAADPCMWAVDecoder *decoder;
+  struct IMAADPCMWAVEncoder *encoder;
+  const uint32_t max_num_frames = 300;
+
+  srand(0);
+  encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+  bank = IMAADPCMDecoderBank_Create(max_num_streams, NULL, 0);
+  output_stride = max_num_streams * IMAADPCM_DECODERBANK_MAX_NUM_CHANNELS;
+  output = malloc(sizeof(int16_t) * output_stride * max_num_frames);
+  stream_file = malloc(sizeof(uint32_t) * max_num_streams);
+  stream_progress = malloc(sizeof(uint32_t) * max_num_streams);
+  stream_id = malloc(sizeof(uint32_t) * max_num_streams);
+
+  /* 各設定のファイルを作成し、一括デコード結果を参照値とする */
+  for (i = 0; i < NUM_TEST_FILES; i++) {
+    int16_t *input[IMAADPCM_MAX_NUM_CHANNELS];
+    struct IMAADPCMWAVEncodeParameter enc_param;
+    data_size[i] = 2 * config[i].num_samples * config[i].num_channels + config[i].block_size + 256;
+    data[i] = malloc(data_size[i]);
+    for (ch = 0; ch < IMAADPCM_MAX_NUM_CHANNELS; ch++) {
+      input[ch] = malloc(sizeof(int16_t) * config[i].num_samples);
+      reference[i][ch] = malloc(sizeof(int16_t) * config[i].num_samples);
+      for (smpl = 0; smpl < config[i].num_samples; smpl++) {
+        input[ch][smpl] = (int16_t)(16000.0 * sin(0.01 * smpl * (ch + i + 1)) + (rand() % 4096) - 2048);
+      }
+    }
+    enc_param.num_channels = config[i].num_channels;
+    enc_param.sampling_rate = 44100;
+    enc_param.bits_per_sample = 4;
+    enc_param.block_size = config[i].block_size;
+    is_ok = ((IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) == IMAADPCM_APIRESULT_OK)
+        && (IMAADPCMWAVEncoder_EncodeWhole(encoder,
+            (const int16_t *const *)input, config[i].num_samples, data[i], data_size[i], &data_size[i]) == IMAADPCM_APIRESULT_OK)
+        && (IMAADPCMWAVDecoder_DecodeWhole(decoder,
+            data[i], data_size[i], reference[i], IMAADPCM_MAX_NUM_CHANNELS, config[i].num_samples) == IMAADPCM_APIRESULT_OK));
+    for (ch = 0; ch < IMAADPCM_MAX_NUM_CHANNELS; ch++) {
+      free(input[ch]);
+    }
+    if (!is_ok) {
+      goto CHECK_END;
+    }
+  }
+
+  is_ok = 0;
+  if (IMAADPCMDecoderBank_SetKernel(bank, kernel) != IMAADPCM_APIRESULT_OK) {
+    goto CHECK_END;
+  }
+
+  /* 全IDを埋める */
+  for (i = 0; i < max_num_streams; i++) {
+    stream_file[i] = (uint32_t)rand() % NUM_TEST_FILES;
+    stream_progress[i] = 0;
+    if ((IMAADPCMDecoderBank_AddStream(bank, data[stream_file[i]], data_size[stream_file[i]], &stream_id[i]) != IMAADPCM_APIRESULT_OK)
+        || (stream_id[i] != i)) {
+      goto CHECK_END;
+    }
+  }
+  if (IMAADPCMDecoderBank_AddStream(bank, data[0], data_size[0], &stream_id[0]) != IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER) {
+    goto CHECK_END;
+  }
+
+  for (frame = 0; frame < 10; frame++) {
+    /* 一部のストリームを入れ替える 削除したIDが再利用される */
+    for (i = 0; i < max_num_streams; i++) {
+      uint32_t id;
+      if ((rand() % 4) != 0) {
+        continue;
+      }
+      if (IMAADPCMDecoderBank_RemoveStream(bank, i) != IMAADPCM_APIRESULT_OK) {
+        goto CHECK_END;
+      }
+      stream_file[i] = (uint32_t)rand() % NUM_TEST_FILES;
+      stream_progress[i] = 0;
+      if ((IMAADPCMDecoderBank_AddStream(bank, data[stream_file[i]], data_size[stream_file[i]], &id) != IMAADPCM_APIRESULT_OK)
+          || (id != i)) {
+        goto CHECK_END;
+      }
+    }
+
+    /* デコードして各ストリームの参照値と比較 */
+    num_frames = (uint32_t)rand() % max_num_frames + 1;
+    if (IMAADPCMDecoderBank_Decode(bank, output, output_stride * max_num_frames, num_frames) != IMAADPCM_APIRESULT_OK) {
+      goto CHECK_END;
+    }
+    for (i = 0; i < max_num_streams; i++) {
+      const uint32_t file = stream_file[i];
+      uint32_t num_remain_samples;
+      for (smpl = 0; smpl < num_frames; smpl++) {
+        for (ch = 0; ch < IMAADPCM_DECODERBANK_MAX_NUM_CHANNELS; ch++) {
+          const uint32_t pos = stream_progress[i] + smpl;
+          const int16_t expected = ((ch < config[file].num_channels) && (pos < config[file].num_samples))
+            ? reference[file][ch][pos] : 0;
+          if (output[smpl * output_stride + i * IMAADPCM_DECODERBANK_MAX_NUM_CHANNELS + ch] != expected) {
+            goto CHECK_END;
+          }
+        }
+      }
+      stream_progress[i] = IMAADPCM_MIN_VAL(stream_progress[i] + num_frames, config[file].num_samples);
+      if ((IMAADPCMDecoderBank_GetNumRemainSamples(bank, i, &num_remain_samples) != IMAADPCM_APIRESULT_OK)
+          || (num_remain_samples != (config[file].num_samples - stream_progress[i]))) {
+        goto CHECK_END;
+      }
+    }
+  }
+
+  is_ok = 1;
+
+CHECK_END:
+  IMAADPCMDecoderBank_Destroy(bank);
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  IMAADPCMWAVEncoder_Destroy(encoder);
+  for (i = 0; i < NUM_TEST_FILES; i++) {
+    free(data[i]);
+    for (ch = 0; ch < IMAADPCM_MAX_NUM_CHANNELS; ch++) {
+      free(reference[i][ch]);
+    }
+  }
+  free(output);
+  free(stream_file);
+  free(stream_progress);
+  free(stream_id);
+
+  return is_ok;
+#undef NUM_TEST_FILES
+}
+
+/* デコーダバンクテスト */
+static void testIMAADPCMDecoderBank_DecodeTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 作成・不正な引数 */
+  {
+    uint8_t data[64] = { 0, };
+    int16_t output[16];
+    uint32_t id, num_samples;
+    void *work;
+    int32_t work_size;
+    struct IMAADPCMDecoderBank *bank;
+
+    Test_AssertCondition(IMAADPCMDecoderBank_CalculateWorkSize(0) < 0);
+    Test_AssertCondition(IMAADPCMDecoderBank_Create(0, NULL, 0) == NULL);
+    /* ワークサイズがint32_tに収まらないストリーム数 */
+    Test_AssertCondition(IMAADPCMDecoderBank_CalculateWorkSize(IMAADPCM_DECODERBANK_MAX_NUM_STREAMS) > 0);
+    Test_AssertCondition(IMAADPCMDecoderBank_CalculateWorkSize(IMAADPCM_DECODERBANK_MAX_NUM_STREAMS + 1) < 0);
+    Test_AssertCondition(IMAADPCMDecoderBank_CalculateWorkSize(UINT32_MAX) < 0);
+    Test_AssertCondition(IMAADPCMDecoderBank_Create(IMAADPCM_DECODERBANK_MAX_NUM_STREAMS + 1, NULL, 0) == NULL);
+    Test_AssertCondition(IMAADPCMDecoderBank_Create(UINT32_MAX, NULL, 0) == NULL);
+    work_size = IMAADPCMDecoderBank_CalculateWorkSize(3);
+    Test_AssertCondition(work_size > 0);
+    work = malloc((size_t)work_size);
+    Test_AssertCondition(IMAADPCMDecoderBank_Create(3, work, work_size - 1) == NULL);
+    bank = IMAADPCMDecoderBank_Create(3, work, work_size);
+    Test_AssertCondition(bank != NULL);
+
+    Test_AssertEqual(IMAADPCMDecoderBank_AddStream(NULL, data, sizeof(data), &id), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMDecoderBank_AddStream(bank, NULL, sizeof(data), &id), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMDecoderBank_AddStream(bank, data, sizeof(data), NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMDecoderBank_AddStream(bank, data, sizeof(data), &id), IMAADPCM_APIRESULT_INVALID_FORMAT);
+    Test_AssertEqual(IMAADPCMDecoderBank_RemoveStream(bank, 0), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMDecoderBank_RemoveStream(bank, 3), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMDecoderBank_GetNumRemainSamples(bank, 0, &num_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMDecoderBank_Decode(NULL, output, 16, 1), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMDecoderBank_Decode(bank, NULL, 16, 1), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMDecoderBank_Decode(bank, output, 16, 3), IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER);
+
+    /* ストリームが無ければ無音 */
+    memset(output, 0xFF, sizeof(output));
+    Test_AssertEqual(IMAADPCMDecoderBank_Decode(bank, output, 16, 2), IMAADPCM_APIRESULT_OK);
+    for (id = 0; id < 12; id++) {
+      Test_AssertEqual(output[id], 0);
+    }
+    Test_AssertEqual(output[12], -1);
+
+    IMAADPCMDecoderBank_Destroy(bank);
+    free(work);
+  }
+
+  /* 一括デコードとの一致確認 */
+  Test_AssertEqual(testIMAADPCMDecoderBank_CheckDecode(1, IMAADPCM_KERNEL_SCALAR), 1);
+  Test_AssertEqual(testIMAADPCMDecoderBank_CheckDecode(37, IMAADPCM_KERNEL_SCALAR), 1);
+  Test_AssertEqual(testIMAADPCMDecoderBank_CheckDecode(37, IMAADPCM_KERNEL_AUTO), 1);
+  if (IMAADPCM_IsKernelAvailable(IMAADPCM_KERNEL_SSE41)) {
+    Test_AssertEqual(testIMAADPCMDecoderBank_CheckDecode(37, IMAADPCM_KERNEL_SSE41), 1);
+  }
+  if (IMAADPCM_IsKernelAvailable(IMAADPCM_KERNEL_AVX2)) {
+    Test_AssertEqual(testIMAADPCMDecoderBank_CheckDecode(37, IMAADPCM_KERNEL_AVX2), 1);
+  }
+  Test_AssertEqual(testIMAADPCMDecoderBank_CheckDecode(64, IMAADPCM_KERNEL_AUTO), 1);
+}
+
+/* デコード・ミックスの結果が一括デコード結果にゲインを掛けて加算したものと一致するか確認するサブルーチン 一致していたら1, していなければ0を返す */
+static uint8_t testIMAADPCMWAVDecoder_CheckDecodeMix(
+    uint16_t num_channels, uint16_t block_size, uint32_t num_samples)
+{
+  uint32_t ch, smpl, trial, output_size, is_ok, start, count, num_decode_samples;
+  int32_t gain;
+  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS], *reference[IMAADPCM_MAX_NUM_CHANNELS];
+  int32_t *int_bus[IMAADPCM_MAX_NUM_CHANNELS], *int_initial[IMAADPCM_MAX_NUM_CHANNELS];
+  float *float_bus[IMAADPCM_MAX_NUM_CHANNELS], *float_initial[IMAADPCM_MAX_NUM_CHANNELS];
+  uint8_t *data;
+  const uint32_t num_samples_per_block = (uint32_t)(block_size - 4 * num_channels) * 2 / num_channels + 1;
+  struct IMAADPCMWAVDecoder *decoder;
+
+  for (ch = 0; ch < num_channels; ch++) {
+    int_bus[ch] = malloc(sizeof(int32_t) * (num_samples + 1));
+    int_initial[ch] = malloc(sizeof(int32_t) * (num_samples + 1));
+    float_bus[ch] = malloc(sizeof(float) * (num_samples + 1));
+    float_initial[ch] = malloc(sizeof(float) * (num_samples + 1));
+  }
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+
+  is_ok = 0;
+  if (testIMAADPCM_CreateEncodedFixture(num_channels, num_samples, block_size,
+        input, &data, &output_size, reference) != 1) {
+    goto CHECK_END;
+  }
+
+  /* バスには既に他のストリームが加算されている想定 */
+  for (ch = 0; ch < num_channels; ch++) {
+    for (smpl = 0; smpl <= num_samples; smpl++) {
+      int_initial[ch][smpl] = rand() % 65536 - 32768;
+      float_initial[ch][smpl] = (float)(rand() % 65536 - 32768) / 32768.0f;
+    }
+  }
+
+  /* ブロック境界をまたぐ範囲・末尾を超える範囲、等倍・負・上限のゲインを含めて確認 */
+  for (trial = 0; trial < 100; trial++) {
+    start = (uint32_t)rand() % num_samples;
+    count = (trial % 2 == 0) ? ((uint32_t)rand() % (3 * num_samples_per_block) + 1) : num_samples;
+    switch (trial % 5) {
+      case 0:   gain = IMAADPCM_MIX_GAIN_ONE; break;
+      case 1:   gain = -IMAADPCM_MIX_MAX_GAIN; break;
+      case 2:   gain = IMAADPCM_MIX_MAX_GAIN; break;
+      default:  gain = rand() % (2 * IMAADPCM_MIX_MAX_GAIN + 1) - IMAADPCM_MIX_MAX_GAIN; break;
+    }
+    for (ch = 0; ch < num_channels; ch++) {
+      memcpy(int_bus[ch], int_initial[ch], sizeof(int32_t) * (num_samples + 1));
+      memcpy(float_bus[ch], float_initial[ch], sizeof(float) * (num_samples + 1));
+    }
+    if ((IMAADPCMWAVDecoder_DecodeRangeMix(decoder, data, output_size,
+          start, count, gain, int_bus, num_channels, num_samples + 1, &num_decode_samples) != IMAADPCM_APIRESULT_OK)
+        || (num_decode_samples != IMAADPCM_MIN_VAL(count, num_samples - start))) {
+      goto CHECK_END;
+    }
+    if ((IMAADPCMWAVDecoder_DecodeRangeMixFloat(decoder, data, output_size,
+          start, count, gain, float_bus, num_channels, num_samples + 1, &num_decode_samples) != IMAADPCM_APIRESULT_OK)
+        || (num_decode_samples != IMAADPCM_MIN_VAL(count, num_samples - start))) {
+      goto CHECK_END;
+    }
+    for (ch = 0; ch < num_channels; ch++) {
+      for (smpl = 0; smpl < num_decode_samples; smpl++) {
+        const int32_t product = reference[ch][start + smpl] * gain;
+        if (int_bus[ch][smpl] != int_initial[ch][smpl] + (int32_t)floor(product / 32768.0 + 0.5)) {
+          goto CHECK_END;
+        }
+        if (fabs(float_bus[ch][smpl] - (float_initial[ch][smpl] + product / (32768.0 * 32768.0))) > 1.0e-6) {
+          goto CHECK_END;
+        }
+      }
+      /* 範囲外には加算しない */
+      if ((int_bus[ch][num_decode_samples] != int_initial[ch][num_decode_samples])
+          || (float_bus[ch][num_decode_samples] != float_initial[ch][num_decode_samples])) {
+        goto CHECK_END;
+      }
+    }
+  }
+
+  /* 範囲末尾までのデータが無い */
+  if (IMAADPCMWAVDecoder_DecodeRangeMix(decoder, data, output_size - 1,
+        num_samples - 1, 1, IMAADPCM_MIX_GAIN_ONE, int_bus, num_channels, num_samples, &num_decode_samples)
+      != IMAADPCM_APIRESULT_INSUFFICIENT_DATA) {
+    goto CHECK_END;
+  }
+
+  is_ok = 1;
+
+CHECK_END:
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  free(data);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(input[ch]);
+    free(reference[ch]);
+    free(int_bus[ch]);
+    free(int_initial[ch]);
+    free(float_bus[ch]);
+    free(float_initial[ch]);
+  }
+
+  return is_ok;
+}
+
+/* デコード・ミックステスト */
+static void testIMAADPCMWAVDecoder_DecodeMixTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 不正な引数 */
+  {
+    uint8_t data[64] = { 0, };
+    int32_t int_buf[16];
+    float float_buf[16];
+    int32_t *int_bus[1];
+    float *float_bus[1];
+    uint32_t num_decode_samples;
+    struct IMAADPCMWAVDecoder *decoder;
+
+    int_bus[0] = int_buf;
+    float_bus[0] = float_buf;
+    decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeRangeMix(NULL,
+          data, sizeof(data), 0, 16, IMAADPCM_MIX_GAIN_ONE, int_bus, 1, 16, &num_decode_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeRangeMix(decoder,
+          NULL, sizeof(data), 0, 16, IMAADPCM_MIX_GAIN_ONE, int_bus, 1, 16, &num_decode_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeRangeMix(decoder,
+          data, sizeof(data), 0, 16, IMAADPCM_MIX_GAIN_ONE, NULL, 1, 16, &num_decode_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeRangeMix(decoder,
+          data, sizeof(data), 0, 16, IMAADPCM_MIX_GAIN_ONE, int_bus, 1, 16, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeRangeMix(decoder,
+          data, sizeof(data), 0, 16, IMAADPCM_MIX_MAX_GAIN + 1, int_bus, 1, 16, &num_decode_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeRangeMixFloat(decoder,
+          data, sizeof(data), 0, 16, IMAADPCM_MIX_GAIN_ONE, NULL, 1, 16, &num_decode_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeRangeMixFloat(decoder,
+          data, sizeof(data), 0, 16, -IMAADPCM_MIX_MAX_GAIN - 1, float_bus, 1, 16, &num_decode_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    IMAADPCMWAVDecoder_Destroy(decoder);
+  }
+
+  /* 一括デコードとの一致確認 */
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeMix(1,  256, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeMix(1,  256, 505 * 10 + 100), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeMix(1, 1024, 2041 * 5 + 2), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeMix(2,  256, 249 * 21 + 17), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeMix(2, 1024, 1017 * 5 + 500), 1);
+}
+
+/* リサンプリングデコードの結果が一括デコード結果を変換したものと一致するか確認するサブルーチン 一致していたら1, していなければ0を返す */
+/* 一括デコード結果の前後に0を詰め、出力位置毎に窓を直接参照して期待値を作る 出力は毎回ランダムなサンプル数ずつ取り出す */
+static uint8_t testIMAADPCMWAVDecoder_CheckDecodeResample(
+    uint16_t num_channels, uint16_t block_size, uint32_t num_samples,
+    uint32_t sampling_rate, uint32_t output_sampling_rate, IMAADPCMResampleMode mode)
+{
+  uint32_t ch, smpl, tap, output_size, is_ok, num_output_samples, progress, num_decode_samples;
+  uint32_t position, position_frac, step_int, step_frac;
+  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS], *reference[IMAADPCM_MAX_NUM_CHANNELS], *output[IMAADPCM_MAX_NUM_CHANNELS];
+  int16_t *buffer_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+  uint8_t *data;
+  const uint32_t data_size = 2 * num_samples * num_channels + block_size;
+  const uint32_t num_taps = (mode == IMAADPCM_RESAMPLE_LINEAR) ? 2 : IMAADPCM_RESAMPLE_NUM_TAPS;
+  const uint32_t max_num_output_samples = (uint32_t)(((uint64_t)num_samples * output_sampling_rate) / sampling_rate + 2);
+  struct IMAADPCMWAVDecoder *decoder;
+  struct IMAADPCMWAVEncoder *encoder;
+  struct IMAADPCMWAVEncodeParameter enc_param;
+
+  srand(0);
+  for (ch = 0; ch < num_channels; ch++) {
+    input[ch] = malloc(sizeof(int16_t) * num_samples);
+    reference[ch] = malloc(sizeof(int16_t) * num_samples);
+    output[ch] = malloc(sizeof(int16_t) * max_num_output_samples);
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      input[ch][smpl] = (int16_t)(16000.0 * sin(0.05 * smpl * (ch + 1)) + (rand() % 4096) - 2048);
+    }
+  }
+  data = malloc(data_size);
+
+  encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+  enc_param.num_channels = num_channels;
+  enc_param.sampling_rate = sampling_rate;
+  enc_param.bits_per_sample = 4;
+  enc_param.block_size = block_size;
+
+  is_ok = 0;
+  if ((IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_EncodeWhole(encoder,
+          (const int16_t *const *)input, num_samples, data, data_size, &output_size) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVDecoder_DecodeWhole(decoder,
+          data, output_size, reference, num_channels, num_samples) != IMAADPCM_APIRESULT_OK)) {
+    goto CHECK_END;
+  }
+
+  /* 総サンプル数は入力の末尾より手前の位置に対応する出力の数 */
+  if ((IMAADPCMWAVDecoder_BeginResample(decoder, data, output_size,
+          output_sampling_rate, mode, &num_output_samples) != IMAADPCM_APIRESULT_OK)
+      || (num_output_samples != (uint32_t)(((uint64_t)num_samples * output_sampling_rate + sampling_rate - 1) / sampling_rate))) {
+    goto CHECK_END;
+  }
+
+  /* ランダムなサンプル数ずつ末尾まで取り出す */
+  progress = 0;
+  while (progress < num_output_samples) {
+    for (ch = 0; ch < num_channels; ch++) {
+      buffer_ptr[ch] = &output[ch][progress];
+    }
+    if ((IMAADPCMWAVDecoder_DecodeResample(decoder, buffer_ptr, num_channels,
+            IMAADPCM_MIN_VAL((uint32_t)rand() % 300 + 1, max_num_output_samples - progress), &num_decode_samples) != IMAADPCM_APIRESULT_OK)
+        || (num_decode_samples == 0)) {
+      goto CHECK_END;
+    }
+    progress += num_decode_samples;
+  }
+  /* 末尾以降は0サンプル */
+  if ((IMAADPCMWAVDecoder_DecodeResample(decoder, output, num_channels,
+          max_num_output_samples, &num_decode_samples) != IMAADPCM_APIRESULT_OK)
+      || (num_decode_samples != 0)) {
+    goto CHECK_END;
+  }
+
+  /* 期待値との比較 */
+  step_int = sampling_rate / output_sampling_rate;
+  step_frac = (uint32_t)(((uint64_t)(sampling_rate % output_sampling_rate) << 32) / output_sampling_rate);
+  position = position_frac = 0;
+  for (smpl = 0; smpl < num_output_samples; smpl++) {
+    for (ch = 0; ch < num_channels; ch++) {
+      int32_t x[IMAADPCM_RESAMPLE_NUM_TAPS], expect;
+      for (tap = 0; tap < num_taps; tap++) {
+        const int64_t pos = (int64_t)position + tap - (num_taps / 2 - 1);
+        x[tap] = ((pos >= 0) && (pos < (int64_t)num_samples)) ? reference[ch][pos] : 0;
+      }
+      if (mode == IMAADPCM_RESAMPLE_LINEAR) {
+        expect = x[0] + (((x[1] - x[0]) * (int32_t)(position_frac >> 17) + (1 << 14)) >> 15);
+      } else {
+        const int16_t *row = &decoder->resample.coef[(position_frac >> (32 - IMAADPCM_RESAMPLE_PHASE_BITS)) * IMAADPCM_RESAMPLE_NUM_TAPS];
+        expect = 0;
+        for (tap = 0; tap < num_taps; tap++) {
+          expect += row[tap] * x[tap];
+        }
+        expect = IMAADPCM_INNER_VAL((expect + (1 << 14)) >> 15, -32768, 32767);
+      }
+      if (output[ch][smpl] != expect) {
+        goto CHECK_END;
+      }
+    }
+    position_frac += step_frac;
+    position += step_int + ((position_frac < step_frac) ? 1 : 0);
+  }
+
+  is_ok = 1;
+
+CHECK_END:
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  IMAADPCMWAVEncoder_Destroy(encoder);
+  free(data);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(input[ch]);
+    free(reference[ch]);
+    free(output[ch]);
+  }
+
+  return is_ok;
+}
+
+/* リサンプリングデコードテスト */
+static void testIMAADPCMWAVDecoder_DecodeResampleTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 不正な引数・開始前の呼び出し */
+  {
+    uint8_t data[64] = { 0, };
+    int16_t buf[16];
+    int16_t *buffer[1];
+    uint32_t num_samples;
+    struct IMAADPCMWAVDecoder *decoder;
+
+    buffer[0] = buf;
+    decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+    Test_AssertEqual(IMAADPCMWAVDecoder_BeginResample(NULL,
+          data, sizeof(data), 48000, IMAADPCM_RESAMPLE_LINEAR, &num_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_BeginResample(decoder,
+          NULL, sizeof(data), 48000, IMAADPCM_RESAMPLE_LINEAR, &num_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_BeginResample(decoder,
+          data, sizeof(data), 0, IMAADPCM_RESAMPLE_LINEAR, &num_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_BeginResample(decoder,
+          data, sizeof(data), 48000, (IMAADPCMResampleMode)2, &num_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_BeginResample(decoder,
+          data, sizeof(data), 48000, IMAADPCM_RESAMPLE_LINEAR, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_BeginResample(decoder,
+          data, sizeof(data), 48000, IMAADPCM_RESAMPLE_LINEAR, &num_samples), IMAADPCM_APIRESULT_INVALID_FORMAT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeResample(decoder, buffer, 1, 16, &num_samples), IMAADPCM_APIRESULT_NG);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeResample(NULL, buffer, 1, 16, &num_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeResample(decoder, NULL, 1, 16, &num_samples), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeResample(decoder, buffer, 1, 16, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    IMAADPCMWAVDecoder_Destroy(decoder);
+  }
+
+  /* 多相フィルタは位相毎に直流利得が1 */
+  {
+    uint32_t phase, tap;
+    int32_t sum;
+    int16_t coef[IMAADPCM_RESAMPLE_NUM_PHASES * IMAADPCM_RESAMPLE_NUM_TAPS];
+    IMAADPCMWAVDecoder_MakeResampleFilter(coef, IMAADPCM_RESAMPLE_CUTOFF);
+    for (phase = 0; phase < IMAADPCM_RESAMPLE_NUM_PHASES; phase++) {
+      sum = 0;
+      for (tap = 0; tap < IMAADPCM_RESAMPLE_NUM_TAPS; tap++) {
+        sum += coef[phase * IMAADPCM_RESAMPLE_NUM_TAPS + tap];
+      }
+      Test_AssertEqual(sum, 32768);
+    }
+  }
+
+  /* 一括デコードからの変換との一致確認（アップサンプル・ダウンサンプル・等倍・大きな間引き） */
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeResample(1,  256, 505 * 7 + 3, 44100, 48000, IMAADPCM_RESAMPLE_LINEAR), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeResample(1,  256, 505 * 7 + 3, 44100, 48000, IMAADPCM_RESAMPLE_POLYPHASE), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeResample(1, 1024, 2041 * 2 + 1, 8000, 48000, IMAADPCM_RESAMPLE_POLYPHASE), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeResample(2,  256, 249 * 9 + 17, 22050, 48000, IMAADPCM_RESAMPLE_LINEAR), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeResample(2,  256, 249 * 9 + 17, 22050, 48000, IMAADPCM_RESAMPLE_POLYPHASE), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeResample(2, 1024, 1017 * 3 + 5, 48000, 44100, IMAADPCM_RESAMPLE_POLYPHASE), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeResample(1,  256, 505 * 3, 16000, 16000, IMAADPCM_RESAMPLE_LINEAR), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeResample(2,  256, 249 * 60, 192000, 1000, IMAADPCM_RESAMPLE_POLYPHASE), 1);
+}
+
+/* エンコードハンドル作成破棄テスト */
+static void testIMAADPCMWAVEncoder_CreateDestroyTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* ワークサイズ計算テスト */
+  {
+    int32_t work_size;
+
+    work_size = IMAADPCMWAVEncoder_CalculateWorkSize();
+    Test_AssertCondition(work_size >= (int32_t)sizeof(struct IMAADPCMWAVEncoder));
+  }
+
+  /* ワーク領域渡しによるハンドル作成（成功例） */
+  {
+    void *work;
+    int32_t work_size;
+    struct IMAADPCMWAVEncoder *encoder;
+
+    work_size = IMAADPCMWAVEncoder_CalculateWorkSize();
+    work = malloc(work_size);
+
+    encoder = IMAADPCMWAVEncoder_Create(work, work_size);
+    Test_AssertCondition(encoder != NULL);
+    Test_AssertCondition(encoder->work == NULL);
+    Test_AssertCondition(encoder->set_parameter == 0);
+
+    IMAADPCMWAVEncoder_Destroy(encoder);
+    free(work);
+  }
+
+  /* 自前確保によるハンドル作成（成功例） */
+  {
+    struct IMAADPCMWAVEncoder *encoder;
+
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    Test_AssertCondition(encoder != NULL);
+    Test_AssertCondition(encoder->work != NULL);
+
+    IMAADPCMWAVEncoder_Destroy(encoder);
+  }
+
+  /* ワーク領域渡しによるハンドル作成（失敗ケース） */
+  {
+    void *work;
+    int32_t work_size;
+    struct IMAADPCMWAVEncoder *encoder;
+
+    work_size = IMAADPCMWAVEncoder_CalculateWorkSize();
+    work = malloc(work_size);
+
+    /* 引数が不正 */
+    encoder = IMAADPCMWAVEncoder_Create(NULL, work_size);
+    Test_AssertCondition(encoder == NULL);
+    encoder = IMAADPCMWAVEncoder_Create(work, 0);
+    Test_AssertCondition(encoder == NULL);
+
+    /* ワークサイズ不足 */
+    encoder = IMAADPCMWAVEncoder_Create(work, work_size - 1);
+    Test_AssertCondition(encoder == NULL);
+
+    free(work);
+  }
+}
+
+/* エンコードパラメータ設定テスト */
+static void testIMAADPCMWAVEncoder_SetEncodeParameterTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 有効なパラメータをセット */
+#define IMAADPCM_SetValidParameter(p_param) {               \
+    struct IMAADPCMWAVEncodeParameter *p__param = p_param;  \
+    p__param->num_channels    = 1;                          \
+    p__param->sampling_rate   = 8000;                       \
+    p__param->bits_per_sample = IMAADPCM_BITS_PER_SAMPLE;   \
+    p__param->block_size      = 256;                        \
+}
+
+  /* 成功例 */
+  {
+    struct IMAADPCMWAVEncoder *encoder;
+    struct IMAADPCMWAVEncodeParameter param;
+
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    
+    IMAADPCM_SetValidParameter(&param);
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &param), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(encoder->set_parameter, 1);
+    Test_AssertEqual(memcmp(&(encoder->encode_paramemter), &param, sizeof(struct IMAADPCMWAVEncodeParameter)), 0);
+
+    IMAADPCMWAVEncoder_Destroy(encoder);
+  }
+
+  /* 失敗ケース */
+  {
+    struct IMAADPCMWAVEncoder *encoder;
+    struct IMAADPCMWAVEncodeParameter param;
+
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+
+    /* 引数が不正 */
+    IMAADPCM_SetValidParameter(&param);
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(NULL,  &param), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+
+    /* サンプルあたりビット数が異常 */
+    IMAADPCM_SetValidParameter(&param);
+    param.bits_per_sample = 0;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &param), IMAADPCM_APIRESULT_INVALID_FORMAT);
+
+    /* ブロックサイズが小さすぎる */
+    IMAADPCM_SetValidParameter(&param);
+    param.block_size = 0;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &param), IMAADPCM_APIRESULT_INVALID_FORMAT);
+    IMAADPCM_SetValidParameter(&param);
+    param.block_size = param.num_channels * 4;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &param), IMAADPCM_APIRESULT_INVALID_FORMAT);
+
+    IMAADPCMWAVEncoder_Destroy(encoder);
+  }
+}
+
+/* エンコード→デコードテスト 成功時は1, 失敗時は0を返す */
+static uint8_t testIMAADPCMWAVEncoder_EncodeDecodeTest(
+    const char *wav_filename, uint16_t bits_per_sample, uint16_t block_size, double rms_epsilon)
+{
+  struct WAVFile *wavfile;
+  struct stat fstat;
+  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS];
+  int16_t *decoded[IMAADPCM_MAX_NUM_CHANNELS];
+  uint8_t is_ok;
+  uint32_t ch, smpl, buffer_size, output_size;
+  uint32_t num_channels, num_samples;
+  uint8_t *buffer;
+  double rms_error;
+  struct IMAADPCMWAVEncodeParameter enc_param;
+  struct IMAADPCMWAVEncoder *encoder;
+  struct IMAADPCMWAVDecoder *decoder;
+
+  assert((wav_filename != NULL) && (rms_epsilon >= 0.0f));
+
+  /* 入力wav取得 */
+  wavfile = WAV_CreateFromFile(wav_filename);
+  assert(wavfile != NULL);
+  num_channels = wavfile->format.num_channels;
+  num_samples = wavfile->format.num_samples;
+
+  /* 出力データの領域割当て */
+  for (ch = 0; ch < num_channels; ch++) {
+    input[ch]   = malloc(sizeof(int16_t) * num_samples);
+    decoded[ch] = malloc(sizeof(int16_t) * num_samples);
+  }
+  /* 入力wavと同じサイズの出力領域を確保（増えることはないと期待） */
+  stat(wav_filename, &fstat);
+  buffer_size = fstat.st_size;
+  buffer = malloc(buffer_size);
+
+  /* 16bit幅でデータ取得 */
+  for (ch = 0; ch < num_channels; ch++) {
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      input[ch][smpl] = WAVFile_PCM(wavfile, smpl, ch) >> 16;
+    }
+  }
+
+  /* ハンドル作成 */
+  encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+
+  /* エンコードパラメータをセット */
+  enc_param.num_channels    = num_channels;
+  enc_param.sampling_rate   = wavfile->format.sampling_rate;
+  enc_param.bits_per_sample = bits_per_sample;
+  enc_param.block_size      = block_size;
+  if (IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK) {
+    is_ok = 0;
+    goto CHECK_END;
+  }
+
+  /* エンコード */
+  if (IMAADPCMWAVEncoder_EncodeWhole(
+        encoder, (const int16_t *const *)input, num_samples,
+        buffer, buffer_size, &output_size) != IMAADPCM_APIRESULT_OK) {
+    is_ok = 0;
+    goto CHECK_END;
+  }
+  /* 半分以下にはなるはず */
+  if (output_size >= (buffer_size / 2)) {
+    is_ok = 0;
+    goto CHECK_END;
+  }
+
+  /* デコード */
+  if (IMAADPCMWAVDecoder_DecodeWhole(
+        decoder, buffer, output_size,
+        decoded, num_channels, num_samples) != IMAADPCM_APIRESULT_OK) {
+    is_ok = 0;
+    goto CHECK_END;
+  }
+
+  /* ロスがあるのでRMSE基準でチェック */
+  rms_error = 0.0;
+  for (ch = 0; ch < num_channels; ch++) {
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      double pcm1, pcm2, abs_error;
+      pcm1 = (double)input[ch][smpl] / INT16_MAX;
+      pcm2 = (double)decoded[ch][smpl] / INT16_MAX;
+      abs_error = fabs(pcm1 - pcm2);
+      rms_error += abs_error * abs_error;
+    }
+  }
+  rms_error = sqrt(rms_error / (num_samples * num_channels));
+
+  /* マージンチェック */
+  if (rms_error < rms_epsilon) {
+    is_ok = 1;
+  } else {
+    is_ok = 0;
+  }
+
+CHECK_END:
+  /* 領域開放 */
+  IMAADPCMWAVEncoder_Destroy(encoder);
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  free(buffer);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(input[ch]);
+    free(decoded[ch]);
+  }
+
+  return is_ok;
+}
+
+/* エンコードテスト */
+static void testIMAADPCMWAVDecoder_EncodeTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 簡単なデータをエンコード→デコードしてみる */
+  {
+#define NUM_CHANNELS  1
+#define NUM_SAMPLES   1024
+    int16_t *input[IMAADPCM_MAX_NUM_CHANNELS];
+    int16_t *decoded[IMAADPCM_MAX_NUM_CHANNELS];
+    uint32_t ch, smpl, buffer_size, output_size;
+    uint8_t *buffer;
+    double rms_error;
+    struct IMAADPCMWAVEncodeParameter enc_param;
+    struct IMAADPCMWAVEncoder *encoder;
+    struct IMAADPCMWAVDecoder *decoder;
+
+    /* 出力データの領域割当て */
+    for (ch = 0; ch < NUM_CHANNELS; ch++) {
+      input[ch] = malloc(sizeof(int16_t) * NUM_SAMPLES);
+      decoded[ch] = malloc(sizeof(int16_t) * NUM_SAMPLES);
+    }
+    /* 入力wavと同じサイズの出力領域を確保（増えることはないと期待） */
+    buffer_size = NUM_CHANNELS * NUM_SAMPLES * sizeof(int16_t);
+    buffer = malloc(buffer_size);
+
+    /* データ作成: 正弦波 */
+    for (ch = 0; ch < NUM_CHANNELS; ch++) {
+      for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+        input[ch][smpl] = (int16_t)(INT16_MAX * sin((2.0 * 3.1415 * 440.0 * smpl) / 48000.0));
+      }
+    }
+
+    /* ハンドル作成 */
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+
+    /* エンコードパラメータをセット */
+    enc_param.num_channels    = NUM_CHANNELS;
+    enc_param.sampling_rate   = 8000;
+    enc_param.bits_per_sample = IMAADPCM_BITS_PER_SAMPLE;
+    enc_param.block_size      = 256;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param), IMAADPCM_APIRESULT_OK);
+
+    /* エンコード */
+    Test_AssertEqual(
+        IMAADPCMWAVEncoder_EncodeWhole(
+          encoder, (const int16_t *const *)input, NUM_SAMPLES,
+          buffer, buffer_size, &output_size), IMAADPCM_APIRESULT_OK);
+    /* 半分以下にはなるはず */
+    Test_AssertCondition(output_size < (buffer_size / 2));
+
+    /* デコード */
+    Test_AssertEqual(
+        IMAADPCMWAVDecoder_DecodeWhole(
+          decoder, buffer, output_size,
+          decoded, NUM_CHANNELS, NUM_SAMPLES), IMAADPCM_APIRESULT_OK);
+
+    /* ロスがあるのでRMSE基準でチェック */
+    rms_error = 0.0;
+    for (ch = 0; ch < NUM_CHANNELS; ch++) {
+      for (smpl = 0; smpl < NUM_SAMPLES; smpl++) {
+        double pcm1, pcm2, abs_error;
+        pcm1 = (double)input[ch][smpl] / INT16_MAX;
+        pcm2 = (double)decoded[ch][smpl] / INT16_MAX;
+        abs_error = fabs(pcm1 - pcm2);
+        rms_error += abs_error * abs_error;
+      }
+    }
+    rms_error = sqrt(rms_error / (NUM_SAMPLES * NUM_CHANNELS));
+
+    /* 経験的に0.05 */
+    Test_AssertCondition(rms_error < 5.0e-2);
+
+    /* 領域開放 */
+    IMAADPCMWAVEncoder_Destroy(encoder);
+    IMAADPCMWAVDecoder_Destroy(decoder);
+    free(buffer);
+    for (ch = 0; ch < NUM_CHANNELS; ch++) {
+      free(input[ch]);
+      free(decoded[ch]);
+    }
+#undef NUM_CHANNELS
+#undef NUM_SAMPLES
+  }
+
+  /* エンコードデコードテスト */
+  {
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse_mono.wav", 4,  128, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse_mono.wav", 4,  256, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse_mono.wav", 4,  512, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse_mono.wav", 4, 1024, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse.wav",      4,  128, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse.wav",      4,  256, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse.wav",      4,  512, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("unit_impulse.wav",      4, 1024, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz_mono.wav",     4,  128, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz_mono.wav",     4,  256, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz_mono.wav",     4,  512, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz_mono.wav",     4, 1024, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz.wav",          4,  128, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz.wav",          4,  256, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz.wav",          4,  512, 5.0e-2), 1);
+    Test_AssertEqual(testIMAADPCMWAVEncoder_EncodeDecodeTest("sin300Hz.wav",          4, 1024, 5.0e-2), 1);
+  }
+
+}
+
+/* 並列エンコードの結果がタスク数・実行順によらず一致するか確認するサブルーチン 一致していたら1, していなければ0を返す */
+static uint8_t testIMAADPCMWAVEncoder_CheckEncodeParallel(
+    uint16_t num_channels, uint16_t block_size, uint32_t num_samples)
+{
+  uint32_t ch, smpl, i, is_ok, num_executed_tasks;
+  uint32_t serial_size, reference_size, output_size;
+  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS], *decoded[IMAADPCM_MAX_NUM_CHANNELS];
+  uint8_t *serial, *reference, *output;
+  double serial_error, parallel_error;
+  const uint32_t data_size = 2 * num_samples * num_channels + 2 * block_size;
+  const uint32_t num_tasks[] = { 2, 3, 7, IMAADPCM_MAX_NUM_TASKS + 10 };
+  const IMAADPCMKernel kernels[] = { IMAADPCM_KERNEL_SSE41, IMAADPCM_KERNEL_AVX2, IMAADPCM_KERNEL_AUTO };
+  struct IMAADPCMWAVDecoder *decoder;
+  struct IMAADPCMWAVEncoder *encoder, *serial_encoder;
+  struct IMAADPCMWAVEncodeParameter enc_param;
+
+  srand(0);
+  for (ch = 0; ch < num_channels; ch++) {
+    input[ch] = malloc(sizeof(int16_t) * num_samples);
+    decoded[ch] = malloc(sizeof(int16_t) * num_samples);
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      const double envelope = 0.5 + 0.5 * sin(0.0003 * smpl);
+      input[ch][smpl] = (int16_t)(envelope * 16000.0 * sin(0.05 * smpl * (ch + 1)) + (rand() % 1024) - 512);
+    }
+  }
+  serial = malloc(data_size);
+  reference = malloc(data_size);
+  output = malloc(data_size);
+
+  encoder = IMAADPCMWAVEncoder_CreateParallel(IMAADPCM_MAX_NUM_TASKS, NULL, 0);
+  serial_encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+  enc_param.num_channels = num_channels;
+  enc_param.sampling_rate = 44100;
+  enc_param.bits_per_sample = 4;
+  enc_param.block_size = block_size;
+
+  /* 基準の出力はスカラ処理で作る */
+  is_ok = 0;
+  if ((IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_SetKernel(encoder, IMAADPCM_KERNEL_SCALAR) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_EncodeWhole(encoder,
+          (const int16_t *const *)input, num_samples, serial, data_size, &serial_size) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+          (const int16_t *const *)input, num_samples, reference, data_size, &reference_size, 1, NULL, NULL) != IMAADPCM_APIRESULT_OK)) {
+    goto CHECK_END;
+  }
+
+  /* 出力サイズは逐次エンコードと一致 */
+  if (reference_size != serial_size) {
+    goto CHECK_END;
+  }
+
+  /* 複数ブロック同時エンコードのカーネルでも出力は一致 */
+  for (i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+    /* 実行中のCPUで使えないカーネルはスキップ */
+    if (IMAADPCMWAVEncoder_SetKernel(encoder, kernels[i]) != IMAADPCM_APIRESULT_OK) {
+      continue;
+    }
+    memset(output, 0, data_size);
+    if ((IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+            (const int16_t *const *)input, num_samples, output, data_size, &output_size,
+            2, NULL, NULL) != IMAADPCM_APIRESULT_OK)
+        || (output_size != reference_size) || (memcmp(output, reference, reference_size) != 0)) {
+      goto CHECK_END;
+    }
+  }
+
+  /* タスク数と実行順を変えても出力は一致 */
+  for (i = 0; i < sizeof(num_tasks) / sizeof(num_tasks[0]); i++) {
+    memset(output, 0, data_size);
+    if ((IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+            (const int16_t *const *)input, num_samples, output, data_size, &output_size,
+            num_tasks[i], NULL, NULL) != IMAADPCM_APIRESULT_OK)
+        || (output_size != reference_size) || (memcmp(output, reference, reference_size) != 0)) {
+      goto CHECK_END;
+    }
+    num_executed_tasks = 0;
+    memset(output, 0, data_size);
+    if ((IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+            (const int16_t *const *)input, num_samples, output, data_size, &output_size,
+            num_tasks[i], testIMAADPCMWAVDecoder_ExecuteTasksReverse, &num_executed_tasks) != IMAADPCM_APIRESULT_OK)
+        || (output_size != reference_size) || (memcmp(output, reference, reference_size) != 0)
+        || (num_executed_tasks > IMAADPCM_MAX_NUM_TASKS)) {
+      goto CHECK_END;
+    }
+  }
+
+  /* タスク毎の領域が無いハンドルでは呼び出しスレッドでエンコードし、出力は一致 */
+  num_executed_tasks = 0;
+  memset(output, 0, data_size);
+  if ((IMAADPCMWAVEncoder_SetEncodeParameter(serial_encoder, &enc_param) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_EncodeWholeParallel(serial_encoder,
+          (const int16_t *const *)input, num_samples, output, data_size, &output_size,
+          3, testIMAADPCMWAVDecoder_ExecuteTasksReverse, &num_executed_tasks) != IMAADPCM_APIRESULT_OK)
+      || (output_size != reference_size) || (memcmp(output, reference, reference_size) != 0)
+      || (num_executed_tasks != 0)) {
+    goto CHECK_END;
+  }
+
+  /* 量子化誤差は逐次エンコードと同程度 */
+  serial_error = parallel_error = 0.0;
+  if (IMAADPCMWAVDecoder_DecodeWhole(decoder,
+        serial, serial_size, decoded, num_channels, num_samples) != IMAADPCM_APIRESULT_OK) {
+    goto CHECK_END;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      const double diff = input[ch][smpl] - decoded[ch][smpl];
+      serial_error += diff * diff;
+    }
+  }
+  if (IMAADPCMWAVDecoder_DecodeWhole(decoder,
+        reference, reference_size, decoded, num_channels, num_samples) != IMAADPCM_APIRESULT_OK) {
+    goto CHECK_END;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      const double diff = input[ch][smpl] - decoded[ch][smpl];
+      parallel_error += diff * diff;
+    }
+  }
+  if (parallel_error > 1.1 * serial_error) {
+    goto CHECK_END;
+  }
+
+  is_ok = 1;
+
+CHECK_END:
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  IMAADPCMWAVEncoder_Destroy(encoder);
+  IMAADPCMWAVEncoder_Destroy(serial_encoder);
+  free(serial);
+  free(reference);
+  free(output);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(input[ch]);
+    free(decoded[ch]);
+  }
+
+  return is_ok;
+}
+
+/* 並列エンコードテスト */
+static void testIMAADPCMWAVEncoder_EncodeParallelTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* ワークサイズ計算・ハンドル作成 */
+  {
+    void *work;
+    int32_t work_size;
+    struct IMAADPCMWAVEncoder *encoder;
+
+    /* タスク数が不正 */
+    Test_AssertEqual(IMAADPCMWAVEncoder_CalculateParallelWorkSize(0), -1);
+    Test_AssertEqual(IMAADPCMWAVEncoder_CalculateParallelWorkSize(IMAADPCM_MAX_NUM_TASKS + 1), -1);
+    Test_AssertCondition(IMAADPCMWAVEncoder_CreateParallel(0, NULL, 0) == NULL);
+    Test_AssertCondition(IMAADPCMWAVEncoder_CreateParallel(IMAADPCM_MAX_NUM_TASKS + 1, NULL, 0) == NULL);
+
+    /* タスク毎の領域の分だけ大きい */
+    work_size = IMAADPCMWAVEncoder_CalculateParallelWorkSize(4);
+    Test_AssertCondition(work_size > IMAADPCMWAVEncoder_CalculateParallelWorkSize(3));
+    Test_AssertCondition(IMAADPCMWAVEncoder_CalculateParallelWorkSize(1) > IMAADPCMWAVEncoder_CalculateWorkSize());
+    Test_AssertCondition(IMAADPCMWAVEncoder_CalculateParallelWorkSize(IMAADPCM_MAX_NUM_TASKS) > 0);
+
+    /* ワーク領域渡し */
+    work = malloc(work_size);
+    encoder = IMAADPCMWAVEncoder_CreateParallel(4, work, work_size);
+    Test_AssertCondition(encoder != NULL);
+    Test_AssertCondition(encoder->work == NULL);
+    IMAADPCMWAVEncoder_Destroy(encoder);
+    Test_AssertCondition(IMAADPCMWAVEncoder_CreateParallel(4, work, work_size - 1) == NULL);
+    Test_AssertCondition(IMAADPCMWAVEncoder_CreateParallel(5, work, work_size) == NULL);
+    free(work);
+  }
+
+  /* 不正な引数 */
+  {
+    uint8_t data[256];
+    int16_t buf[16] = { 0, };
+    const int16_t *input[1];
+    uint32_t output_size;
+    struct IMAADPCMWAVEncoder *encoder;
+    struct IMAADPCMWAVEncodeParameter enc_param;
+
+    input[0] = buf;
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+          input, 16, data, sizeof(data), &output_size, 1, NULL, NULL), IMAADPCM_APIRESULT_PARAMETER_NOT_SET);
+    enc_param.num_channels = 1;
+    enc_param.sampling_rate = 44100;
+    enc_param.bits_per_sample = 4;
+    enc_param.block_size = 256;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeParallel(NULL,
+          input, 16, data, sizeof(data), &output_size, 1, NULL, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+          NULL, 16, data, sizeof(data), &output_size, 1, NULL, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+          input, 16, NULL, sizeof(data), &output_size, 1, NULL, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+          input, 16, data, sizeof(data), NULL, 1, NULL, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+          input, 16, data, sizeof(data), &output_size, 0, NULL, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    IMAADPCMWAVEncoder_Destroy(encoder);
+  }
+
+  /* 出力領域が足りない */
+  {
+    uint32_t ch, task, required_size, output_size;
+    int16_t *input[2];
+    uint8_t *data;
+    struct IMAADPCMWAVEncoder *encoder;
+    struct IMAADPCMWAVEncodeParameter enc_param;
+    const uint32_t num_samples = 249 * 41 + 17;
+
+    for (ch = 0; ch < 2; ch++) {
+      input[ch] = calloc(num_samples, sizeof(int16_t));
+    }
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    enc_param.num_channels = 2;
+    enc_param.sampling_rate = 44100;
+    enc_param.bits_per_sample = 4;
+    enc_param.block_size = 256;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVEncoder_CalculateOutputSize(&enc_param, num_samples, &required_size), IMAADPCM_APIRESULT_OK);
+    data = malloc(required_size);
+
+    /* 末尾のブロック・途中のブロックが書き出せない場合 */
+    for (task = 1; task <= 4; task++) {
+      Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+            (const int16_t *const *)input, num_samples, data, required_size - 1, &output_size, task, NULL, NULL),
+          IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER);
+      Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+            (const int16_t *const *)input, num_samples, data, required_size / 2, &output_size, task, NULL, NULL),
+          IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER);
+    }
+
+    /* ちょうどのサイズなら成功 */
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+          (const int16_t *const *)input, num_samples, data, required_size, &output_size, 4, NULL, NULL),
+        IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(output_size, required_size);
+
+    IMAADPCMWAVEncoder_Destroy(encoder);
+    free(data);
+    for (ch = 0; ch < 2; ch++) {
+      free(input[ch]);
+    }
+  }
+
+  /* タスク数・実行順によらない出力 */
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeParallel(1,  256, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeParallel(1,  256, 505 * 37), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeParallel(1,  256, 505 * 37 + 100), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeParallel(1, 1024, 2041 * 300 + 2), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeParallel(1,  258, 509 * 40), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeParallel(2,  256, 249 * 41 + 17), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeParallel(2, 1024, 1017 * 64 + 500), 1);
+}
+
+/* レイアウト指定エンコードの結果がint16に変換した入力のエンコード結果と一致するか確認するサブルーチン 一致していたら1, していなければ0を返す */
+/* int32の下位16bit・floatの丸め誤差未満のずれ・floatの範囲外の値も含めて確認する インターリーブ時は実際のチャンネル数より1つ多いストライドで読み込む */
+static uint8_t testIMAADPCMWAVEncoder_CheckEncodeLayout(
+    uint16_t num_channels, uint16_t block_size, uint32_t num_samples, uint32_t num_tasks)
+{
+  uint32_t ch, smpl, format, interleaved, stride, is_ok, ref_size, output_size;
+  int16_t *reference_input[IMAADPCM_MAX_NUM_CHANNELS];
+  int16_t *int16_input[IMAADPCM_MAX_NUM_CHANNELS + 1];
+  int32_t *int32_input[IMAADPCM_MAX_NUM_CHANNELS + 1];
+  float *float_input[IMAADPCM_MAX_NUM_CHANNELS + 1];
+  const void *input[IMAADPCM_MAX_NUM_CHANNELS + 1];
+  uint8_t *reference, *data;
+  const uint32_t data_size = 2 * num_samples * num_channels + block_size + IMAADPCMWAVENCODER_HEADER_SIZE;
+  struct IMAADPCMWAVEncoder *encoder;
+  struct IMAADPCMWAVEncodeParameter enc_param;
+  struct IMAADPCMInputLayout layout;
+  IMAADPCMApiResult ret;
+
+  for (ch = 0; ch <= num_channels; ch++) {
+    int16_input[ch] = calloc((num_samples + 1) * (num_channels + 1U), sizeof(int16_t));
+    int32_input[ch] = calloc((num_samples + 1) * (num_channels + 1U), sizeof(int32_t));
+    float_input[ch] = calloc((num_samples + 1) * (num_channels + 1U), sizeof(float));
+  }
+  testIMAADPCM_CreateSineNoiseInput(num_channels, num_samples, reference_input);
+  for (ch = 0; ch < num_channels; ch++) {
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      /* 飽和する値を混ぜる */
+      if ((smpl % 97) == 5) {
+        reference_input[ch][smpl] = 32767;
+      } else if ((smpl % 101) == 7) {
+        reference_input[ch][smpl] = -32768;
+      }
+    }
+  }
+  reference = malloc(data_size);
+  data = malloc(data_size);
+
+  enc_param.num_channels = num_channels;
+  enc_param.sampling_rate = 44100;
+  enc_param.bits_per_sample = 4;
+  enc_param.block_size = block_size;
+
+  /* 出力はint16の入力をそのままエンコードしたもの */
+  is_ok = 0;
+  encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  if ((IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK)
+      || (((num_tasks == 1)
+          ? IMAADPCMWAVEncoder_EncodeWhole(encoder,
+            (const int16_t *const *)reference_input, num_samples, reference, data_size, &ref_size)
+          : IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+            (const int16_t *const *)reference_input, num_samples, reference, data_size, &ref_size, num_tasks, NULL, NULL))
+        != IMAADPCM_APIRESULT_OK)) {
+    IMAADPCMWAVEncoder_Destroy(encoder);
+    goto CHECK_END;
+  }
+  IMAADPCMWAVEncoder_Destroy(encoder);
+
+  for (format = 0; format < 3; format++) {
+    for (interleaved = 0; interleaved < 2; interleaved++) {
+      layout.sample_format = (IMAADPCMSampleFormat)format;
+      layout.interleaved = (uint8_t)interleaved;
+      stride = interleaved ? (num_channels + 1U) : 1;
+      /* 入力の作成 */
+      for (ch = 0; ch < num_channels; ch++) {
+        const uint32_t buf_ch = interleaved ? 0 : ch;
+        const uint32_t offset = interleaved ? ch : 0;
+        for (smpl = 0; smpl < num_samples; smpl++) {
+          const int16_t val = reference_input[ch][smpl];
+          const uint32_t pos = smpl * stride + offset;
+          int16_input[buf_ch][pos] = val;
+          /* 下位16bitは切り捨てられる */
+          int32_input[buf_ch][pos] = (int32_t)val * 65536 + (rand() % 65536);
+          /* 範囲外は飽和する それ以外は最近接に丸められる */
+          if (val == 32767) {
+            float_input[buf_ch][pos] = 1.5f;
+          } else if (val == -32768) {
+            float_input[buf_ch][pos] = -1.5f;
+          } else {
+            float_input[buf_ch][pos] = ((float)val + 0.25f * (float)(rand() % 3 - 1)) / 32768.0f;
+          }
+        }
+      }
+      for (ch = 0; ch <= num_channels; ch++) {
+        switch (format) {
+          case IMAADPCM_SAMPLE_FORMAT_INT16: input[ch] = int16_input[ch]; break;
+          case IMAADPCM_SAMPLE_FORMAT_INT32: input[ch] = int32_input[ch]; break;
+          default:                           input[ch] = float_input[ch]; break;
+        }
+      }
+      encoder = (num_tasks == 1) ? IMAADPCMWAVEncoder_Create(NULL, 0)
+        : IMAADPCMWAVEncoder_CreateParallel(IMAADPCM_MIN_VAL(num_tasks, IMAADPCM_MAX_NUM_TASKS), NULL, 0);
+      if (IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK) {
+        IMAADPCMWAVEncoder_Destroy(encoder);
+        goto CHECK_END;
+      }
+      if (num_tasks == 1) {
+        ret = IMAADPCMWAVEncoder_EncodeWholeFromLayout(encoder, &layout,
+            input, interleaved ? (num_channels + 1U) : num_channels, num_samples, data, data_size, &output_size);
+      } else {
+        ret = IMAADPCMWAVEncoder_EncodeWholeParallelFromLayout(encoder, &layout,
+            input, interleaved ? (num_channels + 1U) : num_channels, num_samples, data, data_size, &output_size,
+            num_tasks, testIMAADPCMWAVDecoder_ExecuteTasksReverse, &smpl);
+      }
+      IMAADPCMWAVEncoder_Destroy(encoder);
+      if ((ret != IMAADPCM_APIRESULT_OK) || (output_size != ref_size)
+          || (memcmp(data, reference, ref_size) != 0)) {
+        goto CHECK_END;
+      }
+    }
+  }
+
+  is_ok = 1;
+
+CHECK_END:
+  free(data);
+  free(reference);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(reference_input[ch]);
+  }
+  for (ch = 0; ch <= num_channels; ch++) {
+    free(int16_input[ch]);
+    free(int32_input[ch]);
+    free(float_input[ch]);
+  }
+
+  return is_ok;
+}
+
+/* レイアウト指定エンコードテスト */
+static void testIMAADPCMWAVEncoder_EncodeLayoutTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 不正な引数 */
+  {
+    uint8_t data[256];
+    int16_t buf[16] = { 0, };
+    const void *input[1];
+    uint32_t output_size;
+    struct IMAADPCMWAVEncoder *encoder;
+    struct IMAADPCMWAVEncodeParameter enc_param;
+    struct IMAADPCMInputLayout layout;
+
+    input[0] = buf;
+    layout.sample_format = IMAADPCM_SAMPLE_FORMAT_INT16;
+    layout.interleaved = 0;
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeFromLayout(encoder,
+          &layout, input, 1, 16, data, sizeof(data), &output_size), IMAADPCM_APIRESULT_PARAMETER_NOT_SET);
+    enc_param.num_channels = 1;
+    enc_param.sampling_rate = 44100;
+    enc_param.bits_per_sample = 4;
+    enc_param.block_size = 256;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeFromLayout(NULL,
+          &layout, input, 1, 16, data, sizeof(data), &output_size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeFromLayout(encoder,
+          NULL, input, 1, 16, data, sizeof(data), &output_size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeFromLayout(encoder,
+          &layout, NULL, 1, 16, data, sizeof(data), &output_size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeFromLayout(encoder,
+          &layout, input, 0, 16, data, sizeof(data), &output_size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeFromLayout(encoder,
+          &layout, input, 1, 16, NULL, sizeof(data), &output_size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeFromLayout(encoder,
+          &layout, input, 1, 16, data, sizeof(data), NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeParallelFromLayout(encoder,
+          &layout, input, 1, 16, data, sizeof(data), &output_size, 0, NULL, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeParallelFromLayout(encoder,
+          &layout, input, 0, 16, data, sizeof(data), &output_size, 1, NULL, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    layout.sample_format = (IMAADPCMSampleFormat)(IMAADPCM_SAMPLE_FORMAT_FLOAT32 + 1);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeFromLayout(encoder,
+          &layout, input, 1, 16, data, sizeof(data), &output_size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    IMAADPCMWAVEncoder_Destroy(encoder);
+  }
+
+  /* 出力領域が足りない（タイルに収まらない大きなブロック） */
+  {
+    uint32_t required_size, output_size;
+    int16_t *buf;
+    uint8_t *data;
+    const void *input[1];
+    struct IMAADPCMWAVEncoder *encoder;
+    struct IMAADPCMWAVEncodeParameter enc_param;
+    struct IMAADPCMInputLayout layout;
+    const uint32_t num_samples = 32761 * 3 + 100;
+
+    buf = calloc(num_samples, sizeof(int16_t));
+    input[0] = buf;
+    layout.sample_format = IMAADPCM_SAMPLE_FORMAT_INT16;
+    layout.interleaved = 0;
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    enc_param.num_channels = 1;
+    enc_param.sampling_rate = 44100;
+    enc_param.bits_per_sample = 4;
+    enc_param.block_size = 16384;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVEncoder_CalculateOutputSize(&enc_param, num_samples, &required_size), IMAADPCM_APIRESULT_OK);
+    data = malloc(required_size);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeParallelFromLayout(encoder,
+          &layout, input, 1, num_samples, data, required_size - 1, &output_size, 2, NULL, NULL),
+        IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWholeParallelFromLayout(encoder,
+          &layout, input, 1, num_samples, data, required_size, &output_size, 2, NULL, NULL),
+        IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(output_size, required_size);
+    IMAADPCMWAVEncoder_Destroy(encoder);
+    free(data);
+    free(buf);
+  }
+
+  /* int16入力のエンコード結果との一致確認 */
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(1,  256, 1, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(1,  256, 505 * 37 + 100, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(1,  256, 505 * 37 + 100, 3), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(1, 1024, 2041 * 30 + 2, 4), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(2,  256, 249 * 41 + 17, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(2, 1024, 1017 * 64 + 500, 5), 1);
+  /* タイルに収まらない大きなブロック */
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(1, 16384, 32761 * 2 + 20000, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(1, 16384, 32761 * 2 + 20000, 3), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(2, 40000, 39993 * 2 + 7, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(2, 40000, 39993 * 2 + 7, 2), 1);
+  /* チャンネルあたりのタイルが小さくなる多チャンネル */
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(8, 8 * 1024, 2041 * 9 + 300, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(8, 8 * 1024, 2041 * 9 + 300, 3), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(8, 8 * 2048, 4089 * 5 + 300, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(8, 8 * 2048, 4089 * 5 + 300, 2), 1);
+}
+
+/* ストリーミングエンコードの結果が一括エンコードと一致するか確認 一致すれば1を返す */
+static uint8_t testIMAADPCMWAVEncoder_CheckEncodeStream(
+    uint16_t num_channels, uint16_t block_size, uint32_t num_samples, uint32_t max_num_feed_samples)
+{
+  uint32_t ch, smpl, is_ok, reference_size, output_size, write_size, num_feed_samples;
+  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS];
+  const int16_t *input_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+  uint8_t *reference, *output;
+  const uint32_t data_size = 2 * num_samples * num_channels + 2 * block_size + 64;
+  struct IMAADPCMWAVEncoder *whole_encoder, *stream_encoder;
+  struct IMAADPCMWAVEncodeParameter enc_param;
+
+  srand(1);
+  for (ch = 0; ch < num_channels; ch++) {
+    input[ch] = malloc(sizeof(int16_t) * (num_samples + 1));
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      input[ch][smpl] = (int16_t)(12000.0 * sin(0.03 * smpl * (ch + 1)) + (rand() % 4096) - 2048);
+    }
+  }
+  reference = malloc(data_size);
+  output = malloc(data_size);
+
+  whole_encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  stream_encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  enc_param.num_channels = num_channels;
+  enc_param.sampling_rate = 44100;
+  enc_param.bits_per_sample = 4;
+  enc_param.block_size = block_size;
+
+  is_ok = 0;
+  if ((IMAADPCMWAVEncoder_SetEncodeParameter(whole_encoder, &enc_param) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_SetEncodeParameter(stream_encoder, &enc_param) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_EncodeWhole(whole_encoder,
+          (const int16_t *const *)input, num_samples, reference, data_size, &reference_size) != IMAADPCM_APIRESULT_OK)) {
+    goto CHECK_END;
+  }
+
+  /* 乱数で決めたサンプル数ずつ供給 */
+  memset(output, 0, data_size);
+  if (IMAADPCMWAVEncoder_BeginEncode(stream_encoder, output, data_size, &output_size) != IMAADPCM_APIRESULT_OK) {
+    goto CHECK_END;
+  }
+  smpl = 0;
+  while (smpl < num_samples) {
+    /* マクロ内で乱数を2回引かないよう先に決める */
+    num_feed_samples = (uint32_t)rand() % (max_num_feed_samples + 1);
+    num_feed_samples = IMAADPCM_MIN_VAL(num_feed_samples, num_samples - smpl);
+    for (ch = 0; ch < num_channels; ch++) {
+      input_ptr[ch] = &input[ch][smpl];
+    }
+    if (IMAADPCMWAVEncoder_EncodeSamples(stream_encoder,
+          input_ptr, num_feed_samples, &output[output_size], data_size - output_size, &write_size) != IMAADPCM_APIRESULT_OK) {
+      goto CHECK_END;
+    }
+    output_size += write_size;
+    smpl += num_feed_samples;
+  }
+  if (IMAADPCMWAVEncoder_FinishEncode(stream_encoder,
+        &output[output_size], data_size - output_size, &write_size, output, data_size) != IMAADPCM_APIRESULT_OK) {
+    goto CHECK_END;
+  }
+  output_size += write_size;
+
+  if ((output_size != reference_size) || (memcmp(output, reference, reference_size) != 0)) {
+    goto CHECK_END;
+  }
+
+  is_ok = 1;
+
+CHECK_END:
+  IMAADPCMWAVEncoder_Destroy(whole_encoder);
+  IMAADPCMWAVEncoder_Destroy(stream_encoder);
+  free(reference);
+  free(output);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(input[ch]);
+  }
+
+  return is_ok;
+}
+
+/* ストリーミングエンコードテスト */
+static void testIMAADPCMWAVEncoder_EncodeStreamTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 不正な引数・状態 */
+  {
+    uint8_t data[256], header[64];
+    int16_t buf[16] = { 0, };
+    const int16_t *input[1];
+    uint32_t output_size;
+    struct IMAADPCMWAVEncoder *encoder;
+    struct IMAADPCMWAVEncodeParameter enc_param;
+
+    input[0] = buf;
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    Test_AssertEqual(IMAADPCMWAVEncoder_BeginEncode(encoder,
+          data, sizeof(data), &output_size), IMAADPCM_APIRESULT_PARAMETER_NOT_SET);
+    enc_param.num_channels = 1;
+    enc_param.sampling_rate = 44100;
+    enc_param.bits_per_sample = 4;
+    enc_param.block_size = 256;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVEncoder_BeginEncode(NULL,
+          data, sizeof(data), &output_size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_BeginEncode(encoder,
+          NULL, sizeof(data), &output_size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_BeginEncode(encoder,
+          data, sizeof(data), NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_BeginEncode(encoder,
+          data, 10, &output_size), IMAADPCM_APIRESULT_INSUFFICIENT_DATA);
+
+    /* 開始前は供給・終了できない */
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeSamples(encoder,
+          input, 16, data, sizeof(data), &output_size), IMAADPCM_APIRESULT_NG);
+    Test_AssertEqual(IMAADPCMWAVEncoder_FinishEncode(encoder,
+          data, sizeof(data), &output_size, header, sizeof(header)), IMAADPCM_APIRESULT_NG);
+
+    /* 書き出し領域が足りなければ状態を変えずに失敗 */
+    Test_AssertEqual(IMAADPCMWAVEncoder_BeginEncode(encoder,
+          data, sizeof(data), &output_size), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeSamples(encoder,
+          input, 16, data, 10, &output_size), IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeSamples(encoder,
+          input, 16, data, 11, &output_size), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(output_size, 4 + 7);
+    Test_AssertEqual(IMAADPCMWAVEncoder_FinishEncode(encoder,
+          data, 0, &output_size, header, sizeof(header)), IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER);
+    Test_AssertEqual(IMAADPCMWAVEncoder_FinishEncode(encoder,
+          data, 1, &output_size, header, sizeof(header)), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(output_size, 1);
+
+    /* 終了後は供給できない */
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeSamples(encoder,
+          input, 16, data, sizeof(data), &output_size), IMAADPCM_APIRESULT_NG);
+
+    IMAADPCMWAVEncoder_Destroy(encoder);
+  }
+
+  /* 供給の区切り方によらず一括エンコードと一致 */
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeStream(1,  256, 0, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeStream(1,  256, 1, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeStream(1,  256, 505 * 10, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeStream(1,  256, 505 * 10 + 2, 7), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeStream(1, 1024, 2041 * 5 + 100, 3000), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeStream(2,  256, 249 * 10 + 1, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeStream(2,  256, 249 * 10 + 5, 13), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeStream(2, 1024, 1017 * 5 + 500, 3000), 1);
+}
+
+/* 出力サイズ計算の結果がエンコード結果・ヘッダの記録と一致するか確認するサブルーチン 一致していたら1, していなければ0を返す */
+/* 計算したサイズちょうどの領域でエンコードでき、1byte少ない領域ではエンコードできないことも確認する */
+static uint8_t testIMAADPCMWAVEncoder_CheckCalculateOutputSize(
+    uint16_t num_channels, uint16_t block_size, uint32_t num_samples)
+{
+  uint32_t ch, smpl, is_ok, size, output_size, num_decode_samples, buffer_size;
+  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS];
+  uint8_t *data;
+  struct IMAADPCMWAVEncoder *encoder;
+  struct IMAADPCMWAVEncodeParameter enc_param;
+  struct IMAADPCMWAVHeaderInfo header;
+  struct IMAADPCMOutputLayout layout;
+
+  srand(0);
+  for (ch = 0; ch < num_channels; ch++) {
+    input[ch] = malloc(sizeof(int16_t) * (num_samples + 1));
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      input[ch][smpl] = (int16_t)((rand() % 32768) - 16384);
+    }
+  }
+
+  encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  enc_param.num_channels = num_channels;
+  enc_param.sampling_rate = 44100;
+  enc_param.bits_per_sample = 4;
+  enc_param.block_size = block_size;
+
+  is_ok = 0;
+  data = NULL;
+  if ((IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_CalculateOutputSize(&enc_param, num_samples, &size) != IMAADPCM_APIRESULT_OK)) {
+    goto CHECK_END;
+  }
+  data = malloc(size);
+
+  /* ちょうどのサイズでエンコードでき、出力サイズと一致 */
+  if ((IMAADPCMWAVEncoder_EncodeWhole(encoder,
+          (const int16_t *const *)input, num_samples, data, size, &output_size) != IMAADPCM_APIRESULT_OK)
+      || (output_size != size)) {
+    goto CHECK_END;
+  }
+  if ((IMAADPCMWAVEncoder_EncodeWholeParallel(encoder,
+          (const int16_t *const *)input, num_samples, data, size, &output_size, 3, NULL, NULL) != IMAADPCM_APIRESULT_OK)
+      || (output_size != size)) {
+    goto CHECK_END;
+  }
+
+  /* ヘッダに記録したRIFFチャンク・dataチャンクのサイズとも一致 */
+  if ((((uint32_t)data[4] | ((uint32_t)data[5] << 8) | ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24)) != (size - 8))
+      || (((uint32_t)data[56] | ((uint32_t)data[57] << 8) | ((uint32_t)data[58] << 16) | ((uint32_t)data[59] << 24))
+        != (size - IMAADPCMWAVENCODER_HEADER_SIZE))) {
+    goto CHECK_END;
+  }
+
+  /* デコーダ側の計算はエンコードしたサンプル数に一致 */
+  layout.sample_format = IMAADPCM_SAMPLE_FORMAT_FLOAT32;
+  layout.interleaved = 1;
+  if ((IMAADPCMWAVDecoder_DecodeHeader(data, size, &header) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVDecoder_CalculateOutputSize(&header, &layout, &num_decode_samples, &buffer_size) != IMAADPCM_APIRESULT_OK)
+      || (num_decode_samples != num_samples) || (buffer_size != (sizeof(float) * num_samples * num_channels))) {
+    goto CHECK_END;
+  }
+
+  /* 1byte足りなければエンコードできない */
+  if (IMAADPCMWAVEncoder_EncodeWhole(encoder,
+        (const int16_t *const *)input, num_samples, data, size - 1, &output_size) == IMAADPCM_APIRESULT_OK) {
+    goto CHECK_END;
+  }
+
+  is_ok = 1;
+CHECK_END:
+  IMAADPCMWAVEncoder_Destroy(encoder);
+  free(data);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(input[ch]);
+  }
+
+  return is_ok;
+}
+
+/* 出力サイズ計算テスト */
+static void testIMAADPCMWAVEncoder_CalculateOutputSizeTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 不正な引数 */
+  {
+    uint32_t size, num_samples;
+    struct IMAADPCMWAVEncodeParameter enc_param;
+    struct IMAADPCMWAVHeaderInfo header;
+    struct IMAADPCMOutputLayout layout;
+
+    enc_param.num_channels = 1;
+    enc_param.sampling_rate = 44100;
+    enc_param.bits_per_sample = 4;
+    enc_param.block_size = 256;
+    Test_AssertEqual(IMAADPCMWAVEncoder_CalculateOutputSize(NULL, 16, &size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_CalculateOutputSize(&enc_param, 16, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    enc_param.num_channels = IMAADPCM_MAX_NUM_CHANNELS + 1;
+    Test_AssertEqual(IMAADPCMWAVEncoder_CalculateOutputSize(&enc_param, 16, &size), IMAADPCM_APIRESULT_INVALID_FORMAT);
+    enc_param.num_channels = 1;
+    enc_param.block_size = 4;
+    Test_AssertEqual(IMAADPCMWAVEncoder_CalculateOutputSize(&enc_param, 16, &size), IMAADPCM_APIRESULT_INVALID_FORMAT);
+
+    /* 簡単な例 */
+    enc_param.block_size = 256;
+    Test_AssertEqual(IMAADPCMWAVEncoder_CalculateOutputSize(&enc_param, 0, &size), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(size, IMAADPCMWAVENCODER_HEADER_SIZE);
+    Test_AssertEqual(IMAADPCMWAVEncoder_CalculateOutputSize(&enc_param, 505 * 2 + 3, &size), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(size, IMAADPCMWAVENCODER_HEADER_SIZE + 256 * 2 + 4 + 1);
+
+    header.num_channels = 2;
+    header.block_size = 256;
+    header.num_samples = 1000;
+    layout.sample_format = IMAADPCM_SAMPLE_FORMAT_INT16;
+    layout.interleaved = 0;
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateOutputSize(NULL, &layout, &num_samples, &size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateOutputSize(&header, NULL, &num_samples, &size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateOutputSize(&header, &layout, NULL, &size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateOutputSize(&header, &layout, &num_samples, NULL), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateOutputSize(&header, &layout, &num_samples, &size), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(num_samples, 1000);
+    Test_AssertEqual(size, 1000 * 2 * sizeof(int16_t));
+    layout.sample_format = IMAADPCM_SAMPLE_FORMAT_INT32;
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateOutputSize(&header, &layout, &num_samples, &size), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(size, 1000 * 2 * sizeof(int32_t));
+    header.num_samples = 0x80000000UL;
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateOutputSize(&header, &layout, &num_samples, &size), IMAADPCM_APIRESULT_INVALID_FORMAT);
+    header.num_samples = 1000;
+    header.num_channels = IMAADPCM_MAX_NUM_CHANNELS + 1;
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateOutputSize(&header, &layout, &num_samples, &size), IMAADPCM_APIRESULT_INVALID_FORMAT);
+  }
+
+  /* 末尾のブロックの長さによらずエンコード結果と一致 */
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckCalculateOutputSize(1,  256, 0), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckCalculateOutputSize(1,  256, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckCalculateOutputSize(1,  256, 2), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckCalculateOutputSize(1,  256, 505 * 3 - 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckCalculateOutputSize(1,  256, 505 * 3), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckCalculateOutputSize(1,  256, 505 * 3 + 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckCalculateOutputSize(1,  258, 509 * 7 + 100), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckCalculateOutputSize(1, 1024, 2041 * 5 + 2), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckCalculateOutputSize(2,  256, 0), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckCalculateOutputSize(2,  256, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckCalculateOutputSize(2,  256, 2), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckCalculateOutputSize(2,  256, 249 * 3), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckCalculateOutputSize(2,  256, 249 * 3 + 9), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckCalculateOutputSize(2, 1024, 1017 * 5 + 500), 1);
+}
+
+/* RF64（4GB超）対応の出力が通常の出力と一致するか確認するサブルーチン 一致していたら1, していなければ0を返す */
+/* ds64チャンクを予約したストリーミングエンコード、手で変換したRF64ファイルのデコード、64bit版APIの結果を確認する */
+static uint8_t testIMAADPCMWAVEncoder_CheckRF64(
+    uint16_t num_channels, uint16_t block_size, uint32_t num_samples)
+{
+  uint32_t ch, smpl, is_ok, size, output_size, write_size, offset, read_size, num_decode_samples, num_output_samples;
+  uint64_t size64, output_size64;
+  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS], *reference[IMAADPCM_MAX_NUM_CHANNELS], *output[IMAADPCM_MAX_NUM_CHANNELS];
+  int16_t *output_ptr[IMAADPCM_MAX_NUM_CHANNELS];
+  uint8_t *data, *rf64_data, *stream_data;
+  struct IMAADPCMWAVEncoder *encoder;
+  struct IMAADPCMWAVDecoder *decoder;
+  struct IMAADPCMWAVEncodeParameter enc_param;
+  struct IMAADPCMWAVHeaderInfo header;
+  struct IMAADPCMInputLayout input_layout;
+  struct IMAADPCMOutputLayout output_layout;
+  const uint32_t ds64_size = IMAADPCM_DS64_CHUNK_SIZE;
+
+  srand(0);
+  for (ch = 0; ch < num_channels; ch++) {
+    input[ch] = malloc(sizeof(int16_t) * num_samples);
+    reference[ch] = malloc(sizeof(int16_t) * num_samples);
+    output[ch] = malloc(sizeof(int16_t) * (num_samples + block_size * 2));
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      input[ch][smpl] = (int16_t)((rand() % 32768) - 16384);
+    }
+  }
+
+  encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  decoder = IMAADPCMWAVDecoder_CreateStream(NULL, 0);
+  enc_param.num_channels = num_channels;
+  enc_param.sampling_rate = 44100;
+  enc_param.bits_per_sample = 4;
+  enc_param.block_size = block_size;
+
+  is_ok = 0;
+  data = rf64_data = stream_data = NULL;
+  if ((IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_CalculateOutputSize(&enc_param, num_samples, &size) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_CalculateOutputSize64(&enc_param, num_samples, &size64) != IMAADPCM_APIRESULT_OK)
+      || (size64 != size)) {
+    goto CHECK_END;
+  }
+  data = malloc(size);
+  rf64_data = malloc(size + ds64_size);
+  stream_data = malloc(size + ds64_size);
+
+  /* 基準となる通常のエンコード・デコード結果 */
+  if ((IMAADPCMWAVEncoder_EncodeWhole(encoder,
+          (const int16_t *const *)input, num_samples, data, size, &output_size) != IMAADPCM_APIRESULT_OK)
+      || (output_size != size)
+      || (IMAADPCMWAVDecoder_DecodeWhole(decoder, data, size, reference, num_channels, num_samples) != IMAADPCM_APIRESULT_OK)) {
+    goto CHECK_END;
+  }
+
+  /* 64bit版の並列エンコードは32bit版と一致 */
+  input_layout.sample_format = IMAADPCM_SAMPLE_FORMAT_INT16;
+  input_layout.interleaved = 0;
+  if ((IMAADPCMWAVEncoder_EncodeWholeParallelFromLayout(encoder, &input_layout,
+          (const void *const *)input, num_channels, num_samples, stream_data, size, &output_size, 3, NULL, NULL) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_EncodeWholeParallelFromLayout64(encoder, &input_layout,
+          (const void *const *)input, num_channels, num_samples, rf64_data, size, &output_size64, 3, NULL, NULL) != IMAADPCM_APIRESULT_OK)
+      || (output_size64 != output_size) || (memcmp(stream_data, rf64_data, size) != 0)) {
+    goto CHECK_END;
+  }
+
+  /* 64bit版の逐次エンコードは32bit版と一致 逐次エンコードは状態を持つため作り直す */
+  IMAADPCMWAVEncoder_Destroy(encoder);
+  encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  if ((IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_EncodeWhole64(encoder,
+          (const int16_t *const *)input, num_samples, stream_data, size, &output_size64) != IMAADPCM_APIRESULT_OK)
+      || (output_size64 != size) || (memcmp(stream_data, data, size) != 0)) {
+    goto CHECK_END;
+  }
+  IMAADPCMWAVEncoder_Destroy(encoder);
+  encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  if ((IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_EncodeWholeFromLayout64(encoder, &input_layout,
+          (const void *const *)input, num_channels, num_samples, stream_data, size, &output_size64) != IMAADPCM_APIRESULT_OK)
+      || (output_size64 != size) || (memcmp(stream_data, data, size) != 0)) {
+    goto CHECK_END;
+  }
+
+  /* ds64チャンクを予約したストリーミングエンコード: JUNKチャンクが挟まる以外は一致 */
+  if ((IMAADPCMWAVEncoder_BeginEncode64(encoder, stream_data, IMAADPCMWAVENCODER_HEADER_SIZE, &output_size) != IMAADPCM_APIRESULT_INSUFFICIENT_DATA)
+      || (IMAADPCMWAVEncoder_BeginEncode64(encoder, stream_data, size + ds64_size, &output_size) != IMAADPCM_APIRESULT_OK)
+      || (output_size != IMAADPCMWAVENCODER_RF64_HEADER_SIZE)
+      || (IMAADPCMWAVEncoder_EncodeSamples(encoder, (const int16_t *const *)input, num_samples,
+          &stream_data[output_size], size + ds64_size - output_size, &write_size) != IMAADPCM_APIRESULT_OK)) {
+    goto CHECK_END;
+  }
+  output_size += write_size;
+  if (IMAADPCMWAVEncoder_FinishEncode(encoder, &stream_data[output_size], size + ds64_size - output_size, &write_size,
+        stream_data, IMAADPCMWAVENCODER_RF64_HEADER_SIZE) != IMAADPCM_APIRESULT_OK) {
+    goto CHECK_END;
+  }
+  output_size += write_size;
+  if ((output_size != (size + ds64_size))
+      || (memcmp(&stream_data[12], "JUNK", 4) != 0)
+      || (memcmp(&stream_data[12 + ds64_size], &data[12], IMAADPCMWAVENCODER_HEADER_SIZE - 12) != 0)
+      || (memcmp(&stream_data[IMAADPCMWAVENCODER_RF64_HEADER_SIZE], &data[IMAADPCMWAVENCODER_HEADER_SIZE],
+          size - IMAADPCMWAVENCODER_HEADER_SIZE) != 0)
+      || (ByteArray_ReadUint32LE(&stream_data[4]) != (size + ds64_size - 8))) {
+    goto CHECK_END;
+  }
+  if ((IMAADPCMWAVDecoder_DecodeHeader(stream_data, output_size, &header) != IMAADPCM_APIRESULT_OK)
+      || (header.header_size != IMAADPCMWAVENCODER_RF64_HEADER_SIZE) || (header.num_samples != num_samples)
+      || (IMAADPCMWAVDecoder_DecodeWhole(decoder, stream_data, output_size, output, num_channels, num_samples) != IMAADPCM_APIRESULT_OK)) {
+    goto CHECK_END;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    if (memcmp(output[ch], reference[ch], sizeof(int16_t) * num_samples) != 0) {
+      goto CHECK_END;
+    }
+  }
+
+  /* 通常の出力をRF64に変換: サイズとサンプル数は-1としてds64チャンクに書く */
+  memcpy(rf64_data, "RF64", 4);
+  ByteArray_WriteUint32LE(&rf64_data[4], 0xFFFFFFFFUL);
+  memcpy(&rf64_data[8], "WAVEds64", 8);
+  ByteArray_WriteUint32LE(&rf64_data[16], ds64_size - 8);
+  ByteArray_WriteUint32LE(&rf64_data[20], size + ds64_size - 8);
+  ByteArray_WriteUint32LE(&rf64_data[24], 0);
+  ByteArray_WriteUint32LE(&rf64_data[28], size - IMAADPCMWAVENCODER_HEADER_SIZE);
+  ByteArray_WriteUint32LE(&rf64_data[32], 0);
+  ByteArray_WriteUint32LE(&rf64_data[36], num_samples);
+  ByteArray_WriteUint32LE(&rf64_data[40], 0);
+  ByteArray_WriteUint32LE(&rf64_data[44], 0);
+  memcpy(&rf64_data[12 + ds64_size], &data[12], size - 12);
+  ByteArray_WriteUint32LE(&rf64_data[IMAADPCMWAVENCODER_RF64_HEADER_SIZE - 12], 0xFFFFFFFFUL);
+  ByteArray_WriteUint32LE(&rf64_data[IMAADPCMWAVENCODER_RF64_HEADER_SIZE - 4], 0xFFFFFFFFUL);
+
+  /* 64bit版の並列デコードは通常のデコードと一致 */
+  output_layout.sample_format = IMAADPCM_SAMPLE_FORMAT_INT16;
+  output_layout.interleaved = 0;
+  if ((IMAADPCMWAVDecoder_DecodeHeader(rf64_data, size + ds64_size, &header) != IMAADPCM_APIRESULT_OK)
+      || (header.header_size != IMAADPCMWAVENCODER_RF64_HEADER_SIZE) || (header.num_samples != num_samples)
+      || (IMAADPCMWAVDecoder_DecodeWholeParallelToLayout64(decoder, rf64_data, size + ds64_size, &output_layout,
+          (void **)output, num_channels, num_samples, 3, NULL, NULL) != IMAADPCM_APIRESULT_OK)) {
+    goto CHECK_END;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    if (memcmp(output[ch], reference[ch], sizeof(int16_t) * num_samples) != 0) {
+      goto CHECK_END;
+    }
+  }
+
+  /* 64bit版の逐次デコード・範囲デコードも通常のデコードと一致 */
+  if (IMAADPCMWAVDecoder_DecodeWhole64(decoder, rf64_data, size + ds64_size,
+        output, num_channels, num_samples) != IMAADPCM_APIRESULT_OK) {
+    goto CHECK_END;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    if (memcmp(output[ch], reference[ch], sizeof(int16_t) * num_samples) != 0) {
+      goto CHECK_END;
+    }
+  }
+  if ((IMAADPCMWAVDecoder_DecodeRange64(decoder, rf64_data, size + ds64_size,
+          num_samples / 3, num_samples, output, num_channels, num_samples, &num_decode_samples) != IMAADPCM_APIRESULT_OK)
+      || (num_decode_samples != (num_samples - num_samples / 3))) {
+    goto CHECK_END;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    if (memcmp(output[ch], &reference[ch][num_samples / 3], sizeof(int16_t) * num_decode_samples) != 0) {
+      goto CHECK_END;
+    }
+  }
+
+  /* ストリーミングデコードも一致 */
+  if (IMAADPCMWAVDecoder_BeginDecode(decoder) != IMAADPCM_APIRESULT_OK) {
+    goto CHECK_END;
+  }
+  offset = 0;
+  num_output_samples = 0;
+  while (offset < (size + ds64_size)) {
+    for (ch = 0; ch < num_channels; ch++) {
+      output_ptr[ch] = &output[ch][num_output_samples];
+    }
+    if ((IMAADPCMWAVDecoder_DecodeData(decoder, &rf64_data[offset], IMAADPCM_MIN_VAL(size + ds64_size - offset, 100), &read_size,
+            output_ptr, num_channels, block_size * 2, &num_decode_samples) != IMAADPCM_APIRESULT_OK)
+        || ((read_size == 0) && (num_decode_samples == 0))) {
+      goto CHECK_END;
+    }
+    offset += read_size;
+    num_output_samples += num_decode_samples;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    output_ptr[ch] = &output[ch][num_output_samples];
+  }
+  if (IMAADPCMWAVDecoder_FinishDecode(decoder,
+        output_ptr, num_channels, block_size * 2, &num_decode_samples) != IMAADPCM_APIRESULT_OK) {
+    goto CHECK_END;
+  }
+  num_output_samples += num_decode_samples;
+  if ((num_output_samples != num_samples) || (decoder->header.header_size != IMAADPCMWAVENCODER_RF64_HEADER_SIZE)) {
+    goto CHECK_END;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    if (memcmp(output[ch], reference[ch], sizeof(int16_t) * num_samples) != 0) {
+      goto CHECK_END;
+    }
+  }
+
+  is_ok = 1;
+CHECK_END:
+  IMAADPCMWAVEncoder_Destroy(encoder);
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  free(data);
+  free(rf64_data);
+  free(stream_data);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(input[ch]);
+    free(reference[ch]);
+    free(output[ch]);
+  }
+
+  return is_ok;
+}
+
+/* RF64（4GB超）対応テスト */
+static void testIMAADPCMWAVEncoder_RF64Test(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 4GBを超えるサイズのヘッダ */
+  {
+    uint32_t size, num_samples;
+    uint64_t size64;
+    uint8_t data[IMAADPCMWAVENCODER_RF64_HEADER_SIZE];
+    struct IMAADPCMWAVEncodeParameter enc_param;
+    struct IMAADPCMWAVHeaderInfo header, decoded_header;
+    struct IMAADPCMOutputLayout layout;
+    struct IMAADPCMWAVEncoder *encoder;
+    const int16_t dummy[1] = { 0 };
+    const int16_t *input[2];
+
+    enc_param.num_channels = 2;
+    enc_param.sampling_rate = 48000;
+    enc_param.bits_per_sample = 4;
+    enc_param.block_size = 1024;
+    input[0] = input[1] = dummy;
+
+    /* 4GB以下では通常のヘッダ */
+    Test_AssertEqual(IMAADPCMWAVEncoder_ConvertParameterToHeader(&enc_param, 0xF0000000UL, &header), IMAADPCM_ERROR_OK);
+    Test_AssertEqual(header.header_size, IMAADPCMWAVENCODER_HEADER_SIZE);
+    Test_AssertEqual(IMAADPCMWAVEncoder_CalculateOutputSize(&enc_param, 0xF0000000UL, &size), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(size, IMAADPCMWAVENCODER_HEADER_SIZE + IMAADPCMWAVEncoder_CalculateDataChunkSize(&header));
+
+    /* 4GBを超えるとRF64のヘッダ */
+    Test_AssertEqual(IMAADPCMWAVEncoder_ConvertParameterToHeader(&enc_param, 0xFFFFFFF0UL, &header), IMAADPCM_ERROR_OK);
+    Test_AssertEqual(header.header_size, IMAADPCMWAVENCODER_RF64_HEADER_SIZE);
+    Test_AssertEqual(IMAADPCMWAVEncoder_CalculateOutputSize(&enc_param, 0xFFFFFFF0UL, &size), IMAADPCM_APIRESULT_INVALID_FORMAT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_CalculateOutputSize64(&enc_param, 0xFFFFFFF0UL, &size64), IMAADPCM_APIRESULT_OK);
+    Test_AssertCondition(size64 > UINT32_MAX);
+    Test_AssertCondition(size64 == (IMAADPCMWAVENCODER_RF64_HEADER_SIZE + IMAADPCMWAVEncoder_CalculateDataChunkSize(&header)));
+
+    /* ヘッダの書き出しと読み込み */
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeHeader(&header, data, IMAADPCMWAVENCODER_HEADER_SIZE), IMAADPCM_APIRESULT_INSUFFICIENT_DATA);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeHeader(&header, data, sizeof(data)), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(memcmp(&data[0], "RF64", 4), 0);
+    Test_AssertEqual(ByteArray_ReadUint32LE(&data[4]), 0xFFFFFFFFUL);
+    Test_AssertEqual(memcmp(&data[12], "ds64", 4), 0);
+    Test_AssertEqual(ByteArray_ReadUint32LE(&data[IMAADPCMWAVENCODER_RF64_HEADER_SIZE - 4]), 0xFFFFFFFFUL);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeHeader(data, sizeof(data), &decoded_header), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(decoded_header.header_size, IMAADPCMWAVENCODER_RF64_HEADER_SIZE);
+    Test_AssertEqual(decoded_header.num_samples, 0xFFFFFFF0UL);
+    Test_AssertEqual(decoded_header.num_channels, 2);
+    Test_AssertEqual(decoded_header.block_size, 1024);
+
+    /* ds64チャンクの無いRF64は不正 */
+    memcpy(&data[12], "JUNK", 4);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeHeader(data, sizeof(data), &decoded_header), IMAADPCM_APIRESULT_INVALID_FORMAT);
+
+    /* デコード結果のバッファサイズは64bit版でのみ計算できる */
+    layout.sample_format = IMAADPCM_SAMPLE_FORMAT_INT16;
+    layout.interleaved = 1;
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateOutputSize(&header, &layout, &num_samples, &size), IMAADPCM_APIRESULT_INVALID_FORMAT);
+    Test_AssertEqual(IMAADPCMWAVDecoder_CalculateOutputSize64(&header, &layout, &num_samples, &size64), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(num_samples, 0xFFFFFFF0UL);
+    Test_AssertCondition(size64 == ((uint64_t)0xFFFFFFF0UL * 2 * sizeof(int16_t)));
+
+    /* ds64チャンクを予約していないストリーミングエンコードは4GBを超えられない */
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVEncoder_BeginEncode(encoder, data, sizeof(data), &size), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(size, IMAADPCMWAVENCODER_HEADER_SIZE);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeSamples(encoder, input, 0xFFFFFFF0UL, data, sizeof(data), &size), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    Test_AssertEqual(IMAADPCMWAVEncoder_BeginEncode64(encoder, data, sizeof(data), &size), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(size, IMAADPCMWAVENCODER_RF64_HEADER_SIZE);
+    Test_AssertEqual(memcmp(&data[0], "RIFF", 4), 0);
+    Test_AssertEqual(memcmp(&data[12], "JUNK", 4), 0);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeSamples(encoder, input, 0xFFFFFFF0UL, data, sizeof(data), &size), IMAADPCM_APIRESULT_INSUFFICIENT_BUFFER);
+    IMAADPCMWAVEncoder_Destroy(encoder);
+  }
+
+  /* ds64チャンクを含むファイルの結果が通常のファイルと一致 */
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckRF64(1,  256, 1), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckRF64(1,  256, 505 * 3 + 7), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckRF64(2,  256, 249 * 3 + 9), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckRF64(2, 1024, 1017 * 9 + 500), 1);
+}
+
+/* 多チャンネルのエンコード・デコード結果を確認するサブルーチン 問題なければ1, あれば0を返す */
+/* 全カーネルの結果がスカラ版と一致し、ブロックのワード配置に従って1チャンネルずつデコードした結果とも一致するか確認 */
+static uint8_t testIMAADPCMWAVEncoder_CheckMultichannel(
+    uint16_t num_channels, uint16_t block_size, uint32_t num_samples, uint32_t channel_mask)
+{
+  static const IMAADPCMKernel kernels[] = {
+    IMAADPCM_KERNEL_SCALAR, IMAADPCM_KERNEL_SSE41, IMAADPCM_KERNEL_AVX2, IMAADPCM_KERNEL_AUTO
+  };
+  uint32_t ch, smpl, i, is_ok, reference_size, output_size, offset;
+  int16_t *input[IMAADPCM_MAX_NUM_CHANNELS], *reference[IMAADPCM_MAX_NUM_CHANNELS], *output[IMAADPCM_MAX_NUM_CHANNELS];
+  uint8_t *reference_data, *data;
+  const uint32_t data_size = 2 * num_samples * num_channels + block_size + 256;
+  struct IMAADPCMWAVDecoder *decoder;
+  struct IMAADPCMWAVEncoder *encoder;
+  struct IMAADPCMWAVEncodeParameter enc_param;
+  struct IMAADPCMWAVHeaderInfo header;
+
+  srand(0);
+  for (ch = 0; ch < num_channels; ch++) {
+    input[ch] = malloc(sizeof(int16_t) * num_samples);
+    reference[ch] = malloc(sizeof(int16_t) * num_samples);
+    output[ch] = malloc(sizeof(int16_t) * num_samples);
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      input[ch][smpl] = (int16_t)(16000.0 * sin(0.002 * smpl * (ch + 1)) + (rand() % 2048) - 1024);
+    }
+  }
+  reference_data = malloc(data_size);
+  data = malloc(data_size);
+
+  encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+  decoder = IMAADPCMWAVDecoder_Create(NULL, 0);
+  enc_param.num_channels = num_channels;
+  enc_param.sampling_rate = 48000;
+  enc_param.bits_per_sample = 4;
+  enc_param.block_size = block_size;
+
+  /* スカラ版でエンコードしたものを参照値とする */
+  is_ok = 0;
+  if ((IMAADPCMWAVEncoder_SetKernel(encoder, IMAADPCM_KERNEL_SCALAR) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_SetChannelMask(encoder, channel_mask) != IMAADPCM_APIRESULT_OK)
+      || (IMAADPCMWAVEncoder_EncodeWhole(encoder,
+          (const int16_t *const *)input, num_samples, reference_data, data_size, &reference_size) != IMAADPCM_APIRESULT_OK)) {
+    goto CHECK_END;
+  }
+
+  /* ヘッダはWAVE_FORMAT_EXTENSIBLE形式 */
+  if ((IMAADPCMWAVDecoder_DecodeHeader(reference_data, reference_size, &header) != IMAADPCM_APIRESULT_OK)
+      || (header.num_channels != num_channels) || (header.num_samples != num_samples)
+      || (header.channel_mask != channel_mask)
+      || (header.header_size != (IMAADPCMWAVENCODER_HEADER_SIZE + IMAADPCM_EXTENSIBLE_FMT_EXTRA_SIZE))
+      || (reference_data[20] != 0xFE) || (reference_data[21] != 0xFF)) {
+    goto CHECK_END;
+  }
+
+  /* ブロックのワード配置に従い、1チャンネルずつ1サンプルデコード関数でデコードして参照値とする */
+  for (ch = 0; ch < num_channels; ch++) {
+    for (offset = 0, smpl = 0; smpl < num_samples; offset += block_size) {
+      struct IMAADPCMCoreDecoder core;
+      const uint8_t *block = &reference_data[header.header_size + offset];
+      const uint32_t num_block_samples = IMAADPCM_MIN_VAL(header.num_samples_per_block, num_samples - smpl);
+      core.sample_val = (int16_t)ByteArray_ReadUint16LE(&block[4 * ch]);
+      core.stepsize_index = (int8_t)block[4 * ch + 2];
+      reference[ch][smpl] = core.sample_val;
+      for (i = 1; i < num_block_samples; i++) {
+        const uint32_t word = (i - 1) / 8, pos = (i - 1) % 8;
+        const uint8_t byte = block[4 * num_channels + 4 * (word * num_channels + ch) + pos / 2];
+        reference[ch][smpl + i] = IMAADPCMCoreDecoder_DecodeSample(&core, (uint8_t)((byte >> (4 * (pos % 2))) & 0xF));
+      }
+      smpl += num_block_samples;
+    }
+  }
+
+  for (i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+    if (!IMAADPCM_IsKernelAvailable(kernels[i])) {
+      continue;
+    }
+    /* エンコード結果がスカラ版と一致 エンコーダは状態を持つため作り直す */
+    IMAADPCMWAVEncoder_Destroy(encoder);
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    if ((IMAADPCMWAVEncoder_SetKernel(encoder, kernels[i]) != IMAADPCM_APIRESULT_OK)
+        || (IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param) != IMAADPCM_APIRESULT_OK)
+        || (IMAADPCMWAVEncoder_SetChannelMask(encoder, channel_mask) != IMAADPCM_APIRESULT_OK)
+        || (IMAADPCMWAVEncoder_EncodeWhole(encoder,
+            (const int16_t *const *)input, num_samples, data, data_size, &output_size) != IMAADPCM_APIRESULT_OK)
+        || (output_size != reference_size) || (memcmp(data, reference_data, reference_size) != 0)) {
+      goto CHECK_END;
+    }
+    /* デコード結果が参照値と一致 */
+    if ((IMAADPCMWAVDecoder_SetKernel(decoder, kernels[i]) != IMAADPCM_APIRESULT_OK)
+        || (IMAADPCMWAVDecoder_DecodeWhole(decoder,
+            data, output_size, output, num_channels, num_samples) != IMAADPCM_APIRESULT_OK)) {
+      goto CHECK_END;
+    }
+    for (ch = 0; ch < num_channels; ch++) {
+      if (memcmp(output[ch], reference[ch], sizeof(int16_t) * num_samples) != 0) {
+        goto CHECK_END;
+      }
+    }
+  }
+
+  is_ok = 1;
+
+CHECK_END:
+  IMAADPCMWAVDecoder_Destroy(decoder);
+  IMAADPCMWAVEncoder_Destroy(encoder);
+  free(reference_data);
+  free(data);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(input[ch]);
+    free(reference[ch]);
+    free(output[ch]);
+  }
+
+  return is_ok;
+}
+
+/* 多チャンネルテスト */
+static void testIMAADPCMWAVEncoder_MultichannelTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 3チャンネル以上はチャンネル毎のワードが揃わないブロックサイズは設定できない */
+  {
+    struct IMAADPCMWAVEncoder *encoder;
+    struct IMAADPCMWAVEncodeParameter enc_param;
+
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    enc_param.num_channels = 3;
+    enc_param.sampling_rate = 48000;
+    enc_param.bits_per_sample = 4;
+    enc_param.block_size = 1024;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param), IMAADPCM_APIRESULT_INVALID_FORMAT);
+    enc_param.block_size = 3 * 512;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param), IMAADPCM_APIRESULT_OK);
+    enc_param.num_channels = IMAADPCM_MAX_NUM_CHANNELS + 1;
+    enc_param.block_size = (IMAADPCM_MAX_NUM_CHANNELS + 1) * 512;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param), IMAADPCM_APIRESULT_INVALID_FORMAT);
+    IMAADPCMWAVEncoder_Destroy(encoder);
+  }
+
+  /* ヘッダエンコード: 3チャンネル以上はWAVE_FORMAT_EXTENSIBLE形式 */
+  {
+    uint8_t data[IMAADPCMWAVENCODER_HEADER_SIZE + IMAADPCM_EXTENSIBLE_FMT_EXTRA_SIZE];
+    struct IMAADPCMWAVHeaderInfo header, decoded_header;
+
+    IMAADPCM_SetValidHeader(&header);
+    header.num_channels = 3;
+    header.block_size = 3 * 256;
+    header.num_samples_per_block = 505;
+    header.channel_mask = 0x7;
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeHeader(&header, data, sizeof(data) - 1), IMAADPCM_APIRESULT_INSUFFICIENT_DATA);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeHeader(&header, data, sizeof(data)), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeHeader(data, sizeof(data), &decoded_header), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(decoded_header.num_channels, 3);
+    Test_AssertEqual(decoded_header.num_samples_per_block, 505);
+    Test_AssertEqual(decoded_header.channel_mask, 0x7);
+    Test_AssertEqual(decoded_header.header_size, sizeof(data));
+
+    /* サブフォーマットがIMA-ADPCMでなければ失敗 */
+    data[44] ^= 0xFF;
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeHeader(data, sizeof(data), &decoded_header), IMAADPCM_APIRESULT_INVALID_FORMAT);
+  }
+
+  /* 2チャンネル以下ではチャンネル配置を指定しても従来のヘッダのまま */
+  {
+    uint8_t data[IMAADPCMWAVENCODER_HEADER_SIZE];
+    struct IMAADPCMWAVHeaderInfo header, decoded_header;
+
+    IMAADPCM_SetValidHeader(&header);
+    header.num_channels = 2;
+    header.block_size = 256;
+    header.num_samples_per_block = 249;
+    header.channel_mask = 0x3;
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeHeader(&header, data, sizeof(data)), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVDecoder_DecodeHeader(data, sizeof(data), &decoded_header), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(decoded_header.channel_mask, 0);
+    Test_AssertEqual(decoded_header.header_size, sizeof(data));
+    Test_AssertEqual(data[20], 0x11);
+    Test_AssertEqual(data[21], 0x00);
+  }
+
+  /* チャンネル配置の設定 */
+  {
+    uint32_t output_size, reference_size;
+    uint8_t *data, *reference_data;
+    int16_t *input[2];
+    int16_t buf[2][1024] = { { 0, }, };
+    struct IMAADPCMWAVEncoder *encoder;
+    struct IMAADPCMWAVEncodeParameter enc_param;
+    const uint32_t data_size = 4096;
+
+    data = malloc(data_size);
+    reference_data = malloc(data_size);
+    input[0] = buf[0]; input[1] = buf[1];
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetChannelMask(NULL, 0x3), IMAADPCM_APIRESULT_INVALID_ARGUMENT);
+    enc_param.num_channels = 2;
+    enc_param.sampling_rate = 48000;
+    enc_param.bits_per_sample = 4;
+    enc_param.block_size = 256;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWhole(encoder,
+          (const int16_t *const *)input, 1024, reference_data, data_size, &reference_size), IMAADPCM_APIRESULT_OK);
+    /* 2チャンネルでは出力が変わらない */
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetChannelMask(encoder, 0x3), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWhole(encoder,
+          (const int16_t *const *)input, 1024, data, data_size, &output_size), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(output_size, reference_size);
+    Test_AssertEqual(memcmp(data, reference_data, reference_size), 0);
+    IMAADPCMWAVEncoder_Destroy(encoder);
+    free(reference_data);
+    free(data);
+  }
+
+  /* デコーダバンクは3チャンネル以上のストリームを受け付けない */
+  {
+    uint32_t output_size, id;
+    uint8_t *data;
+    int16_t *input[3];
+    int16_t buf[3][1024] = { { 0, }, };
+    struct IMAADPCMWAVEncoder *encoder;
+    struct IMAADPCMWAVEncodeParameter enc_param;
+    struct IMAADPCMDecoderBank *bank;
+    const uint32_t data_size = 4096;
+
+    data = malloc(data_size);
+    input[0] = buf[0]; input[1] = buf[1]; input[2] = buf[2];
+    encoder = IMAADPCMWAVEncoder_Create(NULL, 0);
+    bank = IMAADPCMDecoderBank_Create(1, NULL, 0);
+    enc_param.num_channels = 3;
+    enc_param.sampling_rate = 48000;
+    enc_param.bits_per_sample = 4;
+    enc_param.block_size = 3 * 256;
+    Test_AssertEqual(IMAADPCMWAVEncoder_SetEncodeParameter(encoder, &enc_param), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMWAVEncoder_EncodeWhole(encoder,
+          (const int16_t *const *)input, 1024, data, data_size, &output_size), IMAADPCM_APIRESULT_OK);
+    Test_AssertEqual(IMAADPCMDecoderBank_AddStream(bank, data, output_size, &id), IMAADPCM_APIRESULT_INVALID_FORMAT);
+    IMAADPCMDecoderBank_Destroy(bank);
+    IMAADPCMWAVEncoder_Destroy(encoder);
+    free(data);
+  }
+
+  /* 全カーネルの結果の一致確認 */
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckMultichannel(3, 3 * 512, 1, 0), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckMultichannel(3, 3 * 512, 1017 * 5 + 100, 0), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckMultichannel(4, 4 * 256, 505 * 7 + 9, 0x33), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckMultichannel(5, 5 * 512, 1017 * 3 + 3, 0x607), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckMultichannel(6, 6 * 512, 1017 * 4 + 1, 0x3F), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckMultichannel(7, 7 * 36, 65 * 20 + 64, 0), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckMultichannel(8, 8 * 512, 1017 * 6 + 1016, 0x63F), 1);
+
+  /* 他の経路（並列・ストリーミング・レイアウト指定）でも一致 */
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeParallel(3, 3 * 512, 1017 * 20 + 5, 4), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeLayout(6, 6 * 256, 505 * 9 + 77, 3), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeStream(5, 5 * 256, 10, 13, 0), 1);
+  Test_AssertEqual(testIMAADPCMWAVDecoder_CheckDecodeStream(8, 8 * 256, 10, 1000, 0), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeParallel(4, 4 * 512, 1017 * 30 + 11), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeLayout(8, 8 * 512, 1017 * 5 + 3, 2), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeStream(3, 3 * 512, 1017 * 4 + 21, 7), 1);
+  Test_AssertEqual(testIMAADPCMWAVEncoder_CheckEncodeStream(7, 7 * 36, 65 * 9 + 2, 100), 1);
+}
+
+/* 32bitの乱数値 */
+static uint32_t testWAV_Rand32(void)
+{
+  return ((uint32_t)(rand() & 0xFF) << 24) | ((uint32_t)(rand() & 0xFF) << 16)
+    | ((uint32_t)(rand() & 0xFF) << 8) | (uint32_t)(rand() & 0xFF);
+}
+
+/* ファイルの内容を全て読み込む（成功時はサイズを返す） */
+static uint32_t testWAV_LoadFile(const char *filename, uint8_t **data)
+{
+  FILE *fp;
+  struct stat fstat;
+  uint32_t size;
+
+  *data = NULL;
+  if (stat(filename, &fstat) != 0) {
+    return 0;
+  }
+  size = (uint32_t)fstat.st_size;
+  if ((fp = fopen(filename, "rb")) == NULL) {
+    return 0;
+  }
+  *data = (uint8_t *)malloc(size);
+  if (fread(*data, sizeof(uint8_t), size, fp) < size) {
+    size = 0;
+  }
+  fclose(fp);
+
+  return size;
+}
+
+/* バイト列をファイルに書き出す */
+static uint8_t testWAV_SaveFile(const char *filename, const uint8_t *data, uint32_t size)
+{
+  FILE *fp;
+  uint8_t is_ok;
+
+  if ((fp = fopen(filename, "wb")) == NULL) {
+    return 0;
+  }
+  is_ok = (fwrite(data, sizeof(uint8_t), size, fp) == size) ? 1 : 0;
+  fclose(fp);
+
+  return is_ok;
+}
+
+/* リーダで書き出したファイルを読み戻して一致するか確認 list_sizeが非0ならdataチャンクの前にLISTチャンクを挟む */
+static uint8_t testWAV_CheckReader(
+    uint32_t num_channels, uint32_t bits_per_sample, uint32_t num_samples,
+    uint32_t chunk_num_frames, uint32_t list_size)
+{
+  const char test_filename[] = "wav_reader_test.wav";
+  uint8_t is_ok = 0;
+  uint32_t ch, smpl, progress, num_frames, num_read_frames;
+  uint32_t file_size, data_offset;
+  const uint32_t mask = 0xFFFFFFFFUL << (32 - bits_per_sample);
+  uint8_t *file_data = NULL, *list_data = NULL;
+  struct WAVFileFormat format, reader_format;
+  struct WAVFile *wavfile = NULL, *readfile = NULL;
+  struct WAVReader *reader = NULL;
+  WAVPcmData *output[8] = { NULL, };
+  WAVPcmData *output_ptr[8];
+
+  assert(num_channels <= 8);
+
+  /* 量子化ビット数に収まる乱数で埋めたファイルを作成 */
+  format.data_format = WAV_DATA_FORMAT_PCM;
+  format.num_channels = num_channels;
+  format.sampling_rate = 44100;
+  format.bits_per_sample = bits_per_sample;
+  format.num_samples = num_samples;
+  format.channel_mask = 0;
+  if ((wavfile = WAV_Create(&format)) == NULL) {
+    goto CHECK_END;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      wavfile->data[ch][smpl] = (WAVPcmData)(testWAV_Rand32() & mask);
+    }
+    output[ch] = (WAVPcmData *)malloc(sizeof(WAVPcmData) * (num_samples + 1));
+  }
+  if (WAV_WriteToFile(test_filename, wavfile) != WAV_APIRESULT_OK) {
+    goto CHECK_END;
+  }
+
+  /* dataチャンクの前にLISTチャンクを挟む */
+  if (list_size > 0) {
+    assert((list_size % 2) == 0);
+    if ((file_size = testWAV_LoadFile(test_filename, &file_data)) == 0) {
+      goto CHECK_END;
+    }
+    data_offset = file_size - num_samples * num_channels * (bits_per_sample / 8) - 8;
+    if (memcmp(&file_data[data_offset], "data", 4) != 0) {
+      goto CHECK_END;
+    }
+    list_data = (uint8_t *)malloc(file_size + list_size + 8);
+    memcpy(list_data, file_data, data_offset);
+    memcpy(&list_data[data_offset], "LIST", 4);
+    ByteArray_WriteUint32LE(&list_data[data_offset + 4], list_size);
+    memset(&list_data[data_offset + 8], 'd', list_size);
+    memcpy(&list_data[data_offset + 8 + list_size], &file_data[data_offset], file_size - data_offset);
+    ByteArray_WriteUint32LE(&list_data[4], file_size + list_size + 8 - 8);
+    if (testWAV_SaveFile(test_filename, list_data, file_size + list_size + 8) != 1) {
+      goto CHECK_END;
+    }
+  }
+
+  /* フォーマットの確認 */
+  if ((reader = WAV_CreateReader(test_filename, chunk_num_frames)) == NULL) {
+    goto CHECK_END;
+  }
+  if ((WAV_GetReaderFormat(reader, &reader_format) != WAV_APIRESULT_OK)
+      || (reader_format.num_channels != num_channels)
+      || (reader_format.bits_per_sample != bits_per_sample)
+      || (reader_format.sampling_rate != 44100)
+      || (reader_format.num_samples != num_samples)) {
+    goto CHECK_END;
+  }
+
+  /* 不揃いなフレーム数で少しずつ読み込む */
+  progress = 0;
+  num_frames = 1;
+  while (progress < num_samples) {
+    for (ch = 0; ch < num_channels; ch++) {
+      output_ptr[ch] = &output[ch][progress];
+    }
+    if ((WAV_ReadFrames(reader, output_ptr, num_frames, &num_read_frames) != WAV_APIRESULT_OK)
+        || (num_read_frames == 0) || (num_read_frames > num_frames)) {
+      goto CHECK_END;
+    }
+    progress += num_read_frames;
+    num_frames = (num_frames * 7 + 3) % 389 + 1;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    if (memcmp(output[ch], wavfile->data[ch], sizeof(WAVPcmData) * num_samples) != 0) {
+      goto CHECK_END;
+    }
+  }
+
+  /* 末尾に達したら読み込みフレーム数は0 */
+  for (ch = 0; ch < num_channels; ch++) {
+    output_ptr[ch] = &output[ch][num_samples];
+  }
+  if ((WAV_ReadFrames(reader, output_ptr, 1, &num_read_frames) != WAV_APIRESULT_OK)
+      || (num_read_frames != 0)) {
+    goto CHECK_END;
+  }
+
+  /* 一括読み込みも一致 */
+  if ((readfile = WAV_CreateFromFile(test_filename)) == NULL) {
+    goto CHECK_END;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    if (memcmp(readfile->data[ch], wavfile->data[ch], sizeof(WAVPcmData) * num_samples) != 0) {
+      goto CHECK_END;
+    }
+  }
+
+  is_ok = 1;
+CHECK_END:
+  WAV_DestroyReader(reader);
+  WAV_Destroy(readfile);
+  WAV_Destroy(wavfile);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(output[ch]);
+  }
+  free(file_data);
+  free(list_data);
+  remove(test_filename);
+
+  return is_ok;
+}
+
+/* 途中で切れたファイルの読み込みがエラーになるか確認 */
+static uint8_t testWAV_CheckTruncatedReader(
+    uint32_t num_channels, uint32_t bits_per_sample, uint32_t num_samples,
+    uint32_t chunk_num_frames, uint32_t truncate_size)
+{
+  const char test_filename[] = "wav_reader_test.wav";
+  uint8_t is_ok = 0;
+  uint32_t ch, smpl, file_size, num_read_frames;
+  uint8_t *file_data = NULL;
+  struct WAVFileFormat format;
+  struct WAVFile *wavfile = NULL, *readfile = NULL;
+  struct WAVReader *reader = NULL;
+  WAVPcmData *output[8] = { NULL, };
+
+  assert(num_channels <= 8);
+
+  format.data_format = WAV_DATA_FORMAT_PCM;
+  format.num_channels = num_channels;
+  format.sampling_rate = 48000;
+  format.bits_per_sample = bits_per_sample;
+  format.num_samples = num_samples;
+  format.channel_mask = 0;
+  if ((wavfile = WAV_Create(&format)) == NULL) {
+    goto CHECK_END;
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      wavfile->data[ch][smpl] = (WAVPcmData)testWAV_Rand32();
+    }
+    output[ch] = (WAVPcmData *)malloc(sizeof(WAVPcmData) * num_samples);
+  }
+
+  /* 末尾を削ったファイルを作成 */
+  if ((WAV_WriteToFile(test_filename, wavfile) != WAV_APIRESULT_OK)
+      || ((file_size = testWAV_LoadFile(test_filename, &file_data)) == 0)
+      || (truncate_size >= file_size)
+      || (testWAV_SaveFile(test_filename, file_data, file_size - truncate_size) != 1)) {
+    goto CHECK_END;
+  }
+
+  /* ヘッダは読めるが、データを全て読もうとするとエラー */
+  if ((reader = WAV_CreateReader(test_filename, chunk_num_frames)) == NULL) {
+    goto CHECK_END;
+  }
+  if (WAV_ReadFrames(reader, output, num_samples, &num_read_frames) != WAV_APIRESULT_IOERROR) {
+    goto CHECK_END;
+  }
+
+  /* 一括読み込みは失敗する */
+  if ((readfile = WAV_CreateFromFile(test_filename)) != NULL) {
+    goto CHECK_END;
+  }
+
+  is_ok = 1;
+CHECK_END:
+  WAV_DestroyReader(reader);
+  WAV_Destroy(readfile);
+  WAV_Destroy(wavfile);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(output[ch]);
+  }
+  free(file_data);
+  remove(test_filename);
+
+  return is_ok;
+}
+
+/* WAVリーダテスト */
+static void testWAV_ReaderTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* 引数が不正 */
+  {
+    uint32_t num_read_frames;
+    struct WAVFileFormat format;
+    WAVPcmData buffer[1];
+    WAVPcmData *data[1];
+
+    data[0] = buffer;
+    Test_AssertEqual(WAV_CreateReader(NULL, 0) == NULL, 1);
+    Test_AssertEqual(WAV_CreateReader("no_such_file.wav", 0) == NULL, 1);
+    Test_AssertEqual(WAV_GetReaderFormat(NULL, &format), WAV_APIRESULT_INVALID_PARAMETER);
+    Test_AssertEqual(WAV_ReadFrames(NULL, data, 1, &num_read_frames), WAV_APIRESULT_INVALID_PARAMETER);
+  }
+
+  /* 各ビット深度で読み戻し: 先読みバッファより小さいデータ */
+  Test_AssertEqual(testWAV_CheckReader(1,  8, 100, 0, 0), 1);
+  Test_AssertEqual(testWAV_CheckReader(1, 16, 100, 0, 0), 1);
+  Test_AssertEqual(testWAV_CheckReader(2, 24, 100, 0, 0), 1);
+  Test_AssertEqual(testWAV_CheckReader(2, 32, 100, 0, 0), 1);
+  Test_AssertEqual(testWAV_CheckReader(3, 16, 100, 0, 0), 1);
+
+  /* 先読みバッファを跨ぐデータ・小さな読み込み単位 */
+  Test_AssertEqual(testWAV_CheckReader(1,  8, 30000, 1, 0), 1);
+  Test_AssertEqual(testWAV_CheckReader(2, 16, 12345, 7, 0), 1);
+  Test_AssertEqual(testWAV_CheckReader(2, 24, 9999, 13, 0), 1);
+  Test_AssertEqual(testWAV_CheckReader(1, 32, 7777, 1000, 0), 1);
+  Test_AssertEqual(testWAV_CheckReader(3, 24, 5000, 0, 0), 1);
+  Test_AssertEqual(testWAV_CheckReader(6, 16, 4097, 3, 0), 1);
+
+  /* dataチャンクの前のLISTチャンクは読み飛ばす（先読みバッファより大きいものも） */
+  Test_AssertEqual(testWAV_CheckReader(2, 16, 3000, 5, 32), 1);
+  Test_AssertEqual(testWAV_CheckReader(1, 24, 20000, 11, 10 * 1024 - 40), 1);
+  Test_AssertEqual(testWAV_CheckReader(2, 16, 10000, 0, 30 * 1024), 1);
+  Test_AssertEqual(testWAV_CheckReader(3,  8, 1000, 2, 1024), 1);
+
+  /* 途中で切れたファイル: 先読み分だけで終わる場合とファイルから読む場合 */
+  Test_AssertEqual(testWAV_CheckTruncatedReader(1, 16, 100, 0, 1), 1);
+  Test_AssertEqual(testWAV_CheckTruncatedReader(2, 16, 20000, 7, 3), 1);
+  Test_AssertEqual(testWAV_CheckTruncatedReader(2, 24, 20000, 0, 20000), 1);
+  Test_AssertEqual(testWAV_CheckTruncatedReader(1, 32, 10000, 1, 4), 1);
+}
+
+/* バイト列からの変換がスカラーの定義式と一致するか確認 */
+static uint8_t testWAV_CheckConvertBytesToPcmData(
+    uint32_t bytes_per_sample, uint32_t num_channels, uint32_t num_frames, uint32_t offset)
+{
+  uint8_t is_ok = 0;
+  uint32_t ch, smpl, i, value;
+  const uint32_t guard = 8;
+  const WAVPcmData guard_value = (WAVPcmData)0x5A5A5A5AL;
+  uint8_t *bytes;
+  WAVPcmData *data[8] = { NULL, };
+  WAVPcmData *data_ptr[8];
+
+  assert(num_channels <= 8);
+
+  /* 前後に番兵を置いた出力領域 */
+  bytes = (uint8_t *)malloc(bytes_per_sample * num_channels * num_frames + 1);
+  for (i = 0; i < bytes_per_sample * num_channels * num_frames; i++) {
+    bytes[i] = (uint8_t)(rand() & 0xFF);
+  }
+  for (ch = 0; ch < num_channels; ch++) {
+    data[ch] = (WAVPcmData *)malloc(sizeof(WAVPcmData) * (offset + num_frames + 2 * guard));
+    for (smpl = 0; smpl < offset + num_frames + 2 * guard; smpl++) {
+      data[ch][smpl] = guard_value;
+    }
+    data_ptr[ch] = &data[ch][guard];
+  }
+
+  WAV_ConvertBytesToPcmData(bytes, bytes_per_sample, num_channels, num_frames, data_ptr, offset);
+
+  for (ch = 0; ch < num_channels; ch++) {
+    /* 範囲外は書き換えない */
+    for (smpl = 0; smpl < guard + offset; smpl++) {
+      if (data[ch][smpl] != guard_value) {
+        goto CHECK_END;
+      }
+    }
+    for (smpl = guard + offset + num_frames; smpl < offset + num_frames + 2 * guard; smpl++) {
+      if (data[ch][smpl] != guard_value) {
+        goto CHECK_END;
+      }
+    }
+    /* リトルエンディアンの値を上位に詰める（8bitは符号なしなので128を引く） */
+    for (smpl = 0; smpl < num_frames; smpl++) {
+      const uint8_t *src = &bytes[(smpl * num_channels + ch) * bytes_per_sample];
+      value = 0;
+      for (i = 0; i < bytes_per_sample; i++) {
+        value |= (uint32_t)src[i] << (8 * (4 - bytes_per_sample + i));
+      }
+      if (bytes_per_sample == 1) {
+        value ^= 0x80000000UL;
+      }
+      if (data_ptr[ch][offset + smpl] != (WAVPcmData)value) {
+        goto CHECK_END;
+      }
+    }
+  }
+
+  is_ok = 1;
+CHECK_END:
+  free(bytes);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(data[ch]);
+  }
+
+  return is_ok;
+}
+
+/* バイト列からの変換テスト */
+static void testWAV_ConvertBytesToPcmDataTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* SIMD処理の端数も含めて全ての組み合わせで確認 */
+  {
+    uint32_t bytes_per_sample, num_channels, num_frames;
+    uint8_t is_ok = 1;
+    for (bytes_per_sample = 1; bytes_per_sample <= 4; bytes_per_sample++) {
+      for (num_channels = 1; num_channels <= 3; num_channels++) {
+        for (num_frames = 0; num_frames <= 37; num_frames++) {
+          if ((testWAV_CheckConvertBytesToPcmData(bytes_per_sample, num_channels, num_frames, 0) != 1)
+              || (testWAV_CheckConvertBytesToPcmData(bytes_per_sample, num_channels, num_frames, 5) != 1)) {
+            is_ok = 0;
+          }
+        }
+      }
+    }
+    Test_AssertEqual(is_ok, 1);
+  }
+
+  /* 長いデータ */
+  Test_AssertEqual(testWAV_CheckConvertBytesToPcmData(2, 1, 4099, 3), 1);
+  Test_AssertEqual(testWAV_CheckConvertBytesToPcmData(2, 2, 4099, 1), 1);
+  Test_AssertEqual(testWAV_CheckConvertBytesToPcmData(3, 6, 1001, 0), 1);
+}
+
+/* バイト列への変換がスカラーの定義式と一致し、バイト列からの変換と往復して元に戻るか確認 */
+static uint8_t testWAV_CheckConvertPcmDataToBytes(
+    uint32_t bytes_per_sample, uint32_t num_channels, uint32_t num_frames, uint32_t offset)
+{
+  uint8_t is_ok = 0;
+  uint32_t ch, smpl, i, value;
+  const uint32_t guard = 16;
+  const uint32_t num_bytes = bytes_per_sample * num_channels * num_frames;
+  uint8_t *bytes, *reference, *roundtrip;
+  WAVPcmData *data[8] = { NULL, };
+
+  assert(num_channels <= 8);
+
+  /* 下位ビットも含めた任意の32bit値を入力 */
+  for (ch = 0; ch < num_channels; ch++) {
+    data[ch] = (WAVPcmData *)malloc(sizeof(WAVPcmData) * (offset + num_frames + 1));
+    for (smpl = 0; smpl < offset + num_frames + 1; smpl++) {
+      data[ch][smpl] = (WAVPcmData)testWAV_Rand32();
+    }
+  }
+  bytes = (uint8_t *)malloc(num_bytes + guard);
+  reference = (uint8_t *)malloc(num_bytes + guard);
+  roundtrip = (uint8_t *)malloc(num_bytes + guard);
+  memset(bytes, 0xA5, num_bytes + guard);
+  memset(reference, 0xA5, num_bytes + guard);
+
+  /* 上位bytes_per_sampleバイトをリトルエンディアンで並べる（8bitは128を足す） */
+  for (ch = 0; ch < num_channels; ch++) {
+    for (smpl = 0; smpl < num_frames; smpl++) {
+      uint8_t *dst = &reference[(smpl * num_channels + ch) * bytes_per_sample];
+      value = (uint32_t)data[ch][offset + smpl];
+      if (bytes_per_sample == 1) {
+        value ^= 0x80000000UL;
+      }
+      for (i = 0; i < bytes_per_sample; i++) {
+        dst[i] = (uint8_t)(value >> (8 * (4 - bytes_per_sample + i)));
+      }
+    }
+  }
+
+  /* 番兵も含めて一致 */
+  WAV_ConvertPcmDataToBytes((const WAVPcmData *const *)data, offset, num_frames,
+      bytes_per_sample, num_channels, bytes);
+  if (memcmp(bytes, reference, num_bytes + guard) != 0) {
+    goto CHECK_END;
+  }
+
+  /* バイト列 -> PCM -> バイト列で元に戻る */
+  WAV_ConvertBytesToPcmData(bytes, bytes_per_sample, num_channels, num_frames, data, offset);
+  WAV_ConvertPcmDataToBytes((const WAVPcmData *const *)data, offset, num_frames,
+      bytes_per_sample, num_channels, roundtrip);
+  if (memcmp(roundtrip, bytes, num_bytes) != 0) {
+    goto CHECK_END;
+  }
+
+  is_ok = 1;
+CHECK_END:
+  free(bytes);
+  free(reference);
+  free(roundtrip);
+  for (ch = 0; ch < num_channels; ch++) {
+    free(data[ch]);
+  }
+
+  return is_ok;
+}
+
+/* バイト列への変換テスト */
+static void testWAV_ConvertPcmDataToBytesTest(void *obj)
+{
+  TEST_UNUSED_PARAMETER(obj);
+
+  /* SIMD処理の端数も含めて全ての組み合わせで確認 */
+  {
+    uint32_t bytes_per_sample, num_channels, num_frames;
+    uint8_t is_ok = 1;
+    for (bytes_per_sample = 1; bytes_per_sample <= 4; bytes_per_sample++) {
+      for (num_channels = 1; num_channels <= 3; num_channels++) {
+        for (num_frames = 0; num_frames <= 37; num_frames++) {
+          if ((testWAV_CheckConvertPcmDataToBytes(bytes_per_sample, num_channels, num_frames, 0) != 1)
+              || (testWAV_CheckConvertPcmDataToBytes(bytes_per_sample, num_channels, num_frames, 3) != 1)) {
+            is_ok = 0;
+          }
+        }
+      }
+    }
+    Test_AssertEqual(is_ok, 1);
+  }
+
+  /* 16bitの最大・最小付近（飽和パックで値が変わらない） */
+  {
+    uint8_t bytes[2 * 2 * 8];
+    WAVPcmData buffer[2][8];
+    WAVPcmData *data[2];
+    uint32_t smpl;
+    const WAVPcmData edge[8] = {
+      (WAVPcmData)0x7FFFFFFFL, (WAVPcmData)0x7FFF0000L, (WAVPcmData)0x80000000UL, (WAVPcmData)0x8000FFFFUL,
+      (WAVPcmData)0xFFFFFFFFUL, 0, 0x0000FFFFL, (WAVPcmData)0xFFFF0000UL };
+
+    data[0] = buffer[0];
+    data[1] = buffer[1];
+    for (smpl = 0; smpl < 8; smpl++) {
+      buffer[0][smpl] = edge[smpl];
+      buffer[1][smpl] = edge[7 - smpl];
+    }
+    WAV_ConvertPcmDataToBytes((const WAVPcmData *const *)data, 0, 8, 2, 1, bytes);
+    Test_AssertEqual(bytes[0], 0xFF); Test_AssertEqual(bytes[1], 0x7F);
+    Test_AssertEqual(bytes[4], 0x00); Test_AssertEqual(bytes[5], 0x80);
+    Test_AssertEqual(bytes[8], 0xFF); Test_AssertEqual(bytes[9], 0xFF);
+    WAV_ConvertPcmDataToBytes((const WAVPcmData *const *)data, 0, 8, 2, 2, bytes);
+    Test_AssertEqual(bytes[0], 0xFF); Test_AssertEqual(bytes[1], 0x7F);
+    Test_AssertEqual(bytes[2], 0xFF); Test_AssertEqual(bytes[3], 0xFF);
+    Test_AssertEqual(bytes[28], 0xFF); Test_AssertEqual(bytes[29], 0xFF);
+    Test_AssertEqual(bytes[30], 0xFF); Test_AssertEqual(bytes[31], 0x7F);
   }
 
+  /* 長いデータ */
+  Test_AssertEqual(testWAV_CheckConvertPcmDataToBytes(2, 1, 4099, 3), 1);
+  Test_AssertEqual(testWAV_CheckConvertPcmDataToBytes(2, 2, 4099, 1), 1);
+  Test_AssertEqual(testWAV_CheckConvertPcmDataToBytes(3, 6, 1001, 0), 1);
 }
 
 void testIMAADPCM_Setup(void)
@@ -717,8 +4344,30 @@ void testIMAADPCM_Setup(void)
 
   Test_AddTest(suite, testIMAADPCM_HeaderEncodeDecodeTest);
   Test_AddTest(suite, testIMAADPCMWAVDecoder_CreateDestroyTest);
+  Test_AddTest(suite, testIMAADPCMCoreDecoder_TransitionTableTest);
+  Test_AddTest(suite, testIMAADPCMWAVDecoder_ByteDecodeTest);
   Test_AddTest(suite, testIMAADPCMWAVDecoder_DecodeTest);
+  Test_AddTest(suite, testIMAADPCMWAVDecoder_DecodeBlocksSIMDTest);
+  Test_AddTest(suite, testIMAADPCM_SetKernelTest);
+  Test_AddTest(suite, testIMAADPCMWAVDecoder_DecodeParallelTest);
+  Test_AddTest(suite, testIMAADPCMWAVDecoder_DecodeLayoutTest);
+  Test_AddTest(suite, testIMAADPCMWAVDecoder_DecodeStreamTest);
+  Test_AddTest(suite, testIMAADPCMWAVDecoder_DecodeRangeTest);
+  Test_AddTest(suite, testIMAADPCMWAVDecoder_DecodeSeekIndexTest);
+  Test_AddTest(suite, testIMAADPCMDecoderBank_DecodeTest);
+  Test_AddTest(suite, testIMAADPCMWAVDecoder_DecodeMixTest);
+  Test_AddTest(suite, testIMAADPCMWAVDecoder_DecodeResampleTest);
+  Test_AddTest(suite, testIMAADPCMCoreEncoder_QuantizeDiffTest);
   Test_AddTest(suite, testIMAADPCMWAVEncoder_CreateDestroyTest);
   Test_AddTest(suite, testIMAADPCMWAVEncoder_SetEncodeParameterTest);
+  Test_AddTest(suite, testIMAADPCMWAVEncoder_CalculateOutputSizeTest);
+  Test_AddTest(suite, testIMAADPCMWAVEncoder_RF64Test);
+  Test_AddTest(suite, testIMAADPCMWAVEncoder_MultichannelTest);
   Test_AddTest(suite, testIMAADPCMWAVDecoder_EncodeTest);
+  Test_AddTest(suite, testIMAADPCMWAVEncoder_EncodeParallelTest);
+  Test_AddTest(suite, testIMAADPCMWAVEncoder_EncodeLayoutTest);
+  Test_AddTest(suite, testIMAADPCMWAVEncoder_EncodeStreamTest);
+  Test_AddTest(suite, testWAV_ReaderTest);
+  Test_AddTest(suite, testWAV_ConvertBytesToPcmDataTest);
+  Test_AddTest(suite, testWAV_ConvertPcmDataToBytesTest);
 }
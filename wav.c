@@ -5,9 +5,21 @@
 #include <string.h>
 #include <assert.h>
 
+/* SSE2命令の使用可否 */
+#if defined(__GNUC__) && defined(__SSE2__)
+#define WAV_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 /* パーサの読み込みバッファサイズ */
 #define WAVBITBUFFER_BUFFER_SIZE         (10 * 1024)
 
+/* リーダが1度に読み込むフレーム数のデフォルト値 */
+#define WAVREADER_DEFAULT_CHUNK_NUM_FRAMES (4 * 1024)
+
+/* ライタがPCMデータを1度に書き出すフレーム数 */
+#define WAVWRITER_CHUNK_NUM_FRAMES (4 * 1024)
+
 /* 下位n_bitsを取得 */
 /* 補足）((1 << n_bits) - 1)は下位の数値だけ取り出すマスクになる */
 #define WAV_GetLowerBits(n_bits, val) ((val) & (uint32_t)((1 << (n_bits)) - 1))
@@ -30,8 +42,22 @@ struct WAVBitBuffer {
 
 /* パーサ */
 struct WAVParser {
-  FILE*               fp;       /* 読み込みファイルポインタ */
-  struct WAVBitBuffer buffer;   /* ビットバッファ */
+  FILE*               fp;           /* 読み込みファイルポインタ */
+  struct WAVBitBuffer buffer;       /* ビットバッファ */
+  int32_t             buffer_size;  /* ビットバッファに読み込んだバイト数 */
+};
+
+/* リーダ */
+struct WAVReader {
+  FILE*                 fp;                 /* 読み込みファイルポインタ */
+  struct WAVFileFormat  format;             /* フォーマット */
+  uint32_t              bytes_per_sample;   /* サンプルあたりバイト数 */
+  uint32_t              chunk_num_frames;   /* 1度に読み込むフレーム数 */
+  uint32_t              frame_pos;          /* 読み込み済みフレーム数 */
+  uint8_t*              chunk;              /* 読み込みバッファ */
+  uint8_t*              pending;            /* ヘッダ読み取り時に先読みしたPCMデータ */
+  uint32_t              pending_size;       /* 先読みしたPCMデータのバイト数 */
+  uint32_t              pending_pos;        /* 先読みしたPCMデータの読み出し位置 */
 };
 
 /* ライタ */
@@ -49,7 +75,11 @@ static void WAVParser_Finalize(struct WAVParser* parser);
 /* n_bit 取得し、結果を右詰めする */
 static WAVError WAVParser_GetBits(struct WAVParser* parser, uint32_t n_bits, uint64_t* bitsbuf);
 /* シーク（fseek準拠） */
-static WAVError WAVParser_Seek(struct WAVParser* parser, int32_t offset, int32_t wherefrom);
+static WAVError WAVParser_Seek(struct WAVParser* parser, long offset, int32_t wherefrom);
+/* 読み込み位置（ファイル先頭からのバイト数）を取得 */
+static long WAVParser_Tell(struct WAVParser* parser);
+/* バッファに先読みしていてまだ読み出していないバイト列を取得 */
+static uint32_t WAVParser_GetBufferedBytes(struct WAVParser* parser, const uint8_t** bytes);
 /* ライタの初期化 */
 static void WAVWriter_Initialize(struct WAVWriter* writer, FILE* fp);
 /* ライタの終了 */
@@ -81,34 +111,25 @@ static WAVError WAVParser_CheckSignatureString(
 /* パーサを使用してファイルフォーマットを読み取り */
 static WAVError WAVParser_GetWAVFormat(
     struct WAVParser* parser, struct WAVFileFormat* format);
-/* パーサを使用してPCMデータを読み取り */
-static WAVError WAVParser_GetWAVPcmData(
-    struct WAVParser* parser, struct WAVFile* wavfile);
-
-/* 8bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert8bitPCMto32bitPCM(int32_t in_8bitpcm);
-/* 16bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert16bitPCMto32bitPCM(int32_t in_16bitpcm);
-/* 24bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert24bitPCMto32bitPCM(int32_t in_24bitpcm);
-/* 32bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert32bitPCMto32bitPCM(int32_t in_32bitpcm);
-
-/* 32bitPCM形式を8bit形式に変換（注意：返り値は32bit整数だが、8bit範囲でクリップされている） */
-static int32_t WAV_Convert32bitPCMto8bitPCM(int32_t in_32bitpcm);
-/* 32bitPCM形式を16bit形式に変換（注意：返り値は32bit整数だが、16bit範囲でクリップされている） */
-static int32_t WAV_Convert32bitPCMto8bitPCM(int32_t in_32bitpcm);
-/* 32bitPCM形式を24bit形式に変換（注意：返り値は32bit整数だが、24bit範囲でクリップされている） */
-static int32_t WAV_Convert32bitPCMto16bitPCM(int32_t in_32bitpcm);
-/* 32bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert32bitPCMto32bitPCM(int32_t in_32bitpcm);
+
+/* インターリーブされたリトルエンディアンのPCMバイト列を32bit形式に変換しつつチャンネル毎に分けてdata[ch][offset]から書き出す */
+static void WAV_ConvertBytesToPcmData(
+    const uint8_t* bytes, uint32_t bytes_per_sample, uint32_t num_channels,
+    uint32_t num_frames, WAVPcmData** data, uint32_t offset);
+
+/* チャンネル毎の32bit形式のdata[ch][offset]からnum_framesフレームをインターリーブされたリトルエンディアンのPCMバイト列に変換 */
+static void WAV_ConvertPcmDataToBytes(
+    const WAVPcmData* const* data, uint32_t offset, uint32_t num_frames,
+    uint32_t bytes_per_sample, uint32_t num_channels, uint8_t* bytes);
 
 /* パーサを使用してファイルフォーマットを読み取り */
 static WAVError WAVParser_GetWAVFormat(
     struct WAVParser* parser, struct WAVFileFormat* format)
 {
-  uint64_t  bitsbuf;
-  int32_t   fmt_chunk_size;
+  uint64_t  bitsbuf, upper_bits, data_size, ds64_data_size;
+  int32_t   fmt_chunk_size, fmt_read_size;
+  uint8_t   is_rf64, has_ds64, is_extensible;
+  char      string_buf[4];
   struct WAVFileFormat tmp_format;
 
   /* 引数チェック */
@@ -116,8 +137,15 @@ static WAVError WAVParser_GetWAVFormat(
     return WAV_ERROR_INVALID_PARAMETER;
   }
   
-  /* ヘッダ 'R', 'I', 'F', 'F' をチェック */
-  if (WAVParser_CheckSignatureString(parser, "RIFF", 4) != WAV_ERROR_OK) {
+  /* ヘッダ 'R', 'I', 'F', 'F' をチェック 4GBを超えるファイルはRF64（BW64） */
+  if (WAVParser_GetString(parser, string_buf, 4) != WAV_ERROR_OK) {
+    return WAV_ERROR_IO;
+  }
+  if (strncmp(string_buf, "RIFF", 4) == 0) {
+    is_rf64 = 0;
+  } else if ((strncmp(string_buf, "RF64", 4) == 0) || (strncmp(string_buf, "BW64", 4) == 0)) {
+    is_rf64 = 1;
+  } else {
     return WAV_ERROR_INVALID_FORMAT;
   }
 
@@ -129,8 +157,37 @@ static WAVError WAVParser_GetWAVFormat(
     return WAV_ERROR_INVALID_FORMAT;
   }
 
-  /* fmtチャンクのヘッダ 'f', 'm', 't', ' ' をチェック */
-  if (WAVParser_CheckSignatureString(parser, "fmt ", 4) != WAV_ERROR_OK) {
+  /* fmtチャンクまで読み進める */
+  /* ds64チャンクからは64bitのdataチャンクサイズを取得し、他のチャンク（JUNK等）は読み飛ばす */
+  has_ds64 = 0;
+  ds64_data_size = 0;
+  while (1) {
+    if (WAVParser_GetString(parser, string_buf, 4) != WAV_ERROR_OK) {
+      return WAV_ERROR_IO;
+    }
+    if (strncmp(string_buf, "fmt ", 4) == 0) {
+      break;
+    }
+    if (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    if (strncmp(string_buf, "ds64", 4) == 0) {
+      /* RIFFサイズ, dataサイズ（各64bit）を読み、サンプル数とテーブルは読み飛ばし */
+      const uint64_t ds64_chunk_size = bitsbuf;
+      if (ds64_chunk_size < 24) {
+        return WAV_ERROR_INVALID_FORMAT;
+      }
+      if (WAVParser_Seek(parser, 8, SEEK_CUR) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+      if (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+      if (WAVParser_GetLittleEndianBytes(parser, 4, &upper_bits) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+      ds64_data_size = (upper_bits << 32) | bitsbuf;
+      if (WAVParser_Seek(parser, (long)(ds64_chunk_size - 16), SEEK_CUR) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+      has_ds64 = 1;
+    } else {
+      if (WAVParser_Seek(parser, (long)bitsbuf, SEEK_CUR) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    }
+  }
+
+  /* RF64はds64チャンクが必須 */
+  if (is_rf64 && !has_ds64) {
     return WAV_ERROR_INVALID_FORMAT;
   }
 
@@ -140,13 +197,15 @@ static WAVError WAVParser_GetWAVFormat(
   fmt_chunk_size = (int32_t)bitsbuf;
 
   /* フォーマットIDをチェック
-   * 補足）1（リニアPCM）以外対応していない */
+   * 補足）1（リニアPCM）とサブフォーマットで指定する0xFFFE（WAVE_FORMAT_EXTENSIBLE）以外対応していない */
   if (WAVParser_GetLittleEndianBytes(parser, 2, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
-  if (bitsbuf != 1) {
+  if ((bitsbuf != 1) && (bitsbuf != 0xFFFE)) {
     /* fprintf(stderr, "Unsupported format: fmt chunk format ID \n"); */
     return WAV_ERROR_INVALID_FORMAT;
   }
+  is_extensible = (bitsbuf == 0xFFFE) ? 1 : 0;
   tmp_format.data_format = WAV_DATA_FORMAT_PCM;
+  tmp_format.channel_mask = 0;
 
   /* チャンネル数 */
   if (WAVParser_GetLittleEndianBytes(parser, 2, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
@@ -166,15 +225,36 @@ static WAVError WAVParser_GetWAVFormat(
   if (WAVParser_GetLittleEndianBytes(parser, 2, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
   tmp_format.bits_per_sample = (uint32_t)bitsbuf;
 
-  /* 拡張部分の読み取りには未対応: 読み飛ばしを行う */
-  if (fmt_chunk_size > 16) {
-    fprintf(stderr, "Warning: skip fmt chunk extention (unsupported). \n");
-    if (WAVParser_Seek(parser, fmt_chunk_size - 16, SEEK_CUR) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+  /* WAVE_FORMAT_EXTENSIBLEの拡張部分: チャンネル配置とサブフォーマットを読む */
+  fmt_read_size = 16;
+  if (is_extensible) {
+    /* 拡張部分のサイズ(2), 有効ビット数(2), チャンネル配置(4), サブフォーマットGUID(16) */
+    if (fmt_chunk_size < 40) {
+      return WAV_ERROR_INVALID_FORMAT;
+    }
+    /* 拡張部分のサイズと有効ビット数は読み飛ばし */
+    if (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    /* チャンネル配置 */
+    if (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    tmp_format.channel_mask = (uint32_t)bitsbuf;
+    /* サブフォーマットGUIDの先頭2byteがフォーマットID 1（リニアPCM）以外対応していない */
+    if (WAVParser_GetLittleEndianBytes(parser, 2, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    if (bitsbuf != 1) {
+      return WAV_ERROR_INVALID_FORMAT;
+    }
+    fmt_read_size = 26;
+  }
+
+  /* それ以外の拡張部分の読み取りには未対応: 読み飛ばしを行う */
+  if (fmt_chunk_size > fmt_read_size) {
+    if (!is_extensible) {
+      fprintf(stderr, "Warning: skip fmt chunk extention (unsupported). \n");
+    }
+    if (WAVParser_Seek(parser, (long)(fmt_chunk_size - fmt_read_size), SEEK_CUR) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
   }
   
   /* チャンク読み取り */
   while (1) {
-    char string_buf[4];
     /* チャンク文字列取得 */
     if (WAVParser_GetString(parser, string_buf, 4) != WAV_ERROR_OK) {
       return WAV_ERROR_IO;
@@ -187,66 +267,28 @@ static WAVError WAVParser_GetWAVFormat(
       if (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK) {
         return WAV_ERROR_IO;
       }
-      /* printf("chunk:%s size:%d \n", string_buf, (int32_t)bitsbuf); */
-      WAVParser_Seek(parser, (int32_t)bitsbuf, SEEK_CUR);
+      if (WAVParser_Seek(parser, (long)bitsbuf, SEEK_CUR) != WAV_ERROR_OK) {
+        return WAV_ERROR_IO;
+      }
     }
   }
 
   /* サンプル数: 波形データバイト数から算出 */
-  if (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
-  tmp_format.num_samples = (uint32_t)bitsbuf;
-  assert(tmp_format.num_samples % ((tmp_format.bits_per_sample / 8) * tmp_format.num_channels) == 0);
-  tmp_format.num_samples /= ((tmp_format.bits_per_sample / 8) * tmp_format.num_channels);
-
-  /* 構造体コピー */
-  *format = tmp_format;
-
-  return WAV_ERROR_OK;
-}
-
-/* パーサを使用してPCMデータを読み取り */
-static WAVError WAVParser_GetWAVPcmData(
-    struct WAVParser* parser, struct WAVFile* wavfile)
-{
-  uint32_t  ch, sample, bytes_per_sample;
-  uint64_t  bitsbuf;
-  int32_t   (*convert_to_sint32_func)(int32_t);
-
-  /* 引数チェック */
-  if (parser == NULL || wavfile == NULL) {
-    return WAV_ERROR_INVALID_PARAMETER;
+  /* RF64でサイズが-1の場合はds64チャンクのサイズを使う */
+  if (WAVParser_GetLittleEndianBytes(parser, 4, &data_size) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+  if (is_rf64 && (data_size == 0xFFFFFFFFUL)) {
+    data_size = ds64_data_size;
   }
-
-  /* ビット深度に合わせてPCMデータの変換関数を決定 */
-  switch (wavfile->format.bits_per_sample) {
-    case 8:
-      convert_to_sint32_func = WAV_Convert8bitPCMto32bitPCM;
-      break;
-    case 16:
-      convert_to_sint32_func = WAV_Convert16bitPCMto32bitPCM;
-      break;
-    case 24:
-      convert_to_sint32_func = WAV_Convert24bitPCMto32bitPCM;
-      break;
-    case 32:
-      convert_to_sint32_func = WAV_Convert32bitPCMto32bitPCM;
-      break;
-    default:
-      /* fprintf(stderr, "Unsupported bits per sample format(=%d). \n", wavfile->format.bits_per_sample); */
-      return WAV_ERROR_INVALID_FORMAT;
+  assert(data_size % ((tmp_format.bits_per_sample / 8) * tmp_format.num_channels) == 0);
+  data_size /= ((tmp_format.bits_per_sample / 8) * tmp_format.num_channels);
+  /* サンプル数は32bitで表せる範囲のみ対応 */
+  if (data_size > UINT32_MAX) {
+    return WAV_ERROR_INVALID_FORMAT;
   }
+  tmp_format.num_samples = (uint32_t)data_size;
 
-  /* データ読み取り */
-  bytes_per_sample = wavfile->format.bits_per_sample / 8;
-  for (sample = 0; sample < wavfile->format.num_samples; sample++) {
-    for (ch = 0; ch < wavfile->format.num_channels; ch++) {
-      if (WAVParser_GetLittleEndianBytes(parser, bytes_per_sample, &bitsbuf) != WAV_ERROR_OK) {
-        return WAV_ERROR_IO;
-      }
-      /* 32bit整数形式に変形してデータにセット */
-      wavfile->data[ch][sample] = convert_to_sint32_func((int32_t)(bitsbuf));
-    }
-  }
+  /* 構造体コピー */
+  *format = tmp_format;
 
   return WAV_ERROR_OK;
 }
@@ -254,12 +296,21 @@ static WAVError WAVParser_GetWAVPcmData(
 /* ファイルからWAVファイルフォーマットだけ読み取り */
 WAVApiResult WAV_GetWAVFormatFromFile(
     const char* filename, struct WAVFileFormat* format)
+{
+  uint32_t data_offset;
+  return WAV_GetWAVFormatAndDataOffsetFromFile(filename, format, &data_offset);
+}
+
+/* ファイルからWAVファイルフォーマットとPCMデータ先頭のオフセットを読み取り */
+WAVApiResult WAV_GetWAVFormatAndDataOffsetFromFile(
+    const char* filename, struct WAVFileFormat* format, uint32_t* data_offset)
 {
   struct WAVParser parser;
   FILE*            fp;
+  long             pos;
 
   /* 引数チェック */
-  if (filename == NULL || format == NULL) {
+  if (filename == NULL || format == NULL || data_offset == NULL) {
     return WAV_APIRESULT_NG;
   }
   
@@ -275,62 +326,61 @@ WAVApiResult WAV_GetWAVFormatFromFile(
 
   /* ヘッダ読み取り */
   if (WAVParser_GetWAVFormat(&parser, format) != WAV_ERROR_OK) {
+    fclose(fp);
     return WAV_APIRESULT_NG;
   }
 
+  /* ヘッダ直後（PCMデータ先頭）の位置 */
+  pos = WAVParser_Tell(&parser);
+
   /* パーサ使用終了 */
   WAVParser_Finalize(&parser);
 
   /* ファイルを閉じる */
   fclose(fp);
 
+  /* パイプ等で位置が取れない */
+  if (pos < 0) {
+    return WAV_APIRESULT_NG;
+  }
+  (*data_offset) = (uint32_t)pos;
+
   return WAV_APIRESULT_OK;
 }
 
 /* ファイルからWAVファイルハンドルを作成 */
 struct WAVFile* WAV_CreateFromFile(const char* filename)
 {
-  struct WAVParser      parser;
-  FILE*                 fp;
+  struct WAVReader*     reader;
   struct WAVFile*       wavfile;
-  struct WAVFileFormat  format;
+  uint32_t              num_read_frames;
 
   /* 引数チェック */
   if (filename == NULL) {
     return NULL;
   }
-  
-  /* wavファイルを開く */
-  fp = fopen(filename, "rb");
-  if (fp == NULL) {
-    /* fprintf(stderr, "Failed to open %s. \n", filename); */
-    return NULL;
-  }
 
-  /* パーサ初期化 */
-  WAVParser_Initialize(&parser, fp);
-
-  /* ヘッダ読み取り */
-  if (WAVParser_GetWAVFormat(&parser, &format) != WAV_ERROR_OK) {
+  /* リーダでファイルを開く（ヘッダ読み取り） */
+  reader = WAV_CreateReader(filename, 0);
+  if (reader == NULL) {
     return NULL;
   }
 
   /* ハンドル作成 */
-  wavfile = WAV_Create(&format);
+  wavfile = WAV_Create(&reader->format);
   if (wavfile == NULL) {
+    WAV_DestroyReader(reader);
     return NULL;
   }
 
   /* PCMデータ読み取り */
-  if (WAVParser_GetWAVPcmData(&parser, wavfile) != WAV_ERROR_OK) {
+  if ((WAV_ReadFrames(reader, wavfile->data, wavfile->format.num_samples, &num_read_frames) != WAV_APIRESULT_OK)
+      || (num_read_frames != wavfile->format.num_samples)) {
     goto EXIT_FAILURE_WITH_DATA_RELEASE;
   }
 
-  /* パーサ終了 */
-  WAVParser_Finalize(&parser);
-
-  /* ファイルを閉じる */
-  fclose(fp);
+  /* リーダ終了（ファイルを閉じる） */
+  WAV_DestroyReader(reader);
 
   /* 正常終了 */
   return wavfile;
@@ -338,8 +388,7 @@ struct WAVFile* WAV_CreateFromFile(const char* filename)
   /* ハンドルが確保したデータを全て解放して終了 */
 EXIT_FAILURE_WITH_DATA_RELEASE:
   WAV_Destroy(wavfile);
-  WAVParser_Finalize(&parser);
-  fclose(fp);
+  WAV_DestroyReader(reader);
   return NULL;
 }
 
@@ -388,51 +437,289 @@ EXIT_FAILURE_WITH_DATA_RELEASE:
   return NULL;
 }
 
-/* 8bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert8bitPCMto32bitPCM(int32_t in_8bitpcm)
+/* ファイルを開いてリーダハンドルを作成 */
+struct WAVReader* WAV_CreateReader(const char* filename, uint32_t chunk_num_frames)
 {
-  /* 無音に相当する128を引いてから32bit整数に切り上げる */
-  return (in_8bitpcm - 128) << 24;
-}
+  struct WAVParser  parser;
+  struct WAVReader* reader;
+  const uint8_t*    buffered;
 
-/* 16bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert16bitPCMto32bitPCM(int32_t in_16bitpcm)
-{
-  /* そのまま16bit左シフト */
-  return in_16bitpcm << 16;
+  /* 引数チェック */
+  if (filename == NULL) {
+    return NULL;
+  }
+
+  /* ハンドル作成 */
+  reader = (struct WAVReader *)malloc(sizeof(struct WAVReader));
+  if (reader == NULL) {
+    return NULL;
+  }
+  reader->chunk = NULL;
+  reader->pending = NULL;
+
+  /* wavファイルを開く */
+  reader->fp = fopen(filename, "rb");
+  if (reader->fp == NULL) {
+    /* fprintf(stderr, "Failed to open %s. \n", filename); */
+    goto EXIT_FAILURE_WITH_DATA_RELEASE;
+  }
+
+  /* ヘッダ読み取り */
+  WAVParser_Initialize(&parser, reader->fp);
+  if (WAVParser_GetWAVFormat(&parser, &reader->format) != WAV_ERROR_OK) {
+    goto EXIT_FAILURE_WITH_DATA_RELEASE;
+  }
+
+  /* パーサが先読みしたPCMデータを取っておく（シークしないのでパイプからも読める） */
+  reader->pending_size = WAVParser_GetBufferedBytes(&parser, &buffered);
+  reader->pending_pos = 0;
+  if (reader->pending_size > 0) {
+    reader->pending = (uint8_t *)malloc(reader->pending_size);
+    if (reader->pending == NULL) {
+      goto EXIT_FAILURE_WITH_DATA_RELEASE;
+    }
+    memcpy(reader->pending, buffered, reader->pending_size);
+  }
+  WAVParser_Finalize(&parser);
+
+  /* 対応しているビット深度 */
+  switch (reader->format.bits_per_sample) {
+    case 8: case 16: case 24: case 32:
+      break;
+    default:
+      goto EXIT_FAILURE_WITH_DATA_RELEASE;
+  }
+
+  /* 読み込みバッファの割り当て */
+  reader->bytes_per_sample = reader->format.bits_per_sample / 8;
+  reader->chunk_num_frames = (chunk_num_frames > 0) ? chunk_num_frames : WAVREADER_DEFAULT_CHUNK_NUM_FRAMES;
+  reader->frame_pos = 0;
+  reader->chunk = (uint8_t *)malloc((size_t)reader->chunk_num_frames * reader->bytes_per_sample * reader->format.num_channels);
+  if (reader->chunk == NULL) {
+    goto EXIT_FAILURE_WITH_DATA_RELEASE;
+  }
+
+  return reader;
+
+EXIT_FAILURE_WITH_DATA_RELEASE:
+  WAV_DestroyReader(reader);
+  return NULL;
 }
 
-/* 24bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert24bitPCMto32bitPCM(int32_t in_24bitpcm)
+/* リーダハンドルを破棄（ファイルも閉じる） */
+void WAV_DestroyReader(struct WAVReader* reader)
 {
-  /* そのまま8bit左シフト */
-  return in_24bitpcm << 8;
+  if (reader != NULL) {
+    if (reader->fp != NULL) {
+      fclose(reader->fp);
+    }
+    if (reader->chunk != NULL) {
+      free(reader->chunk);
+    }
+    if (reader->pending != NULL) {
+      free(reader->pending);
+    }
+    free(reader);
+  }
 }
 
-/* 32bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert32bitPCMto32bitPCM(int32_t in_32bitpcm)
+/* リーダハンドルからフォーマットを取得 */
+WAVApiResult WAV_GetReaderFormat(
+    const struct WAVReader* reader, struct WAVFileFormat* format)
 {
-  /* 何もしない */
-  return in_32bitpcm;
+  /* 引数チェック */
+  if (reader == NULL || format == NULL) {
+    return WAV_APIRESULT_INVALID_PARAMETER;
+  }
+
+  *format = reader->format;
+  return WAV_APIRESULT_OK;
 }
 
-/* 32bitPCM形式を8bit形式に変換（注意：返り値は32bit整数だが、8bit範囲でクリップされている） */
-static int32_t WAV_Convert32bitPCMto8bitPCM(int32_t in_32bitpcm)
+/* 続きのnum_framesフレームをdata[ch][0]から読み込む */
+WAVApiResult WAV_ReadFrames(struct WAVReader* reader,
+    WAVPcmData** data, uint32_t num_frames, uint32_t* num_read_frames)
 {
-  /* 128のオフセットを加える */
-  return ((in_32bitpcm >> 24) + 128);
+  uint32_t progress, num_chunk_frames;
+  size_t chunk_size, pending_size;
+
+  /* 引数チェック */
+  if (reader == NULL || data == NULL || num_read_frames == NULL) {
+    return WAV_APIRESULT_INVALID_PARAMETER;
+  }
+
+  /* ファイル末尾で切り詰め */
+  num_frames = (num_frames < (reader->format.num_samples - reader->frame_pos))
+    ? num_frames : (reader->format.num_samples - reader->frame_pos);
+
+  for (progress = 0; progress < num_frames; progress += num_chunk_frames) {
+    /* 読み込みバッファに収まるだけ読み込む */
+    num_chunk_frames = ((num_frames - progress) < reader->chunk_num_frames)
+      ? (num_frames - progress) : reader->chunk_num_frames;
+    chunk_size = (size_t)num_chunk_frames * reader->bytes_per_sample * reader->format.num_channels;
+    /* 先読みしたデータから埋めて、残りをファイルから読み込む */
+    pending_size = reader->pending_size - reader->pending_pos;
+    pending_size = (pending_size < chunk_size) ? pending_size : chunk_size;
+    if (pending_size > 0) {
+      memcpy(reader->chunk, &reader->pending[reader->pending_pos], pending_size);
+      reader->pending_pos += (uint32_t)pending_size;
+    }
+    if (fread(&reader->chunk[pending_size], sizeof(uint8_t),
+          chunk_size - pending_size, reader->fp) < (chunk_size - pending_size)) {
+      return WAV_APIRESULT_IOERROR;
+    }
+    /* 32bit整数形式に変形しつつチャンネル毎に分ける */
+    WAV_ConvertBytesToPcmData(reader->chunk,
+        reader->bytes_per_sample, reader->format.num_channels, num_chunk_frames, data, progress);
+  }
+
+  reader->frame_pos += num_frames;
+  *num_read_frames = num_frames;
+  return WAV_APIRESULT_OK;
 }
 
-/* 32bitPCM形式を16bit形式に変換（注意：返り値は32bit整数だが、16bit範囲でクリップされている） */
-static int32_t WAV_Convert32bitPCMto16bitPCM(int32_t in_32bitpcm)
+/* インターリーブされたリトルエンディアンのPCMバイト列を32bit形式に変換しつつチャンネル毎に分けてdata[ch][offset]から書き出す */
+static void WAV_ConvertBytesToPcmData(
+    const uint8_t* bytes, uint32_t bytes_per_sample, uint32_t num_channels,
+    uint32_t num_frames, WAVPcmData** data, uint32_t offset)
 {
-  return (in_32bitpcm >> 16);
+  uint32_t ch, frame = 0;
+
+  assert(bytes != NULL);
+  assert(data != NULL);
+
+#if defined(WAV_USE_SSE2)
+  /* 16bitのモノラル・ステレオはSSE2でまとめて処理 */
+  /* 16bitサンプルを上位に置くよう0とアンパックすれば16bit左シフトと同じになる */
+  if ((bytes_per_sample == 2) && (num_channels == 1)) {
+    const __m128i zero = _mm_setzero_si128();
+    WAVPcmData* dst = &data[0][offset];
+    for (; (frame + 8) <= num_frames; frame += 8) {
+      const __m128i in = _mm_loadu_si128((const __m128i *)&bytes[2 * frame]);
+      _mm_storeu_si128((__m128i *)&dst[frame + 0], _mm_unpacklo_epi16(zero, in));
+      _mm_storeu_si128((__m128i *)&dst[frame + 4], _mm_unpackhi_epi16(zero, in));
+    }
+  } else if ((bytes_per_sample == 2) && (num_channels == 2)) {
+    const __m128i zero = _mm_setzero_si128();
+    WAVPcmData* dst0 = &data[0][offset];
+    WAVPcmData* dst1 = &data[1][offset];
+    for (; (frame + 4) <= num_frames; frame += 4) {
+      const __m128i in = _mm_loadu_si128((const __m128i *)&bytes[4 * frame]);
+      /* L0 R0 L1 R1 / L2 R2 L3 R3 を L0 L1 R0 R1 / L2 L3 R2 R3 に並べ替えてから結合 */
+      const __m128i lo = _mm_shuffle_epi32(_mm_unpacklo_epi16(zero, in), _MM_SHUFFLE(3, 1, 2, 0));
+      const __m128i hi = _mm_shuffle_epi32(_mm_unpackhi_epi16(zero, in), _MM_SHUFFLE(3, 1, 2, 0));
+      _mm_storeu_si128((__m128i *)&dst0[frame], _mm_unpacklo_epi64(lo, hi));
+      _mm_storeu_si128((__m128i *)&dst1[frame], _mm_unpackhi_epi64(lo, hi));
+    }
+  }
+#endif
+
+  /* 残りのフレームはチャンネル毎に変換 */
+  for (ch = 0; ch < num_channels; ch++) {
+    const uint32_t stride = bytes_per_sample * num_channels;
+    const uint8_t* src = &bytes[(frame * num_channels + ch) * bytes_per_sample];
+    WAVPcmData* dst = &data[ch][offset];
+    uint32_t smpl;
+    switch (bytes_per_sample) {
+      case 1:
+        /* 無音に相当する128を引いてから32bit整数に切り上げる */
+        for (smpl = frame; smpl < num_frames; smpl++, src += stride) {
+          dst[smpl] = (WAVPcmData)((uint32_t)(src[0] ^ 0x80) << 24);
+        }
+        break;
+      case 2:
+        for (smpl = frame; smpl < num_frames; smpl++, src += stride) {
+          dst[smpl] = (WAVPcmData)(((uint32_t)src[0] << 16) | ((uint32_t)src[1] << 24));
+        }
+        break;
+      case 3:
+        for (smpl = frame; smpl < num_frames; smpl++, src += stride) {
+          dst[smpl] = (WAVPcmData)(((uint32_t)src[0] << 8) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 24));
+        }
+        break;
+      case 4:
+        for (smpl = frame; smpl < num_frames; smpl++, src += stride) {
+          dst[smpl] = (WAVPcmData)((uint32_t)src[0] | ((uint32_t)src[1] << 8)
+              | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24));
+        }
+        break;
+      default:
+        assert(0);
+    }
+  }
 }
 
-/* 32bitPCM形式を24bit形式に変換（注意：返り値は32bit整数だが、24bit範囲でクリップされている） */
-static int32_t WAV_Convert32bitPCMto24bitPCM(int32_t in_32bitpcm)
+/* チャンネル毎の32bit形式のdata[ch][offset]からnum_framesフレームをインターリーブされたリトルエンディアンのPCMバイト列に変換 */
+static void WAV_ConvertPcmDataToBytes(
+    const WAVPcmData* const* data, uint32_t offset, uint32_t num_frames,
+    uint32_t bytes_per_sample, uint32_t num_channels, uint8_t* bytes)
 {
-  return (in_32bitpcm >> 8);
+  uint32_t ch, frame = 0;
+
+  assert(data != NULL);
+  assert(bytes != NULL);
+
+#if defined(WAV_USE_SSE2)
+  /* 16bitのモノラル・ステレオはSSE2でまとめて処理 */
+  /* 16bit右シフト後は必ず16bitに収まるため飽和パックで値は変わらない */
+  if ((bytes_per_sample == 2) && (num_channels == 1)) {
+    const WAVPcmData* src = &data[0][offset];
+    for (; (frame + 8) <= num_frames; frame += 8) {
+      const __m128i in0 = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)&src[frame + 0]), 16);
+      const __m128i in1 = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)&src[frame + 4]), 16);
+      _mm_storeu_si128((__m128i *)&bytes[2 * frame], _mm_packs_epi32(in0, in1));
+    }
+  } else if ((bytes_per_sample == 2) && (num_channels == 2)) {
+    const WAVPcmData* src0 = &data[0][offset];
+    const WAVPcmData* src1 = &data[1][offset];
+    for (; (frame + 4) <= num_frames; frame += 4) {
+      const __m128i in0 = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)&src0[frame]), 16);
+      const __m128i in1 = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)&src1[frame]), 16);
+      /* L0 R0 L1 R1 / L2 R2 L3 R3 に並べてからパック */
+      _mm_storeu_si128((__m128i *)&bytes[4 * frame],
+          _mm_packs_epi32(_mm_unpacklo_epi32(in0, in1), _mm_unpackhi_epi32(in0, in1)));
+    }
+  }
+#endif
+
+  /* 残りのフレームはチャンネル毎に変換 */
+  /* 32bit形式の上位bytes_per_sampleバイトをリトルエンディアンで並べる（8bitは128のオフセットを加える） */
+  for (ch = 0; ch < num_channels; ch++) {
+    const uint32_t stride = bytes_per_sample * num_channels;
+    const WAVPcmData* src = &data[ch][offset];
+    uint8_t* dst = &bytes[(frame * num_channels + ch) * bytes_per_sample];
+    uint32_t smpl;
+    switch (bytes_per_sample) {
+      case 1:
+        for (smpl = frame; smpl < num_frames; smpl++, dst += stride) {
+          dst[0] = (uint8_t)(((uint32_t)src[smpl] >> 24) ^ 0x80);
+        }
+        break;
+      case 2:
+        for (smpl = frame; smpl < num_frames; smpl++, dst += stride) {
+          dst[0] = (uint8_t)((uint32_t)src[smpl] >> 16);
+          dst[1] = (uint8_t)((uint32_t)src[smpl] >> 24);
+        }
+        break;
+      case 3:
+        for (smpl = frame; smpl < num_frames; smpl++, dst += stride) {
+          dst[0] = (uint8_t)((uint32_t)src[smpl] >>  8);
+          dst[1] = (uint8_t)((uint32_t)src[smpl] >> 16);
+          dst[2] = (uint8_t)((uint32_t)src[smpl] >> 24);
+        }
+        break;
+      case 4:
+        for (smpl = frame; smpl < num_frames; smpl++, dst += stride) {
+          dst[0] = (uint8_t)((uint32_t)src[smpl] >>  0);
+          dst[1] = (uint8_t)((uint32_t)src[smpl] >>  8);
+          dst[2] = (uint8_t)((uint32_t)src[smpl] >> 16);
+          dst[3] = (uint8_t)((uint32_t)src[smpl] >> 24);
+        }
+        break;
+      default:
+        assert(0);
+    }
+  }
 }
 
 /* パーサの初期化 */
@@ -441,6 +728,7 @@ static void WAVParser_Initialize(struct WAVParser* parser, FILE* fp)
   parser->fp                = fp;
   memset(&parser->buffer, 0, sizeof(struct WAVBitBuffer));
   parser->buffer.byte_pos   = -1;
+  parser->buffer_size       = 0;
 }
 
 /* パーサの使用終了 */
@@ -449,6 +737,7 @@ static void WAVParser_Finalize(struct WAVParser* parser)
   parser->fp                = NULL;
   memset(&parser->buffer, 0, sizeof(struct WAVBitBuffer));
   parser->buffer.byte_pos   = -1;
+  parser->buffer_size       = 0;
 }
 
 /* n_bit 取得し、結果を右詰めする */
@@ -464,7 +753,7 @@ static WAVError WAVParser_GetBits(struct WAVParser* parser, uint32_t n_bits, uin
 
   /* 初回読み込み */
   if (buf->byte_pos == -1) {
-      if (fread(buf->bytes, sizeof(uint8_t), WAVBITBUFFER_BUFFER_SIZE, parser->fp) == 0) {
+      if ((parser->buffer_size = (int32_t)fread(buf->bytes, sizeof(uint8_t), WAVBITBUFFER_BUFFER_SIZE, parser->fp)) == 0) {
         return WAV_ERROR_IO;
       }
       buf->byte_pos   = 0;
@@ -485,8 +774,8 @@ static WAVError WAVParser_GetBits(struct WAVParser* parser, uint32_t n_bits, uin
     buf->bit_count   = 8;
 
     /* バッファが一杯ならば、再度読み込み */
-    if (buf->byte_pos == WAVBITBUFFER_BUFFER_SIZE) {
-      if (fread(buf->bytes, sizeof(uint8_t), WAVBITBUFFER_BUFFER_SIZE, parser->fp) == 0) {
+    if (buf->byte_pos == parser->buffer_size) {
+      if ((parser->buffer_size = (int32_t)fread(buf->bytes, sizeof(uint8_t), WAVBITBUFFER_BUFFER_SIZE, parser->fp)) == 0) {
         return WAV_ERROR_IO;
       }
       buf->byte_pos = 0;
@@ -503,20 +792,53 @@ static WAVError WAVParser_GetBits(struct WAVParser* parser, uint32_t n_bits, uin
 }
 
 /* シーク（fseek準拠） */
-static WAVError WAVParser_Seek(struct WAVParser* parser, int32_t offset, int32_t wherefrom)
+static WAVError WAVParser_Seek(struct WAVParser* parser, long offset, int32_t wherefrom)
 {
-  if (parser->buffer.byte_pos != -1) {
-    /* バッファに取り込んだ分先読みしているので戻す */
-    offset -= (WAVBITBUFFER_BUFFER_SIZE - (parser->buffer.byte_pos + 1));
+  if ((parser->buffer.byte_pos != -1) && (wherefrom == SEEK_CUR)) {
+    /* バッファに取り込んだ分先読みしているので戻す（ファイル末尾では読み込めた分だけ） */
+    offset -= (long)(parser->buffer_size - (parser->buffer.byte_pos + 1));
   }
-  /* 移動 */
-  fseek(parser->fp, offset, wherefrom);
   /* バッファをクリア */
   parser->buffer.byte_pos = -1;
+  /* 移動 */
+  if (fseek(parser->fp, offset, wherefrom) != 0) {
+    return WAV_ERROR_IO;
+  }
 
   return WAV_ERROR_OK;
 }
 
+/* 読み込み位置（ファイル先頭からのバイト数）を取得 */
+static long WAVParser_Tell(struct WAVParser* parser)
+{
+  long pos = ftell(parser->fp);
+
+  /* 先読みしている分を戻す */
+  if (pos >= 0) {
+    pos -= (long)WAVParser_GetBufferedBytes(parser, NULL);
+  }
+
+  return pos;
+}
+
+/* バッファに先読みしていてまだ読み出していないバイト列を取得 */
+static uint32_t WAVParser_GetBufferedBytes(struct WAVParser* parser, const uint8_t** bytes)
+{
+  int32_t pos;
+
+  if (parser->buffer.byte_pos == -1) {
+    return 0;
+  }
+
+  /* 読み終えたバイトはbit_countが0 */
+  pos = parser->buffer.byte_pos + ((parser->buffer.bit_count == 0) ? 1 : 0);
+  if (bytes != NULL) {
+    (*bytes) = &parser->buffer.bytes[pos];
+  }
+
+  return (uint32_t)(parser->buffer_size - pos);
+}
+
 /* WAVファイルハンドルを破棄 */
 void WAV_Destroy(struct WAVFile* wavfile)
 {
@@ -545,7 +867,8 @@ void WAV_Destroy(struct WAVFile* wavfile)
 static WAVError WAVWriter_PutWAVHeader(
     struct WAVWriter* writer, const struct WAVFileFormat* format)
 {
-  uint32_t filesize, pcm_data_size;
+  uint64_t filesize, pcm_data_size;
+  uint8_t is_rf64, is_extensible;
 
   /* 引数チェック */
   if (writer == NULL || format == NULL) {
@@ -560,22 +883,35 @@ static WAVError WAVWriter_PutWAVHeader(
 
   /* PCM データサイズ */
   pcm_data_size 
-    = format->num_samples * (format->bits_per_sample / 8) * format->num_channels;
+    = (uint64_t)format->num_samples * (format->bits_per_sample / 8) * format->num_channels;
 
   /* ファイルサイズ */
   filesize 
     = pcm_data_size
     + 44; /* "RIFF" から ("data"のサイズ) までのフィールドのバイト数
              拡張部分を一切含まない */
+
+  /* 3チャンネル以上はWAVE_FORMAT_EXTENSIBLE（fmtチャンクが24byte増える）で出力 */
+  is_extensible = (format->num_channels > 2) ? 1 : 0;
+  if (is_extensible) {
+    filesize += 24;
+  }
+
+  /* 4GBを超える場合はds64チャンク（36byte）を含むRF64で出力 */
+  is_rf64 = ((filesize - 8) > UINT32_MAX) ? 1 : 0;
+  if (is_rf64) {
+    filesize += 36;
+  }
   
-  /* ヘッダ 'R', 'I', 'F', 'F' を出力 */
+  /* ヘッダ 'R', 'I', 'F', 'F' （RF64の場合は 'R', 'F', '6', '4'）を出力 */
   if (WAVWriter_PutBits(writer, 'R', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, 'I', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, 'F', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, 'F', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+  if (WAVWriter_PutBits(writer, is_rf64 ? 'F' : 'I', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+  if (WAVWriter_PutBits(writer, is_rf64 ? '6' : 'F', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+  if (WAVWriter_PutBits(writer, is_rf64 ? '4' : 'F', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
 
-  /* ファイルサイズ-8（この要素以降のサイズ） */
-  if (WAVWriter_PutLittleEndianBytes(writer, 4, filesize - 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+  /* ファイルサイズ-8（この要素以降のサイズ） RF64では-1としてds64チャンクに書く */
+  if (WAVWriter_PutLittleEndianBytes(writer, 4,
+        is_rf64 ? 0xFFFFFFFFUL : (filesize - 8)) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
 
   /* ヘッダ 'W', 'A', 'V', 'E' を出力 */
   if (WAVWriter_PutBits(writer, 'W', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
@@ -583,17 +919,36 @@ static WAVError WAVWriter_PutWAVHeader(
   if (WAVWriter_PutBits(writer, 'V', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
   if (WAVWriter_PutBits(writer, 'E', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
 
+  /* ds64チャンクを出力 */
+  if (is_rf64) {
+    if (WAVWriter_PutBits(writer, 'd', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+    if (WAVWriter_PutBits(writer, 's', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+    if (WAVWriter_PutBits(writer, '6', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+    if (WAVWriter_PutBits(writer, '4', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+    /* チャンクサイズ: テーブルは出力しないので28byte決め打ち */
+    if (WAVWriter_PutLittleEndianBytes(writer, 4, 28) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    /* RIFFサイズ, dataサイズ, サンプル数（各64bit、下位32bitから） */
+    if (WAVWriter_PutLittleEndianBytes(writer, 4, (filesize - 8) & 0xFFFFFFFFUL) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    if (WAVWriter_PutLittleEndianBytes(writer, 4, (filesize - 8) >> 32) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    if (WAVWriter_PutLittleEndianBytes(writer, 4, pcm_data_size & 0xFFFFFFFFUL) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    if (WAVWriter_PutLittleEndianBytes(writer, 4, pcm_data_size >> 32) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    if (WAVWriter_PutLittleEndianBytes(writer, 4, format->num_samples) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    if (WAVWriter_PutLittleEndianBytes(writer, 4, 0) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    /* テーブル長 */
+    if (WAVWriter_PutLittleEndianBytes(writer, 4, 0) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+  }
+
   /* fmtチャンクのヘッダ 'f', 'm', 't', ' ' を出力 */
   if (WAVWriter_PutBits(writer, 'f', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
   if (WAVWriter_PutBits(writer, 'm', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
   if (WAVWriter_PutBits(writer, 't', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
   if (WAVWriter_PutBits(writer, ' ', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
 
-  /* fmtチャンクのバイト数を出力 （補足）現在は16byte決め打ち */
-  if (WAVWriter_PutLittleEndianBytes(writer, 4, 16) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+  /* fmtチャンクのバイト数を出力 （補足）16byte（WAVE_FORMAT_EXTENSIBLEでは40byte） */
+  if (WAVWriter_PutLittleEndianBytes(writer, 4, is_extensible ? 40 : 16) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
 
-  /* フォーマットIDを出力 （補足）現在は1（リニアPCM）決め打ち */
-  if (WAVWriter_PutLittleEndianBytes(writer, 2,  1) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+  /* フォーマットIDを出力 （補足）1（リニアPCM）（WAVE_FORMAT_EXTENSIBLEでは0xFFFE） */
+  if (WAVWriter_PutLittleEndianBytes(writer, 2, is_extensible ? 0xFFFE : 1) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
 
   /* チャンネル数 */
   if (WAVWriter_PutLittleEndianBytes(writer, 2, format->num_channels) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
@@ -614,14 +969,35 @@ static WAVError WAVWriter_PutWAVHeader(
   /* 量子化ビット数（サンプルあたりのビット数） */
   if (WAVWriter_PutLittleEndianBytes(writer, 2, format->bits_per_sample) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
 
+  /* WAVE_FORMAT_EXTENSIBLEの拡張部分 */
+  if (is_extensible) {
+    /* リニアPCMのサブフォーマットGUID 00000001-0000-0010-8000-00AA00389B71 */
+    static const uint8_t pcm_guid[16] = {
+      0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+      0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+    };
+    uint32_t i;
+    /* 拡張部分のサイズ */
+    if (WAVWriter_PutLittleEndianBytes(writer, 2, 22) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+    /* 有効ビット数 */
+    if (WAVWriter_PutLittleEndianBytes(writer, 2, format->bits_per_sample) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+    /* チャンネル配置 */
+    if (WAVWriter_PutLittleEndianBytes(writer, 4, format->channel_mask) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+    /* サブフォーマット */
+    for (i = 0; i < sizeof(pcm_guid); i++) {
+      if (WAVWriter_PutBits(writer, pcm_guid[i], 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+    }
+  }
+
   /* "data" チャンクのヘッダ出力 */
   if (WAVWriter_PutBits(writer, 'd', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
   if (WAVWriter_PutBits(writer, 'a', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
   if (WAVWriter_PutBits(writer, 't', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
   if (WAVWriter_PutBits(writer, 'a', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
 
-  /* 波形データバイト数 */
-  if (WAVWriter_PutLittleEndianBytes(writer, 4, pcm_data_size) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+  /* 波形データバイト数 RF64では-1としてds64チャンクに書く */
+  if (WAVWriter_PutLittleEndianBytes(writer, 4,
+        is_rf64 ? 0xFFFFFFFFUL : pcm_data_size) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
 
   return WAV_ERROR_OK;
 }
@@ -630,41 +1006,46 @@ static WAVError WAVWriter_PutWAVHeader(
 static WAVError WAVWriter_PutWAVPcmData(
     struct WAVWriter* writer, const struct WAVFile* wavfile)
 {
-  uint32_t  ch, sample, bytes_per_sample;
-  int32_t   (*convert_sint32_to_pcmdata_func)(int32_t);
+  uint32_t  progress, num_chunk_frames, bytes_per_sample, bytes_per_frame;
+  uint8_t*  chunk;
+  WAVError  ret = WAV_ERROR_OK;
 
-  /* ビット深度に合わせてPCMデータの変換関数を決定 */
+  /* ビット深度チェック */
   switch (wavfile->format.bits_per_sample) {
-    case 8:
-      convert_sint32_to_pcmdata_func = WAV_Convert32bitPCMto8bitPCM;
-      break;
-    case 16:
-      convert_sint32_to_pcmdata_func = WAV_Convert32bitPCMto16bitPCM;
-      break;
-    case 24:
-      convert_sint32_to_pcmdata_func = WAV_Convert32bitPCMto24bitPCM;
-      break;
-    case 32:
-      convert_sint32_to_pcmdata_func = WAV_Convert32bitPCMto32bitPCM;
+    case 8: case 16: case 24: case 32:
       break;
     default:
       /* fprintf(stderr, "Unsupported bits per sample format(=%d). \n", wavfile->format.bits_per_sample); */
       return WAV_ERROR_INVALID_FORMAT;
   }
 
-  /* チャンネルインターリーブしつつ出力 */
+  /* ヘッダまでの出力をファイルに書き出しておく（以降はバイト単位の出力なので端数ビットはない） */
+  if (WAVWriter_Flush(writer) != WAV_ERROR_OK) {
+    return WAV_ERROR_IO;
+  }
+
+  /* 書き出しバッファの割り当て */
   bytes_per_sample = wavfile->format.bits_per_sample / 8;
-  for (sample = 0; sample < wavfile->format.num_samples; sample++) {
-    for (ch = 0; ch < wavfile->format.num_channels; ch++) {
-      if (WAVWriter_PutLittleEndianBytes(writer,
-            bytes_per_sample,
-            (uint64_t)convert_sint32_to_pcmdata_func(WAVFile_PCM(wavfile, sample, ch))) != WAV_ERROR_OK) {
-        return WAV_ERROR_IO;
-      }
+  bytes_per_frame = bytes_per_sample * wavfile->format.num_channels;
+  chunk = (uint8_t *)malloc((size_t)WAVWRITER_CHUNK_NUM_FRAMES * bytes_per_frame);
+  if (chunk == NULL) {
+    return WAV_ERROR_NG;
+  }
+
+  /* チャンク単位で変換・インターリーブしてまとめて出力 */
+  for (progress = 0; progress < wavfile->format.num_samples; progress += num_chunk_frames) {
+    num_chunk_frames = ((wavfile->format.num_samples - progress) < WAVWRITER_CHUNK_NUM_FRAMES)
+      ? (wavfile->format.num_samples - progress) : WAVWRITER_CHUNK_NUM_FRAMES;
+    WAV_ConvertPcmDataToBytes((const WAVPcmData* const*)wavfile->data,
+        progress, num_chunk_frames, bytes_per_sample, wavfile->format.num_channels, chunk);
+    if (fwrite(chunk, bytes_per_frame, num_chunk_frames, writer->fp) < num_chunk_frames) {
+      ret = WAV_ERROR_IO;
+      break;
     }
   }
 
-  return WAV_ERROR_OK;
+  free(chunk);
+  return ret;
 }
 
 /* ファイル書き出し */
@@ -709,6 +1090,44 @@ WAVApiResult WAV_WriteToFile(
   return WAV_APIRESULT_OK;
 }
 
+/* ヘッダ部だけをファイルに書き出し */
+WAVApiResult WAV_WriteHeaderToFile(
+    const char* filename, const struct WAVFileFormat* format, uint32_t* header_size)
+{
+  struct WAVWriter  writer;
+  FILE*             fp;
+  long              pos;
+
+  /* 引数チェック */
+  if (filename == NULL || format == NULL || header_size == NULL) {
+    return WAV_APIRESULT_INVALID_PARAMETER;
+  }
+
+  /* wavファイルを開く */
+  fp = fopen(filename, "wb");
+  if (fp == NULL) {
+    /* fprintf(stderr, "Failed to open %s. \n", filename); */
+    return WAV_APIRESULT_NG;
+  }
+
+  /* ヘッダ書き出し */
+  WAVWriter_Initialize(&writer, fp);
+  if (WAVWriter_PutWAVHeader(&writer, format) != WAV_ERROR_OK) {
+    fclose(fp);
+    return WAV_APIRESULT_NG;
+  }
+  WAVWriter_Finalize(&writer);
+
+  /* 書き出したサイズがヘッダサイズ */
+  pos = ftell(fp);
+  if ((fclose(fp) != 0) || (pos < 0)) {
+    return WAV_APIRESULT_IOERROR;
+  }
+  (*header_size) = (uint32_t)pos;
+
+  return WAV_APIRESULT_OK;
+}
+
 /* ライタの初期化 */
 static void WAVWriter_Initialize(struct WAVWriter* writer, FILE* fp)
 {
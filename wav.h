@@ -27,6 +27,7 @@ struct WAVFileFormat {
   uint32_t      sampling_rate;    /* サンプリングレート */
   uint32_t      bits_per_sample;  /* 量子化ビット数 */
   uint32_t      num_samples;      /* サンプル数 */
+  uint32_t      channel_mask;     /* チャンネル配置（WAVE_FORMAT_EXTENSIBLEのdwChannelMask, 0は指定なし, 3チャンネル以上でのみ書き出す） */
 };
 
 /* WAVファイルハンドル */
@@ -38,6 +39,9 @@ struct WAVFile {
 /* アクセサ */
 #define WAVFile_PCM(wavfile, samp, ch)  (wavfile->data[(ch)][(samp)])
 
+/* WAVファイルリーダハンドル（ファイルを先頭からフレーム単位で読み込む） */
+struct WAVReader;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -55,10 +59,34 @@ void WAV_Destroy(struct WAVFile* wavfile);
 WAVApiResult WAV_WriteToFile(
     const char* filename, const struct WAVFile* wavfile);
 
+/* ヘッダ部だけをファイルに書き出し（PCMデータは呼び出し側でheader_size以降に書き込む） */
+WAVApiResult WAV_WriteHeaderToFile(
+    const char* filename, const struct WAVFileFormat* format, uint32_t* header_size);
+
 /* ファイルからWAVファイルフォーマットだけ読み取り */
 WAVApiResult WAV_GetWAVFormatFromFile(
     const char* filename, struct WAVFileFormat* format);
 
+/* ファイルからWAVファイルフォーマットとPCMデータ先頭のオフセット（ファイル先頭からのバイト数）を読み取り */
+WAVApiResult WAV_GetWAVFormatAndDataOffsetFromFile(
+    const char* filename, struct WAVFileFormat* format, uint32_t* data_offset);
+
+/* ファイルを開いてリーダハンドルを作成 */
+/* chunk_num_frames: 1度にファイルから読み込むフレーム数（0ならデフォルト値） 使用メモリはこれに比例する */
+struct WAVReader* WAV_CreateReader(const char* filename, uint32_t chunk_num_frames);
+
+/* リーダハンドルを破棄（ファイルも閉じる） */
+void WAV_DestroyReader(struct WAVReader* reader);
+
+/* リーダハンドルからフォーマットを取得 */
+WAVApiResult WAV_GetReaderFormat(
+    const struct WAVReader* reader, struct WAVFileFormat* format);
+
+/* 続きのnum_framesフレームをdata[ch][0]から読み込む */
+/* ファイル末尾に達した場合はそこまでを読み込み、読み込んだフレーム数をnum_read_framesに返す */
+WAVApiResult WAV_ReadFrames(struct WAVReader* reader,
+    WAVPcmData** data, uint32_t num_frames, uint32_t* num_read_frames);
+
 #ifdef __cplusplus
 }
 #endif